@@ -30,13 +30,17 @@
 #include "entitymanager.h"
 #include <functional>
 #include <algorithm>
+#include <atomic>
 #include <QDesktopServices>
 #include <QUrl>
+#include <QMutex>
+#include <QSet>
 #include "util/util.h"
 #include "util/sll/prelude.h"
 #include "interfaces/structures.h"
 #include "interfaces/idownload.h"
 #include "interfaces/ientityhandler.h"
+#include "interfaces/ientityroutinghints.h"
 #include "interfaces/entitytesthandleresult.h"
 #include "core.h"
 #include "pluginmanager.h"
@@ -52,17 +56,132 @@ namespace LeechCraft
 
 	namespace
 	{
+		/** Maps the routing keys declared via IEntityRoutingHints to the
+		 * plugins declaring them, so that only the plugins that could
+		 * possibly handle an entity are queried for it.
+		 *
+		 * The index is rebuilt whenever the list of plugins changes.
+		 */
+		class RoutingIndex
+		{
+			QMutex Mutex_;
+
+			QObjectList Plugins_;
+
+			QObjectList Unrestricted_;
+			QHash<QString, QObjectList> Mime2Plugins_;
+			QList<QPair<QString, QObject*>> MimePrefixes_;
+			QHash<QString, QObjectList> Scheme2Plugins_;
+		public:
+			QSet<QObject*> GetCandidates (const QObjectList& plugins, const Entity& e)
+			{
+				QMutexLocker locker { &Mutex_ };
+				if (plugins != Plugins_)
+					Rebuild (plugins);
+
+				auto result = QSet<QObject*>::fromList (Unrestricted_);
+				result += QSet<QObject*>::fromList (Mime2Plugins_.value (e.Mime_));
+				for (const auto& pair : MimePrefixes_)
+					if (e.Mime_.startsWith (pair.first))
+						result << pair.second;
+				if (e.Entity_.type () == QVariant::Url)
+					result += QSet<QObject*>::fromList (Scheme2Plugins_.value (e.Entity_.toUrl ().scheme ()));
+				return result;
+			}
+		private:
+			void Rebuild (const QObjectList& plugins)
+			{
+				Plugins_ = plugins;
+				Unrestricted_.clear ();
+				Mime2Plugins_.clear ();
+				MimePrefixes_.clear ();
+				Scheme2Plugins_.clear ();
+
+				for (const auto plugin : plugins)
+				{
+					const auto hints = qobject_cast<IEntityRoutingHints*> (plugin);
+					if (!hints)
+					{
+						Unrestricted_ << plugin;
+						continue;
+					}
+
+					const auto& keys = hints->GetEntityRoutingKeys ();
+					for (const auto& mime : keys.Mimes_)
+						Mime2Plugins_ [mime] << plugin;
+					for (const auto& prefix : keys.MimePrefixes_)
+						MimePrefixes_.append ({ prefix, plugin });
+					for (const auto& scheme : keys.Schemes_)
+						Scheme2Plugins_ [scheme] << plugin;
+				}
+			}
+		};
+
+		/** Counts the entities routed and the CouldDownload() and
+		 * CouldHandle() calls made for them, reporting the numbers
+		 * every ReportInterval entities.
+		 */
+		class RoutingStats
+		{
+			std::atomic<quint64> Entities_ { 0 };
+			std::atomic<quint64> Queries_ { 0 };
+			std::atomic<quint64> Skipped_ { 0 };
+
+			static const quint64 ReportInterval = 1000;
+		public:
+			void AddEntity ()
+			{
+				if (++Entities_ % ReportInterval)
+					return;
+
+				const quint64 entities = Entities_;
+				const quint64 queries = Queries_;
+				qDebug () << Q_FUNC_INFO
+						<< entities
+						<< "entities routed with"
+						<< queries
+						<< "handler queries ("
+						<< static_cast<double> (queries) / entities
+						<< "per entity),"
+						<< Skipped_.load ()
+						<< "queries skipped by the routing index";
+			}
+
+			void AddQueries (quint64 queries, quint64 skipped)
+			{
+				Queries_ += queries;
+				Skipped_ += skipped;
+			}
+		};
+
+		RoutingStats Stats;
+
+		template<typename T>
+		RoutingIndex& GetRoutingIndex ()
+		{
+			static RoutingIndex index;
+			return index;
+		}
+
 		template<typename T, typename F>
 		QObjectList GetSubtype (const Entity& e, bool fullScan, const F& queryFunc)
 		{
 			auto pm = Core::Instance ().GetPluginManager ();
+			const auto& plugins = pm->GetAllCastableRoots<T> ();
+			const auto& candidates = GetRoutingIndex<T> ().GetCandidates (plugins, e);
+
+			quint64 queries = 0;
 			QMap<int, QObjectList> result;
 			int cutoffPriority = 0;
-			for (const auto& plugin : pm->GetAllCastableRoots<T> ())
+			for (const auto& plugin : plugins)
 			{
+				if (!candidates.contains (plugin))
+					continue;
+
 				EntityTestHandleResult r;
 				try
 				{
+					++queries;
 					r = queryFunc (e, qobject_cast<T> (plugin));
 				}
 				catch (const std::exception& e)
@@ -92,6 +211,8 @@ namespace LeechCraft
 					break;
 			}
 
+			Stats.AddQueries (queries, plugins.size () - candidates.size ());
+
 			if (cutoffPriority > 0)
 				while (!result.isEmpty ())
 				{
@@ -114,6 +235,8 @@ namespace LeechCraft
 			if (Core::Instance ().IsShuttingDown ())
 				return {};
 
+			Stats.AddEntity ();
+
 			const auto& unwanted = e.Additional_ ["IgnorePlugins"].toStringList ();
 			auto removeUnwanted = [&unwanted] (QObjectList& handlers)
 			{
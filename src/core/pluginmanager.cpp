@@ -52,6 +52,7 @@
 #include "xmlsettingsmanager.h"
 #include "coreproxy.h"
 #include "plugintreebuilder.h"
+#include "pluginmanifest.h"
 #include "config.h"
 #include "coreinstanceobject.h"
 #include "shortcutmanager.h"
@@ -343,6 +344,8 @@ namespace LeechCraft
 		std::shared_ptr<void> groupGuard (nullptr,
 				[&settings] (void*) { settings.endGroup (); });
 
+		const auto& deps = PluginTreeBuilder_->GetDependencies ();
+
 		for (const auto obj : ordered)
 		{
 			const auto ii = qobject_cast<IInfo*> (obj);
@@ -350,7 +353,16 @@ namespace LeechCraft
 			{
 				qDebug () << "Initializing" << ii->GetName ();
 				emit loadProgress (tr ("Initializing %1: stage one...").arg (ii->GetName ()));
-				ii->Init (std::make_shared<CoreProxy> ());
+
+				QStringList depNames;
+				for (const auto dep : deps.value (obj))
+					depNames << qobject_cast<IInfo*> (dep)->GetName ();
+				StartupTrace_.SetInitDependencies (ii->GetName (), depNames);
+
+				{
+					const auto guard = StartupTrace_.Measure (StartupTrace::Stage::Init, ii->GetName ());
+					ii->Init (std::make_shared<CoreProxy> ());
+				}
 
 				const auto& path = GetPluginLibraryPath (obj);
 				if (path.isEmpty ())
@@ -452,6 +464,7 @@ namespace LeechCraft
 			try
 			{
 				emit loadProgress (tr ("Initializing %1: stage two...").arg (ii->GetName ()));
+				const auto guard = StartupTrace_.Measure (StartupTrace::Stage::SecondInit, ii->GetName ());
 				ii->SecondInit ();
 			}
 			catch (const std::exception& e)
@@ -469,6 +482,8 @@ namespace LeechCraft
 			Core::Instance ().PostSecondInit (plugin);
 
 		TryUnload (failed);
+
+		StartupTrace_.Report ();
 	}
 
 	void PluginManager::Release ()
@@ -873,8 +888,54 @@ namespace LeechCraft
 		}
 	}
 
+	void PluginManager::SkipUnusablePlugins ()
+	{
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "-pg");
+		settings.beginGroup ("Plugins");
+
+		QHash<QString, PluginManifest> manifests;
+		for (const auto& loader : PluginContainers_)
+		{
+			const auto& path = loader->GetFileName ();
+
+			settings.beginGroup (path);
+			const auto& manifest = PluginManifest::Load (settings, QFileInfo (path));
+			settings.endGroup ();
+
+			if (!manifest)
+			{
+				qDebug () << Q_FUNC_INFO
+						<< "no valid manifest for"
+						<< path
+						<< "; loading all the plugins";
+				return;
+			}
+
+			manifests [path] = *manifest;
+		}
+
+		settings.endGroup ();
+
+		const auto& unusable = FindUnusablePlugins (manifests, Core::Instance ().GetCoreInstanceObject ());
+		for (int i = PluginContainers_.size () - 1; i >= 0; --i)
+		{
+			const auto& path = PluginContainers_.at (i)->GetFileName ();
+			if (!unusable.contains (path))
+				continue;
+
+			qDebug () << Q_FUNC_INFO
+					<< "skipping loading"
+					<< path
+					<< "since its dependencies can't be fulfilled";
+			PluginContainers_.removeAt (i);
+		}
+	}
+
 	void PluginManager::CheckPlugins ()
 	{
+		SkipUnusablePlugins ();
+
 		QSettings settings (QCoreApplication::organizationName (),
 				QCoreApplication::applicationName () + "-pg");
 		settings.beginGroup ("Plugins");
@@ -886,8 +947,9 @@ namespace LeechCraft
 				<< Checks::TryLoad
 				<< Checks::APILevel;
 
-		auto thrCheck = [checks] (Loaders::IPluginLoader_ptr loader) -> boost::optional<Checks::Fail>
+		auto thrCheck = [this, checks] (Loaders::IPluginLoader_ptr loader) -> boost::optional<Checks::Fail>
 		{
+			const auto guard = StartupTrace_.Measure (StartupTrace::Stage::Load, loader->GetFileName ());
 			for (const auto& check : checks)
 				try
 				{
@@ -995,15 +1057,36 @@ namespace LeechCraft
 
 	void PluginManager::FillInstances ()
 	{
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "-pg");
+		settings.beginGroup ("Plugins");
+
 		Q_FOREACH (auto loader, PluginContainers_)
 		{
 			auto inst = loader->Instance ();
 			Plugins_ << inst;
 			Obj2Loader_ [inst] = loader;
+
+			QObjectList adapted;
 			IPluginAdaptor *ipa = qobject_cast<IPluginAdaptor*> (inst);
 			if (ipa)
-				Plugins_ << ipa->GetPlugins ();
+			{
+				adapted = ipa->GetPlugins ();
+				Plugins_ << adapted;
+			}
+
+			// Rewriting the unchanged manifests on each start would make
+			// QSettings sync the whole file to disk for nothing.
+			const QFileInfo fi { loader->GetFileName () };
+			settings.beginGroup (loader->GetFileName ());
+			const auto& manifest = PluginManifest::FromObjects (inst, adapted, fi);
+			const auto& cached = PluginManifest::Load (settings, fi);
+			if (!cached || *cached != manifest)
+				manifest.Save (settings);
+			settings.endGroup ();
 		}
+
+		settings.endGroup ();
 	}
 
 	QObjectList PluginManager::FirstInitAll ()
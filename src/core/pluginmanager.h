@@ -39,6 +39,7 @@
 #include "loaders/ipluginloader.h"
 #include "interfaces/iinfo.h"
 #include "interfaces/core/ipluginsmanager.h"
+#include "startuptrace.h"
 
 namespace LeechCraft
 {
@@ -75,6 +76,8 @@ namespace LeechCraft
 
 		mutable bool CacheValid_;
 		mutable QObjectList SortedCache_;
+
+		StartupTrace StartupTrace_;
 	public:
 		enum Roles
 		{
@@ -127,13 +130,21 @@ namespace LeechCraft
 		void FindPlugins ();
 		void ScanPlugins (const QStringList&);
 
+		/** Removes the plugins whose dependencies are known to be
+		 * unfulfillable from the cached manifests, so that their
+		 * libraries aren't even loaded. Does nothing if any of the
+		 * manifests is missing or outdated.
+		 */
+		void SkipUnusablePlugins ();
+
 		/** Tries to load all the plugins and filters out those who fail
 		 * various sanity checks.
 		 */
 		void CheckPlugins ();
 
 		/** Fills the Plugins_ list with all instances, both from "real"
-		 * plugins and from adaptors.
+		 * plugins and from adaptors, and refreshes the cached plugin
+		 * manifests that have changed since the last start.
 		 */
 		void FillInstances ();
 
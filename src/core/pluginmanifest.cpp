@@ -0,0 +1,187 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "pluginmanifest.h"
+#include <memory>
+#include <QSettings>
+#include <QFileInfo>
+#include <QDateTime>
+#include <interfaces/iinfo.h>
+#include <interfaces/iplugin2.h>
+#include <interfaces/ipluginready.h>
+
+namespace LeechCraft
+{
+	namespace
+	{
+		QStringList ToStrings (const QSet<QByteArray>& set)
+		{
+			QStringList result;
+			for (const auto& item : set)
+				result << QString::fromUtf8 (item);
+			return result;
+		}
+
+		QSet<QByteArray> ToByteArrays (const QStringList& list)
+		{
+			QSet<QByteArray> result;
+			for (const auto& item : list)
+				result << item.toUtf8 ();
+			return result;
+		}
+	}
+
+	PluginManifest PluginManifest::FromObjects (QObject *root, const QObjectList& adapted, const QFileInfo& fi)
+	{
+		PluginManifest manifest;
+		manifest.MTime_ = fi.lastModified ().toMSecsSinceEpoch ();
+		manifest.Size_ = fi.size ();
+		manifest.IsAdaptor_ = !adapted.isEmpty ();
+
+		if (const auto ii = qobject_cast<IInfo*> (root))
+		{
+			manifest.ID_ = ii->GetUniqueID ();
+			manifest.Needs_ = QSet<QString>::fromList (ii->Needs ());
+		}
+		if (const auto ip2 = qobject_cast<IPlugin2*> (root))
+			manifest.PluginClasses_ = ip2->GetPluginClasses ();
+
+		for (const auto obj : QObjectList { root } + adapted)
+		{
+			if (const auto ii = qobject_cast<IInfo*> (obj))
+				manifest.Provides_ += QSet<QString>::fromList (ii->Provides ());
+			if (const auto ipr = qobject_cast<IPluginReady*> (obj))
+				manifest.ExpectedPluginClasses_ += ipr->GetExpectedPluginClasses ();
+		}
+
+		return manifest;
+	}
+
+	boost::optional<PluginManifest> PluginManifest::Load (QSettings& settings, const QFileInfo& fi)
+	{
+		settings.beginGroup ("Manifest");
+		const auto guard = std::shared_ptr<void> (nullptr,
+				[&settings] (void*) { settings.endGroup (); });
+
+		if (!settings.contains ("ID"))
+			return {};
+
+		PluginManifest manifest;
+		manifest.MTime_ = settings.value ("MTime").toLongLong ();
+		manifest.Size_ = settings.value ("Size").toLongLong ();
+		if (manifest.MTime_ != fi.lastModified ().toMSecsSinceEpoch () ||
+				manifest.Size_ != fi.size ())
+			return {};
+
+		manifest.ID_ = settings.value ("ID").toByteArray ();
+		manifest.Provides_ = QSet<QString>::fromList (settings.value ("Provides").toStringList ());
+		manifest.Needs_ = QSet<QString>::fromList (settings.value ("Needs").toStringList ());
+		manifest.PluginClasses_ = ToByteArrays (settings.value ("PluginClasses").toStringList ());
+		manifest.ExpectedPluginClasses_ = ToByteArrays (settings.value ("ExpectedPluginClasses").toStringList ());
+		manifest.IsAdaptor_ = settings.value ("IsAdaptor").toBool ();
+		return manifest;
+	}
+
+	void PluginManifest::Save (QSettings& settings) const
+	{
+		settings.beginGroup ("Manifest");
+		settings.setValue ("ID", ID_);
+		settings.setValue ("Provides", QStringList (Provides_.toList ()));
+		settings.setValue ("Needs", QStringList (Needs_.toList ()));
+		settings.setValue ("PluginClasses", ToStrings (PluginClasses_));
+		settings.setValue ("ExpectedPluginClasses", ToStrings (ExpectedPluginClasses_));
+		settings.setValue ("IsAdaptor", IsAdaptor_);
+		settings.setValue ("MTime", MTime_);
+		settings.setValue ("Size", Size_);
+		settings.endGroup ();
+	}
+
+	bool PluginManifest::operator== (const PluginManifest& other) const
+	{
+		return ID_ == other.ID_ &&
+				Provides_ == other.Provides_ &&
+				Needs_ == other.Needs_ &&
+				PluginClasses_ == other.PluginClasses_ &&
+				ExpectedPluginClasses_ == other.ExpectedPluginClasses_ &&
+				IsAdaptor_ == other.IsAdaptor_ &&
+				MTime_ == other.MTime_ &&
+				Size_ == other.Size_;
+	}
+
+	bool PluginManifest::operator!= (const PluginManifest& other) const
+	{
+		return !(*this == other);
+	}
+
+	QStringList FindUnusablePlugins (QHash<QString, PluginManifest> manifests, QObject *coreInstance)
+	{
+		QSet<QString> coreProvides;
+		if (const auto ii = qobject_cast<IInfo*> (coreInstance))
+			coreProvides = QSet<QString>::fromList (ii->Provides ());
+		QSet<QByteArray> coreExpected;
+		if (const auto ipr = qobject_cast<IPluginReady*> (coreInstance))
+			coreExpected = ipr->GetExpectedPluginClasses ();
+
+		QStringList result;
+
+		bool changed = true;
+		while (changed)
+		{
+			changed = false;
+
+			auto provides = coreProvides;
+			auto expected = coreExpected;
+			for (const auto& manifest : manifests)
+			{
+				provides += manifest.Provides_;
+				expected += manifest.ExpectedPluginClasses_;
+			}
+
+			for (auto i = manifests.begin (); i != manifests.end (); )
+			{
+				const auto& manifest = *i;
+
+				const bool fulfilled = manifest.IsAdaptor_ ||
+						((manifest.Needs_ - provides).isEmpty () &&
+						 (manifest.PluginClasses_ - expected).isEmpty ());
+				if (fulfilled)
+				{
+					++i;
+					continue;
+				}
+
+				result << i.key ();
+				i = manifests.erase (i);
+				changed = true;
+			}
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,102 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <QSet>
+#include <QStringList>
+#include <QObjectList>
+#include <QHash>
+
+class QSettings;
+class QFileInfo;
+
+namespace LeechCraft
+{
+	/** Describes the dependency-related properties of a plugin library
+	 * as seen during the last successful load of that library.
+	 *
+	 * The manifest is stored in the plugin's settings group and is
+	 * considered valid only as long as the library file has the same
+	 * size and modification time.
+	 */
+	struct PluginManifest
+	{
+		QByteArray ID_;
+
+		/** The features provided by the root plugin object and all the
+		 * objects it adapts, if any.
+		 */
+		QSet<QString> Provides_;
+
+		/** The features required by the root plugin object.
+		 */
+		QSet<QString> Needs_;
+
+		/** Second-level plugin classes of the root plugin object.
+		 */
+		QSet<QByteArray> PluginClasses_;
+
+		/** Second-level plugin classes expected by the root plugin
+		 * object and all the objects it adapts, if any.
+		 */
+		QSet<QByteArray> ExpectedPluginClasses_;
+
+		bool IsAdaptor_ = false;
+
+		qint64 MTime_ = 0;
+		qint64 Size_ = 0;
+
+		static PluginManifest FromObjects (QObject *root, const QObjectList& adapted, const QFileInfo&);
+
+		/** Loads the manifest from the current group of the given
+		 * settings, returning an empty optional if there is no
+		 * manifest or it is outdated with respect to the given file.
+		 */
+		static boost::optional<PluginManifest> Load (QSettings&, const QFileInfo&);
+
+		void Save (QSettings&) const;
+
+		bool operator== (const PluginManifest&) const;
+		bool operator!= (const PluginManifest&) const;
+	};
+
+	/** Returns the paths of the plugins from the given path → manifest
+	 * map that would not survive the PluginTreeBuilder calculation
+	 * anyway: those needing features nobody provides and second-level
+	 * plugins with no first-level plugin expecting them.
+	 *
+	 * The core instance object is always assumed to be present. The
+	 * check is transitive: a plugin that only depends on the features
+	 * of unusable plugins is unusable too. Adaptor plugins are never
+	 * considered unusable.
+	 */
+	QStringList FindUnusablePlugins (QHash<QString, PluginManifest> manifests, QObject *coreInstance);
+}
@@ -182,6 +182,7 @@ namespace LeechCraft
 		Graph_.clear ();
 		Object2Vertex_.clear ();
 		Result_.clear ();
+		Dependencies_.clear ();
 
 		CreateGraph ();
 		const auto& edge2vert = MakeEdges ();
@@ -211,7 +212,15 @@ namespace LeechCraft
 		QList<Vertex_t> vertices;
 		boost::topological_sort (fulfilledSubgraph, std::back_inserter (vertices));
 		for (const auto& vertex : vertices)
-			Result_ << fulfilledSubgraph [vertex].Object_;
+		{
+			const auto object = fulfilledSubgraph [vertex].Object_;
+			Result_ << object;
+
+			auto& deps = Dependencies_ [object];
+			OutEdgeIterator_t ei, ei_end;
+			for (boost::tie (ei, ei_end) = boost::out_edges (vertex, Graph_); ei != ei_end; ++ei)
+				deps << Graph_ [boost::target (*ei, Graph_)].Object_;
+		}
 	}
 
 	QObjectList PluginTreeBuilder::GetResult () const
@@ -219,6 +228,11 @@ namespace LeechCraft
 		return Result_;
 	}
 
+	QHash<QObject*, QObjectList> PluginTreeBuilder::GetDependencies () const
+	{
+		return Dependencies_;
+	}
+
 	void PluginTreeBuilder::CreateGraph ()
 	{
 		for (const auto object : Instances_)
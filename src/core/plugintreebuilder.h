@@ -80,6 +80,7 @@ namespace LeechCraft
 
 		QHash<QObject*, Vertex_t> Object2Vertex_;
 		QObjectList Result_;
+		QHash<QObject*, QObjectList> Dependencies_;
 	public:
 		PluginTreeBuilder ();
 
@@ -87,6 +88,12 @@ namespace LeechCraft
 		void RemoveObject (QObject*);
 		void Calculate ();
 		QObjectList GetResult () const;
+
+		/** Returns the plugins each plugin from GetResult() directly
+		 * depends on, that is, the plugins that should be initialized
+		 * before it.
+		 */
+		QHash<QObject*, QObjectList> GetDependencies () const;
 	private:
 		void CreateGraph ();
 		QMap<Edge_t, QPair<Vertex_t, Vertex_t>> MakeEdges ();
@@ -0,0 +1,183 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "startuptrace.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+	StartupTrace::StartupTrace ()
+	{
+		Timer_.start ();
+	}
+
+	std::shared_ptr<void> StartupTrace::Measure (Stage stage, const QString& name)
+	{
+		const auto start = Timer_.elapsed ();
+		return std::shared_ptr<void> (nullptr,
+				[this, stage, name, start] (void*) { Record (stage, name, start, Timer_.elapsed ()); });
+	}
+
+	void StartupTrace::SetInitDependencies (const QString& name, const QStringList& deps)
+	{
+		QMutexLocker locker { &Mutex_ };
+		InitDeps_ [name] = deps;
+	}
+
+	void StartupTrace::Record (Stage stage, const QString& name, qint64 start, qint64 end)
+	{
+		QMutexLocker locker { &Mutex_ };
+		Stage2Spans_ [static_cast<int> (stage)] [name] = { start, end };
+	}
+
+	namespace
+	{
+		QString GetStageName (StartupTrace::Stage stage)
+		{
+			switch (stage)
+			{
+			case StartupTrace::Stage::Load:
+				return "load";
+			case StartupTrace::Stage::Init:
+				return "Init()";
+			case StartupTrace::Stage::SecondInit:
+				return "SecondInit()";
+			}
+
+			return {};
+		}
+	}
+
+	void StartupTrace::Report () const
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		const int slowestCount = 10;
+
+		for (auto stage : { Stage::Load, Stage::Init, Stage::SecondInit })
+		{
+			const auto& spans = Stage2Spans_.value (static_cast<int> (stage));
+			if (spans.isEmpty ())
+				continue;
+
+			qint64 sum = 0;
+			qint64 begin = std::numeric_limits<qint64>::max ();
+			qint64 end = 0;
+			QList<QPair<qint64, QString>> durations;
+			for (auto i = spans.begin (); i != spans.end (); ++i)
+			{
+				const auto duration = i->End_ - i->Start_;
+				sum += duration;
+				begin = std::min (begin, i->Start_);
+				end = std::max (end, i->End_);
+				durations.append ({ duration, i.key () });
+			}
+			std::sort (durations.begin (), durations.end (),
+					[] (const QPair<qint64, QString>& l, const QPair<qint64, QString>& r)
+						{ return l.first > r.first; });
+
+			qDebug () << "startup trace:"
+					<< GetStageName (stage)
+					<< "of"
+					<< spans.size ()
+					<< "plugins took"
+					<< end - begin
+					<< "ms, sum of durations is"
+					<< sum
+					<< "ms; slowest:";
+			for (const auto& pair : durations.mid (0, slowestCount))
+				qDebug () << "\t" << pair.second << pair.first << "ms";
+		}
+
+		// The critical path of the Init() stage: the longest chain of
+		// plugins each waiting for the previous one to get initialized,
+		// that is, the bound on Init() time if independent plugins were
+		// initialized concurrently.
+		const auto& initSpans = Stage2Spans_.value (static_cast<int> (Stage::Init));
+		QHash<QString, QPair<qint64, QString>> pathEnds;
+		std::function<qint64 (const QString&)> pathLength = [&] (const QString& name) -> qint64
+		{
+			if (pathEnds.contains (name))
+				return pathEnds [name].first;
+
+			pathEnds [name] = { 0, {} };
+
+			qint64 longest = 0;
+			QString prev;
+			for (const auto& dep : InitDeps_.value (name))
+			{
+				if (!initSpans.contains (dep))
+					continue;
+
+				const auto length = pathLength (dep);
+				if (length > longest)
+				{
+					longest = length;
+					prev = dep;
+				}
+			}
+
+			const auto& span = initSpans.value (name);
+			pathEnds [name] = { longest + span.End_ - span.Start_, prev };
+			return pathEnds [name].first;
+		};
+
+		QString last;
+		qint64 criticalLength = -1;
+		for (auto i = initSpans.begin (); i != initSpans.end (); ++i)
+		{
+			const auto length = pathLength (i.key ());
+			if (length > criticalLength)
+			{
+				criticalLength = length;
+				last = i.key ();
+			}
+		}
+
+		if (last.isEmpty ())
+			return;
+
+		QStringList path;
+		for (auto name = last; !name.isEmpty (); name = pathEnds [name].second)
+		{
+			const auto& span = initSpans.value (name);
+			path.prepend (QString ("%1 (%2 ms)")
+					.arg (name)
+					.arg (span.End_ - span.Start_));
+		}
+
+		qDebug () << "startup trace: Init() critical path takes"
+				<< criticalLength
+				<< "ms:"
+				<< path.join (" -> ");
+	}
+}
@@ -0,0 +1,83 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QHash>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QStringList>
+
+namespace LeechCraft
+{
+	/** Collects the durations of loading and initializing the plugins
+	 * during the startup and reports them once the startup is finished.
+	 *
+	 * All the methods are thread-safe.
+	 */
+	class StartupTrace
+	{
+	public:
+		enum class Stage
+		{
+			Load,
+			Init,
+			SecondInit
+		};
+	private:
+		struct Span
+		{
+			qint64 Start_;
+			qint64 End_;
+		};
+
+		mutable QMutex Mutex_;
+		QElapsedTimer Timer_;
+
+		QHash<int, QHash<QString, Span>> Stage2Spans_;
+		QHash<QString, QStringList> InitDeps_;
+	public:
+		StartupTrace ();
+
+		/** Starts measuring the given stage for the given plugin. The
+		 * measurement ends once the returned guard is destroyed.
+		 */
+		std::shared_ptr<void> Measure (Stage, const QString& name);
+
+		/** Sets the plugins the Init() of the given plugin has waited
+		 * for, used to find the critical path.
+		 */
+		void SetInitDependencies (const QString& name, const QStringList& deps);
+
+		void Report () const;
+	private:
+		void Record (Stage, const QString&, qint64, qint64);
+	};
+}
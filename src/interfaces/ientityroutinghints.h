@@ -0,0 +1,88 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QStringList>
+#include <QtPlugin>
+
+/** @brief Describes the entities a plugin could possibly handle.
+ *
+ * An entity matches these keys if it matches any of them.
+ *
+ * @sa IEntityRoutingHints
+ */
+struct EntityRoutingKeys
+{
+	/** @brief Exact values of Entity::Mime_.
+	 */
+	QStringList Mimes_;
+
+	/** @brief Prefixes of Entity::Mime_.
+	 *
+	 * For example, "x-leechcraft/notification" matches both
+	 * "x-leechcraft/notification" and "x-leechcraft/notification+advanced".
+	 */
+	QStringList MimePrefixes_;
+
+	/** @brief URL schemes of Entity::Entity_.
+	 *
+	 * Only entities whose Entity_ is a QUrl are matched against these
+	 * schemes. Local files have the "file" scheme.
+	 */
+	QStringList Schemes_;
+};
+
+/** @brief Interface for entity handlers declaring what they handle.
+ *
+ * By default, IDownload::CouldDownload() and
+ * IEntityHandler::CouldHandle() of every plugin are called for every
+ * entity the core routes. A plugin implementing this interface
+ * promises that its CouldDownload() and CouldHandle() would reject any
+ * entity not matching the keys returned from GetEntityRoutingKeys(),
+ * so the core may skip calling them for such entities altogether.
+ *
+ * The keys are queried once, so they should not depend on the plugin
+ * settings or other state that may change at runtime.
+ *
+ * @sa IEntityHandler, IDownload
+ */
+class Q_DECL_EXPORT IEntityRoutingHints
+{
+public:
+	virtual ~IEntityRoutingHints () {}
+
+	/** @brief Returns the keys of the entities this plugin handles.
+	 *
+	 * @return The routing keys of this plugin.
+	 */
+	virtual EntityRoutingKeys GetEntityRoutingKeys () const = 0;
+};
+
+Q_DECLARE_INTERFACE (IEntityRoutingHints, "org.Deviant.LeechCraft.IEntityRoutingHints/1.0");
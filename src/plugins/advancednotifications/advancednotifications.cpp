@@ -135,6 +135,11 @@ namespace AdvancedNotifications
 		GeneralHandler_->Handle (e);
 	}
 
+	EntityRoutingKeys Plugin::GetEntityRoutingKeys () const
+	{
+		return { {}, { "x-leechcraft/notification" } };
+	}
+
 	Util::XmlSettingsDialog_ptr Plugin::GetSettingsDialog () const
 	{
 		return SettingsDialog_;
@@ -37,7 +37,9 @@
 #include <QUrl>
 #include <QTimer>
 #include <QTextCodec>
+#include <QFileInfo>
 #include <QXmlStreamWriter>
+#include <QtConcurrentRun>
 #include <QNetworkReply>
 #include <interfaces/iwebbrowser.h>
 #include <interfaces/core/icoreproxy.h>
@@ -49,6 +51,7 @@
 #include <util/sys/paths.h>
 #include <util/xpc/defaulthookproxy.h>
 #include <util/shortcuts/shortcutmanager.h>
+#include <util/sll/futures.h>
 #include "core.h"
 #include "regexpmatchermanager.h"
 #include "xmlsettingsmanager.h"
@@ -87,6 +90,7 @@ namespace Aggregator
 	, ReprWidget_ (0)
 	, PluginManager_ (nullptr)
 	, DBUpThread_ (new DBUpdateThread (this))
+	, LastSearchID_ (0)
 	, ShortcutMgr_ (nullptr)
 	{
 		qRegisterMetaType<IDType_t> ("IDType_t");
@@ -97,6 +101,7 @@ namespace Aggregator
 		qRegisterMetaType<ChannelShort> ("ChannelShort");
 		qRegisterMetaType<Channel_ptr> ("Channel_ptr");
 		qRegisterMetaType<channels_container_t> ("channels_container_t");
+		qRegisterMetaType<ItemSearchResults_t> ("ItemSearchResults_t");
 		qRegisterMetaTypeStreamOperators<Feed> ("LeechCraft::Plugins::Aggregator::Feed");
 	}
 
@@ -111,6 +116,10 @@ namespace Aggregator
 		if (DBUpThread_->isRunning ())
 			DBUpThread_->quit ();
 
+		for (auto& future : ParseFutures_)
+			future.waitForFinished ();
+		ParseFutures_.clear ();
+
 		delete JobHolderRepresentation_;
 		delete ChannelsFilterModel_;
 		delete ChannelsModel_;
@@ -142,7 +151,7 @@ namespace Aggregator
 
 	Util::IDPool<IDType_t>& Core::GetPool (PoolType type)
 	{
-		return Pools_ [type];
+		return Pools_ [static_cast<std::size_t> (type)];
 	}
 
 	bool Core::CouldHandle (const LeechCraft::Entity& e)
@@ -402,7 +411,16 @@ namespace Aggregator
 
 	bool Core::ReinitStorage ()
 	{
-		Pools_.clear ();
+		// The parsers allocate IDs from the pools in other threads, so
+		// they should be done before the pools are reset, and whatever
+		// they've parsed is not for the new storage anyway.
+		for (auto& future : ParseFutures_)
+			future.waitForFinished ();
+		ParseFutures_.clear ();
+		++StorageGeneration_;
+
+		for (auto& pool : Pools_)
+			pool.SetID (0);
 		ChannelsModel_->Clear ();
 
 		StorageBackend_.reset (new DumbStorage);
@@ -471,11 +489,7 @@ namespace Aggregator
 		}
 
 		for (int type = 0; type < PTMAX; ++type)
-		{
-			Util::IDPool<IDType_t> pool;
-			pool.SetID (StorageBackend_->GetHighestID (static_cast<PoolType> (type)) + 1);
-			Pools_ [static_cast<PoolType> (type)] = pool;
-		}
+			Pools_ [type].SetID (StorageBackend_->GetHighestID (static_cast<PoolType> (type)) + 1);
 
 		return true;
 	}
@@ -1118,78 +1132,157 @@ namespace Aggregator
 		PendingJobs_.remove (id);
 		ID2Downloader_.remove (id);
 
-		Util::FileRemoveGuard file (pj.Filename_);
-		if (!file.open (QIODevice::ReadOnly))
+		if (pj.Role_ == PendingJob::RFeedExternalData)
+		{
+			Util::FileRemoveGuard file (pj.Filename_);
+			if (!file.open (QIODevice::ReadOnly))
+			{
+				qWarning () << Q_FUNC_INFO << "could not open file for pj " << pj.Filename_;
+				return;
+			}
+			if (!file.size ())
+				return;
+
+			HandleExternalData (pj.URL_, file);
+			UpdateUnreadItemsNumber ();
+			scheduleSave ();
+			return;
+		}
+
+		const QFileInfo fileInfo (pj.Filename_);
+		if (!fileInfo.exists ())
 		{
 			qWarning () << Q_FUNC_INFO << "could not open file for pj " << pj.Filename_;
 			return;
 		}
-		if (!file.size ())
+		if (!fileInfo.size ())
 		{
-			if (pj.Role_ != PendingJob::RFeedExternalData)
-				ErrorNotification (tr ("Feed error"),
-						tr ("Downloaded file from url %1 has null size.").arg (pj.URL_));
+			QFile::remove (pj.Filename_);
+			ErrorNotification (tr ("Feed error"),
+					tr ("Downloaded file from url %1 has null size.").arg (pj.URL_));
 			return;
 		}
 
-		channels_container_t channels;
-		if (pj.Role_ != PendingJob::RFeedExternalData)
+		// Parsing big feeds is costly, so it's done in the thread pool,
+		// and only the storage-related part is done in the main thread.
+		const auto& future = QtConcurrent::run (&Core::ParseFeedFile, pj.Filename_, pj.URL_);
+
+		ParseFutures_.erase (std::remove_if (ParseFutures_.begin (), ParseFutures_.end (),
+					[] (const QFuture<FeedParseResult>& f) { return f.isFinished (); }),
+				ParseFutures_.end ());
+		ParseFutures_ << future;
+
+		const auto generation = StorageGeneration_;
+		Util::ExecuteFuture ([future] { return future; },
+				[this, pj, generation] (const FeedParseResult& result)
+				{
+					if (generation == StorageGeneration_)
+						HandleFeedParsed (result, pj);
+					else
+						QFile::remove (pj.Filename_);
+				},
+				this);
+	}
+
+	namespace
+	{
+		/** Keeps a copy of a feed that failed to parse for debugging.
+		 *
+		 * Several feeds may fail in parallel, so the copy is named after
+		 * the (unique) downloaded file.
+		 */
+		void SaveFailedFile (QFile& file)
 		{
-			QByteArray data = file.readAll ();
-			QDomDocument doc;
-			QString errorMsg;
-			int errorLine, errorColumn;
-			if (!doc.setContent (data, true, &errorMsg, &errorLine, &errorColumn))
-			{
-				file.copy (QDir::tempPath () + "/failedFile.xml");
-				ErrorNotification (tr ("Feed error"),
-						tr ("XML file parse error: %1, line %2, column %3, filename %4, from %5")
-						.arg (errorMsg)
-						.arg (errorLine)
-						.arg (errorColumn)
-						.arg (pj.Filename_)
-						.arg (pj.URL_));
-				return;
-			}
+			const auto& name = QString ("%1/failedFile-%2.xml")
+					.arg (QDir::tempPath ())
+					.arg (QFileInfo (file.fileName ()).fileName ());
+			QFile::remove (name);
+			file.copy (name);
+		}
+	}
 
-			Parser *parser = ParserFactory::Instance ().Return (doc);
-			if (!parser)
-			{
-				file.copy (QDir::tempPath () + "/failedFile.xml");
-				ErrorNotification (tr ("Feed error"),
-						tr ("Could not find parser to parse file %1 from %2")
-						.arg (pj.Filename_)
-						.arg (pj.URL_));
-				return;
-			}
+	Core::FeedParseResult Core::ParseFeedFile (const QString& filename, const QString& url)
+	{
+		FeedParseResult result;
 
-			IDType_t feedId = IDNotFound;
-			if (pj.Role_ == PendingJob::RFeedAdded)
-			{
-				const auto& feed = std::make_shared<Feed> ();
-				feed->URL_ = pj.URL_;
-				StorageBackend_->AddFeed (feed);
-				feedId = feed->FeedID_;
-			}
-			else
-				feedId = StorageBackend_->FindFeed (pj.URL_);
+		QFile file (filename);
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			result.Error_ = tr ("Could not open downloaded file %1 from %2.")
+					.arg (filename)
+					.arg (url);
+			return result;
+		}
 
-			if (feedId == IDNotFound)
-			{
-				ErrorNotification (tr ("Feed error"),
-						tr ("Feed with url %1 not found.").arg (pj.URL_));
-				return;
-			}
+		QDomDocument doc;
+		QString errorMsg;
+		int errorLine, errorColumn;
+		if (!doc.setContent (&file, true, &errorMsg, &errorLine, &errorColumn))
+		{
+			SaveFailedFile (file);
+			result.Error_ = tr ("XML file parse error: %1, line %2, column %3, filename %4, from %5")
+					.arg (errorMsg)
+					.arg (errorLine)
+					.arg (errorColumn)
+					.arg (filename)
+					.arg (url);
+			return result;
+		}
+
+		const auto parser = ParserFactory::Instance ().Return (doc);
+		if (!parser)
+		{
+			SaveFailedFile (file);
+			result.Error_ = tr ("Could not find parser to parse file %1 from %2")
+					.arg (filename)
+					.arg (url);
+			return result;
+		}
+
+		result.Channels_ = parser->ParseFeed (doc, IDNotFound);
+		result.Parsed_ = true;
+		return result;
+	}
+
+	void Core::HandleFeedParsed (const FeedParseResult& result, const PendingJob& pj)
+	{
+		QFile::remove (pj.Filename_);
+
+		if (!StorageBackend_)
+			return;
+
+		if (!result.Parsed_)
+		{
+			ErrorNotification (tr ("Feed error"), result.Error_);
+			return;
+		}
+
+		IDType_t feedId = IDNotFound;
+		if (pj.Role_ == PendingJob::RFeedAdded)
+		{
+			const auto& feed = std::make_shared<Feed> ();
+			feed->URL_ = pj.URL_;
+			StorageBackend_->AddFeed (feed);
+			feedId = feed->FeedID_;
+		}
+		else
+			feedId = StorageBackend_->FindFeed (pj.URL_);
 
-			channels = parser->ParseFeed (doc, feedId);
+		if (feedId == IDNotFound)
+		{
+			ErrorNotification (tr ("Feed error"),
+					tr ("Feed with url %1 not found.").arg (pj.URL_));
+			return;
 		}
 
+		const auto& channels = result.Channels_;
+		for (const auto& channel : channels)
+			channel->FeedID_ = feedId;
+
 		if (pj.Role_ == PendingJob::RFeedAdded)
 			HandleFeedAdded (channels, pj);
 		else if (pj.Role_ == PendingJob::RFeedUpdated)
 			HandleFeedUpdated (channels, pj);
-		else if (pj.Role_ == PendingJob::RFeedExternalData)
-			HandleExternalData (pj.URL_, file);
 		UpdateUnreadItemsNumber ();
 		scheduleSave ();
 	}
@@ -1476,6 +1569,11 @@ namespace Aggregator
 				SIGNAL (hookGotNewItems (LeechCraft::IHookProxy_ptr, QVariantList)),
 				this,
 				SIGNAL (hookGotNewItems (LeechCraft::IHookProxy_ptr, QVariantList)));
+		connect (DBUpThread_->GetWorker (),
+				SIGNAL (gotSearchResults (quint64, ItemSearchResults_t)),
+				this,
+				SIGNAL (gotItemsSearchResults (quint64, ItemSearchResults_t)),
+				Qt::QueuedConnection);
 	}
 
 	void Core::handleDBUpGotNewChannel (const ChannelShort& chSh)
@@ -1619,6 +1717,28 @@ namespace Aggregator
 				Q_ARG (QString, pj.URL_));
 	}
 
+	quint64 Core::SearchItems (const QString& text, int limit)
+	{
+		const auto searchId = ++LastSearchID_;
+
+		// The caller gets to know the ID before the results arrive in any case.
+		if (!DBUpThread_->GetWorker ())
+			QMetaObject::invokeMethod (this,
+					"gotItemsSearchResults",
+					Qt::QueuedConnection,
+					Q_ARG (quint64, searchId),
+					Q_ARG (ItemSearchResults_t, {}));
+		else
+			QMetaObject::invokeMethod (DBUpThread_->GetWorker (),
+					"searchItems",
+					Qt::QueuedConnection,
+					Q_ARG (quint64, searchId),
+					Q_ARG (QString, text),
+					Q_ARG (int, limit));
+
+		return searchId;
+	}
+
 	void Core::MarkChannel (const QModelIndex& i, bool state)
 	{
 		try
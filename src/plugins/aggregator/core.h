@@ -30,12 +30,14 @@
 #ifndef PLUGINS_AGGREGATOR_CORE_H
 #define PLUGINS_AGGREGATOR_CORE_H
 #include <memory>
+#include <array>
 #include <QAbstractItemModel>
 #include <QString>
 #include <QMap>
 #include <QPair>
 #include <QList>
 #include <QDateTime>
+#include <QFuture>
 #include <interfaces/idownload.h>
 #include <interfaces/core/icoreproxy.h>
 #include <interfaces/core/ihookproxy.h>
@@ -111,6 +113,20 @@ namespace Aggregator
 			Feed_ptr RelatedFeed_;
 		};
 		QMap<int, PendingJob> PendingJobs_;
+
+		struct FeedParseResult
+		{
+			bool Parsed_ = false;
+			QString Error_;
+			channels_container_t Channels_;
+		};
+		QList<QFuture<FeedParseResult>> ParseFutures_;
+
+		/** Incremented each time the storage is reinitialized, so that
+		 * the feeds parsed for the previous storage are dropped.
+		 */
+		int StorageGeneration_ = 0;
+
 		QMap<QString, ExternalData> PendingJob2ExternalData_;
 		QList<QObject*> Downloaders_;
 		QMap<int, QObject*> ID2Downloader_;
@@ -132,12 +148,16 @@ namespace Aggregator
 		PluginManager *PluginManager_;
 
 		DBUpdateThread *DBUpThread_;
+		quint64 LastSearchID_;
 
 		Util::ShortcutManager *ShortcutMgr_;
 
 		Core ();
 	private:
-		QHash<PoolType, Util::IDPool<IDType_t>> Pools_;
+		/** Filled once on storage init, so that the parser threads can
+		 * get IDs without mutating any container.
+		 */
+		std::array<Util::IDPool<IDType_t>, PTMAX> Pools_;
 	public:
 		struct ChannelInfo
 		{
@@ -229,6 +249,14 @@ namespace Aggregator
 				const std::vector<bool>&) const;
 		JobHolderRepresentation* GetJobHolderRepresentation () const;
 		StorageBackend* GetStorageBackend () const;
+
+		/** @brief Runs a full-text search in the DB update thread.
+		 *
+		 * The results are delivered via gotItemsSearchResults() along
+		 * with the ID returned by this function, which is unique among
+		 * all the searches requested so far.
+		 */
+		quint64 SearchItems (const QString& text, int limit);
 		void GetChannels (channels_shorts_t&) const;
 		void AddFeeds (const feeds_container_t&, const QString&);
 		void SetContextMenu (QMenu*);
@@ -256,6 +284,8 @@ namespace Aggregator
 		void FetchPixmap (const Channel_ptr&);
 		void FetchFavicon (const Channel_ptr&);
 		void HandleExternalData (const QString&, const QFile&);
+		static FeedParseResult ParseFeedFile (const QString&, const QString&);
+		void HandleFeedParsed (const FeedParseResult&, const PendingJob&);
 		void HandleFeedAdded (const channels_container_t&,
 				const PendingJob&);
 		void HandleFeedUpdated (const channels_container_t&,
@@ -269,6 +299,7 @@ namespace Aggregator
 		void delegateEntity (const LeechCraft::Entity&, int*, QObject**);
 		void gotEntity (const LeechCraft::Entity&);
 		void channelRemoved (IDType_t);
+		void gotItemsSearchResults (quint64 searchId, const ItemSearchResults_t& results);
 
 		void storageChanged ();
 
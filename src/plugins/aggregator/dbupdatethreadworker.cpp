@@ -31,7 +31,10 @@
 #include <stdexcept>
 #include <boost/optional.hpp>
 #include <QUrl>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QtDebug>
+#include <util/db/dblock.h>
 #include <util/xpc/util.h>
 #include <util/xpc/defaulthookproxy.h>
 #include "xmlsettingsmanager.h"
@@ -46,6 +49,8 @@ namespace Aggregator
 {
 	DBUpdateThreadWorker::DBUpdateThreadWorker (QObject *parent)
 	: QObject (parent)
+	, TotalRows_ (0)
+	, TotalMSecs_ (0)
 	{
 		try
 		{
@@ -117,7 +122,6 @@ namespace Aggregator
 		channel->Items_.resize (truncateAt);
 
 		SB_->AddChannel (channel);
-		emit gotNewChannel (channel->ToShort ());
 
 		QString str = tr ("Added channel \"%1\" (%n item(s))",
 				"", channel->Items_.size ())
@@ -227,18 +231,67 @@ namespace Aggregator
 		SB_->ToggleChannelUnread (channel, state);
 	}
 
+	void DBUpdateThreadWorker::searchItems (quint64 searchId, const QString& text, int limit)
+	{
+		ItemSearchResults_t results;
+		if (SB_)
+			results = SB_->SearchItems (text, limit);
+		emit gotSearchResults (searchId, results);
+	}
+
 	namespace
 	{
-		// TODO CPP14 merge with plusadic
-		template<typename T, template<typename, typename...> class List = std::initializer_list>
-		boost::optional<T> GetFirst (const List<std::function<boost::optional<T> ()>>& producers)
+		/** Mimics the FindItem(), FindItemByLink() and FindItemByTitle()
+		 * lookup chain of StorageBackend for the items of a single
+		 * channel without querying the storage for each incoming item.
+		 */
+		class ItemsIndex
 		{
-			for (const auto& prod : producers)
-					if (const auto& res = prod ())
-							return res;
+			QHash<QPair<QString, QString>, IDType_t> ByTitleLink_;
+			QHash<QString, IDType_t> ByLink_;
+			QHash<QString, IDType_t> ByTitle_;
+		public:
+			ItemsIndex (const items_shorts_t& items)
+			{
+				ByTitleLink_.reserve (items.size ());
+				ByLink_.reserve (items.size ());
+				ByTitle_.reserve (items.size ());
 
-			return {};
-		}
+				for (const auto& item : items)
+					Add (item.Title_, item.URL_, item.ItemID_);
+			}
+
+			void Add (const QString& title, const QString& link, IDType_t id)
+			{
+				const QPair<QString, QString> titleLink { title, link };
+				if (!ByTitleLink_.contains (titleLink))
+					ByTitleLink_ [titleLink] = id;
+				if (!link.isEmpty () && !ByLink_.contains (link))
+					ByLink_ [link] = id;
+				if (!ByTitle_.contains (title))
+					ByTitle_ [title] = id;
+			}
+
+			boost::optional<IDType_t> Find (const QString& title, const QString& link) const
+			{
+				const auto titleLinkPos = ByTitleLink_.find ({ title, link });
+				if (titleLinkPos != ByTitleLink_.end ())
+					return *titleLinkPos;
+
+				if (!link.isEmpty ())
+				{
+					const auto linkPos = ByLink_.find (link);
+					if (linkPos != ByLink_.end ())
+						return *linkPos;
+				}
+
+				const auto titlePos = ByTitle_.find (title);
+				if (titlePos != ByTitle_.end ())
+					return *titlePos;
+
+				return {};
+			}
+		};
 	}
 
 	void DBUpdateThreadWorker::updateFeed (channels_container_t channels, QString url)
@@ -253,10 +306,28 @@ namespace Aggregator
 			return;
 		}
 
+		QElapsedTimer timer;
+		timer.start ();
+
+		std::shared_ptr<Util::DBLock> lock;
+		try
+		{
+			lock = SB_->BeginTransaction ();
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to start transaction, continuing without it:"
+					<< e.what ();
+		}
+
 		const auto& feedSettings = GetFeedSettings (feedId);
 		const auto ipc = feedSettings.NumItems_;
 		const auto days = feedSettings.ItemAge_;
 
+		QList<ChannelShort> newChannels;
+		int totalRows = 0;
+
 		for (const auto& channel : channels)
 		{
 			Channel_ptr ourChannel;
@@ -269,34 +340,64 @@ namespace Aggregator
 			catch (const StorageBackend::ChannelNotFoundError&)
 			{
 				AddChannel (channel, feedSettings);
+				newChannels << channel->ToShort ();
+				totalRows += channel->Items_.size () + 1;
 				continue;
 			}
 
 			const auto& channelPart = GetItemMapChannelPart (ourChannel);
 
+			items_shorts_t existing;
+			SB_->GetItems (existing, ourChannel->ChannelID_);
+			ItemsIndex index { existing };
+
 			int newItems = 0;
 			int updatedItems = 0;
 
 			for (const auto& item : channel->Items_)
 			{
-				if (const auto& ourItemID = GetFirst<IDType_t> ({
-							[&] { return SB_->FindItem (item->Title_, item->Link_, ourChannel->ChannelID_); },
-							[&] { return SB_->FindItemByLink (item->Link_, ourChannel->ChannelID_); },
-							[&] { return SB_->FindItemByTitle (item->Title_, ourChannel->ChannelID_); }
-						}))
+				if (const auto& ourItemID = index.Find (item->Title_, item->Link_))
 				{
 					const auto& ourItem = SB_->GetItem (*ourItemID);
 					if (UpdateItem (item, ourItem))
 						++updatedItems;
 				}
 				else if (AddItem (item, ourChannel, channelPart, feedSettings))
+				{
+					index.Add (item->Title_, item->Link_, item->ItemID_);
 					++newItems;
+				}
 			}
 
 			SB_->TrimChannel (ourChannel->ChannelID_, days, ipc);
 
 			NotifyUpdates (newItems, updatedItems, channel);
+
+			totalRows += newItems + updatedItems;
 		}
+
+		if (lock)
+		{
+			lock->Good ();
+			lock.reset ();
+		}
+
+		for (const auto& channel : newChannels)
+			emit gotNewChannel (channel);
+
+		const auto msecs = std::max<qint64> (timer.elapsed (), 1);
+		TotalRows_ += totalRows;
+		TotalMSecs_ += msecs;
+		qDebug () << Q_FUNC_INFO
+				<< url
+				<< totalRows
+				<< "rows in"
+				<< msecs
+				<< "ms;"
+				<< totalRows * 1000 / msecs
+				<< "rows/sec, overall"
+				<< TotalRows_ * 1000 / std::max<qint64> (TotalMSecs_, 1)
+				<< "rows/sec";
 	}
 }
 }
@@ -36,6 +36,7 @@
 #include "common.h"
 #include "channel.h"
 #include "feed.h"
+#include "storagebackend.h"
 
 namespace LeechCraft
 {
@@ -43,13 +44,14 @@ struct Entity;
 
 namespace Aggregator
 {
-	class StorageBackend;
-
 	class DBUpdateThreadWorker : public QObject
 	{
 		Q_OBJECT
 
 		std::shared_ptr<StorageBackend> SB_;
+
+		qint64 TotalRows_;
+		qint64 TotalMSecs_;
 	public:
 		DBUpdateThreadWorker (QObject* = 0);
 	private:
@@ -62,8 +64,10 @@ namespace Aggregator
 	public slots:
 		void toggleChannelUnread (IDType_t channel, bool state);
 		void updateFeed (channels_container_t channels, QString url);
+		void searchItems (quint64 searchId, const QString& text, int limit);
 	signals:
 		void gotNewChannel (const ChannelShort&);
+		void gotSearchResults (quint64 searchId, const ItemSearchResults_t& results);
 		void gotEntity (const LeechCraft::Entity&);
 
 		void hookGotNewItems (LeechCraft::IHookProxy_ptr proxy,
@@ -125,6 +125,7 @@ namespace Aggregator
 		CurrentChannel_ = channel;
 		CurrentRow_ = -1;
 		CurrentItems_.clear ();
+		Snippets_.clear ();
 		if (channel != static_cast<IDType_t> (-1))
 			Core::Instance ().GetStorageBackend ()->GetItems (CurrentItems_, channel);
 
@@ -138,6 +139,7 @@ namespace Aggregator
 		CurrentChannel_ = -1;
 		CurrentRow_ = -1;
 		CurrentItems_.clear ();
+		Snippets_.clear ();
 
 		StorageBackend *sb = Core::Instance ().GetStorageBackend ();
 		for (const IDType_t& itemId : items)
@@ -146,6 +148,11 @@ namespace Aggregator
 		endResetModel ();
 	}
 
+	void ItemsListModel::SetSnippets (const QHash<IDType_t, QString>& snippets)
+	{
+		Snippets_ = snippets;
+	}
+
 	void ItemsListModel::RemoveItems (const QSet<IDType_t>& ids)
 	{
 		if (ids.isEmpty ())
@@ -347,6 +354,9 @@ namespace Aggregator
 			}
 			result += "<br />";
 
+			if (Snippets_.contains (id))
+				return result + Snippets_ [id];
+
 			const int maxDescriptionSize = 1000;
 			auto descr = item->Description_;
 			RemoveTag ("img", descr);
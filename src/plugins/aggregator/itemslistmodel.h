@@ -32,6 +32,7 @@
 #include <QAbstractItemModel>
 #include <QStringList>
 #include <QSet>
+#include <QHash>
 #include <QPair>
 #include <QIcon>
 #include "interfaces/aggregator/iitemsmodel.h"
@@ -53,6 +54,8 @@ namespace Aggregator
 		int CurrentRow_;
 		IDType_t CurrentChannel_;
 
+		QHash<IDType_t, QString> Snippets_;
+
 		const QIcon StarredIcon_;
 		const QIcon UnreadIcon_;
 		const QIcon ReadIcon_;
@@ -69,6 +72,7 @@ namespace Aggregator
 		QStringList GetCategories (int) const;
 		void Reset (const IDType_t&);
 		void Reset (const QList<IDType_t>&);
+		void SetSnippets (const QHash<IDType_t, QString>&);
 		void RemoveItems (const QSet<IDType_t>&);
 		void ItemDataUpdated (Item_ptr);
 
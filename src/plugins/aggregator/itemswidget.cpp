@@ -98,8 +98,15 @@ namespace Aggregator
 		QTimer *SelectedChecker_;
 		QModelIndex LastSelectedIndex_;
 		QModelIndex LastSelectedChannel_;
+
+		quint64 PendingSearchID_;
 	};
 
+	namespace
+	{
+		const int FullTextSearchSection = 5;
+	}
+
 	ItemsWidget::ItemsWidget (QWidget *parent)
 	: QWidget (parent)
 	, Impl_ (new ItemsWidget_Impl)
@@ -117,6 +124,7 @@ namespace Aggregator
 		Impl_->TapeMode_ = XmlSettingsManager::Instance ()->
 				Property ("ShowAsTape", false).toBool ();
 		Impl_->MergeMode_ = false;
+		Impl_->PendingSearchID_ = 0;
 		Impl_->ControlToolBar_ = SetupToolBar ();
 
 		Impl_->CurrentItemsModel_.reset (new ItemsListModel);
@@ -161,6 +169,10 @@ namespace Aggregator
 				Impl_->ActionNextUnreadItem_
 			});
 
+		const auto sb = Core::Instance ().GetStorageBackend ();
+		if (!sb || !sb->SupportsFullTextSearch ())
+			Impl_->Ui_.SearchType_->removeItem (FullTextSearchSection);
+
 		connect (Impl_->Ui_.SearchLine_,
 				SIGNAL (textChanged (const QString&)),
 				this,
@@ -169,6 +181,10 @@ namespace Aggregator
 				SIGNAL (currentIndexChanged (int)),
 				this,
 				SLOT (updateItemsFilter ()));
+		connect (&Core::Instance (),
+				SIGNAL (gotItemsSearchResults (quint64, ItemSearchResults_t)),
+				this,
+				SLOT (handleItemsSearchResults (quint64, ItemSearchResults_t)));
 
 		new Util::ClearLineEditAddon (Core::Instance ().GetProxy (), Impl_->Ui_.SearchLine_);
 
@@ -1496,15 +1512,34 @@ namespace Aggregator
 	void ItemsWidget::updateItemsFilter ()
 	{
 		const int section = Impl_->Ui_.SearchType_->currentIndex ();
+		const QString& text = Impl_->Ui_.SearchLine_->text ();
+
+		if (section != FullTextSearchSection)
+		{
+			// Drop the results of a full-text search that may still be running.
+			Impl_->PendingSearchID_ = 0;
+			if (!Impl_->Ui_.Items_->isSortingEnabled ())
+				Impl_->Ui_.Items_->setSortingEnabled (true);
+		}
+
 		if (section == 4)
 		{
 			StorageBackend *sb = Core::Instance ().GetStorageBackend ();
 			Impl_->CurrentItemsModel_->Reset (sb->GetItemsForTag ("_important"));
 		}
+		else if (section == FullTextSearchSection)
+		{
+			// The results come ranked by relevance, so the view
+			// shouldn't reorder them.
+			Impl_->Ui_.Items_->setSortingEnabled (false);
+			Impl_->ItemsFilterModel_->sort (-1);
+
+			const int maxResults = 500;
+			Impl_->PendingSearchID_ = Core::Instance ().SearchItems (text, maxResults);
+		}
 		else
 			CurrentChannelChanged (Impl_->LastSelectedChannel_);
 
-		const QString& text = Impl_->Ui_.SearchLine_->text ();
 		switch (section)
 		{
 		case 1:
@@ -1513,6 +1548,9 @@ namespace Aggregator
 		case 2:
 			Impl_->ItemsFilterModel_->setFilterRegExp (text);
 			break;
+		case FullTextSearchSection:
+			Impl_->ItemsFilterModel_->setFilterFixedString ({});
+			break;
 		default:
 			Impl_->ItemsFilterModel_->setFilterFixedString (text);
 			break;
@@ -1524,6 +1562,23 @@ namespace Aggregator
 		Impl_->ItemsFilterModel_->SetItemTags (tags);
 	}
 
+	void ItemsWidget::handleItemsSearchResults (quint64 searchId, const ItemSearchResults_t& results)
+	{
+		if (searchId != Impl_->PendingSearchID_)
+			return;
+
+		QList<IDType_t> ids;
+		QHash<IDType_t, QString> snippets;
+		for (const auto& result : results)
+		{
+			ids << result.ItemID_;
+			snippets [result.ItemID_] = result.Snippet_;
+		}
+
+		Impl_->CurrentItemsModel_->Reset (ids);
+		Impl_->CurrentItemsModel_->SetSnippets (snippets);
+	}
+
 	void ItemsWidget::selectorVisiblityChanged ()
 	{
 		if (!XmlSettingsManager::Instance ()->
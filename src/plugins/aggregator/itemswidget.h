@@ -33,6 +33,7 @@
 #include "ui_itemswidget.h"
 #include "item.h"
 #include "channel.h"
+#include "storagebackend.h"
 
 class QModelIndex;
 class QToolBar;
@@ -153,6 +154,7 @@ namespace Aggregator
 		void checkSelected ();
 		void makeCurrentItemVisible ();
 		void updateItemsFilter ();
+		void handleItemsSearchResults (quint64, const ItemSearchResults_t&);
 		void selectorVisiblityChanged ();
 		void navBarVisibilityChanged ();
 	signals:
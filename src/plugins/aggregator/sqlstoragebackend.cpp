@@ -37,6 +37,8 @@
 #include <QThread>
 #include <QVariant>
 #include <QSqlRecord>
+#include <QRegExp>
+#include <QStringList>
 #include <util/util.h>
 #include <util/db/dblock.h>
 #include <util/xpc/defaulthookproxy.h>
@@ -953,6 +955,13 @@ namespace Aggregator
 		return GetHighestID (field, table);
 	}
 
+	std::shared_ptr<Util::DBLock> SQLStorageBackend::BeginTransaction ()
+	{
+		const auto& lock = std::make_shared<Util::DBLock> (DB_);
+		lock->Init ();
+		return lock;
+	}
+
 	IDType_t SQLStorageBackend::GetHighestID (const QString& idName, const QString& tableName) const
 	{
 		QSqlQuery findHighestID (DB_);
@@ -2346,9 +2355,177 @@ namespace Aggregator
 			}
 		}
 
+		HasFullTextIndex_ = InitializeFullTextIndex ();
+		if (!HasFullTextIndex_)
+			qWarning () << Q_FUNC_INFO
+					<< "full-text search will be unavailable";
+
 		return true;
 	}
 
+	namespace
+	{
+		const QString PgItemsTSVector = "to_tsvector ('simple', "
+				"COALESCE (title, '') || ' ' || "
+				"COALESCE (description, '') || ' ' || "
+				"COALESCE (author, '') || ' ' || "
+				"COALESCE (category, ''))";
+	}
+
+	bool SQLStorageBackend::InitializeFullTextIndex ()
+	{
+		QSqlQuery query (DB_);
+		if (Type_ == SBSQLite)
+		{
+			if (DB_.tables ().contains ("items_fts"))
+				return true;
+
+			qDebug () << Q_FUNC_INFO
+					<< "creating and populating the full-text index, this may take a while...";
+
+			Util::DBLock lock (DB_);
+			try
+			{
+				lock.Init ();
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO << e.what ();
+				return false;
+			}
+
+			// The index is an external content FTS5 table, so the
+			// texts themselves are stored only once in the items table,
+			// and the triggers keep the index in sync with it.
+			const QStringList queries
+			{
+				"CREATE VIRTUAL TABLE items_fts USING fts5 ("
+					"title, description, author, category, "
+					"content='items', content_rowid='item_id');",
+				"CREATE TRIGGER items_fts_insert AFTER INSERT ON items BEGIN "
+					"INSERT INTO items_fts (rowid, title, description, author, category) "
+					"VALUES (new.item_id, new.title, new.description, new.author, new.category); "
+					"END;",
+				"CREATE TRIGGER items_fts_delete AFTER DELETE ON items BEGIN "
+					"INSERT INTO items_fts (items_fts, rowid, title, description, author, category) "
+					"VALUES ('delete', old.item_id, old.title, old.description, old.author, old.category); "
+					"END;",
+				"CREATE TRIGGER items_fts_update AFTER UPDATE OF title, description, author, category ON items BEGIN "
+					"INSERT INTO items_fts (items_fts, rowid, title, description, author, category) "
+					"VALUES ('delete', old.item_id, old.title, old.description, old.author, old.category); "
+					"INSERT INTO items_fts (rowid, title, description, author, category) "
+					"VALUES (new.item_id, new.title, new.description, new.author, new.category); "
+					"END;",
+				"INSERT INTO items_fts (items_fts) VALUES ('rebuild');"
+			};
+
+			for (const auto& str : queries)
+				if (!query.exec (str))
+				{
+					Util::DBLock::DumpError (query);
+					return false;
+				}
+
+			lock.Good ();
+			return true;
+		}
+		else if (Type_ == SBPostgres)
+		{
+			if (!query.exec ("SELECT 1 FROM pg_indexes WHERE indexname = 'idx_items_fts';"))
+			{
+				Util::DBLock::DumpError (query);
+				return false;
+			}
+
+			if (query.next ())
+				return true;
+
+			qDebug () << Q_FUNC_INFO
+					<< "creating the full-text index, this may take a while...";
+
+			// PostgreSQL maintains expression indexes by itself.
+			if (!query.exec ("CREATE INDEX idx_items_fts ON items USING GIN (" + PgItemsTSVector + ");"))
+			{
+				Util::DBLock::DumpError (query);
+				return false;
+			}
+
+			return true;
+		}
+
+		return false;
+	}
+
+	bool SQLStorageBackend::SupportsFullTextSearch () const
+	{
+		return HasFullTextIndex_;
+	}
+
+	namespace
+	{
+		QString MakeFTS5Query (const QString& text)
+		{
+			QStringList terms;
+			for (auto term : text.split (QRegExp ("\\s+"), QString::SkipEmptyParts))
+				terms << '"' + term.replace ('"', "\"\"") + '"';
+
+			// Let the last word be a prefix, so that search-as-you-type
+			// works as expected.
+			if (!terms.isEmpty ())
+				terms.last () += '*';
+
+			return terms.join (" ");
+		}
+	}
+
+	QList<StorageBackend::ItemSearchResult> SQLStorageBackend::SearchItems (const QString& text, int limit) const
+	{
+		if (!HasFullTextIndex_ || text.trimmed ().isEmpty ())
+			return {};
+
+		QSqlQuery query (DB_);
+		switch (Type_)
+		{
+			case SBSQLite:
+				query.prepare ("SELECT rowid, -bm25 (items_fts), "
+						"snippet (items_fts, -1, '<b>', '</b>', '...', 16) "
+						"FROM items_fts "
+						"WHERE items_fts MATCH :text "
+						"ORDER BY bm25 (items_fts) "
+						"LIMIT :limit;");
+				query.bindValue (":text", MakeFTS5Query (text));
+				break;
+			case SBPostgres:
+				query.prepare ("SELECT item_id, ts_rank (" + PgItemsTSVector + ", q) AS rank, "
+						"ts_headline ('simple', COALESCE (description, ''), q, "
+							"'StartSel=<b>, StopSel=</b>, MaxWords=16, MinWords=8') "
+						"FROM items, plainto_tsquery ('simple', :text) q "
+						"WHERE " + PgItemsTSVector + " @@ q "
+						"ORDER BY rank DESC "
+						"LIMIT :limit;");
+				query.bindValue (":text", text);
+				break;
+			case SBMysql:
+				return {};
+		}
+		query.bindValue (":limit", limit);
+
+		if (!query.exec ())
+		{
+			Util::DBLock::DumpError (query);
+			return {};
+		}
+
+		QList<ItemSearchResult> result;
+		while (query.next ())
+			result.append ({
+					query.value (0).value<IDType_t> (),
+					query.value (1).toDouble (),
+					query.value (2).toString ()
+				});
+		return result;
+	}
+
 	QByteArray SQLStorageBackend::SerializePixmap (const QImage& pixmap) const
 	{
 		QByteArray bytes;
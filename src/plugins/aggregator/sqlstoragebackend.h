@@ -44,6 +44,8 @@ namespace Aggregator
 		QSqlDatabase DB_;
 
 		Type Type_;
+		bool HasFullTextIndex_ = false;
+
 							/** Returns:
 							 * - last_update
 							 *
@@ -617,10 +619,15 @@ namespace Aggregator
 
 		virtual IDType_t GetHighestID (const PoolType&) const;
 
+		virtual std::shared_ptr<Util::DBLock> BeginTransaction ();
+
+		virtual bool SupportsFullTextSearch () const;
+		virtual QList<ItemSearchResult> SearchItems (const QString&, int) const;
 	private:
 		QString GetBoolType () const;
 		QString GetBlobType () const;
 		bool InitializeTables ();
+		bool InitializeFullTextIndex ();
 		QByteArray SerializePixmap (const QImage&) const;
 		QImage UnserializePixmap (const QByteArray&) const;
 
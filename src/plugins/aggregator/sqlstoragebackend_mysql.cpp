@@ -308,6 +308,13 @@ namespace Aggregator
 
 	}
 
+	std::shared_ptr<Util::DBLock> SQLStorageBackendMysql::BeginTransaction ()
+	{
+		const auto& lock = std::make_shared<Util::DBLock> (DB_);
+		lock->Init ();
+		return lock;
+	}
+
 	IDType_t SQLStorageBackendMysql::GetHighestID (const QString& idName, const QString& tableName) const
 	{
 		QSqlQuery findHighestID (DB_);
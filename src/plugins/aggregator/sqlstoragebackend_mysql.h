@@ -584,6 +584,7 @@ namespace Aggregator
 
 		virtual IDType_t GetHighestID (const PoolType&) const;
 
+		virtual std::shared_ptr<Util::DBLock> BeginTransaction ();
 	private:
 		QString GetBoolType () const;
 		QString GetBlobType () const;
@@ -31,6 +31,7 @@
 #include <stdexcept>
 #include <QFile>
 #include <QDebug>
+#include <util/db/dblock.h>
 #include "sqlstoragebackend.h"
 #include "sqlstoragebackend_mysql.h"
 #include "storagebackendmanager.h"
@@ -62,6 +63,21 @@ namespace Aggregator
 	{
 	}
 
+	std::shared_ptr<Util::DBLock> StorageBackend::BeginTransaction ()
+	{
+		return {};
+	}
+
+	bool StorageBackend::SupportsFullTextSearch () const
+	{
+		return false;
+	}
+
+	QList<StorageBackend::ItemSearchResult> StorageBackend::SearchItems (const QString&, int) const
+	{
+		return {};
+	}
+
 	StorageBackend_ptr StorageBackend::Create (const QString& strType, const QString& id)
 	{
 		StorageBackend::Type type;
@@ -38,6 +38,11 @@
 
 namespace LeechCraft
 {
+namespace Util
+{
+	class DBLock;
+}
+
 namespace Aggregator
 {
 	class StorageBackend;
@@ -60,6 +65,26 @@ namespace Aggregator
 		struct FeedGettingError {};
 		struct FeedNotFoundError {};
 
+		/** @brief A single result of a full-text search over items.
+		 *
+		 * @sa SearchItems()
+		 */
+		struct ItemSearchResult
+		{
+			/** @brief The ID of the found item.
+			 */
+			IDType_t ItemID_;
+
+			/** @brief The relevance of the item, the higher the better.
+			 */
+			double Rank_;
+
+			/** @brief A fragment of the item with matches highlighted
+			 * by <code>&lt;b&gt;</code> tags.
+			 */
+			QString Snippet_;
+		};
+
 		enum Type
 		{
 			SBSQLite,
@@ -448,6 +473,48 @@ namespace Aggregator
 		 * @return highest channels id in the database or 0 if empty
 		 */
 		virtual IDType_t GetHighestID (const PoolType& type) const = 0;
+
+		/** @brief Starts a transaction spanning several modifications.
+		 *
+		 * The transaction lasts until the returned lock is destroyed
+		 * and is committed only if Util::DBLock::Good() has been called
+		 * on it, otherwise it is rolled back.
+		 *
+		 * Backends not supporting transactions return a null pointer,
+		 * which is also what the default implementation does.
+		 *
+		 * @return The lock guarding the transaction, or a null pointer.
+		 *
+		 * @throw std::runtime_error If the transaction could not be
+		 * started.
+		 */
+		virtual std::shared_ptr<Util::DBLock> BeginTransaction ();
+
+		/** @brief Returns whether this backend has a full-text index.
+		 *
+		 * The default implementation returns false.
+		 *
+		 * @return Whether SearchItems() is supported.
+		 *
+		 * @sa SearchItems()
+		 */
+		virtual bool SupportsFullTextSearch () const;
+
+		/** @brief Searches the items using the full-text index.
+		 *
+		 * The index covers the title, description, author and
+		 * categories of each item and is kept up-to-date by the
+		 * backend itself as items are added, updated and removed.
+		 *
+		 * The default implementation returns an empty list.
+		 *
+		 * @param[in] text The user-entered words to search for.
+		 * @param[in] limit The maximum number of results to return.
+		 * @return The found items, sorted by their relevance.
+		 *
+		 * @sa SupportsFullTextSearch()
+		 */
+		virtual QList<ItemSearchResult> SearchItems (const QString& text, int limit) const;
 	signals:
 		/** @brief Notifies about updated channel information.
 		 *
@@ -499,5 +566,7 @@ namespace Aggregator
 		 */
 		void hookItemLoad (LeechCraft::IHookProxy_ptr proxy, Item *item) const;
 	};
+
+	typedef QList<StorageBackend::ItemSearchResult> ItemSearchResults_t;
 }
 }
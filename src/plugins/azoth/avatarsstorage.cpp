@@ -0,0 +1,473 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "avatarsstorage.h"
+#include <algorithm>
+#include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <QFutureInterface>
+#include <QRunnable>
+#include <QtDebug>
+#include <util/sys/paths.h>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	namespace
+	{
+		const auto MaxDiskSize = 64 * 1024 * 1024;
+		const auto MemoryCacheKiB = 16 * 1024;
+		const auto ScaledCacheKiB = 8 * 1024;
+
+		const QByteArray IndexMagic { "LCAZAV" };
+		const quint8 IndexVersion = 1;
+		const QString IndexFilename { "index" };
+
+		class Task : public QRunnable
+		{
+			const std::function<void ()> F_;
+		public:
+			Task (const std::function<void ()>& f)
+			: F_ { f }
+			{
+			}
+
+			void run () override
+			{
+				F_ ();
+			}
+		};
+
+		QByteArray GetFileName (const QByteArray& key)
+		{
+			return QCryptographicHash::hash (key, QCryptographicHash::Sha1).toHex ();
+		}
+
+		int GetCost (const QImage& image)
+		{
+			return image.byteCount () / 1024 + 1;
+		}
+
+		quint32 Now ()
+		{
+			return QDateTime::currentDateTime ().toTime_t ();
+		}
+
+		QImage Scale (const QImage& image, int size)
+		{
+			if (size <= 0 || image.isNull () ||
+					(image.width () <= size && image.height () <= size))
+				return image;
+
+			return image.scaled (size, size, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+		}
+
+		QFuture<QImage> MakeReadyFuture (const QImage& image)
+		{
+			QFutureInterface<QImage> iface;
+			iface.reportStarted ();
+			iface.reportFinished (&image);
+			return iface.future ();
+		}
+	}
+
+	AvatarsStorage::AvatarsStorage ()
+	: Dir_ { Util::GetUserDir (Util::UserDir::Cache, "azoth/avatars") }
+	, Cache_ { MemoryCacheKiB }
+	, ScaledCache_ { ScaledCacheKiB }
+	{
+		Pool_.setMaxThreadCount (1);
+
+		Schedule ([this] { LoadIndex (); });
+	}
+
+	AvatarsStorage::~AvatarsStorage ()
+	{
+		Pool_.waitForDone ();
+		SaveIndex ();
+
+		const auto& stats = GetStats ();
+		qDebug () << Q_FUNC_INFO
+				<< "hits:"
+				<< stats.Hits_
+				<< "misses:"
+				<< stats.Misses_
+				<< "decoded"
+				<< stats.Decodes_
+				<< "images in"
+				<< stats.DecodeUSecs_ / 1000
+				<< "ms";
+	}
+
+	void AvatarsStorage::StoreAvatar (const QByteArray& key, const QImage& image)
+	{
+		InvalidateCached (key);
+		if (!image.isNull ())
+			CacheImage ({ key, 0 }, image);
+
+		Schedule ([this, key, image]
+				{
+					// Lookups queued before this store might have cached the old image.
+					InvalidateCached (key);
+					if (!image.isNull ())
+						CacheImage ({ key, 0 }, image);
+
+					const auto& name = GetFileName (key);
+					const auto& path = Dir_.absoluteFilePath (name);
+
+					const auto pos = Index_.find (name);
+					if (pos != Index_.end ())
+					{
+						TotalSize_ -= pos->Size_;
+						Index_.erase (pos);
+						IndexDirty_ = true;
+					}
+
+					if (image.isNull ())
+					{
+						QFile::remove (path);
+						SaveIndex ();
+						return;
+					}
+
+					const auto& tmpPath = path + ".new";
+					if (!image.save (tmpPath, "PNG"))
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "unable to save avatar to"
+								<< tmpPath;
+						QFile::remove (tmpPath);
+						return;
+					}
+
+					QFile::remove (path);
+					if (!QFile::rename (tmpPath, path))
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "unable to rename"
+								<< tmpPath
+								<< "to"
+								<< path;
+						QFile::remove (tmpPath);
+						return;
+					}
+
+					const auto size = QFileInfo { path }.size ();
+					Index_ [name] = { size, Now () };
+					TotalSize_ += size;
+					IndexDirty_ = true;
+
+					EvictOld ();
+					SaveIndex ();
+				});
+	}
+
+	QFuture<QImage> AvatarsStorage::GetAvatar (const QByteArray& key, int size)
+	{
+		size = std::max (size, 0);
+
+		{
+			QMutexLocker locker { &CacheMutex_ };
+			if (const auto image = Cache_.object ({ key, size }))
+			{
+				++Hits_;
+
+				// Index_ belongs to the pool thread, so the access is
+				// recorded there, together with the other hits meanwhile.
+				if (PendingAccesses_.isEmpty ())
+					Schedule ([this] { RecordPendingAccesses (); });
+				PendingAccesses_ << key;
+
+				return MakeReadyFuture (*image);
+			}
+		}
+
+		++Misses_;
+
+		QFutureInterface<QImage> iface;
+		iface.reportStarted ();
+		Schedule ([this, key, size, iface] () mutable
+				{
+					const auto& name = GetFileName (key);
+
+					QImage image;
+					{
+						QMutexLocker locker { &CacheMutex_ };
+						if (const auto orig = Cache_.object ({ key, 0 }))
+							image = *orig;
+					}
+
+					if (image.isNull () && Index_.contains (name))
+					{
+						QElapsedTimer timer;
+						timer.start ();
+
+						image = QImage { Dir_.absoluteFilePath (name) };
+
+						++Decodes_;
+						DecodeUSecs_ += timer.nsecsElapsed () / 1000;
+
+						if (image.isNull ())
+						{
+							TotalSize_ -= Index_.take (name).Size_;
+							IndexDirty_ = true;
+						}
+						else
+							CacheImage ({ key, 0 }, image);
+					}
+
+					if (Index_.contains (name))
+					{
+						Index_ [name].LastAccess_ = Now ();
+						IndexDirty_ = true;
+					}
+
+					if (size && !image.isNull ())
+					{
+						QElapsedTimer timer;
+						timer.start ();
+
+						image = Scale (image, size);
+						CacheImage ({ key, size }, image);
+
+						DecodeUSecs_ += timer.nsecsElapsed () / 1000;
+					}
+
+					iface.reportFinished (&image);
+				});
+		return iface.future ();
+	}
+
+	QImage AvatarsStorage::GetScaled (const QImage& image, int size)
+	{
+		if (image.isNull ())
+			return image;
+
+		const QPair<qint64, int> key { image.cacheKey (), size };
+		if (const auto scaled = ScaledCache_.object (key))
+		{
+			++Hits_;
+			return *scaled;
+		}
+
+		++Misses_;
+
+		QElapsedTimer timer;
+		timer.start ();
+
+		const auto& scaled = image.scaled (size, size,
+				Qt::KeepAspectRatio, Qt::SmoothTransformation);
+		ScaledCache_.insert (key, new QImage { scaled }, GetCost (scaled));
+
+		DecodeUSecs_ += timer.nsecsElapsed () / 1000;
+
+		return scaled;
+	}
+
+	AvatarsStorage::Stats AvatarsStorage::GetStats () const
+	{
+		return { Hits_, Misses_, Decodes_, DecodeUSecs_ };
+	}
+
+	void AvatarsStorage::Schedule (const std::function<void ()>& f)
+	{
+		Pool_.start (new Task { f });
+	}
+
+	void AvatarsStorage::LoadIndex ()
+	{
+		QFile file { Dir_.absoluteFilePath (IndexFilename) };
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			RebuildIndex ();
+			return;
+		}
+
+		QDataStream stream { &file };
+		stream.setVersion (QDataStream::Qt_4_8);
+
+		QByteArray magic;
+		quint8 version = 0;
+		quint32 count = 0;
+		stream >> magic >> version >> count;
+		if (magic != IndexMagic || version != IndexVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown index format"
+					<< magic
+					<< version;
+			RebuildIndex ();
+			return;
+		}
+
+		Index_.reserve (count);
+		for (quint32 i = 0; i < count && stream.status () == QDataStream::Ok; ++i)
+		{
+			QByteArray name;
+			IndexEntry entry;
+			stream >> name >> entry.Size_ >> entry.LastAccess_;
+			Index_ [name] = entry;
+			TotalSize_ += entry.Size_;
+		}
+
+		if (stream.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "truncated index";
+			RebuildIndex ();
+		}
+	}
+
+	void AvatarsStorage::RebuildIndex ()
+	{
+		Index_.clear ();
+		TotalSize_ = 0;
+
+		for (const auto& info : Dir_.entryInfoList (QDir::Files))
+		{
+			if (info.fileName () == IndexFilename)
+				continue;
+
+			if (info.fileName ().endsWith (".new"))
+			{
+				QFile::remove (info.absoluteFilePath ());
+				continue;
+			}
+
+			Index_ [info.fileName ().toLatin1 ()] = { info.size (), info.lastModified ().toTime_t () };
+			TotalSize_ += info.size ();
+		}
+
+		IndexDirty_ = true;
+		EvictOld ();
+		SaveIndex ();
+	}
+
+	void AvatarsStorage::SaveIndex ()
+	{
+		if (!IndexDirty_)
+			return;
+
+		const auto& path = Dir_.absoluteFilePath (IndexFilename);
+		QFile file { path + ".new" };
+		if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream stream { &file };
+		stream.setVersion (QDataStream::Qt_4_8);
+		stream << IndexMagic << IndexVersion << static_cast<quint32> (Index_.size ());
+		for (auto i = Index_.begin (), end = Index_.end (); i != end; ++i)
+			stream << i.key () << i->Size_ << i->LastAccess_;
+		file.close ();
+
+		QFile::remove (path);
+		if (!QFile::rename (file.fileName (), path))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to rename"
+					<< file.fileName ()
+					<< "to"
+					<< path;
+			return;
+		}
+
+		IndexDirty_ = false;
+	}
+
+	void AvatarsStorage::EvictOld ()
+	{
+		if (TotalSize_ <= MaxDiskSize)
+			return;
+
+		QList<QPair<quint32, QByteArray>> byAccess;
+		byAccess.reserve (Index_.size ());
+		for (auto i = Index_.begin (), end = Index_.end (); i != end; ++i)
+			byAccess.append ({ i->LastAccess_, i.key () });
+		std::sort (byAccess.begin (), byAccess.end ());
+
+		// Leave some room so that we don't evict on every store.
+		const auto target = MaxDiskSize * 9 / 10;
+		for (const auto& pair : byAccess)
+		{
+			if (TotalSize_ <= target)
+				break;
+
+			QFile::remove (Dir_.absoluteFilePath (pair.second));
+			TotalSize_ -= Index_.take (pair.second).Size_;
+		}
+
+		IndexDirty_ = true;
+	}
+
+	void AvatarsStorage::RecordPendingAccesses ()
+	{
+		QSet<QByteArray> keys;
+		{
+			QMutexLocker locker { &CacheMutex_ };
+			std::swap (keys, PendingAccesses_);
+		}
+
+		const auto now = Now ();
+		for (const auto& key : keys)
+		{
+			const auto pos = Index_.find (GetFileName (key));
+			if (pos == Index_.end ())
+				continue;
+
+			pos->LastAccess_ = now;
+			IndexDirty_ = true;
+		}
+	}
+
+	void AvatarsStorage::InvalidateCached (const QByteArray& key)
+	{
+		QMutexLocker locker { &CacheMutex_ };
+		for (const auto& cacheKey : Cache_.keys ())
+			if (cacheKey.first == key)
+				Cache_.remove (cacheKey);
+	}
+
+	void AvatarsStorage::CacheImage (const CacheKey_t& key, const QImage& image)
+	{
+		QMutexLocker locker { &CacheMutex_ };
+		Cache_.insert (key, new QImage { image }, GetCost (image));
+	}
+}
+}
@@ -0,0 +1,117 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <QDir>
+#include <QHash>
+#include <QSet>
+#include <QCache>
+#include <QMutex>
+#include <QThreadPool>
+#include "interfaces/azoth/iavatarsstorage.h"
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	/** The on-disk part lives in a single directory with an index of
+	 * file sizes and access times, so that evicting least recently
+	 * used avatars doesn't require listing the directory. All disk
+	 * operations are serialized in a dedicated single-threaded pool.
+	 */
+	class AvatarsStorage : public IAvatarsStorage
+	{
+		const QDir Dir_;
+		QThreadPool Pool_;
+
+		struct IndexEntry
+		{
+			qint64 Size_;
+			quint32 LastAccess_;
+		};
+
+		// These are accessed from the Pool_ thread only.
+		QHash<QByteArray, IndexEntry> Index_;
+		qint64 TotalSize_ = 0;
+		bool IndexDirty_ = false;
+
+		typedef QPair<QByteArray, int> CacheKey_t;
+		QMutex CacheMutex_;
+		QCache<CacheKey_t, QImage> Cache_;
+
+		// Keys of the memory cache hits whose access is yet to be
+		// recorded in Index_, guarded by CacheMutex_.
+		QSet<QByteArray> PendingAccesses_;
+
+		// This is used from the main thread only.
+		QCache<QPair<qint64, int>, QImage> ScaledCache_;
+
+		std::atomic<quint64> Hits_ { 0 };
+		std::atomic<quint64> Misses_ { 0 };
+		std::atomic<quint64> Decodes_ { 0 };
+		std::atomic<qint64> DecodeUSecs_ { 0 };
+	public:
+		struct Stats
+		{
+			quint64 Hits_;
+			quint64 Misses_;
+			quint64 Decodes_;
+			qint64 DecodeUSecs_;
+		};
+
+		AvatarsStorage ();
+		~AvatarsStorage ();
+
+		void StoreAvatar (const QByteArray&, const QImage&) override;
+		QFuture<QImage> GetAvatar (const QByteArray&, int) override;
+
+		/** Returns the \em image scaled to fit a square with sides of
+		 * \em size pixels, reusing the previously scaled one if the
+		 * same image has already been scaled to that size.
+		 */
+		QImage GetScaled (const QImage& image, int size);
+
+		Stats GetStats () const;
+	private:
+		void Schedule (const std::function<void ()>&);
+
+		void LoadIndex ();
+		void RebuildIndex ();
+		void SaveIndex ();
+		void EvictOld ();
+		void RecordPendingAccesses ();
+
+		void InvalidateCached (const QByteArray&);
+		void CacheImage (const CacheKey_t&, const QImage&);
+	};
+}
+}
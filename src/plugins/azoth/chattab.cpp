@@ -45,6 +45,8 @@
 #include <QDesktopWidget>
 #include <QMimeData>
 #include <QToolBar>
+#include <QElapsedTimer>
+#include <QWheelEvent>
 
 #if QT_VERSION >= 0x050000
 #include <QUrlQuery>
@@ -78,6 +80,7 @@
 #include "interfaces/azoth/isupportpgp.h"
 #endif
 #include "core.h"
+#include "avatarsstorage.h"
 #include "textedit.h"
 #include "chattabsmanager.h"
 #include "xmlsettingsmanager.h"
@@ -176,6 +179,10 @@ namespace Azoth
 	, HadHighlight_ (false)
 	, NumUnreadMsgs_ (Core::Instance ().GetUnreadCount (GetEntry<ICLEntry> ()))
 	, ScrollbackPos_ (0)
+	, FlushScheduled_ (false)
+	, PagedOutMessages_ (0)
+	, UnmarkedMessages_ (0)
+	, ScrollbackReload_ (false)
 	, IsMUC_ (false)
 	, PreviousTextHeight_ (0)
 	, CDF_ (new ContactDropFilter (entryId, this))
@@ -186,6 +193,7 @@ namespace Azoth
 	{
 		Ui_.setupUi (this);
 		Ui_.View_->installEventFilter (new ZoomEventFilter (Ui_.View_));
+		Ui_.View_->installEventFilter (this);
 		Ui_.MsgEdit_->installEventFilter (new CopyFilter (Ui_.View_));
 		MUCEventLog_->installEventFilter (this);
 
@@ -306,6 +314,11 @@ namespace Azoth
 				</html>)delim")
 					.arg (tr ("Unable to load style, please check you've enabled at least one styles plugin."));
 
+		// Pending messages are already known to the entry and will be appended on load.
+		PendingMessages_.clear ();
+		PagedOutMessages_ = 0;
+		UnmarkedMessages_ = 0;
+
 		Ui_.View_->setContent (data.toUtf8 (),
 				"text/html", //"application/xhtml+xml" fails to work, though better to use it
 				Core::Instance ().GetSelectedChatTemplateURL (GetEntry<QObject> ()));
@@ -536,6 +549,13 @@ namespace Azoth
 		if (obj == MUCEventLog_ && event->type () == QEvent::Close)
 			Ui_.MUCEventsButton_->setChecked (false);
 
+		if (obj == Ui_.View_ &&
+				PagedOutMessages_ &&
+				event->type () == QEvent::Wheel &&
+				static_cast<QWheelEvent*> (event)->delta () > 0 &&
+				Ui_.View_->page ()->mainFrame ()->scrollPosition ().y () <= 0)
+			RematerializeScrollback ();
+
 		return false;
 	}
 
@@ -769,11 +789,36 @@ namespace Azoth
 		me->SetMUCSubject (Ui_.SubjEdit_->toPlainText ());
 	}
 
-	void ChatTab::on_View__loadFinished (bool)
+	namespace
 	{
-		Q_FOREACH (IMessage *msg, HistoryMessages_)
-			AppendMessage (msg);
+		/* The time spent per appended message is reported only if the
+		 * LC_AZOTH_APPEND_TIMING environment variable is set, as it's of
+		 * interest only when profiling chat styles.
+		 */
+		bool IsAppendTimingEnabled ()
+		{
+			static const bool enabled = !qgetenv ("LC_AZOTH_APPEND_TIMING").isEmpty ();
+			return enabled;
+		}
+
+		void ReportAppendTiming (const char *context, int count, qint64 elapsed)
+		{
+			if (count <= 1 || !IsAppendTimingEnabled ())
+				return;
 
+			qDebug () << context
+					<< "appended"
+					<< count
+					<< "messages in"
+					<< elapsed
+					<< "ms,"
+					<< static_cast<double> (elapsed) / count
+					<< "ms per message";
+		}
+	}
+
+	void ChatTab::on_View__loadFinished (bool)
+	{
 		ICLEntry *e = GetEntry<ICLEntry> ();
 		if (!e)
 		{
@@ -782,6 +827,15 @@ namespace Azoth
 			return;
 		}
 
+		QElapsedTimer timer;
+		timer.start ();
+
+		const auto frame = Ui_.View_->page ()->mainFrame ();
+		Core::Instance ().BeginAppendBatch (e->GetQObject (), frame);
+
+		Q_FOREACH (IMessage *msg, HistoryMessages_)
+			AppendMessage (msg);
+
 		auto messages = e->GetAllMessages ();
 
 		const auto& dummyMsgs = DummyMsgManager::Instance ().GetIMessages (e->GetQObject ());
@@ -796,6 +850,10 @@ namespace Azoth
 		for (const auto msg : messages)
 			AppendMessage (msg);
 
+		Core::Instance ().EndAppendBatch (e->GetQObject (), frame);
+		ReportAppendTiming (Q_FUNC_INFO,
+				HistoryMessages_.size () + messages.size (), timer.elapsed ());
+
 		QFile scrollerJS (":/plugins/azoth/resources/scripts/scrollers.js");
 		if (!scrollerJS.open (QIODevice::ReadOnly))
 			qWarning () << Q_FUNC_INFO
@@ -807,6 +865,19 @@ namespace Azoth
 			Ui_.View_->page ()->mainFrame ()->evaluateJavaScript ("InstallEventListeners(); ScrollToBottom();");
 		}
 
+		/* The older messages have just been requested, so keep them
+		 * in view. This also keeps TrimMessages() from paging them out
+		 * again until the user scrolls back to the bottom.
+		 */
+		if (ScrollbackReload_)
+		{
+			ScrollbackReload_ = false;
+			frame->evaluateJavaScript ("window.ShouldScroll = false;");
+			frame->setScrollPosition ({ 0, 0 });
+		}
+
+		TrimDisplayedMessages ();
+
 		emit hookThemeReloaded (Util::DefaultHookProxy_ptr (new Util::DefaultHookProxy),
 				this, Ui_.View_, GetEntry<QObject> ());
 	}
@@ -888,6 +959,22 @@ namespace Azoth
 		PrepareTheme ();
 	}
 
+	void ChatTab::RematerializeScrollback ()
+	{
+		ScrollbackPos_ = std::max (ScrollbackPos_, PagedOutMessages_);
+		PagedOutMessages_ = 0;
+
+		qDeleteAll (HistoryMessages_);
+		HistoryMessages_.clear ();
+		qDeleteAll (CoreMessages_);
+		CoreMessages_.clear ();
+		LastDateTime_ = QDateTime ();
+
+		ScrollbackReload_ = true;
+		if (!RequestLogs (ScrollbackPos_))
+			PrepareTheme ();
+	}
+
 	void ChatTab::handleHistoryBack ()
 	{
 		ScrollbackPos_ += 50;
@@ -897,7 +984,7 @@ namespace Azoth
 		CoreMessages_.clear ();
 		DummyMsgManager::Instance ().ClearMessages (GetCLEntry ());
 		LastDateTime_ = QDateTime ();
-		RequestLogs (ScrollbackPos_);
+		ScrollbackReload_ = RequestLogs (ScrollbackPos_);
 	}
 
 	void ChatTab::handleRichTextToggled ()
@@ -1093,7 +1180,7 @@ namespace Azoth
 				Ui_.VariantBox_->setCurrentIndex (idx);
 		}
 
-		AppendMessage (msg);
+		ScheduleAppend (msg);
 	}
 
 	void ChatTab::handleVariantsChanged (QStringList variants)
@@ -1140,10 +1227,10 @@ namespace Azoth
 
 	void ChatTab::handleAvatarChanged (const QImage& avatar)
 	{
-		const QPixmap& px = QPixmap::fromImage (avatar);
-		if (!px.isNull ())
+		if (!avatar.isNull ())
 		{
-			const QPixmap& scaled = px.scaled (QSize (18, 18), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+			const auto& scaled = QPixmap::fromImage (Core::Instance ()
+					.GetAvatarsStorage ()->GetScaled (avatar, 18));
 			Ui_.AvatarLabel_->setPixmap (scaled);
 			Ui_.AvatarLabel_->resize (scaled.size ());
 			Ui_.AvatarLabel_->setMaximumSize (scaled.size ());
@@ -1477,6 +1564,33 @@ namespace Azoth
 		Ui_.View_->page ()->mainFrame ()->evaluateJavaScript (js);
 	}
 
+	void ChatTab::flushPendingMessages ()
+	{
+		FlushScheduled_ = false;
+
+		const auto entryObj = GetEntry<QObject> ();
+		if (PendingMessages_.isEmpty () || !entryObj)
+			return;
+
+		QElapsedTimer timer;
+		timer.start ();
+
+		const auto frame = Ui_.View_->page ()->mainFrame ();
+		Core::Instance ().BeginAppendBatch (entryObj, frame);
+
+		const auto pending = PendingMessages_;
+		PendingMessages_.clear ();
+		for (const auto& msgObj : pending)
+			if (msgObj)
+				AppendMessage (qobject_cast<IMessage*> (msgObj));
+
+		Core::Instance ().EndAppendBatch (entryObj, frame);
+
+		TrimDisplayedMessages ();
+
+		ReportAppendTiming (Q_FUNC_INFO, pending.size (), timer.elapsed ());
+	}
+
 	template<typename T>
 	T* ChatTab::GetEntry () const
 	{
@@ -1823,7 +1937,7 @@ namespace Azoth
 				this, "handleMinLinesHeightChanged");
 	}
 
-	void ChatTab::RequestLogs (int num)
+	bool ChatTab::RequestLogs (int num)
 	{
 		ICLEntry *entry = GetEntry<ICLEntry> ();
 		if (!entry)
@@ -1831,7 +1945,7 @@ namespace Azoth
 			qWarning () << Q_FUNC_INFO
 					<< "null entry for"
 					<< EntryID_;
-			return;
+			return false;
 		}
 
 		QObject *entryObj = entry->GetQObject ();
@@ -1839,6 +1953,7 @@ namespace Azoth
 		const QObjectList& histories = Core::Instance ().GetProxy ()->
 				GetPluginsManager ()->GetAllCastableRoots<IHistoryPlugin*> ();
 
+		bool requested = false;
 		Q_FOREACH (QObject *histObj, histories)
 		{
 			IHistoryPlugin *hist = qobject_cast<IHistoryPlugin*> (histObj);
@@ -1852,7 +1967,9 @@ namespace Azoth
 					Qt::UniqueConnection);
 
 			hist->RequestLastMessages (entryObj, num);
+			requested = true;
 		}
+		return requested;
 	}
 
 	namespace
@@ -1863,6 +1980,33 @@ namespace Azoth
 		}
 	}
 
+	void ChatTab::ScheduleAppend (IMessage *msg)
+	{
+		PendingMessages_ << msg->GetQObject ();
+
+		if (FlushScheduled_)
+			return;
+
+		FlushScheduled_ = true;
+		QTimer::singleShot (0,
+				this,
+				SLOT (flushPendingMessages ()));
+	}
+
+	void ChatTab::TrimDisplayedMessages ()
+	{
+		const int maxCount = XmlSettingsManager::Instance ()
+				.property ("MaxDisplayedMessages").toInt ();
+
+		// The script is called even if there is no limit so that it
+		// knows which nodes the messages correspond to if one is set.
+		const auto& js = QString ("typeof TrimMessages == 'function' ? TrimMessages (%1, %2) : 0;")
+				.arg (UnmarkedMessages_)
+				.arg (std::max (maxCount, 0));
+		UnmarkedMessages_ = 0;
+		PagedOutMessages_ += Ui_.View_->page ()->mainFrame ()->evaluateJavaScript (js).toInt ();
+	}
+
 	void ChatTab::AppendMessage (IMessage *msg)
 	{
 		ICLEntry *other = qobject_cast<ICLEntry*> (msg->OtherPart ());
@@ -1970,6 +2114,8 @@ namespace Azoth
 				msg->GetQObject (), info))
 			qWarning () << Q_FUNC_INFO
 					<< "unhandled append message :(";
+		else
+			++UnmarkedMessages_;
 	}
 
 	QString ChatTab::ReformatTitle ()
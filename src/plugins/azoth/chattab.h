@@ -99,6 +99,18 @@ namespace Azoth
 		QDateTime LastDateTime_;
 		QList<CoreMessage*> CoreMessages_;
 
+		QList<QPointer<QObject>> PendingMessages_;
+		bool FlushScheduled_;
+		int PagedOutMessages_;
+		/** Messages appended to the view since the last call to
+		 * TrimDisplayedMessages().
+		 */
+		int UnmarkedMessages_;
+		/** Whether the view is being reloaded to show older messages,
+		 * so it should stay at them instead of scrolling to the bottom.
+		 */
+		bool ScrollbackReload_;
+
 		QIcon TabIcon_;
 		bool IsMUC_;
 		int PreviousTextHeight_;
@@ -223,6 +235,8 @@ namespace Azoth
 		void handleAccountStyleChanged (IAccount*);
 
 		void performJS (const QString&);
+
+		void flushPendingMessages ();
 	private:
 		template<typename T>
 		T* GetEntry () const;
@@ -237,7 +251,8 @@ namespace Azoth
 		void InitMsgEdit ();
 		void RegisterSettings ();
 
-		void RequestLogs (int);
+		bool RequestLogs (int);
+		void RematerializeScrollback ();
 
 		void UpdateTextHeight ();
 		void SetChatPartState (ChatPartState);
@@ -246,6 +261,19 @@ namespace Azoth
 		 */
 		void AppendMessage (IMessage*);
 
+		/** Queues the message to be appended to the message view area
+		 * together with other messages arriving during the current
+		 * event loop iteration.
+		 */
+		void ScheduleAppend (IMessage*);
+
+		/** Tells the view how many messages were appended since the
+		 * last call and removes the oldest messages from the message
+		 * view area if there are more of them than allowed by the
+		 * settings.
+		 */
+		void TrimDisplayedMessages ();
+
 		/** Updates the tab icon and other usages of state icon from the
 		 * TabIcon_.
 		 */
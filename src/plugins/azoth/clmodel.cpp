@@ -54,6 +54,7 @@ namespace Azoth
 	QVariant CLModel::data (const QModelIndex& index, int role) const
 	{
 		CheckRequestUpdateTooltip (index, role);
+		CheckRefreshIcon (index, role);
 		return QStandardItemModel::data (index, role);
 	}
 
@@ -137,6 +138,14 @@ namespace Azoth
 		TooltipManager_->RebuildTooltip (entry);
 	}
 
+	void CLModel::CheckRefreshIcon (const QModelIndex& index, int role) const
+	{
+		if (role != Qt::DecorationRole)
+			return;
+
+		Core::Instance ().RefreshOutdatedIcon (index, role);
+	}
+
 	bool CLModel::PerformHooks (const QMimeData *mime, int row, const QModelIndex& parent)
 	{
 		if (CheckHookDnDEntry2Entry (mime, row, parent))
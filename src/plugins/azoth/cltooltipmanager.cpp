@@ -425,6 +425,10 @@ namespace Azoth
 			return;
 		}
 
+		// Already cleared and waiting to be rebuilt on demand.
+		if (DirtyTooltips_.contains (entry))
+			return;
+
 		for (auto item : Entry2Items_.value (entry))
 			item->setToolTip ({});
 
@@ -40,6 +40,7 @@
 #include <QStringListModel>
 #include <QMessageBox>
 #include <QClipboard>
+#include <QTimer>
 #include <QtDebug>
 #include <util/util.h>
 #include <util/xpc/util.h>
@@ -63,6 +64,7 @@
 #include "interfaces/azoth/imucperms.h"
 #include "interfaces/azoth/iauthable.h"
 #include "interfaces/azoth/iresourceplugin.h"
+#include "interfaces/azoth/isupportbatchappend.h"
 #include "interfaces/azoth/iurihandler.h"
 #include "interfaces/azoth/irichtextmessage.h"
 #include "interfaces/azoth/ihaveservicediscovery.h"
@@ -93,9 +95,11 @@
 #include "customstatusesmanager.h"
 #include "customchatstylemanager.h"
 #include "cltooltipmanager.h"
+#include "avatarsstorage.h"
 #include "corecommandsmanager.h"
 #include "resourcesmanager.h"
 #include "notificationsmanager.h"
+#include "statusflusher.h"
 
 Q_DECLARE_METATYPE (QPointer<QObject>);
 
@@ -215,6 +219,12 @@ namespace Azoth
 	, ImportManager_ (new ImportManager)
 	, UnreadQueueManager_ (new UnreadQueueManager)
 	, CustomChatStyleManager_ (new CustomChatStyleManager)
+	, StatusFlushScheduled_ (false)
+	, StatusFlusher_ (new StatusFlusher (CLModel_,
+				[this] (QStandardItem *item) { UpdateItemIcon (item); },
+				[this] (QStandardItem *item) { ItemIconManager_->Cancel (item); },
+				[this] (QStandardItem *item) { RecalculateOnlineForCat (item); }))
+	, AvatarsStorage_ (new AvatarsStorage)
 	{
 		FillANFields ();
 
@@ -272,6 +282,7 @@ namespace Azoth
 	{
 		ShortcutManager_.reset ();
 		StyleOptionManagers_.clear ();
+		AvatarsStorage_.reset ();
 
 #ifdef ENABLE_CRYPT
 		CryptoManager::Instance ().Release ();
@@ -347,6 +358,11 @@ namespace Azoth
 		return CustomChatStyleManager_.get ();
 	}
 
+	AvatarsStorage* Core::GetAvatarsStorage () const
+	{
+		return AvatarsStorage_.get ();
+	}
+
 	UnreadQueueManager* Core::GetUnreadQueueManager () const
 	{
 		return UnreadQueueManager_.get ();
@@ -722,7 +738,12 @@ namespace Azoth
 
 			auto chatStyleSrc = qobject_cast<IChatStyleResourceSource*> (object);
 			if (chatStyleSrc)
+			{
 				AddChatStyleResourceSource (chatStyleSrc);
+
+				if (const auto batch = qobject_cast<ISupportBatchAppend*> (object))
+					BatchAppendSources_ [chatStyleSrc] = batch;
+			}
 		}
 	}
 
@@ -787,6 +808,18 @@ namespace Azoth
 		return src->AppendMessage (frame, message, info);
 	}
 
+	void Core::BeginAppendBatch (QObject *entry, QWebFrame *frame)
+	{
+		if (const auto batch = BatchAppendSources_.value (GetCurrentChatStyle (entry)))
+			batch->BeginBatch (frame);
+	}
+
+	void Core::EndAppendBatch (QObject *entry, QWebFrame *frame)
+	{
+		if (const auto batch = BatchAppendSources_.value (GetCurrentChatStyle (entry)))
+			batch->EndBatch (frame);
+	}
+
 	void Core::FrameFocused (QObject *entry, QWebFrame *frame)
 	{
 		IChatStyleResourceSource *src = GetCurrentChatStyle (entry);
@@ -1192,18 +1225,50 @@ namespace Azoth
 		emit hookEntryStatusChanged (Util::DefaultHookProxy_ptr (new Util::DefaultHookProxy),
 				entry->GetQObject (), variant);
 
-		const State state = entry->GetStatus ().State_;
-		const auto& icon = ResourcesManager::Instance ().GetIconPathForState (state);
+		PendingStatusEntries_ << entry;
 
-		for (auto item : Entry2Items_.value (entry))
-		{
-			ItemIconManager_->SetIcon (item, icon.get ());
-			RecalculateOnlineForCat (item->parent ());
-		}
+		if (StatusFlushScheduled_)
+			return;
 
-		const QString& id = entry->GetEntryID ();
+		// Roughly one frame: enough to gather presence bursts on connect or MUC join.
+		StatusFlushScheduled_ = true;
+		QTimer::singleShot (16,
+				this,
+				SLOT (flushPendingStatuses ()));
+	}
+
+	void Core::UpdateItemIcon (QStandardItem *item)
+	{
+		const auto entry = qobject_cast<ICLEntry*> (item->data (CLREntryObject).value<QObject*> ());
+		if (!entry)
+			return;
+
+		const auto& id = entry->GetEntryID ();
 		if (!XferJobManager_->GetPendingIncomingJobsFor (id).isEmpty ())
+		{
 			CheckFileIcon (id);
+			return;
+		}
+
+		const auto& icon = ResourcesManager::Instance ().GetIconPathForState (entry->GetStatus ().State_);
+		ItemIconManager_->SetIcon (item, icon.get ());
+	}
+
+	void Core::RefreshOutdatedIcon (const QModelIndex& index, int role)
+	{
+		StatusFlusher_->CheckOutdatedIcon (index, role);
+	}
+
+	void Core::flushPendingStatuses ()
+	{
+		StatusFlushScheduled_ = false;
+
+		QList<QStandardItem*> items;
+		for (const auto entry : PendingStatusEntries_)
+			items += Entry2Items_.value (entry);
+		PendingStatusEntries_.clear ();
+
+		StatusFlusher_->Flush (items);
 	}
 
 	void Core::CheckFileIcon (const QString& id)
@@ -1230,7 +1295,10 @@ namespace Azoth
 				.GetResourceLoader (ResourcesManager::RLTStatusIconLoader)->
 						GetIconDevice (filename, true);
 		for (auto item : Entry2Items_.value (entry))
+		{
+			item->setData (false, CLRIconOutdated);
 			ItemIconManager_->SetIcon (item, fileIcon.get ());
+		}
 	}
 
 	void Core::IncreaseUnreadCount (ICLEntry* entry, int amount)
@@ -1262,10 +1330,7 @@ namespace Azoth
 		if (avatar.isNull () || !avatar.width ())
 			avatar = ResourcesManager::Instance ().GetDefaultAvatar (size);
 
-		const QImage& scaled = avatar.isNull () ?
-				QImage () :
-				avatar.scaled (size, size,
-						Qt::KeepAspectRatio, Qt::SmoothTransformation);
+		const auto& scaled = AvatarsStorage_->GetScaled (avatar, size);
 		Entry2SmoothAvatarCache_ [entry] = scaled;
 		return scaled;
 	}
@@ -1684,7 +1749,10 @@ namespace Azoth
 
 		for (auto entry : Entry2Items_.keys ())
 			if (entry->GetParentAccount () == accFace)
+			{
 				Entry2Items_.remove (entry);
+				PendingStatusEntries_.remove (entry);
+			}
 
 		NotificationsManager_->RemoveAccount (account);
 
@@ -1775,6 +1843,7 @@ namespace Azoth
 				RemoveCLItem (item);
 
 			Entry2Items_.remove (entry);
+			PendingStatusEntries_.remove (entry);
 
 			ActionsManager_->HandleEntryRemoved (entry);
 
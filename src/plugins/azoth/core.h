@@ -65,6 +65,7 @@ namespace Azoth
 	class IMessage;
 	class IEmoticonResourceSource;
 	class IChatStyleResourceSource;
+	class ISupportBatchAppend;
 
 	class ChatTabsManager;
 	class PluginManager;
@@ -72,6 +73,7 @@ namespace Azoth
 	class TransferJobManager;
 	class CallManager;
 	class EventsNotifier;
+	class StatusFlusher;
 	class ActionsManager;
 	class ImportManager;
 	class CLModel;
@@ -83,6 +85,7 @@ namespace Azoth
 	class CLTooltipManager;
 	class CoreCommandsManager;
 	class NotificationsManager;
+	class AvatarsStorage;
 
 	class Core : public QObject
 	{
@@ -123,6 +126,9 @@ namespace Azoth
 
 		std::shared_ptr<SourceTrackingModel<IEmoticonResourceSource>> SmilesOptionsModel_;
 		std::shared_ptr<SourceTrackingModel<IChatStyleResourceSource>> ChatStylesOptionsModel_;
+		/** Chat style sources also implementing ISupportBatchAppend.
+		 */
+		QHash<IChatStyleResourceSource*, ISupportBatchAppend*> BatchAppendSources_;
 
 		std::shared_ptr<PluginManager> PluginManager_;
 		std::shared_ptr<ProxyObject> PluginProxyObject_;
@@ -137,6 +143,12 @@ namespace Azoth
 		std::shared_ptr<CustomChatStyleManager> CustomChatStyleManager_;
 		std::shared_ptr<NotificationsManager> NotificationsManager_;
 
+		QSet<ICLEntry*> PendingStatusEntries_;
+		bool StatusFlushScheduled_;
+		std::shared_ptr<StatusFlusher> StatusFlusher_;
+
+		std::shared_ptr<AvatarsStorage> AvatarsStorage_;
+
 		Core ();
 	public:
 		enum CLRoles
@@ -149,7 +161,8 @@ namespace Azoth
 			CLRRole,
 			CLRAffiliation,
 			CLRNumOnline,
-			CLRIsMUCCategory
+			CLRIsMUCCategory,
+			CLRIconOutdated
 		};
 
 		enum CLEntryType
@@ -180,6 +193,7 @@ namespace Azoth
 		Util::ShortcutManager* GetShortcutManager () const;
 		CustomStatusesManager* GetCustomStatusesManager () const;
 		CustomChatStyleManager* GetCustomChatStyleManager () const;
+		AvatarsStorage* GetAvatarsStorage () const;
 		UnreadQueueManager* GetUnreadQueueManager () const;
 
 		void AddPlugin (QObject*);
@@ -202,6 +216,12 @@ namespace Azoth
 
 		void UpdateItem (QObject*);
 
+		/** Sets the state icon for the contact list item at the given
+		 * index if it has been marked as outdated after a batch of
+		 * status changes and the role is Qt::DecorationRole.
+		 */
+		void RefreshOutdatedIcon (const QModelIndex&, int role);
+
 		/** Returns the list of all groups of all chat entries.
 		 */
 		QStringList GetChatGroups () const;
@@ -258,6 +278,15 @@ namespace Azoth
 
 		bool AppendMessageByTemplate (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
 
+		/** Starts coalescing messages appended to the given frame of
+		 * the given entry, if the current chat style supports it.
+		 */
+		void BeginAppendBatch (QObject*, QWebFrame*);
+
+		/** Flushes the messages appended since BeginAppendBatch().
+		 */
+		void EndAppendBatch (QObject*, QWebFrame*);
+
 		void FrameFocused (QObject*, QWebFrame*);
 
 		QString FormatDate (QDateTime, IMessage*);
@@ -313,10 +342,18 @@ namespace Azoth
 				QMap<const IAccount*, QStandardItem*>& accountItemCache);
 
 		/** Handles the event of status changes in a contact list entry.
+		 *
+		 * The contact list items are updated later, together with
+		 * other entries whose status changed during the same frame.
 		 */
 		void HandleStatusChanged (const EntryStatus& status,
 				ICLEntry *entry, const QString& variant);
 
+		/** Updates the state icon of the given contact list item
+		 * right away.
+		 */
+		void UpdateItemIcon (QStandardItem*);
+
 		/** Checks whether icon representing incoming file should be
 		 * drawn for the entry with the given id.
 		 */
@@ -354,6 +391,11 @@ namespace Azoth
 
 		void saveAccountVisibility (IAccount*);
 	private slots:
+		/** Applies the status changes accumulated since the last
+		 * call to the contact list model.
+		 */
+		void flushPendingStatuses ();
+
 		void handleNewProtocols (const QList<QObject*>&);
 
 		/** Handles a new account. This account may be both a new one
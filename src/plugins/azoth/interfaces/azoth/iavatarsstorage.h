@@ -0,0 +1,90 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QFuture>
+#include <QImage>
+
+class QByteArray;
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	/** @brief Azoth-wide storage for contacts' avatars.
+	 *
+	 * This storage keeps avatars on disk in a single size-bounded
+	 * store shared by all protocols, and keeps recently used decoded
+	 * (and possibly scaled) images in memory.
+	 *
+	 * Avatars are identified by opaque keys chosen by the protocol,
+	 * like the avatar hash or the ID of the entry.
+	 *
+	 * The storage is obtained via IProxyObject::GetAvatarsStorage().
+	 * All its functions are expected to be called from the main
+	 * thread, while disk I/O and decoding happen in the background.
+	 */
+	class IAvatarsStorage
+	{
+	protected:
+		virtual ~IAvatarsStorage () {}
+	public:
+		/** @brief Stores the \em image under the given \em key.
+		 *
+		 * The avatar previously stored under the same key, if any,
+		 * is replaced. Storing a null image removes the avatar.
+		 *
+		 * The function returns immediately, the image is written in
+		 * background.
+		 *
+		 * @param[in] key The key of the avatar.
+		 * @param[in] image The avatar image.
+		 */
+		virtual void StoreAvatar (const QByteArray& key, const QImage& image) = 0;
+
+		/** @brief Returns the avatar stored under the given \em key.
+		 *
+		 * If \em size is positive, the avatar is scaled down (keeping
+		 * its aspect ratio) to fit a square with sides of \em size
+		 * pixels.
+		 *
+		 * The returned future is already finished if the requested
+		 * image is in memory. It contains a null image if there is no
+		 * avatar for the \em key.
+		 *
+		 * @param[in] key The key of the avatar.
+		 * @param[in] size The size to scale the avatar to, or 0 for
+		 * the original size.
+		 * @return The future with the avatar.
+		 */
+		virtual QFuture<QImage> GetAvatar (const QByteArray& key, int size = 0) = 0;
+	};
+}
+}
@@ -45,6 +45,8 @@ namespace Util
 
 namespace Azoth
 {
+	class IAvatarsStorage;
+
 	class IFormatterProxyObject
 	{
 	public:
@@ -345,6 +347,14 @@ namespace Azoth
 		virtual QObject* GetFirstUnreadMessage (QObject *entryObj) const = 0;
 
 		virtual IFormatterProxyObject& GetFormatterProxy () = 0;
+
+		/** @brief Returns the shared avatars storage.
+		 *
+		 * @return The avatars storage, owned by Azoth.
+		 *
+		 * @sa IAvatarsStorage
+		 */
+		virtual IAvatarsStorage* GetAvatarsStorage () = 0;
 	};
 }
 }
@@ -0,0 +1,83 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QtPlugin>
+
+class QWebFrame;
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	/** @brief Interface for chat styles that can coalesce appends.
+	 *
+	 * This interface may be implemented by chat style resource sources
+	 * (that is, objects implementing IChatStyleResourceSource) that are
+	 * able to accumulate several appended messages and insert them into
+	 * the chat view at once, for example, via a single JavaScript call.
+	 *
+	 * Azoth calls BeginBatch() before appending a bunch of messages via
+	 * IChatStyleResourceSource::AppendMessage() and EndBatch() after
+	 * the last one. Batches are never nested and always end within the
+	 * same event loop iteration.
+	 *
+	 * @sa IChatStyleResourceSource
+	 */
+	class ISupportBatchAppend
+	{
+	public:
+		virtual ~ISupportBatchAppend () {}
+
+		/** @brief Starts collecting appended messages for the frame.
+		 *
+		 * After this function is called the messages appended to the
+		 * given frame don't have to be visible until EndBatch() is
+		 * called for the same frame.
+		 *
+		 * @param[in] frame The chat view frame.
+		 *
+		 * @sa EndBatch()
+		 */
+		virtual void BeginBatch (QWebFrame *frame) = 0;
+
+		/** @brief Inserts the collected messages into the frame.
+		 *
+		 * @param[in] frame The chat view frame.
+		 *
+		 * @sa BeginBatch()
+		 */
+		virtual void EndBatch (QWebFrame *frame) = 0;
+	};
+}
+}
+
+Q_DECLARE_INTERFACE (LeechCraft::Azoth::ISupportBatchAppend,
+		"org.LeechCraft.Azoth.ISupportBatchAppend/1.0");
@@ -0,0 +1,254 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "ircmessageparser.h"
+#include <QTextCodec>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Acetamide
+{
+	namespace
+	{
+		int SkipSpaces (const char *data, int pos, int end)
+		{
+			while (pos < end && data [pos] == ' ')
+				++pos;
+			return pos;
+		}
+
+		int FindSpace (const char *data, int pos, int end)
+		{
+			while (pos < end && data [pos] != ' ')
+				++pos;
+			return pos;
+		}
+
+		bool IsValidCommand (const char *data, int size)
+		{
+			if (!size)
+				return false;
+
+			const auto isDigit = [] (char c) { return c >= '0' && c <= '9'; };
+			const auto isAlpha = [] (char c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); };
+
+			if (size == 3 && isDigit (data [0]) && isDigit (data [1]) && isDigit (data [2]))
+				return true;
+
+			for (int i = 0; i < size; ++i)
+				if (!isAlpha (data [i]))
+					return false;
+			return true;
+		}
+
+		void SplitPrefix (const char *data, int pos, int end, IrcLine& result)
+		{
+			int bang = -1;
+			int at = -1;
+			for (int i = pos; i < end; ++i)
+				if (data [i] == '!' && bang < 0 && at < 0)
+					bang = i;
+				else if (data [i] == '@' && at < 0)
+					at = i;
+
+			const auto nickEnd = bang >= 0 ? bang : (at >= 0 ? at : end);
+			result.Nick_ = { pos, nickEnd - pos };
+
+			if (bang >= 0)
+			{
+				const auto userEnd = at >= 0 ? at : end;
+				result.User_ = { bang + 1, userEnd - bang - 1 };
+			}
+
+			if (at >= 0)
+				result.Host_ = { at + 1, end - at - 1 };
+			else if (bang < 0)
+				result.Host_ = result.Nick_;
+		}
+	}
+
+	bool TokenizeIrcLine (const QByteArray& line, IrcLine& result)
+	{
+		result.Raw_ = line;
+		result.Tags_ = {};
+		result.Nick_ = {};
+		result.User_ = {};
+		result.Host_ = {};
+		result.Command_ = {};
+		result.Params_.clear ();
+		result.HasTrailing_ = false;
+		result.Trailing_ = {};
+
+		const auto data = line.constData ();
+		auto end = line.size ();
+		while (end > 0 && (data [end - 1] == '\n' || data [end - 1] == '\r'))
+			--end;
+
+		auto pos = 0;
+		if (pos < end && data [pos] == '@')
+		{
+			const auto tagsEnd = FindSpace (data, pos, end);
+			result.Tags_ = { pos + 1, tagsEnd - pos - 1 };
+			pos = SkipSpaces (data, tagsEnd, end);
+		}
+
+		if (pos < end && data [pos] == ':')
+		{
+			const auto prefixEnd = FindSpace (data, pos, end);
+			SplitPrefix (data, pos + 1, prefixEnd, result);
+			pos = SkipSpaces (data, prefixEnd, end);
+		}
+
+		const auto commandEnd = FindSpace (data, pos, end);
+		if (!IsValidCommand (data + pos, commandEnd - pos))
+			return false;
+		result.Command_ = { pos, commandEnd - pos };
+		pos = commandEnd;
+
+		while (pos < end)
+		{
+			// Exactly one space separates the parameters, so the trailing one may start with spaces.
+			++pos;
+			if (pos < end && data [pos] == ':')
+			{
+				result.HasTrailing_ = true;
+				result.Trailing_ = { pos + 1, end - pos - 1 };
+				break;
+			}
+
+			if (pos < end && data [pos] == ' ')
+				continue;
+
+			if (result.Params_.size () == IrcLine::MaxParams - 1)
+			{
+				result.HasTrailing_ = true;
+				result.Trailing_ = { pos, end - pos };
+				break;
+			}
+
+			const auto paramEnd = FindSpace (data, pos, end);
+			if (paramEnd > pos)
+				result.Params_.append ({ pos, paramEnd - pos });
+			pos = paramEnd;
+		}
+
+		return true;
+	}
+
+	namespace
+	{
+		QString UnescapeTagValue (const char *data, int size)
+		{
+			QByteArray result;
+			result.reserve (size);
+			for (int i = 0; i < size; ++i)
+			{
+				if (data [i] != '\\')
+				{
+					result += data [i];
+					continue;
+				}
+
+				// A lone backslash at the end of the value is dropped.
+				if (i + 1 == size)
+					break;
+
+				switch (data [++i])
+				{
+				case ':':
+					result += ';';
+					break;
+				case 's':
+					result += ' ';
+					break;
+				case 'r':
+					result += '\r';
+					break;
+				case 'n':
+					result += '\n';
+					break;
+				default:
+					result += data [i];
+					break;
+				}
+			}
+			return QString::fromUtf8 (result);
+		}
+	}
+
+	QHash<QString, QString> ParseIrcTags (const IrcLine& line)
+	{
+		QHash<QString, QString> result;
+		if (line.Tags_.IsEmpty ())
+			return result;
+
+		const auto data = line.GetData (line.Tags_);
+		const auto size = line.Tags_.Size_;
+
+		int tagStart = 0;
+		while (tagStart < size)
+		{
+			auto tagEnd = tagStart;
+			while (tagEnd < size && data [tagEnd] != ';')
+				++tagEnd;
+
+			auto eq = tagStart;
+			while (eq < tagEnd && data [eq] != '=')
+				++eq;
+
+			if (eq > tagStart)
+			{
+				const auto& key = QString::fromUtf8 (data + tagStart, eq - tagStart);
+				result [key] = eq < tagEnd ?
+						UnescapeTagValue (data + eq + 1, tagEnd - eq - 1) :
+						QString ();
+			}
+
+			tagStart = tagEnd + 1;
+		}
+
+		return result;
+	}
+
+	QString DecodeIrcPart (const IrcLine& line, const IrcLineRange& range, QTextCodec *codec)
+	{
+		const auto data = line.GetData (range);
+		for (int i = 0; i < range.Size_; ++i)
+			if (static_cast<unsigned char> (data [i]) >= 0x80)
+				return codec ?
+						codec->toUnicode (data, range.Size_) :
+						QString::fromUtf8 (data, range.Size_);
+
+		return QString::fromLatin1 (data, range.Size_);
+	}
+}
+}
+}
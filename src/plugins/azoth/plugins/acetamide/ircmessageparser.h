@@ -0,0 +1,120 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+#include <QVarLengthArray>
+#include <QHash>
+
+class QTextCodec;
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Acetamide
+{
+	/** @brief A part of a raw IRC line.
+	 */
+	struct IrcLineRange
+	{
+		int Pos_ = 0;
+		int Size_ = 0;
+
+		bool IsEmpty () const
+		{
+			return !Size_;
+		}
+	};
+
+	/** @brief A tokenized IRC line.
+	 *
+	 * All the parts are ranges in the original raw line, so tokenizing
+	 * doesn't copy or transcode anything. The parts are decoded later
+	 * and only if needed.
+	 *
+	 * The line layout is
+	 * \code
+	   [@tags] [:nick[!user][@host]] command [middle params...] [:trailing]\endcode
+	 */
+	struct IrcLine
+	{
+		/** RFC 1459 allows at most 15 parameters.
+		 */
+		enum { MaxParams = 15 };
+
+		QByteArray Raw_;
+
+		IrcLineRange Tags_;
+
+		IrcLineRange Nick_;
+		IrcLineRange User_;
+		IrcLineRange Host_;
+
+		IrcLineRange Command_;
+
+		QVarLengthArray<IrcLineRange, MaxParams> Params_;
+
+		bool HasTrailing_ = false;
+		IrcLineRange Trailing_;
+
+		const char* GetData (const IrcLineRange& range) const
+		{
+			return Raw_.constData () + range.Pos_;
+		}
+	};
+
+	/** @brief Tokenizes the raw IRC \em line.
+	 *
+	 * The trailing CR and LF characters, if any, are ignored.
+	 *
+	 * @param[in] line The raw IRC line as received from the server.
+	 * @param[out] result The tokenized line.
+	 * @return Whether the line is a valid IRC message.
+	 */
+	bool TokenizeIrcLine (const QByteArray& line, IrcLine& result);
+
+	/** @brief Parses the IRCv3 message tags of the given \em line.
+	 *
+	 * Escaped characters in the tags' values are unescaped. Tags
+	 * without values are mapped to empty strings.
+	 */
+	QHash<QString, QString> ParseIrcTags (const IrcLine& line);
+
+	/** @brief Decodes the given part of the line with the \em codec.
+	 *
+	 * Pure ASCII strings, like nicknames, commands and most of the
+	 * parameters, are converted directly without involving the
+	 * \em codec.
+	 */
+	QString DecodeIrcPart (const IrcLine& line, const IrcLineRange& range, QTextCodec *codec);
+}
+}
+}
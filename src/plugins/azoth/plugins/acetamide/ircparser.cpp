@@ -28,10 +28,6 @@
  **********************************************************************/
 
 #include "ircparser.h"
-#include <boost/bind.hpp>
-#include <boost/spirit/include/classic_core.hpp>
-#include <boost/spirit/include/classic_loops.hpp>
-#include <boost/spirit/include/classic_push_back_actor.hpp>
 #include <QTextCodec>
 #include "ircaccount.h"
 #include "ircserverhandler.h"
@@ -42,8 +38,6 @@ namespace Azoth
 {
 namespace Acetamide
 {
-	using namespace boost::spirit::classic;
-
 	IrcParser::IrcParser (IrcServerHandler *sh)
 	: ISH_ (sh)
 	, ServerOptions_ (sh->GetServerOptions ())
@@ -412,82 +406,41 @@ namespace Acetamide
 		ISH_->SendCommand (chListCmd);
 	}
 
-	bool IrcParser::ParseMessage (const QByteArray& message)
+	namespace
 	{
-		QTextCodec *codec = QTextCodec::codecForName (ISH_->
-				GetServerOptions ().ServerEncoding_.toUtf8 ());
-		const auto& msg = codec->toUnicode (message);
+		std::string ToUtf8String (const IrcLine& line, const IrcLineRange& range, QTextCodec *codec)
+		{
+			const auto data = line.GetData (range);
+			for (int i = 0; i < range.Size_; ++i)
+				if (static_cast<unsigned char> (data [i]) >= 0x80)
+					return DecodeIrcPart (line, range, codec).toUtf8 ().constData ();
 
-		IrcMessageOptions_.Command_.clear ();
-		IrcMessageOptions_.Nick_.clear ();
-		IrcMessageOptions_.Message_.clear ();
-		IrcMessageOptions_.Parameters_.clear ();
-		IrcMessageOptions_.UserName_.clear ();
-		IrcMessageOptions_.Host_.clear ();
-
-		std::string nickStr;
-		std::string userStr;
-		std::string hostStr;
-		std::string commandStr;
-		std::string msgStr;
-		QList<std::string> opts;
-
-		range<> ascii (char (0x01), char (0x7F));
-		rule<> special = lexeme_d [ch_p ('[') | ']' | '\\' | '`' |
-				'_' | '^' | '{' | '|' | '}'];
-		rule<> shortname = *(alnum_p
-				>> *(alnum_p || ch_p ('-'))
-				>> *alnum_p);
-		rule<> hostname = (shortname
-				>> *(ch_p ('.')
-				>> shortname)) [assign_a (hostStr)];
-		rule<> nickname = (alpha_p | special)
-				>> *(alnum_p | special | ch_p ('-'));
-		rule<> user =  +(ascii - '\r' - '\n' - ' ' - '@' - '\0');
-		rule<> host = lexeme_d [+(anychar_p - ' ')] ;
-		rule<> nick = lexeme_d [nickname [assign_a (nickStr)]
-				>> !(!(ch_p ('!')
-				>> user [assign_a (userStr)])
-				>> ch_p ('@')
-				>> host [assign_a (hostStr)])];
-		rule<> nospcrlfcl = (anychar_p - '\0' - '\r' - '\n' -
-				' ' - ':');
-		rule<> lastParam = lexeme_d [ch_p (' ')
-				>> !ch_p (':')
-				>> (*(ch_p (':') | ch_p (' ') | nospcrlfcl))
-					[assign_a (msgStr)]];
-		rule<> firsParam = lexeme_d [ch_p (' ')
-				>> (nospcrlfcl
-				>> *(ch_p (':') | nospcrlfcl))
-					[push_back_a (opts)]];
-		rule<> params =  *firsParam
-				>> !lastParam;
-		rule<> command = longest_d [(+alpha_p) |
-				(repeat_p (3) [digit_p])] [assign_a (commandStr)];
-		rule<> prefix = longest_d [hostname | nick];
-		rule<> reply = (lexeme_d [!(ch_p (':')
-				>> prefix >> ch_p (' '))]
-				>> command
-				>> !params
-				>> eol_p);
-
-		bool res = parse (msg.toUtf8 ().constData (), reply).full;
-
-		if (!res)
+			return { data, static_cast<std::size_t> (range.Size_) };
+		}
+	}
+
+	bool IrcParser::ParseMessage (const QByteArray& message)
+	{
+		if (!TokenizeIrcLine (message, Line_))
 		{
 			qWarning () << "input string is not a valide IRC command"
-					<< msg;
+					<< message;
 			return false;
 		}
-		else
-		{
-			IrcMessageOptions_.Nick_ = QString::fromUtf8 (nickStr.c_str ());
-			IrcMessageOptions_.Command_ = QString::fromUtf8 (commandStr.c_str ()).toLower ();
-			IrcMessageOptions_.Message_ = QString::fromUtf8 (msgStr.c_str ());
-			IrcMessageOptions_.UserName_ = QString::fromUtf8 (userStr.c_str ());
-			IrcMessageOptions_.Host_ = QString::fromUtf8 (hostStr.c_str ());
-			IrcMessageOptions_.Parameters_ = opts;
-		}
+
+		const auto codec = GetCodec ();
+
+		IrcMessageOptions_.Nick_ = DecodeIrcPart (Line_, Line_.Nick_, codec);
+		IrcMessageOptions_.UserName_ = DecodeIrcPart (Line_, Line_.User_, codec);
+		IrcMessageOptions_.Host_ = DecodeIrcPart (Line_, Line_.Host_, codec);
+		IrcMessageOptions_.Command_ = DecodeIrcPart (Line_, Line_.Command_, codec).toLower ();
+		IrcMessageOptions_.Message_ = DecodeIrcPart (Line_, Line_.Trailing_, codec);
+
+		IrcMessageOptions_.Parameters_.clear ();
+		for (const auto& param : Line_.Params_)
+			IrcMessageOptions_.Parameters_ << ToUtf8String (Line_, param, codec);
+
+		IrcMessageOptions_.Tags_ = ParseIrcTags (Line_);
 
 		return true;
 	}
@@ -499,8 +452,7 @@ namespace Acetamide
 
 	QStringList IrcParser::EncodingList (const QStringList& list)
 	{
-		QTextCodec *codec = QTextCodec::codecForName (ISH_->
-				GetServerOptions ().ServerEncoding_.toUtf8 ());
+		const auto codec = GetCodec ();
 		QStringList encodedList;
 		Q_FOREACH (const QString& str, list)
 		{
@@ -510,6 +462,25 @@ namespace Acetamide
 		return encodedList;
 	}
 
+	QTextCodec* IrcParser::GetCodec ()
+	{
+		const auto encoding = ISH_->GetServerOptions ().ServerEncoding_;
+		if (!Codec_ || encoding != CodecName_)
+		{
+			CodecName_ = encoding;
+			Codec_ = QTextCodec::codecForName (encoding.toUtf8 ());
+			if (!Codec_)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unknown encoding"
+						<< encoding
+						<< ", falling back to UTF-8";
+				Codec_ = QTextCodec::codecForName ("UTF-8");
+			}
+		}
+		return Codec_;
+	}
+
 };
 };
 };
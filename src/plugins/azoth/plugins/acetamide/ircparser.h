@@ -33,6 +33,9 @@
 #include <QObject>
 #include "core.h"
 #include "localtypes.h"
+#include "ircmessageparser.h"
+
+class QTextCodec;
 
 namespace LeechCraft
 {
@@ -52,6 +55,11 @@ namespace Acetamide
 		IrcMessageOptions IrcMessageOptions_;
 
 		QStringList LongAnswerCommands_;
+
+		IrcLine Line_;
+
+		QString CodecName_;
+		QTextCodec *Codec_ = nullptr;
 	public:
 		IrcParser (IrcServerHandler*);
 
@@ -107,6 +115,7 @@ namespace Acetamide
 		IrcMessageOptions GetIrcMessageOptions () const;
 	private:
 		QStringList EncodingList (const QStringList&);
+		QTextCodec* GetCodec ();
 	};
 };
 };
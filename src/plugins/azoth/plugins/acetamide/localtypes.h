@@ -33,6 +33,7 @@
 #include <QStringList>
 #include <QPair>
 #include <QDateTime>
+#include <QHash>
 
 namespace LeechCraft
 {
@@ -108,6 +109,7 @@ namespace Acetamide
 		QString Command_;
 		QString Message_;
 		QList<std::string> Parameters_;
+		QHash<QString, QString> Tags_;
 	};
 
 	struct IrcBookmark
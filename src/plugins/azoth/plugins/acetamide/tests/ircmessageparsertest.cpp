@@ -0,0 +1,236 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "ircmessageparsertest.h"
+#include <stdexcept>
+#include <QtTest>
+#include <QTextCodec>
+#include "ircmessageparser.cpp"
+
+QTEST_MAIN (LeechCraft::Azoth::Acetamide::IrcMessageParserTest)
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+namespace Acetamide
+{
+	namespace
+	{
+		QByteArray Part (const IrcLine& line, const IrcLineRange& range)
+		{
+			return QByteArray (line.GetData (range), range.Size_);
+		}
+
+		IrcLine Tokenize (const QByteArray& raw)
+		{
+			IrcLine line;
+			if (!TokenizeIrcLine (raw, line))
+				throw std::runtime_error ("unable to tokenize");
+			return line;
+		}
+
+		/* Mimics a capture of a server log while joining a large
+		 * channel: a NAMES burst, a WHO burst and some chatter.
+		 */
+		QList<QByteArray> MakeServerLog ()
+		{
+			QList<QByteArray> result;
+
+			for (int i = 0; i < 50; ++i)
+			{
+				QByteArray names = ":irc.example.net 353 leechcraft = #bigchannel :";
+				for (int j = 0; j < 200; ++j)
+					names += (j % 7 ? "" : "@") + QByteArray ("user") + QByteArray::number (i * 200 + j) + ' ';
+				result << names + "\r\n";
+			}
+			result << ":irc.example.net 366 leechcraft #bigchannel :End of /NAMES list.\r\n";
+
+			for (int i = 0; i < 10000; ++i)
+			{
+				const auto& num = QByteArray::number (i);
+				result << ":irc.example.net 352 leechcraft #bigchannel ~user" + num +
+						" host-" + num + ".example.com irc.example.net user" + num +
+						" H :0 Real Name " + num + "\r\n";
+			}
+			result << ":irc.example.net 315 leechcraft #bigchannel :End of /WHO list.\r\n";
+
+			for (int i = 0; i < 2000; ++i)
+			{
+				const auto& num = QByteArray::number (i);
+				result << "@time=2014-10-18T12:00:00.000Z;account=user" + num +
+						" :user" + num + "!~user" + num + "@host-" + num +
+						".example.com PRIVMSG #bigchannel :hello, this is message number " + num + "\r\n";
+			}
+
+			return result;
+		}
+	}
+
+	void IrcMessageParserTest::commandOnly ()
+	{
+		const auto& line = Tokenize ("PING\r\n");
+		QCOMPARE (Part (line, line.Command_), QByteArray ("PING"));
+		QVERIFY (line.Nick_.IsEmpty ());
+		QCOMPARE (line.Params_.size (), 0);
+		QVERIFY (!line.HasTrailing_);
+	}
+
+	void IrcMessageParserTest::numericWithParams ()
+	{
+		const auto& line = Tokenize (":irc.example.net 001 nick :Welcome to the network\r\n");
+		QCOMPARE (Part (line, line.Command_), QByteArray ("001"));
+		QCOMPARE (line.Params_.size (), 1);
+		QCOMPARE (Part (line, line.Params_ [0]), QByteArray ("nick"));
+		QVERIFY (line.HasTrailing_);
+		QCOMPARE (Part (line, line.Trailing_), QByteArray ("Welcome to the network"));
+	}
+
+	void IrcMessageParserTest::fullPrefix ()
+	{
+		const auto& line = Tokenize (":nick!~user@host.example.com JOIN #channel\r\n");
+		QCOMPARE (Part (line, line.Nick_), QByteArray ("nick"));
+		QCOMPARE (Part (line, line.User_), QByteArray ("~user"));
+		QCOMPARE (Part (line, line.Host_), QByteArray ("host.example.com"));
+		QCOMPARE (Part (line, line.Command_), QByteArray ("JOIN"));
+		QCOMPARE (line.Params_.size (), 1);
+		QCOMPARE (Part (line, line.Params_ [0]), QByteArray ("#channel"));
+	}
+
+	void IrcMessageParserTest::serverPrefix ()
+	{
+		const auto& line = Tokenize (":irc.example.net NOTICE * :Looking up your hostname\r\n");
+		QCOMPARE (Part (line, line.Nick_), QByteArray ("irc.example.net"));
+		QCOMPARE (Part (line, line.Host_), QByteArray ("irc.example.net"));
+		QVERIFY (line.User_.IsEmpty ());
+	}
+
+	void IrcMessageParserTest::trailingWithColons ()
+	{
+		const auto& line = Tokenize (":a!b@c PRIVMSG #chan ::) see http://example.com\r\n");
+		QCOMPARE (Part (line, line.Trailing_), QByteArray (":) see http://example.com"));
+	}
+
+	void IrcMessageParserTest::emptyTrailing ()
+	{
+		const auto& line = Tokenize ("TOPIC #chan :\r\n");
+		QVERIFY (line.HasTrailing_);
+		QVERIFY (line.Trailing_.IsEmpty ());
+		QCOMPARE (line.Params_.size (), 1);
+	}
+
+	void IrcMessageParserTest::extraSpaces ()
+	{
+		const auto& line = Tokenize ("MODE  #chan   +o  nick \r\n");
+		QCOMPARE (line.Params_.size (), 3);
+		QCOMPARE (Part (line, line.Params_ [2]), QByteArray ("nick"));
+		QVERIFY (!line.HasTrailing_);
+	}
+
+	void IrcMessageParserTest::maxParams ()
+	{
+		const auto& line = Tokenize ("CMD 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16\r\n");
+		QCOMPARE (line.Params_.size (), 14);
+		QVERIFY (line.HasTrailing_);
+		QCOMPARE (Part (line, line.Trailing_), QByteArray ("15 16"));
+	}
+
+	void IrcMessageParserTest::tags ()
+	{
+		const auto& line = Tokenize ("@time=2014-10-18T12:00:00.000Z;msgid=a\\sb\\:c;flag :n!u@h PRIVMSG #c :hi\r\n");
+		QCOMPARE (Part (line, line.Command_), QByteArray ("PRIVMSG"));
+
+		const auto& tags = ParseIrcTags (line);
+		QCOMPARE (tags.size (), 3);
+		QCOMPARE (tags ["time"], QString ("2014-10-18T12:00:00.000Z"));
+		QCOMPARE (tags ["msgid"], QString ("a b;c"));
+		QVERIFY (tags.contains ("flag"));
+		QVERIFY (tags ["flag"].isEmpty ());
+	}
+
+	void IrcMessageParserTest::tagsTrailingBackslash ()
+	{
+		const auto& line = Tokenize ("@a=x\\;b=\\;c=y\\\\ :n!u@h PRIVMSG #c :hi\r\n");
+
+		const auto& tags = ParseIrcTags (line);
+		QCOMPARE (tags.size (), 3);
+		QCOMPARE (tags ["a"], QString ("x"));
+		QVERIFY (tags ["b"].isEmpty ());
+		QCOMPARE (tags ["c"], QString ("y\\"));
+	}
+
+	void IrcMessageParserTest::invalidCommand ()
+	{
+		IrcLine line;
+		QVERIFY (!TokenizeIrcLine (":nick!user@host\r\n", line));
+		QVERIFY (!TokenizeIrcLine ("12 param\r\n", line));
+		QVERIFY (!TokenizeIrcLine ("PRIV-MSG param\r\n", line));
+	}
+
+	void IrcMessageParserTest::decodeNonAscii ()
+	{
+		const auto codec = QTextCodec::codecForName ("KOI8-R");
+		const auto& text = QString::fromUtf8 ("\xd0\xbf\xd1\x80\xd0\xb8\xd0\xb2\xd0\xb5\xd1\x82");
+		const auto& line = Tokenize ("PRIVMSG #chan :" + codec->fromUnicode (text) + "\r\n");
+		QCOMPARE (DecodeIrcPart (line, line.Trailing_, codec), text);
+		QCOMPARE (DecodeIrcPart (line, line.Params_ [0], codec), QString ("#chan"));
+	}
+
+	void IrcMessageParserTest::benchTokenize ()
+	{
+		const auto& log = MakeServerLog ();
+		IrcLine line;
+		QBENCHMARK
+		{
+			for (const auto& raw : log)
+				TokenizeIrcLine (raw, line);
+		}
+	}
+
+	void IrcMessageParserTest::benchTokenizeDecode ()
+	{
+		const auto& log = MakeServerLog ();
+		const auto codec = QTextCodec::codecForName ("UTF-8");
+		IrcLine line;
+		QBENCHMARK
+		{
+			for (const auto& raw : log)
+			{
+				TokenizeIrcLine (raw, line);
+				DecodeIrcPart (line, line.Nick_, codec);
+				DecodeIrcPart (line, line.Command_, codec);
+				DecodeIrcPart (line, line.Trailing_, codec);
+				for (const auto& param : line.Params_)
+					DecodeIrcPart (line, param, codec);
+			}
+		}
+	}
+}
+}
+}
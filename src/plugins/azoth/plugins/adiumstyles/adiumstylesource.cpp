@@ -347,7 +347,12 @@ namespace AdiumStyles
 		}
 
 		const QString& command = isNextMsg ? "appendNextMessage(\"%1\");" : "appendMessage(\"%1\");";
-		frame->evaluateJavaScript (command.arg (body));
+
+		const auto batch = Batches_.find (frame);
+		if (batch != Batches_.end ())
+			batch->Script_ += command.arg (body);
+		else
+			frame->evaluateJavaScript (command.arg (body));
 
 		if (templ.contains ("%stateElementId%"))
 		{
@@ -374,13 +379,42 @@ namespace AdiumStyles
 
 			const QString& selector = QString ("*[id=\"delivery_state_%1\"]")
 					.arg (GetMessageID (msgObj));
-			QWebElement elem = frame->findFirstElement (selector);
-			elem.setInnerXml (replacement);
+			if (batch != Batches_.end ())
+				batch->StateElements_.append ({ selector, replacement });
+			else
+			{
+				QWebElement elem = frame->findFirstElement (selector);
+				elem.setInnerXml (replacement);
+			}
 		}
 
 		return true;
 	}
 
+	void AdiumStyleSource::BeginBatch (QWebFrame *frame)
+	{
+		connect (frame,
+				SIGNAL (destroyed (QObject*)),
+				this,
+				SLOT (handleFrameDestroyed ()),
+				Qt::UniqueConnection);
+
+		Batches_ [frame] = PendingBatch ();
+	}
+
+	void AdiumStyleSource::EndBatch (QWebFrame *frame)
+	{
+		const auto& batch = Batches_.take (frame);
+		if (!batch.Script_.isEmpty ())
+			frame->evaluateJavaScript (batch.Script_);
+
+		for (const auto& pair : batch.StateElements_)
+		{
+			QWebElement elem = frame->findFirstElement (pair.first);
+			elem.setInnerXml (pair.second);
+		}
+	}
+
 	void AdiumStyleSource::FrameFocused (QWebFrame*)
 	{
 	}
@@ -772,6 +806,7 @@ namespace AdiumStyles
 
 		Frame2LastContact_.remove (static_cast<QWebFrame*> (sender ()));
 		Frame2Pack_.remove (static_cast<QWebFrame*> (sender ()));
+		Batches_.remove (static_cast<QWebFrame*> (sender ()));
 	}
 }
 }
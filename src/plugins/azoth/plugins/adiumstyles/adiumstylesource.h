@@ -36,6 +36,7 @@
 #include <QColor>
 #include <QCache>
 #include <interfaces/azoth/ichatstyleresourcesource.h>
+#include <interfaces/azoth/isupportbatchappend.h>
 #include "plistparser.h"
 
 namespace LeechCraft
@@ -58,9 +59,11 @@ namespace AdiumStyles
 
 	class AdiumStyleSource : public QObject
 						   , public IChatStyleResourceSource
+						   , public ISupportBatchAppend
 	{
 		Q_OBJECT
-		Q_INTERFACES (LeechCraft::Azoth::IChatStyleResourceSource)
+		Q_INTERFACES (LeechCraft::Azoth::IChatStyleResourceSource
+				LeechCraft::Azoth::ISupportBatchAppend)
 
 		std::shared_ptr<Util::ResourceLoader> StylesLoader_;
 		IProxyObject *Proxy_;
@@ -78,6 +81,13 @@ namespace AdiumStyles
 
 		mutable QCache<QString, QString> AvatarsCache_;
 		mutable QCache<IAccount*, QString> OurAvatarsCache_;
+
+		struct PendingBatch
+		{
+			QString Script_;
+			QList<QPair<QString, QString>> StateElements_;
+		};
+		QHash<QWebFrame*, PendingBatch> Batches_;
 	public:
 		AdiumStyleSource (IProxyObject*, QObject* = 0);
 
@@ -88,6 +98,9 @@ namespace AdiumStyles
 		bool AppendMessage (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
 		void FrameFocused (QWebFrame*);
 		QStringList GetVariantsForPack (const QString&);
+
+		void BeginBatch (QWebFrame*);
+		void EndBatch (QWebFrame*);
 	private:
 		void PercentTemplate (QString&, const QMap<QString, QString>&) const;
 		void ParseGlobalTemplate (QString& templ, ICLEntry*) const;
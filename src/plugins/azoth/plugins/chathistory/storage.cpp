@@ -34,6 +34,8 @@
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QDir>
+#include <QTimer>
+#include <QElapsedTimer>
 #include <QtDebug>
 #include <util/db/dblock.h>
 #include <util/sys/paths.h>
@@ -53,13 +55,16 @@ namespace ChatHistory
 	Storage::RawSearchResult::RawSearchResult ()
 	: EntryID_ (0)
 	, AccountID_ (0)
+	, Rowid_ (0)
 	{
 	}
 
-	Storage::RawSearchResult::RawSearchResult (qint32 entryId, qint32 accountId, const QDateTime& date)
+	Storage::RawSearchResult::RawSearchResult (qint32 entryId, qint32 accountId,
+			const QDateTime& date, qint64 rowid)
 	: EntryID_ (entryId)
 	, AccountID_ (accountId)
 	, Date_ (date)
+	, Rowid_ (rowid)
 	{
 	}
 
@@ -68,9 +73,39 @@ namespace ChatHistory
 		return Date_.isNull () || !EntryID_ || !AccountID_;
 	}
 
+	namespace
+	{
+		const int MaxBatchSize = 200;
+		const int MaxBatchDelay = 100;
+
+		QString GetHistoryTableQuery (const QString& name)
+		{
+			return "CREATE TABLE " + name + " ("
+					"MsgId INTEGER PRIMARY KEY, "
+					"Id INTEGER, "
+					"AccountId INTEGER, "
+					"Date DATETIME, "
+					"Direction INTEGER, "
+					"Message TEXT, "
+					"Variant TEXT, "
+					"Type INTEGER, "
+					"RichMessage TEXT, "
+					"EscapePolicy VARCHAR(3), "
+					"UNIQUE (Id, AccountId, Date, Direction, Message, Variant, Type) ON CONFLICT IGNORE);";
+		}
+	}
+
 	Storage::Storage (QObject *parent)
 	: QObject (parent)
+	, FlushTimer_ (new QTimer (this))
 	{
+		FlushTimer_->setSingleShot (true);
+		FlushTimer_->setInterval (MaxBatchDelay);
+		connect (FlushTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (flushPending ()));
+
 		DB_.reset (new QSqlDatabase (QSqlDatabase::addDatabase ("QSQLITE", "History connection")));
 		DB_->setDatabaseName (Util::CreateIfNotExists ("azoth").filePath ("history.db"));
 		if (!DB_->open ())
@@ -126,40 +161,32 @@ namespace ChatHistory
 				"AND Date >= :lower_date "
 				"AND Date <= :upper_date");
 
-		LogsSearcher_ = QSqlQuery (*DB_);
-		LogsSearcher_.prepare ("SELECT date FROM azoth_history "
+		/* The queries below refer to the messages by Rowid: it is an
+		 * alias for MsgId in the current table, while the old one that
+		 * is used until migrateHistory() is done has no MsgId, but its
+		 * rowids become the MsgIds of the migrated messages.
+		 */
+		Rowid2Pos_ = QSqlQuery (*DB_);
+		Rowid2Pos_.prepare ("SELECT COUNT(1) FROM azoth_history "
 				"WHERE Id = :entry_id "
 				"AND AccountID = :account_id "
-				"AND Date = (SELECT Date FROM azoth_history "
-				"	WHERE Id = :inner_entry_id "
-				"	AND AccountID = :inner_account_id "
-				"	AND ((Message LIKE :text AND :insensitive) OR (Message GLOB :ctext AND :sensitive)) "
-				"	ORDER BY Rowid DESC "
-				"	LIMIT 1 OFFSET :offset);");
-
-		LogsSearcherWOContact_ = QSqlQuery (*DB_);
-		LogsSearcherWOContact_.prepare ("SELECT Date, Id FROM azoth_history "
-				"WHERE AccountID = :account_id "
-				"AND Date = (SELECT Date FROM azoth_history "
-				"	WHERE AccountID = :inner_account_id "
-				"	AND ((Message LIKE :text AND :insensitive) OR (Message GLOB :ctext AND :sensitive)) "
-				"	ORDER BY Rowid DESC "
-				"	LIMIT 1 OFFSET :offset);");
-
-		LogsSearcherWOContactAccount_ = QSqlQuery (*DB_);
-		LogsSearcherWOContactAccount_.prepare ("SELECT Date, Id, AccountID FROM azoth_history "
-				"WHERE Date = (SELECT Date FROM azoth_history "
-				"	WHERE ((Message LIKE :text AND :insensitive) OR (Message GLOB :ctext AND :sensitive)) "
-				"	ORDER BY Rowid DESC "
-				"	LIMIT 1 OFFSET :offset);");
+				"AND Rowid >= :rowid");
 
 		HistoryGetter_ = QSqlQuery (*DB_);
-		HistoryGetter_.prepare ("SELECT Date, Direction, Message, Variant, Type, RichMessage, EscapePolicy "
+		HistoryGetter_.prepare ("SELECT Date, Direction, Message, Variant, Type, RichMessage, EscapePolicy, Rowid "
 				"FROM azoth_history "
 				"WHERE Id = :entry_id "
 				"AND AccountID = :account_id "
 				"ORDER BY Rowid DESC LIMIT :limit OFFSET :offset;");
 
+		HistoryGetterBefore_ = QSqlQuery (*DB_);
+		HistoryGetterBefore_.prepare ("SELECT Date, Direction, Message, Variant, Type, RichMessage, EscapePolicy, Rowid "
+				"FROM azoth_history "
+				"WHERE Id = :entry_id "
+				"AND AccountID = :account_id "
+				"AND Rowid < :rowid "
+				"ORDER BY Rowid DESC LIMIT :limit;");
+
 		HistoryClearer_ = QSqlQuery (*DB_);
 		HistoryClearer_.prepare ("DELETE FROM azoth_history WHERE Id = :entry_id AND AccountID = :account_id;");
 
@@ -176,6 +203,8 @@ namespace ChatHistory
 		EntryCacheClearer_ = QSqlQuery (*DB_);
 		EntryCacheClearer_.prepare ("DELETE FROM azoth_entrycache WHERE Id = :user_id;");
 
+		PrepareIndexQueries ();
+
 		try
 		{
 			Users_ = GetUsers ();
@@ -201,6 +230,27 @@ namespace ChatHistory
 		PrepareEntryCache ();
 	}
 
+	Storage::~Storage ()
+	{
+		flushPending ();
+
+		if (FlushStats_.Batches_)
+			qDebug () << Q_FUNC_INFO
+					<< "wrote"
+					<< FlushStats_.Messages_
+					<< "messages in"
+					<< FlushStats_.Batches_
+					<< "batches, average batch"
+					<< static_cast<double> (FlushStats_.Messages_) / FlushStats_.Batches_
+					<< "max batch"
+					<< FlushStats_.MaxBatch_
+					<< "; average commit time"
+					<< static_cast<double> (FlushStats_.TotalMSecs_) / FlushStats_.Batches_
+					<< "ms, max"
+					<< FlushStats_.MaxMSecs_
+					<< "ms";
+	}
+
 	void Storage::InitializeTables ()
 	{
 		Util::DBLock lock (*DB_);
@@ -234,17 +284,7 @@ namespace ChatHistory
 				});
 		table2query.append ({
 					"azoth_history",
-					"CREATE TABLE azoth_history ("
-						"Id INTEGER, "
-						"AccountId INTEGER, "
-						"Date DATETIME, "
-						"Direction INTEGER, "
-						"Message TEXT, "
-						"Variant TEXT, "
-						"Type INTEGER, "
-						"RichMessage TEXT, "
-						"EscapePolicy VARCHAR(3), "
-						"UNIQUE (Id, AccountId, Date, Direction, Message, Variant, Type) ON CONFLICT IGNORE);"
+					GetHistoryTableQuery ("azoth_history")
 				});
 		table2query.append ({
 					"azoth_entrycache",
@@ -282,8 +322,19 @@ namespace ChatHistory
 		}
 
 		UpdateTables ();
+		InitializeIndex ();
+
+		// The migrated table comes with its own azoth_history_entry index.
+		if (!query.exec ("SELECT 1 FROM sqlite_master WHERE type = 'index' AND name = 'azoth_history_entry';"))
+		{
+			Util::DBLock::DumpError (query);
+			throw std::runtime_error ("Unable to query `azoth_history` indexes.");
+		}
+		const bool hasMigratedIndex = query.next ();
+		query.finish ();
 
-		if (!query.exec ("CREATE INDEX IF NOT EXISTS azoth_history_id_accountid ON azoth_history (Id, AccountId);"))
+		if (!MigratingHistory_ && !hasMigratedIndex &&
+				!query.exec ("CREATE INDEX IF NOT EXISTS azoth_history_id_accountid ON azoth_history (Id, AccountId);"))
 		{
 			Util::DBLock::DumpError (query);
 			throw std::runtime_error ("Unable to index `azoth_history`.");
@@ -328,6 +379,136 @@ namespace ChatHistory
 					<< columns;
 			throw std::runtime_error ("Unable to add column `EscapePolicy` to `azoth_history`.");
 		}
+
+		// The full-text index refers to the messages by their rowids,
+		// and implicit rowids may be renumbered by VACUUM, so the
+		// messages are moved to a table with an explicit key keeping
+		// the current values.
+		if (!columns.contains ("MsgId"))
+			StartHistoryMigration ();
+	}
+
+	void Storage::StartHistoryMigration ()
+	{
+		QSqlQuery query { *DB_ };
+
+		// The copying itself is done in background by migrateHistory(),
+		// and the old full-text index is dropped to be recreated against
+		// the new key once it's done.
+		if (!DB_->tables ().contains ("azoth_history_migration") &&
+				!(query.exec ("DROP TABLE IF EXISTS azoth_history_new;") &&
+					query.exec (GetHistoryTableQuery ("azoth_history_new")) &&
+					query.exec ("CREATE INDEX azoth_history_entry ON azoth_history_new (Id, AccountId);") &&
+					query.exec ("CREATE TABLE azoth_history_migration (CopiedUpTo INTEGER);") &&
+					query.exec ("INSERT INTO azoth_history_migration (CopiedUpTo) VALUES (0);") &&
+					query.exec ("DROP TABLE IF EXISTS azoth_history_fts;") &&
+					query.exec ("DROP TABLE IF EXISTS azoth_history_fts_backfill;")))
+		{
+			Util::DBLock::DumpError (query);
+			throw std::runtime_error ("Unable to start migrating `azoth_history`.");
+		}
+
+		if (!query.exec ("SELECT CopiedUpTo FROM azoth_history_migration;") ||
+				!query.next ())
+		{
+			Util::DBLock::DumpError (query);
+			throw std::runtime_error ("Unable to get `azoth_history` migration state.");
+		}
+
+		MigratedUpTo_ = query.value (0).toLongLong ();
+		MigratingHistory_ = true;
+		query.finish ();
+
+		qDebug () << Q_FUNC_INFO
+				<< "history migration is at"
+				<< MigratedUpTo_;
+
+		QTimer::singleShot (0,
+				this,
+				SLOT (migrateHistory ()));
+	}
+
+	void Storage::InitializeIndex ()
+	{
+		if (MigratingHistory_)
+			return;
+
+		QSqlQuery query { *DB_ };
+
+		if (!DB_->tables ().contains ("azoth_history_fts"))
+		{
+			// The trigram tokenizer allows the index to be used for the
+			// very same LIKE and GLOB substring matches the search is
+			// based upon.
+			if (!query.exec ("CREATE VIRTUAL TABLE azoth_history_fts USING fts5 ("
+						"Message, content='azoth_history', content_rowid='MsgId', tokenize='trigram');"))
+			{
+				Util::DBLock::DumpError (query);
+				qWarning () << Q_FUNC_INFO
+						<< "unable to create the full-text index, search will be slow";
+				return;
+			}
+
+			// Existing messages are indexed later in background by
+			// backfillIndex(), while the new ones are indexed in
+			// addMessage() right away.
+			if (!query.exec ("CREATE TABLE azoth_history_fts_backfill (IndexedUpTo INTEGER, Target INTEGER);") ||
+					!query.exec ("INSERT INTO azoth_history_fts_backfill (IndexedUpTo, Target) "
+						"SELECT 0, COALESCE (MAX (MsgId), 0) FROM azoth_history;"))
+			{
+				Util::DBLock::DumpError (query);
+				throw std::runtime_error ("Unable to initialize full-text index backfill state.");
+			}
+		}
+
+		HasIndex_ = true;
+
+		if (!DB_->tables ().contains ("azoth_history_fts_backfill"))
+			return;
+
+		if (!query.exec ("SELECT IndexedUpTo, Target FROM azoth_history_fts_backfill;"))
+		{
+			Util::DBLock::DumpError (query);
+			throw std::runtime_error ("Unable to get full-text index backfill state.");
+		}
+
+		if (query.next ())
+		{
+			IndexedUpTo_ = query.value (0).toLongLong ();
+			IndexTarget_ = query.value (1).toLongLong ();
+		}
+		query.finish ();
+
+		qDebug () << Q_FUNC_INFO
+				<< "full-text index backfill is at"
+				<< IndexedUpTo_
+				<< "of"
+				<< IndexTarget_;
+
+		QTimer::singleShot (0,
+				this,
+				SLOT (backfillIndex ()));
+	}
+
+	void Storage::PrepareIndexQueries ()
+	{
+		if (!HasIndex_)
+			return;
+
+		IndexInserter_ = QSqlQuery (*DB_);
+		IndexInserter_.prepare ("INSERT INTO azoth_history_fts (rowid, Message) VALUES (:rowid, :message);");
+
+		IndexClearer_ = QSqlQuery (*DB_);
+		IndexClearer_.prepare ("INSERT INTO azoth_history_fts (azoth_history_fts, rowid, Message) "
+				"SELECT 'delete', Rowid, Message FROM azoth_history "
+				"WHERE Id = :entry_id "
+				"AND AccountID = :account_id "
+				"AND (Rowid <= :indexed_up_to OR Rowid > :index_target);");
+	}
+
+	bool Storage::IsIndexReady () const
+	{
+		return HasIndex_ && IndexedUpTo_ >= IndexTarget_;
 	}
 
 	QHash<QString, qint32> Storage::GetUsers ()
@@ -471,152 +652,132 @@ namespace ChatHistory
 		}
 	}
 
-	namespace
+	Storage::RawSearchResult Storage::Search (qint32 accountId,
+			qint32 entryId, const QString& text, int shift, bool cs)
 	{
-		std::shared_ptr<void> CleanupQueryGuard (QSqlQuery& query)
+		if (SearchCursor_.AccountID_ != accountId ||
+				SearchCursor_.EntryID_ != entryId ||
+				SearchCursor_.Text_ != text ||
+				SearchCursor_.CS_ != cs)
 		{
-			return std::shared_ptr<void> (nullptr, [&query] (void*) { query.finish (); });
+			SearchCursor_.AccountID_ = accountId;
+			SearchCursor_.EntryID_ = entryId;
+			SearchCursor_.Text_ = text;
+			SearchCursor_.CS_ = cs;
+			SearchCursor_.Shift2Rowid_.clear ();
 		}
-	}
 
-	Storage::RawSearchResult Storage::Search (const QString& accountId,
-			const QString& entryId, const QString& text, int shift, bool cs)
-	{
-		if (!Accounts_.contains (accountId))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "Accounts_ doesn't contain"
-					<< accountId
-					<< "; raw contents"
-					<< Accounts_;
-			return RawSearchResult ();
-		}
-		if (!Users_.contains (entryId))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "Users_ doesn't contain"
-					<< entryId
-					<< "; raw contents"
-					<< Users_;
-			return RawSearchResult ();
-		}
-
-		const qint32 intEntryId = Users_ [entryId];
-		const qint32 intAccId = Accounts_ [accountId];
-		LogsSearcher_.bindValue (":entry_id", intEntryId);
-		LogsSearcher_.bindValue (":account_id", intAccId);
-		LogsSearcher_.bindValue (":inner_entry_id", intEntryId);
-		LogsSearcher_.bindValue (":inner_account_id", intAccId);
-		LogsSearcher_.bindValue (":text", '%' + text + '%');
-		LogsSearcher_.bindValue (":ctext", '*' + text + '*');
-		LogsSearcher_.bindValue (":sensitive", static_cast<int> (cs));
-		LogsSearcher_.bindValue (":insensitive", static_cast<int> (!cs));
-		LogsSearcher_.bindValue (":offset", shift);
-		if (!LogsSearcher_.exec ())
-		{
-			Util::DBLock::DumpError (LogsSearcher_);
-			return RawSearchResult ();
-		}
-		auto guard = CleanupQueryGuard (LogsSearcher_);
-
-		if (!LogsSearcher_.next ())
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to move to the next entry";
-			return RawSearchResult ();
-		}
+		// Start from the closest previous match we already know about,
+		// skipping only the matches between it and the requested one.
+		qint64 anchor = 0;
+		int offset = shift;
+		int anchorShift = -1;
+		for (auto i = SearchCursor_.Shift2Rowid_.begin (),
+				end = SearchCursor_.Shift2Rowid_.end (); i != end; ++i)
+			if (i.key () < shift && i.key () > anchorShift)
+			{
+				anchorShift = i.key ();
+				anchor = i.value ();
+				offset = shift - anchorShift - 1;
+			}
 
-		return RawSearchResult (intEntryId, intAccId, LogsSearcher_.value (0).toDateTime ());
-	}
+		const bool useIndex = IsIndexReady ();
+		const QString msgField = useIndex ? "f.Message" : "h.Message";
+
+		QString queryStr = "SELECT h.Date, h.Id, h.AccountId, h.Rowid ";
+		queryStr += useIndex ?
+				"FROM azoth_history_fts f, azoth_history h WHERE h.Rowid = f.rowid " :
+				"FROM azoth_history h WHERE 1 ";
+		queryStr += cs ?
+				"AND " + msgField + " GLOB :text " :
+				"AND " + msgField + " LIKE :text ";
+		if (accountId)
+			queryStr += "AND h.AccountId = :account_id ";
+		if (entryId)
+			queryStr += "AND h.Id = :entry_id ";
+		if (anchor)
+			queryStr += "AND h.Rowid < :anchor ";
+		queryStr += "ORDER BY h.Rowid DESC LIMIT 1 OFFSET :offset;";
 
-	Storage::RawSearchResult Storage::Search (const QString& accountId,
-			const QString& text, int shift, bool cs)
-	{
-		if (!Accounts_.contains (accountId))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "Accounts_ doesn't contain"
-					<< accountId
-					<< "; raw contents"
-					<< Accounts_;
-			return RawSearchResult ();
-		}
-
-		const qint32 intAccId = Accounts_ [accountId];
-		LogsSearcherWOContact_.bindValue (":account_id", intAccId);
-		LogsSearcherWOContact_.bindValue (":inner_account_id", intAccId);
-		LogsSearcherWOContact_.bindValue (":text", '%' + text + '%');
-		LogsSearcherWOContact_.bindValue (":ctext", '*' + text + '*');
-		LogsSearcherWOContact_.bindValue (":sensitive", static_cast<int> (cs));
-		LogsSearcherWOContact_.bindValue (":insensitive", static_cast<int> (!cs));
-		LogsSearcherWOContact_.bindValue (":offset", shift);
-		if (!LogsSearcherWOContact_.exec ())
+		QSqlQuery query { *DB_ };
+		query.prepare (queryStr);
+		query.bindValue (":text", cs ? '*' + text + '*' : '%' + text + '%');
+		if (accountId)
+			query.bindValue (":account_id", accountId);
+		if (entryId)
+			query.bindValue (":entry_id", entryId);
+		if (anchor)
+			query.bindValue (":anchor", anchor);
+		query.bindValue (":offset", offset);
+
+		if (!query.exec ())
 		{
-			Util::DBLock::DumpError (LogsSearcherWOContact_);
+			Util::DBLock::DumpError (query);
 			return RawSearchResult ();
 		}
 
-		if (!LogsSearcherWOContact_.next ())
+		if (!query.next ())
 		{
 			qWarning () << Q_FUNC_INFO
 					<< "unable to move to the next entry";
 			return RawSearchResult ();
 		}
 
-		auto guard = CleanupQueryGuard (LogsSearcherWOContact_);
-
-		return RawSearchResult (LogsSearcherWOContact_.value (1).toInt (),
-				intAccId,
-				LogsSearcherWOContact_.value (0).toDateTime ());
+		const RawSearchResult result
+		{
+			query.value (1).toInt (),
+			query.value (2).toInt (),
+			query.value (0).toDateTime (),
+			query.value (3).toLongLong ()
+		};
+		SearchCursor_.Shift2Rowid_ [shift] = result.Rowid_;
+		return result;
 	}
 
-	Storage::RawSearchResult Storage::Search (const QString& text, int shift, bool cs)
+	void Storage::SearchDate (qint32 accountId, qint32 entryId, const QDateTime& dt)
 	{
-		LogsSearcherWOContactAccount_.bindValue (":text", '%' + text + '%');
-		LogsSearcherWOContactAccount_.bindValue (":ctext", '*' + text + '*');
-		LogsSearcherWOContactAccount_.bindValue (":sensitive", static_cast<int> (cs));
-		LogsSearcherWOContactAccount_.bindValue (":insensitive", static_cast<int> (!cs));
-		LogsSearcherWOContactAccount_.bindValue (":offset", shift);
-		if (!LogsSearcherWOContactAccount_.exec ())
+		Date2Pos_.bindValue (":date", dt);
+		Date2Pos_.bindValue (":account_id", accountId);
+		Date2Pos_.bindValue (":entry_id", entryId);
+		if (!Date2Pos_.exec ())
 		{
-			Util::DBLock::DumpError (LogsSearcherWOContactAccount_);
-			return RawSearchResult ();
+			Util::DBLock::DumpError (Date2Pos_);
+			return;
 		}
 
-		if (!LogsSearcherWOContactAccount_.next ())
+		if (!Date2Pos_.next ())
 		{
 			qWarning () << Q_FUNC_INFO
-					<< "unable to move to the next entry";
-			return RawSearchResult ();
+					<< "unable to navigate to next record";
+			return;
 		}
 
-		auto guard = CleanupQueryGuard (LogsSearcherWOContactAccount_);
+		const int index = Date2Pos_.value (0).toInt ();
+		Date2Pos_.finish ();
 
-		return RawSearchResult (LogsSearcherWOContactAccount_.value (1).toInt (),
-				LogsSearcherWOContactAccount_.value (2).toInt (),
-				LogsSearcherWOContactAccount_.value (0).toDateTime ());
+		emit gotSearchPosition (Accounts_.key (accountId), Users_.key (entryId), index);
 	}
 
-	void Storage::SearchDate (qint32 accountId, qint32 entryId, const QDateTime& dt)
+	void Storage::SearchRowid (qint32 accountId, qint32 entryId, qint64 rowid)
 	{
-		Date2Pos_.bindValue (":date", dt);
-		Date2Pos_.bindValue (":account_id", accountId);
-		Date2Pos_.bindValue (":entry_id", entryId);
-		if (!Date2Pos_.exec ())
+		Rowid2Pos_.bindValue (":rowid", rowid);
+		Rowid2Pos_.bindValue (":account_id", accountId);
+		Rowid2Pos_.bindValue (":entry_id", entryId);
+		if (!Rowid2Pos_.exec ())
 		{
-			Util::DBLock::DumpError (Date2Pos_);
+			Util::DBLock::DumpError (Rowid2Pos_);
 			return;
 		}
 
-		if (!Date2Pos_.next ())
+		if (!Rowid2Pos_.next ())
 		{
 			qWarning () << Q_FUNC_INFO
 					<< "unable to navigate to next record";
 			return;
 		}
 
-		const int index = Date2Pos_.value (0).toInt ();
-		Date2Pos_.finish ();
+		const int index = Rowid2Pos_.value (0).toInt ();
+		Rowid2Pos_.finish ();
 
 		emit gotSearchPosition (Accounts_.key (accountId), Users_.key (entryId), index);
 	}
@@ -632,8 +793,10 @@ namespace ChatHistory
 		}
 	}
 
-	void Storage::addMessage (const QVariantMap& data)
+	void Storage::migrateHistory ()
 	{
+		const int chunkSize = 5000;
+
 		Util::DBLock lock (*DB_);
 		try
 		{
@@ -647,6 +810,151 @@ namespace ChatHistory
 			return;
 		}
 
+		QSqlQuery query { *DB_ };
+		query.prepare ("SELECT COUNT (1), MAX (Rowid) FROM "
+				"(SELECT Rowid FROM azoth_history WHERE Rowid > :from ORDER BY Rowid LIMIT :limit);");
+		query.bindValue (":from", MigratedUpTo_);
+		query.bindValue (":limit", chunkSize);
+		if (!query.exec () || !query.next ())
+		{
+			Util::DBLock::DumpError (query);
+			return;
+		}
+
+		const auto count = query.value (0).toInt ();
+		const auto upTo = count ? query.value (1).toLongLong () : MigratedUpTo_;
+		query.finish ();
+
+		query.prepare ("INSERT INTO azoth_history_new "
+				"(MsgId, Id, AccountId, Date, Direction, Message, Variant, Type, RichMessage, EscapePolicy) "
+				"SELECT Rowid, Id, AccountId, Date, Direction, Message, Variant, Type, RichMessage, EscapePolicy "
+				"FROM azoth_history WHERE Rowid > :from AND Rowid <= :to;");
+		query.bindValue (":from", MigratedUpTo_);
+		query.bindValue (":to", upTo);
+		if (!query.exec ())
+		{
+			Util::DBLock::DumpError (query);
+			return;
+		}
+
+		// The last chunk has been copied, and no new messages may appear
+		// before the tables are swapped in this very transaction.
+		const bool done = count < chunkSize;
+		if (done)
+		{
+			if (!query.exec ("DROP TABLE azoth_history;") ||
+					!query.exec ("ALTER TABLE azoth_history_new RENAME TO azoth_history;") ||
+					!query.exec ("DROP TABLE azoth_history_migration;"))
+			{
+				Util::DBLock::DumpError (query);
+				return;
+			}
+
+			MigratingHistory_ = false;
+			try
+			{
+				InitializeIndex ();
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< e.what ();
+				MigratingHistory_ = true;
+				HasIndex_ = false;
+				return;
+			}
+		}
+		else
+		{
+			query.prepare ("UPDATE azoth_history_migration SET CopiedUpTo = :up_to;");
+			query.bindValue (":up_to", upTo);
+			if (!query.exec ())
+			{
+				Util::DBLock::DumpError (query);
+				return;
+			}
+		}
+
+		lock.Good ();
+		MigratedUpTo_ = upTo;
+
+		if (done)
+		{
+			PrepareIndexQueries ();
+			qDebug () << Q_FUNC_INFO
+					<< "history migration is done";
+		}
+		else
+			QTimer::singleShot (0,
+					this,
+					SLOT (migrateHistory ()));
+	}
+
+	void Storage::backfillIndex ()
+	{
+		const qint64 chunkSize = 5000;
+
+		Util::DBLock lock (*DB_);
+		try
+		{
+			lock.Init ();
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to start transaction:"
+					<< e.what ();
+			return;
+		}
+
+		const auto upTo = std::min (IndexedUpTo_ + chunkSize, IndexTarget_);
+
+		QSqlQuery query { *DB_ };
+		query.prepare ("INSERT INTO azoth_history_fts (rowid, Message) "
+				"SELECT Rowid, Message FROM azoth_history "
+				"WHERE Rowid > :from AND Rowid <= :to;");
+		query.bindValue (":from", IndexedUpTo_);
+		query.bindValue (":to", upTo);
+		if (!query.exec ())
+		{
+			Util::DBLock::DumpError (query);
+			return;
+		}
+
+		const bool done = upTo >= IndexTarget_;
+		if (done)
+		{
+			if (!query.exec ("DROP TABLE azoth_history_fts_backfill;"))
+			{
+				Util::DBLock::DumpError (query);
+				return;
+			}
+		}
+		else
+		{
+			query.prepare ("UPDATE azoth_history_fts_backfill SET IndexedUpTo = :up_to;");
+			query.bindValue (":up_to", upTo);
+			if (!query.exec ())
+			{
+				Util::DBLock::DumpError (query);
+				return;
+			}
+		}
+
+		lock.Good ();
+		IndexedUpTo_ = upTo;
+
+		if (done)
+			qDebug () << Q_FUNC_INFO
+					<< "full-text index is ready";
+		else
+			QTimer::singleShot (0,
+					this,
+					SLOT (backfillIndex ()));
+	}
+
+	bool Storage::WriteMessage (const QVariantMap& data)
+	{
 		const QString& accountID = data ["AccountID"].toString ();
 		if (!Accounts_.contains (accountID))
 		{
@@ -660,7 +968,7 @@ namespace ChatHistory
 						<< accountID
 						<< "unable to add account ID to the DB:"
 						<< e.what ();
-				return;
+				return false;
 			}
 		}
 
@@ -677,7 +985,7 @@ namespace ChatHistory
 						<< entryID
 						<< "unable to add the user to the DB:"
 						<< e.what ();
-				return;
+				return false;
 			}
 		}
 
@@ -720,22 +1028,124 @@ namespace ChatHistory
 			break;
 		}
 
+		// The message and its index entry go together: if the latter
+		// fails, the former is rolled back so that the surrounding batch
+		// doesn't commit a message the search doesn't know about.
+		QSqlQuery savepoint { *DB_ };
+		if (!savepoint.exec ("SAVEPOINT azoth_message;"))
+		{
+			Util::DBLock::DumpError (savepoint);
+			return false;
+		}
+
 		if (!MessageDumper_.exec ())
 		{
 			Util::DBLock::DumpError (MessageDumper_);
+			savepoint.exec ("ROLLBACK TO azoth_message;");
+			savepoint.exec ("RELEASE azoth_message;");
+			return false;
+		}
+
+		if (HasIndex_ && MessageDumper_.numRowsAffected () > 0)
+		{
+			IndexInserter_.bindValue (":rowid", MessageDumper_.lastInsertId ());
+			IndexInserter_.bindValue (":message", data ["Body"]);
+			if (!IndexInserter_.exec ())
+			{
+				Util::DBLock::DumpError (IndexInserter_);
+				savepoint.exec ("ROLLBACK TO azoth_message;");
+				savepoint.exec ("RELEASE azoth_message;");
+				return false;
+			}
+		}
+
+		if (!savepoint.exec ("RELEASE azoth_message;"))
+			Util::DBLock::DumpError (savepoint);
+
+		// The search cursor anchors on the newest matches, which a new
+		// message may now precede.
+		if (MessageDumper_.numRowsAffected () > 0)
+			SearchCursor_.Shift2Rowid_.clear ();
+
+		PagesCursors_.remove ({ userId, Accounts_ [accountID] });
+		return true;
+	}
+
+	void Storage::flushPending ()
+	{
+		FlushTimer_->stop ();
+
+		if (PendingMessages_.isEmpty ())
 			return;
+
+		const auto messages = PendingMessages_;
+		PendingMessages_.clear ();
+
+		QElapsedTimer timer;
+		timer.start ();
+
+		{
+			Util::DBLock lock (*DB_);
+			try
+			{
+				lock.Init ();
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to start transaction, dropping"
+						<< messages.size ()
+						<< "messages:"
+						<< e.what ();
+				return;
+			}
+
+			// A message failing to be written shouldn't take the rest
+			// of the batch down with it, so it's just skipped, with
+			// WriteMessage() undoing whatever it has written for it.
+			for (const auto& message : messages)
+				WriteMessage (message);
+
+			lock.Good ();
 		}
 
-		lock.Good ();
+		const auto msecs = timer.elapsed ();
+		++FlushStats_.Batches_;
+		FlushStats_.Messages_ += messages.size ();
+		FlushStats_.MaxBatch_ = std::max (FlushStats_.MaxBatch_, messages.size ());
+		FlushStats_.TotalMSecs_ += msecs;
+		FlushStats_.MaxMSecs_ = std::max (FlushStats_.MaxMSecs_, msecs);
+
+		if (messages.size () >= MaxBatchSize || msecs >= MaxBatchDelay)
+			qDebug () << Q_FUNC_INFO
+					<< "wrote"
+					<< messages.size ()
+					<< "messages in"
+					<< msecs
+					<< "ms";
+	}
+
+	void Storage::addMessage (const QVariantMap& data)
+	{
+		PendingMessages_ << data;
+
+		if (PendingMessages_.size () >= MaxBatchSize)
+			flushPending ();
+		else if (!FlushTimer_->isActive ())
+			FlushTimer_->start ();
 	}
 
 	void Storage::getOurAccounts ()
 	{
+		flushPending ();
+
 		emit gotOurAccounts (Accounts_.keys ());
 	}
 
 	void Storage::getUsersForAccount (const QString& accountId)
 	{
+		flushPending ();
+
 		if (!Accounts_.contains (accountId))
 		{
 			qWarning () << Q_FUNC_INFO
@@ -768,6 +1178,8 @@ namespace ChatHistory
 	void Storage::getChatLogs (const QString& accountId,
 			const QString& entryId, int backpages, int amount)
 	{
+		flushPending ();
+
 		if (!Accounts_.contains (accountId))
 		{
 			qWarning () << Q_FUNC_INFO
@@ -787,45 +1199,96 @@ namespace ChatHistory
 			return;
 		}
 
-		HistoryGetter_.bindValue (":entry_id", Users_ [entryId]);
-		HistoryGetter_.bindValue (":account_id", Accounts_ [accountId]);
-		HistoryGetter_.bindValue (":limit", amount);
-		HistoryGetter_.bindValue (":offset", amount * backpages);
+		const auto userId = Users_ [entryId];
+		const auto accId = Accounts_ [accountId];
 
-		if (!HistoryGetter_.exec ())
+		auto& cursor = PagesCursors_ [{ userId, accId }];
+		if (cursor.Amount_ != amount)
 		{
-			Util::DBLock::DumpError (HistoryGetter_);
+			cursor.Amount_ = amount;
+			cursor.Page2LastRowid_.clear ();
+		}
+
+		// If the previous page has already been fetched, continue right
+		// after its oldest message instead of skipping all the newer ones.
+		auto& getter = backpages && cursor.Page2LastRowid_.contains (backpages - 1) ?
+				HistoryGetterBefore_ :
+				HistoryGetter_;
+		getter.bindValue (":entry_id", userId);
+		getter.bindValue (":account_id", accId);
+		getter.bindValue (":limit", amount);
+		if (&getter == &HistoryGetterBefore_)
+			getter.bindValue (":rowid", cursor.Page2LastRowid_ [backpages - 1]);
+		else
+			getter.bindValue (":offset", amount * backpages);
+
+		if (!getter.exec ())
+		{
+			Util::DBLock::DumpError (getter);
 			return;
 		}
 
 		QList<QVariant> result;
-		while (HistoryGetter_.next ())
+		qint64 lastRowid = 0;
+		while (getter.next ())
 		{
 			QVariantMap map;
-			map ["Date"] = HistoryGetter_.value (0);
-			map ["Direction"] = HistoryGetter_.value (1);
-			map ["Message"] = HistoryGetter_.value (2);
-			map ["Variant"] = HistoryGetter_.value (3);
-			map ["Type"] = HistoryGetter_.value (4);
-			map ["RichMessage"] = HistoryGetter_.value (5);
-			map ["EscapePolicy"] = HistoryGetter_.value (6);
+			map ["Date"] = getter.value (0);
+			map ["Direction"] = getter.value (1);
+			map ["Message"] = getter.value (2);
+			map ["Variant"] = getter.value (3);
+			map ["Type"] = getter.value (4);
+			map ["RichMessage"] = getter.value (5);
+			map ["EscapePolicy"] = getter.value (6);
 			result.prepend (map);
+
+			lastRowid = getter.value (7).toLongLong ();
 		}
 
+		if (lastRowid)
+			cursor.Page2LastRowid_ [backpages] = lastRowid;
+
 		emit gotChatLogs (accountId, entryId, backpages, amount, result);
 	}
 
 	void Storage::search (const QString& accountId,
 			const QString& entryId, const QString& text, int shift, bool cs)
 	{
-		RawSearchResult res;
-		if (!accountId.isEmpty () && !entryId.isEmpty ())
-			res = Search (accountId, entryId, text, shift, cs);
-		else if (!accountId.isEmpty ())
-			res = Search (accountId, text, shift, cs);
-		else
-			res = Search (text, shift, cs);
+		flushPending ();
+
+		qint32 accId = 0;
+		qint32 userId = 0;
+		if (!accountId.isEmpty ())
+		{
+			if (!Accounts_.contains (accountId))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "Accounts_ doesn't contain"
+						<< accountId
+						<< "; raw contents"
+						<< Accounts_;
+				emit gotSearchPosition (accountId, entryId, 0);
+				return;
+			}
+			accId = Accounts_ [accountId];
+
+			if (!entryId.isEmpty ())
+			{
+				if (!Users_.contains (entryId))
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "Users_ doesn't contain"
+							<< entryId
+							<< "; raw contents"
+							<< Users_;
+					emit gotSearchPosition (accountId, entryId, 0);
+					return;
+				}
+				userId = Users_ [entryId];
+			}
+		}
 
+		const auto& res = Search (accId, userId, text, shift, cs);
 		if (res.Date_.isNull ())
 		{
 			emit gotSearchPosition (accountId, entryId, 0);
@@ -835,11 +1298,13 @@ namespace ChatHistory
 		if (res.IsEmpty ())
 			return;
 
-		SearchDate (res.AccountID_, res.EntryID_, res.Date_);
+		SearchRowid (res.AccountID_, res.EntryID_, res.Rowid_);
 	}
 
 	void Storage::searchDate (const QString& account, const QString& entry, const QDateTime& dt)
 	{
+		flushPending ();
+
 		if (!Accounts_.contains (account))
 		{
 			qWarning () << Q_FUNC_INFO
@@ -866,6 +1331,8 @@ namespace ChatHistory
 
 	void Storage::getDaysForSheet (const QString& account, const QString& entry, int year, int month)
 	{
+		flushPending ();
+
 		if (!Accounts_.contains (account))
 		{
 			qWarning () << Q_FUNC_INFO
@@ -914,6 +1381,8 @@ namespace ChatHistory
 
 	void Storage::clearHistory (const QString& accountId, const QString& entryId)
 	{
+		flushPending ();
+
 		if (!Accounts_.contains (accountId) ||
 				!Users_.contains (entryId))
 		{
@@ -928,12 +1397,36 @@ namespace ChatHistory
 		lock.Init ();
 
 		const auto userId = Users_.take (entryId);
+		PagesCursors_.remove ({ userId, Accounts_ [accountId] });
+		SearchCursor_.Shift2Rowid_.clear ();
+
+		if (HasIndex_)
+		{
+			IndexClearer_.bindValue (":entry_id", userId);
+			IndexClearer_.bindValue (":account_id", Accounts_ [accountId]);
+			IndexClearer_.bindValue (":indexed_up_to", IndexedUpTo_);
+			IndexClearer_.bindValue (":index_target", IndexTarget_);
+			if (!IndexClearer_.exec ())
+				Util::DBLock::DumpError (IndexClearer_);
+		}
+
 		HistoryClearer_.bindValue (":entry_id", userId);
 		HistoryClearer_.bindValue (":account_id", Accounts_ [accountId]);
 
 		if (!HistoryClearer_.exec ())
 			Util::DBLock::DumpError (HistoryClearer_);
 
+		// The messages that are already migrated should go as well.
+		if (MigratingHistory_)
+		{
+			QSqlQuery query { *DB_ };
+			query.prepare ("DELETE FROM azoth_history_new WHERE Id = :entry_id AND AccountID = :account_id;");
+			query.bindValue (":entry_id", userId);
+			query.bindValue (":account_id", Accounts_ [accountId]);
+			if (!query.exec ())
+				Util::DBLock::DumpError (query);
+		}
+
 		EntryCacheClearer_.bindValue (":user_id", userId);
 		if (!EntryCacheClearer_.exec ())
 			Util::DBLock::DumpError (EntryCacheClearer_);
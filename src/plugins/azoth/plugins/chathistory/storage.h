@@ -32,10 +32,12 @@
 #include <memory>
 #include <QSqlQuery>
 #include <QHash>
+#include <QPair>
 #include <QVariant>
 #include <QDateTime>
 
 class QSqlDatabase;
+class QTimer;
 
 namespace LeechCraft
 {
@@ -59,12 +61,13 @@ namespace ChatHistory
 		QSqlQuery MessageDumper_;
 		QSqlQuery UsersForAccountGetter_;
 		QSqlQuery Date2Pos_;
+		QSqlQuery Rowid2Pos_;
 		QSqlQuery GetMonthDates_;
-		QSqlQuery LogsSearcher_;
-		QSqlQuery LogsSearcherWOContact_;
-		QSqlQuery LogsSearcherWOContactAccount_;
 		QSqlQuery HistoryGetter_;
+		QSqlQuery HistoryGetterBefore_;
 		QSqlQuery HistoryClearer_;
+		QSqlQuery IndexInserter_;
+		QSqlQuery IndexClearer_;
 		QSqlQuery UserClearer_;
 		QSqlQuery EntryCacheSetter_;
 		QSqlQuery EntryCacheGetter_;
@@ -75,22 +78,92 @@ namespace ChatHistory
 
 		QHash<qint32, QString> EntryCache_;
 
+		/** Whether the messages are still being moved from the old
+		 * azoth_history table without the MsgId key to the new one by
+		 * migrateHistory().
+		 */
+		bool MigratingHistory_ = false;
+
+		/** The rowid of the last message copied by migrateHistory().
+		 */
+		qint64 MigratedUpTo_ = 0;
+
+		/** Whether the azoth_history_fts full-text index exists.
+		 */
+		bool HasIndex_ = false;
+
+		/** Rows with rowids in (IndexedUpTo_, IndexTarget_] are yet to
+		 * be put into the full-text index by backfillIndex(), all the
+		 * others are already there.
+		 */
+		qint64 IndexedUpTo_ = 0;
+		qint64 IndexTarget_ = 0;
+
+		/** Rowids of the messages found during the last search, keyed
+		 * by the search shift, so that the next search result is looked
+		 * up starting from the previous one instead of skipping all the
+		 * matches via OFFSET.
+		 */
+		struct SearchCursor
+		{
+			qint32 AccountID_ = 0;
+			qint32 EntryID_ = 0;
+			QString Text_;
+			bool CS_ = false;
+
+			QHash<int, qint64> Shift2Rowid_;
+		} SearchCursor_;
+
+		/** Rowids of the oldest messages on each of the already fetched
+		 * pages of the chat logs, keyed by (user ID, account ID), so
+		 * that the next page is fetched via the rowid instead of OFFSET.
+		 */
+		struct PagesCursor
+		{
+			int Amount_ = 0;
+			QHash<int, qint64> Page2LastRowid_;
+		};
+		QHash<QPair<qint32, qint32>, PagesCursor> PagesCursors_;
+
+		/** Messages passed to addMessage() but not written yet. They are
+		 * written in a single transaction by flushPending() either when
+		 * there are enough of them or when FlushTimer_ fires, whichever
+		 * comes first.
+		 */
+		QList<QVariantMap> PendingMessages_;
+		QTimer * const FlushTimer_;
+
+		struct FlushStats
+		{
+			qint64 Batches_ = 0;
+			qint64 Messages_ = 0;
+			int MaxBatch_ = 0;
+			qint64 TotalMSecs_ = 0;
+			qint64 MaxMSecs_ = 0;
+		} FlushStats_;
+
 		struct RawSearchResult
 		{
 			qint32 EntryID_;
 			qint32 AccountID_;
 			QDateTime Date_;
+			qint64 Rowid_;
 
 			RawSearchResult ();
-			RawSearchResult (qint32 entryId, qint32 accountId, const QDateTime& date);
+			RawSearchResult (qint32 entryId, qint32 accountId, const QDateTime& date, qint64 rowid);
 
 			bool IsEmpty () const;
 		};
 	public:
 		Storage (QObject* = 0);
+		~Storage ();
 	private:
 		void InitializeTables ();
 		void UpdateTables ();
+		void StartHistoryMigration ();
+		void InitializeIndex ();
+		void PrepareIndexQueries ();
+		bool IsIndexReady () const;
 
 		QHash<QString, qint32> GetUsers ();
 		qint32 GetUserID (const QString&);
@@ -101,13 +174,23 @@ namespace ChatHistory
 		QHash<QString, qint32> GetAccounts ();
 		qint32 GetAccountID (const QString&);
 		void AddAccount (const QString& id);
-		RawSearchResult Search (const QString& accountId, const QString& entryId,
+		RawSearchResult Search (qint32 accountId, qint32 entryId,
 				const QString& text, int shift, bool cs);
-		RawSearchResult Search (const QString& accountId, const QString& text, int shift, bool cs);
-		RawSearchResult Search (const QString& text, int shift, bool cs);
 		void SearchDate (qint32, qint32, const QDateTime&);
+		void SearchRowid (qint32, qint32, qint64);
+
+		bool WriteMessage (const QVariantMap&);
 	public slots:
 		void regenUsersCache ();
+		void migrateHistory ();
+		void backfillIndex ();
+
+		/** @brief Writes all the messages queued by addMessage().
+		 *
+		 * All the slots reading the history call this first, so they
+		 * always see the messages added before them.
+		 */
+		void flushPending ();
 
 		void addMessage (const QVariantMap&);
 		void getOurAccounts ();
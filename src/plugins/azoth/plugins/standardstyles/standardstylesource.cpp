@@ -326,6 +326,9 @@ namespace StandardStyles
 
 		QWebElement elem = frame->findFirstElement ("body");
 
+		const auto batch = Batches_.find (frame);
+		const QString separator ("<hr class=\"lastSeparator\" />");
+
 		if (msg->GetMessageType () == IMessage::Type::ChatMessage ||
 			msg->GetMessageType () == IMessage::Type::MUCMessage)
 		{
@@ -336,14 +339,25 @@ namespace StandardStyles
 				auto hr = elem.findFirst ("hr[class=\"lastSeparator\"]");
 				if (!hr.isNull ())
 					hr.removeFromDocument ();
-				elem.appendInside ("<hr class=\"lastSeparator\" />");
+
+				if (batch != Batches_.end ())
+				{
+					batch->Html_.remove (separator);
+					batch->Html_ += separator;
+				}
+				else
+					elem.appendInside (separator);
 			}
 			IsLastMsgRead_ [frame] = isRead;
 		}
 
-		elem.appendInside (QString ("<div class='%1' style='word-wrap: break-word;'>%2</div>")
+		const auto& html = QString ("<div class='%1' style='word-wrap: break-word;'>%2</div>")
 					.arg (divClass)
-					.arg (string));
+					.arg (string);
+		if (batch != Batches_.end ())
+			batch->Html_ += html;
+		else
+			elem.appendInside (html);
 		return true;
 	}
 
@@ -357,8 +371,32 @@ namespace StandardStyles
 		return {};
 	}
 
-	QList<QColor> StandardStyleSource::CreateColors (const QString& scheme, QWebFrame *frame)
+	void StandardStyleSource::BeginBatch (QWebFrame *frame)
 	{
+		connect (frame,
+				SIGNAL (destroyed (QObject*)),
+				this,
+				SLOT (handleFrameDestroyed ()),
+				Qt::UniqueConnection);
+
+		Batches_ [frame] = { QString (), GetBackgroundColor (frame) };
+	}
+
+	void StandardStyleSource::EndBatch (QWebFrame *frame)
+	{
+		const auto& html = Batches_.take (frame).Html_;
+		if (html.isEmpty ())
+			return;
+
+		frame->findFirstElement ("body").appendInside (html);
+	}
+
+	QColor StandardStyleSource::GetBackgroundColor (QWebFrame *frame)
+	{
+		const auto batch = Batches_.find (frame);
+		if (batch != Batches_.end ())
+			return batch->BgColor_;
+
 		QColor bgColor;
 
 		const auto js = "window.getComputedStyle(document.body) ['background-color']";
@@ -372,6 +410,13 @@ namespace StandardStyles
 			bgColor.setRgb (vals.value (0).toInt (),
 					vals.value (1).toInt (), vals.value (2).toInt ());
 
+		return bgColor;
+	}
+
+	QList<QColor> StandardStyleSource::CreateColors (const QString& scheme, QWebFrame *frame)
+	{
+		const auto& bgColor = GetBackgroundColor (frame);
+
 		const auto& mangledScheme = scheme + bgColor.name ();
 
 		if (!Coloring2Colors_.contains (mangledScheme))
@@ -390,10 +435,17 @@ namespace StandardStyles
 	{
 		const QString& fullName = Proxy_->GetSettingsManager ()->
 				property ("SystemIcons").toString () + '/' + statusIconName;
+
+		const auto pos = StatusImages_.find (fullName);
+		if (pos != StatusImages_.end ())
+			return *pos;
+
 		const QString& statusIconPath = Proxy_->
 				GetResourceLoader (IProxyObject::PRLSystemIcons)->GetIconPath (fullName);
 		const QImage& img = QImage (statusIconPath);
-		return Util::GetAsBase64Src (img);
+		const auto& src = Util::GetAsBase64Src (img);
+		StatusImages_ [fullName] = src;
+		return src;
 	}
 
 	void StandardStyleSource::handleMessageDelivered ()
@@ -420,6 +472,7 @@ namespace StandardStyles
 	void StandardStyleSource::handleFrameDestroyed ()
 	{
 		IsLastMsgRead_.remove (static_cast<QWebFrame*> (sender ()));
+		Batches_.remove (static_cast<QWebFrame*> (sender ()));
 		const QObject *snd = sender ();
 		for (QHash<QObject*, QWebFrame*>::iterator i = Msg2Frame_.begin ();
 				i != Msg2Frame_.end (); )
@@ -35,6 +35,7 @@
 #include <QHash>
 #include <QColor>
 #include <interfaces/azoth/ichatstyleresourcesource.h>
+#include <interfaces/azoth/isupportbatchappend.h>
 
 namespace LeechCraft
 {
@@ -52,9 +53,11 @@ namespace StandardStyles
 {
 	class StandardStyleSource : public QObject
 							  , public IChatStyleResourceSource
+							  , public ISupportBatchAppend
 	{
 		Q_OBJECT
-		Q_INTERFACES (LeechCraft::Azoth::IChatStyleResourceSource)
+		Q_INTERFACES (LeechCraft::Azoth::IChatStyleResourceSource
+				LeechCraft::Azoth::ISupportBatchAppend)
 
 		std::shared_ptr<Util::ResourceLoader> StylesLoader_;
 
@@ -65,6 +68,15 @@ namespace StandardStyles
 		mutable QString LastPack_;
 
 		QHash<QObject*, QWebFrame*> Msg2Frame_;
+
+		struct PendingBatch
+		{
+			QString Html_;
+			QColor BgColor_;
+		};
+		QHash<QWebFrame*, PendingBatch> Batches_;
+
+		QHash<QString, QString> StatusImages_;
 	public:
 		StandardStyleSource (IProxyObject*, QObject* = 0);
 
@@ -75,7 +87,11 @@ namespace StandardStyles
 		bool AppendMessage (QWebFrame*, QObject*, const ChatMsgAppendInfo&);
 		void FrameFocused (QWebFrame*);
 		QStringList GetVariantsForPack (const QString&);
+
+		void BeginBatch (QWebFrame*);
+		void EndBatch (QWebFrame*);
 	private:
+		QColor GetBackgroundColor (QWebFrame*);
 		QList<QColor> CreateColors (const QString&, QWebFrame*);
 		QString GetMessageID (QObject*);
 		QString GetStatusImage (const QString&);
@@ -33,15 +33,20 @@
 #include <QDomDocument>
 #include <QTimer>
 #include <QDir>
+#include <QImage>
+#include <QtConcurrentRun>
 #include <QXmppLogger.h>
 #include <util/sys/paths.h>
+#include <util/sll/futures.h>
 #include <interfaces/azoth/iaccount.h>
 #include <interfaces/azoth/iproxyobject.h>
+#include <interfaces/azoth/iavatarsstorage.h>
 #include "glooxprotocol.h"
 #include "glooxclentry.h"
 #include "glooxaccount.h"
+#include "entrybase.h"
 #include "capsdatabase.h"
-#include "avatarsstorage.h"
+#include "xmlsettingsmanager.h"
 
 namespace LeechCraft
 {
@@ -53,7 +58,6 @@ namespace Xoox
 	: PluginProxy_ (0)
 	, SaveRosterScheduled_ (false)
 	, CapsDB_ (new CapsDatabase (this))
-	, Avatars_ (new AvatarsStorage (this))
 	{
 		QXmppLogger::getLogger ()->setLoggingType (QXmppLogger::FileLogging);
 		QXmppLogger::getLogger ()->setLogFilePath (Util::CreateIfNotExists ("azoth").filePath ("qxmpp.log"));
@@ -61,6 +65,30 @@ namespace Xoox
 		GlooxProtocol_.reset (new GlooxProtocol (this));
 	}
 
+	namespace
+	{
+		// Remove later, along with the migration.
+		QDir GetLegacyAvatarsDir ()
+		{
+			return Util::GetUserDir (Util::UserDir::Cache, "azoth/xoox").filePath ("hashed_avatars");
+		}
+
+		QHash<QByteArray, QImage> LoadLegacyAvatars (const QStringList& names)
+		{
+			auto dir = GetLegacyAvatarsDir ();
+
+			QHash<QByteArray, QImage> result;
+			for (const auto& name : names)
+			{
+				const QImage image { dir.absoluteFilePath (name) };
+				if (!image.isNull ())
+					result [name.toLatin1 ()] = image;
+				dir.remove (name);
+			}
+			return result;
+		}
+	}
+
 	Core& Core::Instance ()
 	{
 		static Core c;
@@ -77,6 +105,8 @@ namespace Xoox
 					SIGNAL (gotCLItems (QList<QObject*>)),
 					this,
 					SLOT (handleItemsAdded (QList<QObject*>)));
+
+		MigrateLegacyAvatars ();
 	}
 
 	void Core::Release ()
@@ -114,11 +144,6 @@ namespace Xoox
 		return CapsDB_;
 	}
 
-	AvatarsStorage* Core::GetAvatarsStorage () const
-	{
-		return Avatars_;
-	}
-
 	void Core::SendEntity (const Entity& e)
 	{
 		emit gotEntity (e);
@@ -231,6 +256,78 @@ namespace Xoox
 		}
 	}
 
+	void Core::MigrateLegacyAvatars ()
+	{
+		auto& xsm = XmlSettingsManager::Instance ();
+		if (xsm.Property ("LegacyAvatarsMigrated", false).toBool ())
+			return;
+
+		// The old cache is just a cache, so avatars not migrated if
+		// we are closed in the middle of this are fetched again later.
+		xsm.setProperty ("LegacyAvatarsMigrated", true);
+
+		const auto& dir = GetLegacyAvatarsDir ();
+		if (!dir.exists ())
+			return;
+
+		PendingLegacyAvatars_ = dir.entryList (QDir::Files);
+		MigrateLegacyAvatarsChunk ();
+	}
+
+	void Core::MigrateLegacyAvatarsChunk ()
+	{
+		if (PendingLegacyAvatars_.isEmpty ())
+		{
+			auto dir = GetLegacyAvatarsDir ();
+			dir.cdUp ();
+			dir.rmdir ("hashed_avatars");
+			return;
+		}
+
+		// Chunks keep the amount of decoded images in memory bounded.
+		const auto& chunk = PendingLegacyAvatars_.mid (0, 50);
+		PendingLegacyAvatars_ = PendingLegacyAvatars_.mid (chunk.size ());
+
+		Util::ExecuteFuture ([chunk] { return QtConcurrent::run (LoadLegacyAvatars, chunk); },
+				[this] (const QHash<QByteArray, QImage>& avatars)
+				{
+					HandleLegacyAvatars (avatars);
+					MigrateLegacyAvatarsChunk ();
+				},
+				this);
+	}
+
+	void Core::HandleLegacyAvatars (const QHash<QByteArray, QImage>& avatars)
+	{
+		if (!GlooxProtocol_)
+			return;
+
+		auto left = avatars;
+
+		// Entries that already tried loading their avatars from the
+		// storage get theirs right away, unless they've got a fresh
+		// one meanwhile.
+		for (const auto accObj : GlooxProtocol_->GetRegisteredAccounts ())
+			for (const auto entryObj : qobject_cast<GlooxAccount*> (accObj)->GetCLEntries ())
+			{
+				const auto entry = qobject_cast<EntryBase*> (entryObj);
+				if (!entry)
+					continue;
+
+				const auto& id = entry->GetEntryID ().toUtf8 ().toHex ();
+				if (!left.contains (id))
+					continue;
+
+				const auto& image = left.take (id);
+				if (entry->GetAvatar ().isNull ())
+					entry->SetAvatar (image);
+			}
+
+		const auto storage = GetPluginProxy ()->GetAvatarsStorage ();
+		for (auto i = left.begin (), end = left.end (); i != end; ++i)
+			storage->StoreAvatar (i.key (), i.value ());
+	}
+
 	void Core::saveRoster ()
 	{
 		SaveRosterScheduled_ = false;
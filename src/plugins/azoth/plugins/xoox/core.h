@@ -30,6 +30,7 @@
 #ifndef PLUGINS_AZOTH_PLUGINS_XOOX_CORE_H
 #define PLUGINS_AZOTH_PLUGINS_XOOX_CORE_H
 #include <QObject>
+#include <QStringList>
 #include <interfaces/structures.h>
 #include <interfaces/core/icoreproxy.h>
 
@@ -44,7 +45,6 @@ namespace Xoox
 	class GlooxProtocol;
 	class GlooxCLEntry;
 	class CapsDatabase;
-	class AvatarsStorage;
 
 	class Core : public QObject
 	{
@@ -56,7 +56,8 @@ namespace Xoox
 		bool SaveRosterScheduled_;
 
 		CapsDatabase *CapsDB_;
-		AvatarsStorage *Avatars_;
+
+		QStringList PendingLegacyAvatars_;
 
 		Core ();
 	public:
@@ -72,13 +73,20 @@ namespace Xoox
 		ICoreProxy_ptr GetProxy () const;
 
 		CapsDatabase* GetCapsDatabase () const;
-		AvatarsStorage* GetAvatarsStorage () const;
 
 		void SendEntity (const Entity&);
 
 		void ScheduleSaveRoster (int = 2000);
 	private:
 		void LoadRoster ();
+
+		/** Moves the avatars cached by Xoox before the Azoth-wide
+		 * IAvatarsStorage was introduced to that storage. This is done
+		 * only once, the old cache is removed afterwards.
+		 */
+		void MigrateLegacyAvatars ();
+		void MigrateLegacyAvatarsChunk ();
+		void HandleLegacyAvatars (const QHash<QByteArray, QImage>&);
 	public slots:
 		void saveRoster ();
 	private slots:
@@ -49,6 +49,7 @@
 #include <util/sll/delayedexecutor.h>
 #include <util/sll/futures.h>
 #include <interfaces/azoth/iproxyobject.h>
+#include <interfaces/azoth/iavatarsstorage.h>
 #include <interfaces/azoth/azothutil.h>
 #include "glooxmessage.h"
 #include "glooxclentry.h"
@@ -71,7 +72,6 @@
 #include "useravatardata.h"
 #include "useravatarmetadata.h"
 #include "capsdatabase.h"
-#include "avatarsstorage.h"
 #include "inforequestpolicymanager.h"
 #include "pingmanager.h"
 #include "pingreplyobject.h"
@@ -116,13 +116,8 @@ namespace Xoox
 					return;
 
 				const auto id = GetEntryID ().toUtf8 ().toHex ();
-				Util::ExecuteFuture ([id]
-						{
-							return QtConcurrent::run ([id]
-									{
-										return Core::Instance ().GetAvatarsStorage ()->GetAvatar (id);
-									});
-						},
+				const auto storage = Core::Instance ().GetPluginProxy ()->GetAvatarsStorage ();
+				Util::ExecuteFuture ([storage, id] { return storage->GetAvatar (id); },
 						[this, guard] (const QImage& newAvatar)
 						{
 							if (!guard)
@@ -131,7 +126,7 @@ namespace Xoox
 							if (newAvatar.isNull ())
 								return;
 
-							Avatar_ = std::move (newAvatar);
+							Avatar_ = newAvatar;
 							emit avatarChanged (Avatar_);
 						},
 						this);
@@ -721,7 +716,7 @@ namespace Xoox
 		Avatar_ = avatar;
 
 		const auto id = GetEntryID ().toUtf8 ().toHex ();
-		Core::Instance ().GetAvatarsStorage ()->StoreAvatar (Avatar_, id);
+		Core::Instance ().GetPluginProxy ()->GetAvatarsStorage ()->StoreAvatar (id, Avatar_);
 
 		emit avatarChanged (Avatar_);
 	}
@@ -37,7 +37,6 @@
 #include "roomhandler.h"
 #include "roomclentry.h"
 #include "core.h"
-#include "avatarsstorage.h"
 
 namespace LeechCraft
 {
@@ -46,6 +46,7 @@
 #include "resourcesmanager.h"
 #include "util.h"
 #include "customstatusesmanager.h"
+#include "avatarsstorage.h"
 
 namespace LeechCraft
 {
@@ -423,5 +424,10 @@ namespace Azoth
 	{
 		return Formatter_;
 	}
+
+	IAvatarsStorage* ProxyObject::GetAvatarsStorage ()
+	{
+		return Core::Instance ().GetAvatarsStorage ();
+	}
 }
 }
@@ -101,6 +101,7 @@ namespace Azoth
 		QObject* GetFirstUnreadMessage (QObject *entryObj) const override;
 
 		IFormatterProxyObject& GetFormatterProxy () override;
+		IAvatarsStorage* GetAvatarsStorage () override;
 	};
 }
 }
@@ -14,3 +14,37 @@ function InstallEventListeners() {
 	window.addEventListener ("resize", function () { setTimeout (ScrollToBottom, 0); });
 	window.addEventListener ("scroll", TestScroll);
 }
+// Style sources are free to wrap messages into any number of nodes (or
+// none at all, appending to the previous message's node), so the nodes
+// are tracked in chunks, each chunk being the nodes added to the
+// container along with the given number of messages.
+var MessageChunks = [];
+var MarkedNodes = 0;
+var DisplayedMessages = 0;
+function TrimMessages(newMessages, maxCount) {
+	var container = document.getElementById ("Chat") || document.body;
+	var newNodes = container.childElementCount - MarkedNodes;
+	if (newNodes > 0 || !MessageChunks.length)
+		MessageChunks.push ({ Nodes: Math.max (newNodes, 0), Messages: newMessages });
+	else
+		MessageChunks [MessageChunks.length - 1].Messages += newMessages;
+	MarkedNodes = container.childElementCount;
+	DisplayedMessages += newMessages;
+
+	if (maxCount <= 0 || !window.ShouldScroll)
+		return 0;
+	if (DisplayedMessages - maxCount <= maxCount / 10)
+		return 0;
+
+	var removed = 0;
+	while (MessageChunks.length > 1 &&
+			DisplayedMessages - MessageChunks [0].Messages >= maxCount) {
+		var chunk = MessageChunks.shift ();
+		for (var i = 0; i < chunk.Nodes && container.firstElementChild; ++i)
+			container.removeChild (container.firstElementChild);
+		MarkedNodes = container.childElementCount;
+		DisplayedMessages -= chunk.Messages;
+		removed += chunk.Messages;
+	}
+	return removed;
+}
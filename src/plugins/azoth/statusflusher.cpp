@@ -0,0 +1,103 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "statusflusher.h"
+#include <QSet>
+#include <QStandardItemModel>
+#include "core.h"
+#include "layoutupdatesafeguard.h"
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	StatusFlusher::StatusFlusher (QStandardItemModel *model,
+			IconSetter_f setIcon, IconCanceller_f cancelIcon, CategoryUpdater_f updateCategory)
+	: Model_ (model)
+	, SetIcon_ (setIcon)
+	, CancelIcon_ (cancelIcon)
+	, UpdateCategory_ (updateCategory)
+	{
+	}
+
+	void StatusFlusher::Flush (const QList<QStandardItem*>& items)
+	{
+		QSet<QStandardItem*> categories;
+
+		// A few changes are cheaper to propagate via the usual dataChanged() signals.
+		if (items.size () <= MaxImmediateUpdates)
+		{
+			for (const auto item : items)
+			{
+				item->setData (false, Core::CLRIconOutdated);
+				SetIcon_ (item);
+				categories << item->parent ();
+			}
+
+			for (const auto category : categories)
+				UpdateCategory_ (category);
+			return;
+		}
+
+		LayoutUpdateSafeguard guard (Model_);
+
+		// Icons are regenerated lazily, when a view asks for a visible row.
+		for (const auto item : items)
+		{
+			CancelIcon_ (item);
+			item->setData (true, Core::CLRIconOutdated);
+			categories << item->parent ();
+		}
+
+		for (const auto category : categories)
+			UpdateCategory_ (category);
+	}
+
+	void StatusFlusher::CheckOutdatedIcon (const QModelIndex& index, int role)
+	{
+		if (role != Qt::DecorationRole)
+			return;
+
+		if (const auto item = Model_->itemFromIndex (index))
+			RefreshOutdatedIcon (item);
+	}
+
+	void StatusFlusher::RefreshOutdatedIcon (QStandardItem *item)
+	{
+		if (!item->data (Core::CLRIconOutdated).toBool ())
+			return;
+
+		// The view asking for the icon gets the new one anyway, no need to notify anyone.
+		const bool wasBlocked = Model_->blockSignals (true);
+		item->setData (false, Core::CLRIconOutdated);
+		SetIcon_ (item);
+		Model_->blockSignals (wasBlocked);
+	}
+}
+}
@@ -0,0 +1,102 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QList>
+
+class QStandardItem;
+class QStandardItemModel;
+class QModelIndex;
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	/** @brief Applies coalesced status changes to the contact list.
+	 *
+	 * Core gathers the entries whose status changed during a short
+	 * period of time and passes the contact list items of all of them
+	 * to Flush() at once.
+	 *
+	 * Small batches are applied right away with the usual dataChanged()
+	 * notifications. Large ones are applied as a single layout change,
+	 * and the icons of their items are only marked as outdated via the
+	 * Core::CLRIconOutdated role, to be set by CheckOutdatedIcon() when
+	 * a view asks for them. Each affected category is updated once per
+	 * batch in both cases.
+	 */
+	class StatusFlusher
+	{
+	public:
+		/** Sets the up-to-date icon of the given item.
+		 */
+		typedef std::function<void (QStandardItem*)> IconSetter_f;
+
+		/** Cancels an icon update of the given item that may still be
+		 * pending.
+		 */
+		typedef std::function<void (QStandardItem*)> IconCanceller_f;
+
+		/** Recalculates the data of a category depending on its items,
+		 * like the number of online contacts.
+		 */
+		typedef std::function<void (QStandardItem*)> CategoryUpdater_f;
+
+		/** Batches of up to this number of items are applied right
+		 * away.
+		 */
+		static const int MaxImmediateUpdates = 16;
+	private:
+		QStandardItemModel * const Model_;
+
+		const IconSetter_f SetIcon_;
+		const IconCanceller_f CancelIcon_;
+		const CategoryUpdater_f UpdateCategory_;
+	public:
+		StatusFlusher (QStandardItemModel*, IconSetter_f, IconCanceller_f, CategoryUpdater_f);
+
+		/** Applies the status changes of the given contact items.
+		 */
+		void Flush (const QList<QStandardItem*>&);
+
+		/** Sets the icon of the item at the given index if it is
+		 * outdated and the role is Qt::DecorationRole. This is to be
+		 * called by the model whenever its data is requested.
+		 */
+		void CheckOutdatedIcon (const QModelIndex&, int role);
+
+		/** Sets the icon of the given item if it is outdated, without
+		 * notifying the views.
+		 */
+		void RefreshOutdatedIcon (QStandardItem*);
+	};
+}
+}
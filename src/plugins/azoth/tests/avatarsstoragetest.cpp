@@ -0,0 +1,162 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "avatarsstoragetest.h"
+#include <QtTest>
+#include <util/sys/paths.h>
+#include "avatarsstorage.h"
+
+QTEST_MAIN (LeechCraft::Azoth::AvatarsStorageTest)
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	namespace
+	{
+		const QByteArray Key { "contact@example.com" };
+
+		QImage MakeImage (int width, int height)
+		{
+			QImage image { width, height, QImage::Format_ARGB32 };
+			image.fill (QColor { Qt::red }.rgb ());
+			return image;
+		}
+
+		// Neither QTemporaryDir nor QDir::removeRecursively() are there in Qt 4.
+		void RemoveRecursively (const QString& path)
+		{
+			const QDir dir { path };
+			for (const auto& info : dir.entryInfoList (QDir::AllEntries | QDir::NoDotAndDotDot | QDir::Hidden | QDir::System))
+				if (info.isDir () && !info.isSymLink ())
+					RemoveRecursively (info.filePath ());
+				else
+					QFile::remove (info.filePath ());
+
+			QDir {}.rmdir (path);
+		}
+	}
+
+	void AvatarsStorageTest::initTestCase ()
+	{
+		CacheDir_ = QDir::temp ().filePath (QString ("lc_azoth_avatarsstorage_test_%1")
+				.arg (QCoreApplication::applicationPid ()));
+		RemoveRecursively (CacheDir_);
+		QVERIFY (QDir {}.mkpath (CacheDir_));
+
+		// Keep the storage away from the user's real avatars.
+		qputenv ("XDG_CACHE_HOME", QFile::encodeName (CacheDir_));
+	}
+
+	void AvatarsStorageTest::cleanupTestCase ()
+	{
+		RemoveRecursively (CacheDir_);
+	}
+
+	void AvatarsStorageTest::cleanup ()
+	{
+		RemoveRecursively (Util::GetUserDir (Util::UserDir::Cache, "azoth/avatars").path ());
+	}
+
+	void AvatarsStorageTest::storedIsReturned ()
+	{
+		AvatarsStorage storage;
+		storage.StoreAvatar (Key, MakeImage (64, 64));
+
+		const auto& image = storage.GetAvatar (Key).result ();
+		QCOMPARE (image.size (), QSize (64, 64));
+		QCOMPARE (image.pixel (0, 0), QColor { Qt::red }.rgb ());
+	}
+
+	void AvatarsStorageTest::scaledToFit ()
+	{
+		AvatarsStorage storage;
+		storage.StoreAvatar (Key, MakeImage (64, 32));
+
+		QCOMPARE (storage.GetAvatar (Key, 16).result ().size (), QSize (16, 8));
+
+		// Images are never scaled up.
+		QCOMPARE (storage.GetAvatar (Key, 128).result ().size (), QSize (64, 32));
+	}
+
+	void AvatarsStorageTest::missingIsNull ()
+	{
+		AvatarsStorage storage;
+		QVERIFY (storage.GetAvatar (Key).result ().isNull ());
+	}
+
+	void AvatarsStorageTest::storingNullRemoves ()
+	{
+		{
+			AvatarsStorage storage;
+			storage.StoreAvatar (Key, MakeImage (64, 64));
+			storage.StoreAvatar (Key, {});
+
+			QVERIFY (storage.GetAvatar (Key).result ().isNull ());
+		}
+
+		AvatarsStorage storage;
+		QVERIFY (storage.GetAvatar (Key).result ().isNull ());
+	}
+
+	void AvatarsStorageTest::persistsAcrossInstances ()
+	{
+		{
+			AvatarsStorage storage;
+			storage.StoreAvatar (Key, MakeImage (64, 64));
+		}
+
+		AvatarsStorage storage;
+		const auto& image = storage.GetAvatar (Key).result ();
+		QCOMPARE (image.size (), QSize (64, 64));
+		QCOMPARE (image.pixel (0, 0), QColor { Qt::red }.rgb ());
+		QCOMPARE (storage.GetStats ().Decodes_, quint64 { 1 });
+	}
+
+	void AvatarsStorageTest::lookupsAreCached ()
+	{
+		{
+			AvatarsStorage storage;
+			storage.StoreAvatar (Key, MakeImage (64, 64));
+		}
+
+		AvatarsStorage storage;
+		storage.GetAvatar (Key, 16).result ();
+		storage.GetAvatar (Key, 32).result ();
+
+		const auto& before = storage.GetStats ();
+		QCOMPARE (storage.GetAvatar (Key, 16).result ().size (), QSize (16, 16));
+		QCOMPARE (storage.GetAvatar (Key).result ().size (), QSize (64, 64));
+
+		const auto& after = storage.GetStats ();
+		QCOMPARE (after.Hits_, before.Hits_ + 2);
+		QCOMPARE (after.Decodes_, quint64 { 1 });
+	}
+}
+}
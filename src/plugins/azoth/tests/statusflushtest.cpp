@@ -0,0 +1,285 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "statusflushtest.h"
+#include <QtTest>
+#include <QStandardItemModel>
+#include <QSortFilterProxyModel>
+#include "statusflusher.h"
+#include "core.h"
+
+QTEST_MAIN (LeechCraft::Azoth::StatusFlushTest)
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	namespace
+	{
+		/* A synthetic roster mimicking the contact list: groups with
+		 * contacts, the states of the contacts living outside of the
+		 * model like they do in ICLEntry, a dynamically sorting proxy
+		 * ordering the contacts by their state, and each group keeping
+		 * the count of its online contacts.
+		 */
+		enum Role
+		{
+			ContactIndexRole = Core::CLRIconOutdated + 1,
+			NumOnlineRole
+		};
+
+		const int GroupsCount = 40;
+		const int ContactsPerGroup = 500;
+
+		// Asks the flusher about outdated icons just like CLModel does.
+		class RosterModel : public QStandardItemModel
+		{
+		public:
+			StatusFlusher *Flusher_ = nullptr;
+
+			QVariant data (const QModelIndex& index, int role) const
+			{
+				Flusher_->CheckOutdatedIcon (index, role);
+				return QStandardItemModel::data (index, role);
+			}
+		};
+
+		class StateSortProxy : public QSortFilterProxyModel
+		{
+			const QVector<int>& States_;
+		public:
+			StateSortProxy (const QVector<int>& states)
+			: States_ (states)
+			{
+			}
+		protected:
+			bool lessThan (const QModelIndex& left, const QModelIndex& right) const
+			{
+				const auto& leftIdx = left.data (ContactIndexRole);
+				const auto& rightIdx = right.data (ContactIndexRole);
+				if (!leftIdx.isValid () || !rightIdx.isValid ())
+					return QSortFilterProxyModel::lessThan (left, right);
+
+				return States_ [leftIdx.toInt ()] < States_ [rightIdx.toInt ()];
+			}
+		};
+
+		struct Roster
+		{
+			QVector<int> States_;
+			QList<QStandardItem*> Contacts_;
+
+			RosterModel Model_;
+			StateSortProxy Proxy_;
+			StatusFlusher Flusher_;
+
+			int IconsSet_ = 0;
+
+			Roster ()
+			: States_ (GroupsCount * ContactsPerGroup, 0)
+			, Proxy_ (States_)
+			, Flusher_ (&Model_,
+					[this] (QStandardItem *item)
+					{
+						++IconsSet_;
+						item->setData (QString ("state%1").arg (GetState (item)), Qt::DecorationRole);
+					},
+					[] (QStandardItem*) {},
+					[this] (QStandardItem *group) { RecalculateOnline (group); })
+			{
+				Model_.Flusher_ = &Flusher_;
+
+				for (int i = 0; i < GroupsCount; ++i)
+				{
+					const auto group = new QStandardItem (QString ("Group %1").arg (i));
+					group->setData (0, NumOnlineRole);
+					for (int j = 0; j < ContactsPerGroup; ++j)
+					{
+						const auto contact = new QStandardItem (QString ("contact%1@group%2").arg (j).arg (i));
+						contact->setData (Contacts_.size (), ContactIndexRole);
+						contact->setData (QString ("state0"), Qt::DecorationRole);
+						group->appendRow (contact);
+						Contacts_ << contact;
+					}
+					Model_.appendRow (group);
+				}
+
+				Proxy_.setDynamicSortFilter (true);
+				Proxy_.setSourceModel (&Model_);
+				Proxy_.sort (0);
+			}
+
+			int GetState (QStandardItem *item) const
+			{
+				return States_ [item->data (ContactIndexRole).toInt ()];
+			}
+
+			void RecalculateOnline (QStandardItem *group)
+			{
+				int result = 0;
+				for (int i = 0; i < group->rowCount (); ++i)
+					result += GetState (group->child (i)) != 0;
+				group->setData (result, NumOnlineRole);
+			}
+
+			// Each presence arrives in its own frame.
+			void ApplyImmediate (const QList<QPair<int, int>>& burst)
+			{
+				for (const auto& change : burst)
+				{
+					States_ [change.first] = change.second;
+					Flusher_.Flush ({ Contacts_ [change.first] });
+				}
+			}
+
+			// The whole burst arrives in a single frame.
+			void ApplyBatched (const QList<QPair<int, int>>& burst)
+			{
+				QList<QStandardItem*> items;
+				for (const auto& change : burst)
+				{
+					States_ [change.first] = change.second;
+					items << Contacts_ [change.first];
+				}
+				Flusher_.Flush (items);
+			}
+
+			/* Rows with equal states may end up in different orders
+			 * depending on how the proxy got to sort them, so the rows
+			 * are compared as sets, and the proxy is checked to keep
+			 * them sorted separately. The icons are requested the way
+			 * a view does it.
+			 */
+			QStringList GetContents () const
+			{
+				QStringList result;
+				for (int i = 0; i < Proxy_.rowCount (); ++i)
+				{
+					const auto& groupIdx = Proxy_.index (i, 0);
+					result << groupIdx.data ().toString () + ':' + groupIdx.data (NumOnlineRole).toString ();
+
+					QStringList contacts;
+					for (int j = 0; j < Proxy_.rowCount (groupIdx); ++j)
+					{
+						const auto& idx = Proxy_.index (j, 0, groupIdx);
+						contacts << idx.data (Qt::DecorationRole).toString () + ':' + idx.data ().toString ();
+					}
+					contacts.sort ();
+					result += contacts;
+				}
+				return result;
+			}
+
+			bool IsSorted () const
+			{
+				for (int i = 0; i < Proxy_.rowCount (); ++i)
+				{
+					const auto& groupIdx = Proxy_.index (i, 0);
+					for (int j = 1; j < Proxy_.rowCount (groupIdx); ++j)
+						if (States_ [Proxy_.index (j - 1, 0, groupIdx).data (ContactIndexRole).toInt ()] >
+								States_ [Proxy_.index (j, 0, groupIdx).data (ContactIndexRole).toInt ()])
+							return false;
+				}
+				return true;
+			}
+		};
+
+		/* A roster burst: every contact goes online exactly once in
+		 * some arbitrary order, like after connecting to a big account.
+		 */
+		QList<QPair<int, int>> MakeBurst ()
+		{
+			QList<QPair<int, int>> result;
+			const int total = GroupsCount * ContactsPerGroup;
+			for (int i = 0; i < total; ++i)
+				result.append ({ (i * 7919) % total, 1 + i % 5 });
+			return result;
+		}
+	}
+
+	void StatusFlushTest::batchedMatchesImmediate ()
+	{
+		const auto& burst = MakeBurst ();
+
+		Roster immediate;
+		immediate.ApplyImmediate (burst);
+
+		Roster batched;
+		batched.ApplyBatched (burst);
+
+		QVERIFY (immediate.IsSorted ());
+		QVERIFY (batched.IsSorted ());
+		QCOMPARE (batched.GetContents (), immediate.GetContents ());
+	}
+
+	void StatusFlushTest::batchedIconsAreLazy ()
+	{
+		const auto& burst = MakeBurst ();
+
+		Roster roster;
+		roster.ApplyBatched (burst);
+
+		QCOMPARE (roster.IconsSet_, 0);
+		for (const auto contact : roster.Contacts_)
+			QVERIFY (contact->data (Core::CLRIconOutdated).toBool ());
+
+		const auto& groupIdx = roster.Proxy_.index (0, 0);
+		const auto& idx = roster.Proxy_.index (0, 0, groupIdx);
+		const auto contact = roster.Contacts_ [idx.data (ContactIndexRole).toInt ()];
+		QCOMPARE (idx.data (Qt::DecorationRole).toString (),
+				QString ("state%1").arg (roster.GetState (contact)));
+		QVERIFY (!contact->data (Core::CLRIconOutdated).toBool ());
+		QCOMPARE (roster.IconsSet_, 1);
+
+		// Asking again doesn't regenerate the icon.
+		idx.data (Qt::DecorationRole);
+		QCOMPARE (roster.IconsSet_, 1);
+	}
+
+	void StatusFlushTest::benchImmediate ()
+	{
+		const auto& burst = MakeBurst ();
+		Roster roster;
+		QBENCHMARK_ONCE
+		{
+			roster.ApplyImmediate (burst);
+		}
+	}
+
+	void StatusFlushTest::benchBatched ()
+	{
+		const auto& burst = MakeBurst ();
+		Roster roster;
+		QBENCHMARK_ONCE
+		{
+			roster.ApplyBatched (burst);
+		}
+	}
+}
+}
@@ -30,29 +30,20 @@
 #pragma once
 
 #include <QObject>
-#include <QDir>
-
-class QImage;
 
 namespace LeechCraft
 {
 namespace Azoth
 {
-namespace Xoox
-{
-	class AvatarsStorage : public QObject
+	class StatusFlushTest : public QObject
 	{
 		Q_OBJECT
-
-		QDir AvatarsDir_;
-	public:
-		AvatarsStorage (QObject* = 0);
-
-		void StoreAvatar (const QImage&, const QByteArray&);
-		QImage GetAvatar (const QByteArray&) const;
 	private slots:
-		void collectOldAvatars ();
+		void batchedMatchesImmediate ();
+		void batchedIconsAreLazy ();
+
+		void benchImmediate ();
+		void benchBatched ();
 	};
 }
 }
-}
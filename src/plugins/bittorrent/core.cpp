@@ -56,6 +56,9 @@
 #include <QTextCodec>
 #include <QDataStream>
 #include <QDesktopServices>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrentMap>
 
 #if QT_VERSION >= 0x050000
 #include <QUrlQuery>
@@ -91,6 +94,7 @@
 #include "torrentmaker.h"
 #include "notifymanager.h"
 #include "sessionsettingsmanager.h"
+#include "torrentstorage.h"
 
 Q_DECLARE_METATYPE (QMenu*)
 Q_DECLARE_METATYPE (QToolBar*)
@@ -129,7 +133,6 @@ namespace BitTorrent
 	: NotifyManager_ (new NotifyManager (this))
 	, Session_ (0)
 	, CurrentTorrent_ (-1)
-	, FinishedTimer_ (new QTimer ())
 	, WarningWatchdog_ (new QTimer ())
 	, LiveStreamManager_ (new LiveStreamManager ())
 	, SaveScheduled_ (false)
@@ -241,17 +244,21 @@ namespace BitTorrent
 				<< tr ("Total uploaded")
 				<< tr ("Ratio");
 
-		connect (FinishedTimer_.get (),
-				SIGNAL (timeout ()),
-				this,
-				SLOT (checkFinished ()));
-		FinishedTimer_->start (10000);
-
+#if LIBTORRENT_VERSION_NUM >= 10100
+		Session_->set_alert_notify ([this]
+				{
+					if (!AlertsNotified_.exchange (true))
+						QMetaObject::invokeMethod (this,
+								"queryLibtorrentForWarnings",
+								Qt::QueuedConnection);
+				});
+#else
 		connect (WarningWatchdog_.get (),
 				SIGNAL (timeout ()),
 				this,
 				SLOT (queryLibtorrentForWarnings ()));
 		WarningWatchdog_->start (2000);
+#endif
 
 		connect (SessionSettingsMgr_,
 				SIGNAL (scrapeRequested ()),
@@ -262,15 +269,18 @@ namespace BitTorrent
 				this,
 				SLOT (writeSettings ()));
 
+		Storage_ = std::make_shared<TorrentStorage> ();
 		RestoreTorrents ();
 	}
 
 	void Core::Release ()
 	{
+#if LIBTORRENT_VERSION_NUM >= 10100
+		Session_->set_alert_notify ([] {});
+#endif
 		Session_->pause ();
 		writeSettings ();
 
-		FinishedTimer_.reset ();
 		WarningWatchdog_.reset ();
 
 		QObjectList kids = children ();
@@ -1093,6 +1103,7 @@ namespace BitTorrent
 		Session_->remove_torrent (Handles_.at (pos).Handle_, roptions);
 		int id = Handles_.at (pos).ID_;
 		Handles_.removeAt (pos);
+		Hash2Row_.clear ();
 		Proxy_->FreeID (id);
 		endRemoveRows ();
 
@@ -1107,7 +1118,6 @@ namespace BitTorrent
 
 		Handles_.at (pos).Handle_.pause ();
 		Handles_.at (pos).Handle_.auto_managed (false);
-		checkFinished ();
 	}
 
 	void Core::ResumeTorrent (int pos)
@@ -1118,7 +1128,6 @@ namespace BitTorrent
 		Handles_.at (pos).Handle_.resume ();
 		Handles_ [pos].State_ = TSIdle;
 		Handles_.at (pos).Handle_.auto_managed (Handles_.at (pos).AutoManaged_);
-		checkFinished ();
 	}
 
 	void Core::ForceReannounce (int pos)
@@ -1444,24 +1453,9 @@ namespace BitTorrent
 			return;
 		}
 
-		QFile file (QDir::homePath () +
-				"/.leechcraft/bittorrent/" +
-				torrent->TorrentFileName_ +
-				".resume");
-
-		if (!file.open (QIODevice::WriteOnly))
-		{
-			qWarning () << QString ("Could not open file %1 for write: %2")
-				.arg (file.fileName ())
-				.arg (file.errorString ());
-			return;
-		}
-
-		std::deque<char> outbuf;
-		libtorrent::bencode (std::back_inserter (outbuf), *a.resume_data.get ());
-
-		for (size_t i = 0; i < outbuf.size (); ++i)
-			file.write (&outbuf.at (i), 1);
+		QByteArray resumeData;
+		libtorrent::bencode (std::back_inserter (resumeData), *a.resume_data.get ());
+		Storage_->WriteResumeData (torrent->TorrentFileName_, resumeData);
 	}
 
 	void Core::HandleMetadata (const libtorrent::metadata_received_alert& a)
@@ -1497,6 +1491,7 @@ namespace BitTorrent
 		libtorrent::entry e;
 		e ["info"] = infoE;
 		libtorrent::bencode (std::back_inserter (torrent->TorrentFileContents_), e);
+		torrent->TorrentFileSaved_ = false;
 
 		qDebug () << "HandleMetadata"
 			<< std::distance (Handles_.begin (), torrent)
@@ -1510,23 +1505,97 @@ namespace BitTorrent
 		LiveStreamManager_->PieceRead (a);
 	}
 
+	namespace
+	{
+		/** Returns the bitmask of the columns whose data differs between
+		 * the old and the new status, mirroring what Core::data() reads.
+		 */
+		quint32 GetChangedColumns (const libtorrent::torrent_status& o,
+				const libtorrent::torrent_status& n)
+		{
+			const bool stateChanged = o.state != n.state ||
+					o.paused != n.paused ||
+					o.error != n.error;
+			const bool doneChanged = o.progress != n.progress ||
+					o.total_wanted_done != n.total_wanted_done ||
+					o.total_wanted != n.total_wanted;
+			const bool downRateChanged = o.download_payload_rate != n.download_payload_rate;
+			const bool upRateChanged = o.upload_payload_rate != n.upload_payload_rate;
+			const bool peersChanged = o.num_peers != n.num_peers ||
+					o.num_seeds != n.num_seeds;
+
+			quint32 result = 0;
+			auto mark = [&result] (int column, bool changed)
+			{
+				if (changed)
+					result |= 1 << column;
+			};
+
+			mark (Core::ColumnID, stateChanged || doneChanged);
+			mark (Core::ColumnName, stateChanged);
+			mark (Core::ColumnState, stateChanged ||
+					(n.state == libtorrent::torrent_status::downloading &&
+						(doneChanged || o.download_rate != n.download_rate)));
+			mark (Core::ColumnProgress, stateChanged ||
+					doneChanged ||
+					downRateChanged ||
+					upRateChanged ||
+					peersChanged ||
+					o.num_incomplete != n.num_incomplete ||
+					o.list_peers != n.list_peers ||
+					o.list_seeds != n.list_seeds);
+			mark (Core::ColumnDownSpeed, downRateChanged);
+			mark (Core::ColumnUpSpeed, upRateChanged);
+			mark (Core::ColumnLeechers, peersChanged);
+			mark (Core::ColumnSeeders, o.num_seeds != n.num_seeds);
+			mark (Core::ColumnSize, o.total_wanted != n.total_wanted);
+			mark (Core::ColumnDownloaded, o.all_time_download != n.all_time_download);
+			mark (Core::ColumnUploaded, o.all_time_upload != n.all_time_upload);
+			mark (Core::ColumnRatio, o.all_time_download != n.all_time_download ||
+					o.all_time_upload != n.all_time_upload);
+			return result;
+		}
+	}
+
 	void Core::UpdateStatus (const std::vector<libtorrent::torrent_status>& statuses)
 	{
+		const auto columns = columnCount ();
+		const quint32 allColumns = (1 << columns) - 1;
+
 		for (const auto& status : statuses)
 		{
 			const auto handle = status.handle;
+			const auto prevPos = Handle2Status_.find (handle);
+			const auto changed = prevPos == Handle2Status_.end () ?
+					allColumns :
+					GetChangedColumns (*prevPos, status);
 			Handle2Status_ [handle] = status;
 
-			const auto pos = FindHandle (handle);
-			if (pos == Handles_.end ())
+			const auto row = FindRow (handle);
+			if (row == -1)
 			{
 				qWarning () << Q_FUNC_INFO
 						<< "unknown handle";
 				continue;
 			}
 
-			const auto row = std::distance (Handles_.begin (), pos);
-			emit dataChanged (index (row, 0), index (row, columnCount () - 1));
+			UpdateTorrentState (row, status);
+
+			for (int start = 0; start < columns; )
+			{
+				if (!(changed & (1 << start)))
+				{
+					++start;
+					continue;
+				}
+
+				auto end = start;
+				while (end + 1 < columns && (changed & (1 << (end + 1))))
+					++end;
+
+				emit dataChanged (index (row, start), index (row, end));
+				start = end + 1;
+			}
 		}
 	}
 
@@ -1564,6 +1633,7 @@ namespace BitTorrent
 			Handles_.at (*i).Handle_.queue_position_up ();
 			std::swap (Handles_ [*i],
 					Handles_ [*i - 1]);
+			Hash2Row_.clear ();
 
 			emit dataChanged (index (*i - 1, 0),
 					index (*i, columnCount () - 1));
@@ -1586,6 +1656,7 @@ namespace BitTorrent
 			Handles_.at (*i).Handle_.queue_position_down ();
 			std::swap (Handles_ [*i],
 					Handles_ [*i + 1]);
+			Hash2Row_.clear ();
 
 			emit dataChanged (index (*i, 0),
 					index (*i + 1, columnCount () - 1));
@@ -1658,16 +1729,53 @@ namespace BitTorrent
 		return result;
 	}
 
+	namespace
+	{
+		QByteArray GetHashKey (const libtorrent::torrent_handle& h)
+		{
+			const auto& str = h.info_hash ().to_string ();
+			return QByteArray (str.data (), str.size ());
+		}
+	}
+
+	int Core::FindRow (const libtorrent::torrent_handle& h) const
+	{
+		const auto& key = GetHashKey (h);
+
+		auto checkHint = [this, &h, &key] () -> int
+		{
+			const auto pos = Hash2Row_.find (key);
+			if (pos == Hash2Row_.end ())
+				return -1;
+
+			const auto row = *pos;
+			return row < Handles_.size () && Handles_.at (row).Handle_ == h ?
+					row :
+					-1;
+		};
+
+		const auto hinted = checkHint ();
+		if (hinted != -1)
+			return hinted;
+
+		Hash2Row_.clear ();
+		Hash2Row_.reserve (Handles_.size ());
+		for (int i = 0; i < Handles_.size (); ++i)
+			Hash2Row_ [GetHashKey (Handles_.at (i).Handle_)] = i;
+
+		return checkHint ();
+	}
+
 	auto Core::FindHandle (const libtorrent::torrent_handle& h) -> HandleDict_t::iterator
 	{
-		return std::find_if (Handles_.begin (), Handles_.end (),
-				[&h] (const TorrentStruct& ts) { return ts.Handle_ == h; });
+		const auto row = FindRow (h);
+		return row == -1 ? Handles_.end () : Handles_.begin () + row;
 	}
 
 	auto Core::FindHandle (const libtorrent::torrent_handle& h) const -> HandleDict_t::const_iterator
 	{
-		return std::find_if (Handles_.begin (), Handles_.end (),
-				[&h] (const TorrentStruct& ts) { return ts.Handle_ == h; });
+		const auto row = FindRow (h);
+		return row == -1 ? Handles_.end () : Handles_.begin () + row;
 	}
 
 	libtorrent::torrent_status Core::GetCachedStatus (const libtorrent::torrent_handle& handle) const
@@ -1686,6 +1794,7 @@ namespace BitTorrent
 
 		beginRemoveRows (QModelIndex (), row, row);
 		TorrentStruct tmp = Handles_.takeAt (row);
+		Hash2Row_.clear ();
 		endRemoveRows ();
 
 		beginInsertRows (QModelIndex (), 0, 0);
@@ -1699,6 +1808,7 @@ namespace BitTorrent
 
 		beginRemoveRows (QModelIndex (), row, row);
 		TorrentStruct tmp = Handles_.takeAt (row);
+		Hash2Row_.clear ();
 		endRemoveRows ();
 
 		beginInsertRows (QModelIndex (), Handles_.size (), Handles_.size ());
@@ -1706,89 +1816,149 @@ namespace BitTorrent
 		endInsertRows ();
 	}
 
-	void Core::RestoreTorrents ()
+	namespace
 	{
-		QSettings settings (QCoreApplication::organizationName (),
-				QCoreApplication::applicationName () + "_Torrent");
-		settings.beginGroup ("Core");
-		int torrents = settings.beginReadArray ("AddedTorrents");
-		qDebug () << Q_FUNC_INFO << "gonna restore" << torrents << "torrents";
-		for (int i = 0; i < torrents; ++i)
+		struct LoadedTorrent
 		{
-			settings.setArrayIndex (i);
-			const auto& pathStr = settings.value ("SavePath").toString ();
-			const auto& path = std::string (pathStr.toUtf8 ().constData ());
-			QString filename = settings.value ("Filename").toString ();
-			QFile torrent (QDir::homePath () + "/.leechcraft/bittorrent/" + filename);
-			if (!torrent.open (QIODevice::ReadOnly))
-			{
-				emit error (tr ("Could not open saved torrent %1 for read.").arg (filename));
-				continue;
-			}
-			QByteArray data = torrent.readAll ();
-			torrent.close ();
-			if (data.isEmpty ())
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "empty torrent data for"
-						<< filename;
-				continue;
-			}
+			SavedTorrent Saved_;
+			QByteArray Data_;
+			QByteArray ResumeData_;
+			Core::TorrentInfo_ptr Info_;
+			boost::system::error_code ParseError_;
+		};
 
-			QFile resumeDataFile (QDir::homePath () + "/.leechcraft/bittorrent/" +
-					filename + ".resume");
-			QByteArray resumed;
-			if (resumeDataFile.open (QIODevice::ReadOnly))
-			{
-				resumed = resumeDataFile.readAll ();
-				resumeDataFile.close ();
-			}
+		struct TorrentLoader
+		{
+			typedef LoadedTorrent result_type;
 
-			bool automanaged = settings.value ("AutoManaged", true).toBool ();
-			TaskParameters taskParameters = static_cast<TaskParameters> (settings
-						.value ("Parameters").toInt ());
+			const TorrentStorage& Storage_;
 
-			auto handle = RestoreSingleTorrent (data,
-					resumed,
-					path,
-					automanaged,
-					taskParameters & NoAutostart);
-			if (!handle.is_valid ())
+			LoadedTorrent operator() (const SavedTorrent& saved) const
 			{
-				qWarning () << Q_FUNC_INFO
-						<< "got invalid handle for"
-						<< filename;
-				continue;
+				LoadedTorrent result;
+				result.Saved_ = saved;
+				result.Data_ = Storage_.ReadTorrentFile (saved.Filename_);
+				if (result.Data_.isEmpty ())
+					return result;
+
+				result.ResumeData_ = Storage_.ReadResumeData (saved.Filename_);
+
+				Core::TorrentInfo_ptr info (new libtorrent::torrent_info (result.Data_.constData (),
+							result.Data_.size (), result.ParseError_));
+				if (!result.ParseError_)
+					result.Info_ = info;
+				return result;
 			}
+		};
+	}
+
+	void Core::RestoreTorrents ()
+	{
+		QElapsedTimer timer;
+		timer.start ();
+
+		const auto& savedList = Storage_->LoadList ();
+		qDebug () << Q_FUNC_INFO << "gonna restore" << savedList.size () << "torrents";
+
+		/* Reading and parsing the .torrent files is what takes most of
+		 * the time, so it's done in parallel, while adding the parsed
+		 * torrents to the session and to the model is done batch by
+		 * batch in this thread.
+		 */
+		const auto batchSize = std::max (QThread::idealThreadCount (), 1) * 16;
+
+		qint64 loadTime = 0;
+		qint64 addTime = 0;
+		int restoredCount = 0;
+		for (int start = 0; start < savedList.size (); start += batchSize)
+		{
+			QElapsedTimer batchTimer;
+			batchTimer.start ();
+
+			const auto& loaded = QtConcurrent::blockingMapped<QList<LoadedTorrent>> (savedList.mid (start, batchSize),
+					TorrentLoader { *Storage_ });
 
-			std::vector<int> priorities;
-			QByteArray prioritiesLine = settings.value ("Priorities").toByteArray ();
-			std::copy (prioritiesLine.begin (), prioritiesLine.end (),
-					std::back_inserter (priorities));
+			loadTime += batchTimer.restart ();
 
-			if (priorities.empty ())
+			QList<TorrentStruct> restored;
+			for (const auto& item : loaded)
 			{
-				priorities.resize (handle.get_torrent_info ().num_files ());
-				std::fill (priorities.begin (), priorities.end (), 1);
-			}
+				const auto& saved = item.Saved_;
+				if (item.Data_.isEmpty ())
+				{
+					emit error (tr ("Could not open saved torrent %1 for read.").arg (saved.Filename_));
+					continue;
+				}
 
-			handle.prioritize_files (priorities);
+				if (!item.Info_)
+				{
+					emit error (tr ("Bad bencoding in saved torrent data: %1")
+								.arg (QString::fromUtf8 (item.ParseError_.message ().c_str ())));
+					continue;
+				}
+
+				const auto taskParameters = static_cast<TaskParameters> (saved.Parameters_);
+				auto handle = RestoreSingleTorrent (item.Info_,
+						item.ResumeData_,
+						std::string (saved.SavePath_.toUtf8 ().constData ()),
+						saved.AutoManaged_,
+						taskParameters & NoAutostart);
+				if (!handle.is_valid ())
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "got invalid handle for"
+							<< saved.Filename_;
+					continue;
+				}
+
+				std::vector<int> priorities (saved.Priorities_.begin (), saved.Priorities_.end ());
+				if (priorities.empty ())
+					priorities.resize (item.Info_->num_files (), 1);
 
-			beginInsertRows ({}, Handles_.size (), Handles_.size ());
-			Handles_.append ({
+				handle.prioritize_files (priorities);
+
+				TorrentStruct torrent
+				{
 					priorities,
 					handle,
-					data,
-					filename,
-					settings.value ("Tags").toStringList (),
-					automanaged,
+					item.Data_,
+					saved.Filename_,
+					saved.Tags_,
+					saved.AutoManaged_,
 					Proxy_->GetID (),
 					taskParameters
-				});
-			endInsertRows ();
-			qDebug () << "restored a torrent";
+				};
+				torrent.TorrentFileSaved_ = true;
+				restored << torrent;
+			}
+
+			if (!restored.isEmpty ())
+			{
+				beginInsertRows ({}, Handles_.size (), Handles_.size () + restored.size () - 1);
+				Handles_ += restored;
+				endInsertRows ();
+			}
+
+			restoredCount += restored.size ();
+			addTime += batchTimer.elapsed ();
 		}
-		settings.endArray ();
+
+		qDebug () << Q_FUNC_INFO
+				<< "restored"
+				<< restoredCount
+				<< "of"
+				<< savedList.size ()
+				<< "torrents in"
+				<< timer.elapsed ()
+				<< "ms;"
+				<< loadTime
+				<< "ms loading,"
+				<< addTime
+				<< "ms adding";
+
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "_Torrent");
+		settings.beginGroup ("Core");
 
 		int filters = settings.beginReadArray ("IPFilter");
 		for (int i = 0; i < filters; ++i)
@@ -1816,7 +1986,7 @@ namespace BitTorrent
 		return true;
 	}
 
-	libtorrent::torrent_handle Core::RestoreSingleTorrent (const QByteArray& data,
+	libtorrent::torrent_handle Core::RestoreSingleTorrent (const TorrentInfo_ptr& info,
 			const QByteArray& resumeData,
 			const boost::filesystem::path& path,
 			bool automanaged,
@@ -1824,14 +1994,10 @@ namespace BitTorrent
 	{
 		libtorrent::torrent_handle handle;
 
-		libtorrent::lazy_entry e;
-		if (!DecodeEntry (data, e))
-			return handle;
-
 		try
 		{
 			libtorrent::add_torrent_params atp;
-			atp.ti = new libtorrent::torrent_info (e);
+			atp.ti = info;
 			atp.storage_mode = GetCurrentStorageMode ();
 			atp.save_path = path.string ();
 			if (!automanaged)
@@ -1926,6 +2092,43 @@ namespace BitTorrent
 		emit taskFinished (torrent.ID_);
 	}
 
+	void Core::UpdateTorrentState (int row, const libtorrent::torrent_status& status)
+	{
+		auto& torrent = Handles_ [row];
+		if (torrent.State_ == TSSeeding)
+			return;
+
+		if (status.paused)
+		{
+			torrent.State_ = TSIdle;
+			return;
+		}
+
+		switch (status.state)
+		{
+			case libtorrent::torrent_status::queued_for_checking:
+			case libtorrent::torrent_status::checking_files:
+			case libtorrent::torrent_status::checking_resume_data:
+			case libtorrent::torrent_status::allocating:
+			case libtorrent::torrent_status::downloading_metadata:
+				torrent.State_ = TSPreparing;
+				break;
+			case libtorrent::torrent_status::downloading:
+				torrent.State_ = TSDownloading;
+				break;
+			case libtorrent::torrent_status::finished:
+			case libtorrent::torrent_status::seeding:
+				const auto oldState = torrent.State_;
+				torrent.State_ = TSSeeding;
+				if (oldState == TSDownloading)
+				{
+					HandleSingleFinished (row);
+					ScheduleSave ();
+				}
+				break;
+		}
+	}
+
 	void Core::HandleFileRenamed (const libtorrent::file_renamed_alert& a)
 	{
 		const auto pos = FindHandle (a.handle);
@@ -1987,22 +2190,11 @@ namespace BitTorrent
 	void Core::writeSettings ()
 	{
 		SaveScheduled_ = false;
-		QDir home = QDir::home ();
-		if (!home.exists (".leechcraft/bittorrent"))
-			if (!home.mkdir (".leechcraft/bittorrent"))
-			{
-				emit error (QDir::toNativeSeparators (tr ("Could not create path %1/.leechcraft/bittorrent"))
-						.arg (QDir::toNativeSeparators (QDir::homePath ())));
-				return;
-			}
 
-		QSettings settings (QCoreApplication::organizationName (),
-				QCoreApplication::applicationName () + "_Torrent");
-		settings.beginGroup ("Core");
-		settings.beginWriteArray ("AddedTorrents");
+		QList<SavedTorrent> savedList;
+		savedList.reserve (Handles_.size ());
 		for (int i = 0; i < Handles_.size (); ++i)
 		{
-			settings.setArrayIndex (i);
 			if (!CheckValidity (i))
 			{
 				qWarning () << Q_FUNC_INFO
@@ -2010,52 +2202,42 @@ namespace BitTorrent
 					<< i;
 				continue;
 			}
-			if (Handles_.at (i).TorrentFileName_.isEmpty ())
+
+			auto& torrent = Handles_ [i];
+			if (torrent.TorrentFileName_.isEmpty ())
 			{
 				qWarning () << Q_FUNC_INFO
 					<< "empty file name"
 					<< i;
 				continue;
 			}
-			int oldCurrent = CurrentTorrent_;
-			CurrentTorrent_ = i;
+
 			try
 			{
-				QFile file_info (QDir::homePath () +
-						"/.leechcraft/bittorrent/" +
-						Handles_.at (i).TorrentFileName_);
-				if (!file_info.open (QIODevice::WriteOnly))
-					emit error (QString ("Cannot write settings! "
-								"Cannot open file %1 for write!")
-							.arg (Handles_.at (i).TorrentFileName_));
-				else
+				if (!torrent.TorrentFileSaved_)
 				{
-					file_info.write (Handles_.at (i).TorrentFileContents_);
-					file_info.close ();
-
-					const auto& handle = Handles_.at (i).Handle_;
-					if (handle.need_save_resume_data ())
-						handle.save_resume_data ();
-
-					settings.setValue ("SavePath",
-							QString::fromUtf8 (handle.save_path ().c_str ()));
-					settings.setValue ("Filename",
-							Handles_.at (i).TorrentFileName_);
-					settings.setValue ("Tags",
-							Handles_.at (i).Tags_);
-					settings.setValue ("ID",
-							Handles_.at (i).ID_);
-					settings.setValue ("Parameters",
-							static_cast<int> (Handles_.at (i).Parameters_));
-					settings.setValue ("AutoManaged",
-							Handles_.at (i).AutoManaged_);
-
-					QByteArray prioritiesLine;
-					std::copy (Handles_.at (i).FilePriorities_.begin (),
-							Handles_.at (i).FilePriorities_.end (),
-							std::back_inserter (prioritiesLine));
-					settings.setValue ("Priorities", prioritiesLine);
+					if (Storage_->WriteTorrentFile (torrent.TorrentFileName_, torrent.TorrentFileContents_))
+						torrent.TorrentFileSaved_ = true;
+					else
+						emit error (QString ("Cannot write settings! "
+									"Cannot write file %1!")
+								.arg (torrent.TorrentFileName_));
 				}
+
+				const auto& handle = torrent.Handle_;
+				if (handle.need_save_resume_data ())
+					handle.save_resume_data ();
+
+				SavedTorrent saved;
+				saved.Filename_ = torrent.TorrentFileName_;
+				saved.SavePath_ = QString::fromUtf8 (handle.save_path ().c_str ());
+				saved.Tags_ = torrent.Tags_;
+				saved.Parameters_ = static_cast<int> (torrent.Parameters_);
+				saved.AutoManaged_ = torrent.AutoManaged_;
+				std::copy (torrent.FilePriorities_.begin (),
+						torrent.FilePriorities_.end (),
+						std::back_inserter (saved.Priorities_));
+				savedList << saved;
 			}
 			catch (const std::exception& e)
 			{
@@ -2065,9 +2247,13 @@ namespace BitTorrent
 			{
 				qWarning () << Q_FUNC_INFO << "unknown exception";
 			}
-			CurrentTorrent_ = oldCurrent;
 		}
-		settings.endArray ();
+
+		Storage_->SaveList (savedList);
+
+		QSettings settings (QCoreApplication::organizationName (),
+				QCoreApplication::applicationName () + "_Torrent");
+		settings.beginGroup ("Core");
 
 		settings.beginWriteArray ("IPFilter");
 		settings.remove ("");
@@ -2100,48 +2286,6 @@ namespace BitTorrent
 		queryLibtorrentForWarnings ();
 	}
 
-	void Core::checkFinished ()
-	{
-		for (int i = 0; i < Handles_.size (); ++i)
-		{
-			if (Handles_.at (i).State_ == TSSeeding)
-				continue;
-
-			const auto& status = Handles_.at (i).Handle_.status (0);
-			libtorrent::torrent_status::state_t state = status.state;
-
-			if (status.paused)
-			{
-				Handles_ [i].State_ = TSIdle;
-				continue;
-			}
-
-			switch (state)
-			{
-				case libtorrent::torrent_status::queued_for_checking:
-				case libtorrent::torrent_status::checking_files:
-				case libtorrent::torrent_status::checking_resume_data:
-				case libtorrent::torrent_status::allocating:
-				case libtorrent::torrent_status::downloading_metadata:
-					Handles_ [i].State_ = TSPreparing;
-					break;
-				case libtorrent::torrent_status::downloading:
-					Handles_ [i].State_ = TSDownloading;
-					break;
-				case libtorrent::torrent_status::finished:
-				case libtorrent::torrent_status::seeding:
-					TorrentState oldState = Handles_ [i].State_;
-					Handles_ [i].State_ = TSSeeding;
-					if (oldState == TSDownloading)
-					{
-						HandleSingleFinished (i);
-						ScheduleSave ();
-					}
-					break;
-			}
-		}
-	}
-
 	struct SimpleDispatcher
 	{
 		mutable bool NeedToLog_ = true;
@@ -2339,6 +2483,8 @@ namespace BitTorrent
 
 	void Core::queryLibtorrentForWarnings ()
 	{
+		AlertsNotified_ = false;
+
 		std::deque<libtorrent::alert*> alerts;
 		const auto guard = Util::MakeScopeGuard ([&alerts]
 				{
@@ -2421,9 +2567,11 @@ namespace BitTorrent
 			return;
 
 		Session_->post_torrent_updates ();
+#if LIBTORRENT_VERSION_NUM < 10100
 		QTimer::singleShot (200,
 				this,
 				SLOT (queryLibtorrentForWarnings ()));
+#endif
 	}
 }
 }
@@ -33,9 +33,11 @@
 #include <list>
 #include <deque>
 #include <memory>
+#include <atomic>
 #include <QAbstractItemModel>
 #include <QPair>
 #include <QList>
+#include <QHash>
 #include <QVector>
 #include <QIcon>
 #include <libtorrent/alert_types.hpp>
@@ -79,6 +81,7 @@ namespace BitTorrent
 	class RepresentationModel;
 	class LiveStreamManager;
 	class SessionSettingsManager;
+	class TorrentStorage;
 	struct NewTorrentParams;
 
 	class Core : public QAbstractItemModel
@@ -111,6 +114,10 @@ namespace BitTorrent
 
 			bool PauseAfterCheck_ = false;
 
+			/** Whether TorrentFileContents_ are already saved to disk.
+				*/
+			bool TorrentFileSaved_ = false;
+
 			TorrentStruct (const libtorrent::torrent_handle& handle,
 					const QStringList& tags,
 					int id,
@@ -145,6 +152,14 @@ namespace BitTorrent
 		friend struct SimpleDispatcher;
 
 		mutable QMap<libtorrent::torrent_handle, libtorrent::torrent_status> Handle2Status_;
+
+		/** Maps the info hash of a torrent to its row in Handles_.
+		 *
+		 * This is a hint rather than an authoritative mapping: lookups
+		 * verify the row they get and rebuild the whole index on a miss,
+		 * so structural changes to Handles_ only need to clear it.
+		 */
+		mutable QHash<QByteArray, int> Hash2Row_;
 	public:
 		struct PerTrackerStats
 		{
@@ -152,6 +167,8 @@ namespace BitTorrent
 			qint64 UploadRate_ = 0;
 		};
 		typedef QMap<QString, PerTrackerStats> pertrackerstats_t;
+
+		typedef decltype (libtorrent::add_torrent_params::ti) TorrentInfo_ptr;
 	private:
 		struct PerTrackerAccumulator
 		{
@@ -170,8 +187,10 @@ namespace BitTorrent
 		HandleDict_t Handles_;
 		QList<QString> Headers_;
 		mutable int CurrentTorrent_;
-		std::shared_ptr<QTimer> FinishedTimer_, WarningWatchdog_;
+		std::shared_ptr<QTimer> WarningWatchdog_;
+		std::atomic<bool> AlertsNotified_ { false };
 		std::shared_ptr<LiveStreamManager> LiveStreamManager_;
+		std::shared_ptr<TorrentStorage> Storage_;
 		QString ExternalAddress_;
 		bool SaveScheduled_;
 		QToolBar *Toolbar_;
@@ -348,6 +367,7 @@ namespace BitTorrent
 
 		QList<FileInfo> GetTorrentFiles (int = -1) const;
 	private:
+		int FindRow (const libtorrent::torrent_handle&) const;
 		HandleDict_t::iterator FindHandle (const libtorrent::torrent_handle&);
 		HandleDict_t::const_iterator FindHandle (const libtorrent::torrent_handle&) const;
 
@@ -357,13 +377,14 @@ namespace BitTorrent
 		void MoveToBottom (int);
 		void RestoreTorrents ();
 		bool DecodeEntry (const QByteArray&, libtorrent::lazy_entry&);
-		libtorrent::torrent_handle RestoreSingleTorrent (const QByteArray&,
+		libtorrent::torrent_handle RestoreSingleTorrent (const TorrentInfo_ptr&,
 				const QByteArray&,
 				const boost::filesystem::path&,
 				bool,
 				bool);
 
 		void HandleSingleFinished (int);
+		void UpdateTorrentState (int, const libtorrent::torrent_status&);
 		void HandleFileRenamed (const libtorrent::file_renamed_alert&);
 
 		/** Returns human-readable list of tags for the given torrent.
@@ -382,7 +403,6 @@ namespace BitTorrent
 		void HandleLibtorrentException (const libtorrent::libtorrent_exception&);
 	private slots:
 		void writeSettings ();
-		void checkFinished ();
 		void scrape ();
 	public slots:
 		void queryLibtorrentForWarnings ();
@@ -0,0 +1,297 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "torrentstorage.h"
+#include <stdexcept>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QSettings>
+#include <QCoreApplication>
+#include <QtDebug>
+#include <util/sys/paths.h>
+
+namespace LeechCraft
+{
+namespace BitTorrent
+{
+	namespace
+	{
+		const QString ListFilename { "torrents.list" };
+		const QByteArray Magic { "LCBTTL" };
+		const quint8 ListVersion = 1;
+
+		QDataStream& operator<< (QDataStream& out, const SavedTorrent& torrent)
+		{
+			return out << torrent.Filename_
+					<< torrent.SavePath_
+					<< torrent.Tags_
+					<< static_cast<qint32> (torrent.Parameters_)
+					<< torrent.AutoManaged_
+					<< torrent.Priorities_;
+		}
+
+		QDataStream& operator>> (QDataStream& in, SavedTorrent& torrent)
+		{
+			qint32 params = 0;
+			in >> torrent.Filename_
+					>> torrent.SavePath_
+					>> torrent.Tags_
+					>> params
+					>> torrent.AutoManaged_
+					>> torrent.Priorities_;
+			torrent.Parameters_ = params;
+			return in;
+		}
+
+		QByteArray SerializeList (const QList<SavedTorrent>& torrents)
+		{
+			QByteArray result;
+
+			QDataStream out { &result, QIODevice::WriteOnly };
+			out.setVersion (QDataStream::Qt_4_8);
+			out << Magic << ListVersion << static_cast<qint32> (torrents.size ());
+			for (const auto& torrent : torrents)
+				out << torrent;
+
+			return result;
+		}
+
+		bool DeserializeList (const QByteArray& data, QList<SavedTorrent>& torrents)
+		{
+			QDataStream in { data };
+			in.setVersion (QDataStream::Qt_4_8);
+
+			QByteArray magic;
+			quint8 version = 0;
+			qint32 count = 0;
+			in >> magic >> version >> count;
+			if (magic != Magic || version != ListVersion || count < 0)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unknown list format"
+						<< magic
+						<< version;
+				return false;
+			}
+
+			torrents.reserve (count);
+			for (qint32 i = 0; i < count; ++i)
+			{
+				SavedTorrent torrent;
+				in >> torrent;
+				if (in.status () != QDataStream::Ok)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "truncated list at"
+							<< i
+							<< "of"
+							<< count;
+					return false;
+				}
+				torrents << torrent;
+			}
+
+			return true;
+		}
+
+		QList<SavedTorrent> LoadLegacyList ()
+		{
+			QList<SavedTorrent> result;
+
+			QSettings settings (QCoreApplication::organizationName (),
+					QCoreApplication::applicationName () + "_Torrent");
+			settings.beginGroup ("Core");
+			const int size = settings.beginReadArray ("AddedTorrents");
+			for (int i = 0; i < size; ++i)
+			{
+				settings.setArrayIndex (i);
+
+				SavedTorrent torrent;
+				torrent.Filename_ = settings.value ("Filename").toString ();
+				torrent.SavePath_ = settings.value ("SavePath").toString ();
+				torrent.Tags_ = settings.value ("Tags").toStringList ();
+				torrent.Parameters_ = settings.value ("Parameters").toInt ();
+				torrent.AutoManaged_ = settings.value ("AutoManaged", true).toBool ();
+				torrent.Priorities_ = settings.value ("Priorities").toByteArray ();
+				result << torrent;
+			}
+			settings.endArray ();
+			settings.endGroup ();
+
+			return result;
+		}
+
+		void RemoveLegacyList ()
+		{
+			QSettings settings (QCoreApplication::organizationName (),
+					QCoreApplication::applicationName () + "_Torrent");
+			settings.beginGroup ("Core");
+			settings.remove ("AddedTorrents");
+			settings.endGroup ();
+		}
+	}
+
+	TorrentStorage::TorrentStorage ()
+	{
+		try
+		{
+			Dir_ = Util::CreateIfNotExists ("bittorrent");
+			IsValid_ = true;
+		}
+		catch (const std::runtime_error& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< e.what ();
+		}
+	}
+
+	QList<SavedTorrent> TorrentStorage::LoadList ()
+	{
+		QList<SavedTorrent> result;
+		if (!IsValid_)
+			return result;
+
+		const auto& data = Read (ListFilename);
+		if (!data.isEmpty () && DeserializeList (data, result))
+		{
+			LastList_ = data;
+			return result;
+		}
+
+		result = LoadLegacyList ();
+		HasLegacyList_ = !result.isEmpty ();
+		if (HasLegacyList_)
+			qDebug () << Q_FUNC_INFO
+					<< "migrating"
+					<< result.size ()
+					<< "torrents from the old storage";
+		return result;
+	}
+
+	bool TorrentStorage::SaveList (const QList<SavedTorrent>& torrents)
+	{
+		if (!IsValid_)
+			return false;
+
+		const auto& data = SerializeList (torrents);
+		if (data == LastList_)
+			return false;
+
+		if (!Write (ListFilename, data))
+			return false;
+
+		LastList_ = data;
+
+		if (HasLegacyList_)
+		{
+			RemoveLegacyList ();
+			HasLegacyList_ = false;
+		}
+
+		return true;
+	}
+
+	QByteArray TorrentStorage::ReadTorrentFile (const QString& name) const
+	{
+		return Read (name);
+	}
+
+	QByteArray TorrentStorage::ReadResumeData (const QString& name) const
+	{
+		return Read (name + ".resume");
+	}
+
+	bool TorrentStorage::WriteTorrentFile (const QString& name, const QByteArray& contents) const
+	{
+		return Write (name, contents);
+	}
+
+	bool TorrentStorage::WriteResumeData (const QString& name, const QByteArray& contents) const
+	{
+		return Write (name + ".resume", contents);
+	}
+
+	QByteArray TorrentStorage::Read (const QString& name) const
+	{
+		if (!IsValid_)
+			return {};
+
+		/* Previous versions could crash between removing the old file
+		 * and renaming the new one, leaving only the complete new one.
+		 */
+		auto path = Dir_.filePath (name);
+		if (!QFile::exists (path) && QFile::exists (path + ".new"))
+			path += ".new";
+
+		QFile file { path };
+		if (!file.open (QIODevice::ReadOnly))
+			return {};
+
+		return file.readAll ();
+	}
+
+	bool TorrentStorage::Write (const QString& name, const QByteArray& contents) const
+	{
+		if (!IsValid_)
+			return false;
+
+		QSaveFile file { Dir_.filePath (name) };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return false;
+		}
+
+		if (file.write (contents) != contents.size ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write"
+					<< file.fileName ()
+					<< file.errorString ();
+			file.cancelWriting ();
+			return false;
+		}
+
+		if (!file.commit ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to commit"
+					<< file.fileName ()
+					<< file.errorString ();
+			return false;
+		}
+
+		return true;
+	}
+}
+}
@@ -0,0 +1,97 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QDir>
+#include <QList>
+#include <QStringList>
+#include <QByteArray>
+
+namespace LeechCraft
+{
+namespace BitTorrent
+{
+	/** Describes a single torrent in the saved session.
+	 */
+	struct SavedTorrent
+	{
+		QString Filename_;
+		QString SavePath_;
+		QStringList Tags_;
+		int Parameters_ = 0;
+		bool AutoManaged_ = true;
+		QByteArray Priorities_;
+	};
+
+	/** Stores the list of torrents in the session along with their
+	 * .torrent files and resume data under ~/.leechcraft/bittorrent.
+	 *
+	 * The list itself is kept in a single binary file which is only
+	 * rewritten if its contents have actually changed since the last
+	 * save. All the files are written to a temporary file first and
+	 * then renamed over the old ones, so a crash in the middle of a
+	 * save leaves the previous version intact.
+	 *
+	 * The read-only methods are reentrant and may be called from the
+	 * worker threads.
+	 */
+	class TorrentStorage
+	{
+		QDir Dir_;
+		bool IsValid_ = false;
+
+		QByteArray LastList_;
+		bool HasLegacyList_ = false;
+	public:
+		TorrentStorage ();
+
+		/** Returns the list of the saved torrents, migrating it from
+		 * the old QSettings-based storage if needed.
+		 */
+		QList<SavedTorrent> LoadList ();
+
+		/** Saves the list of the torrents if it differs from the one
+		 * saved (or loaded) last time.
+		 *
+		 * @return Whether the list has been written.
+		 */
+		bool SaveList (const QList<SavedTorrent>&);
+
+		QByteArray ReadTorrentFile (const QString& name) const;
+		QByteArray ReadResumeData (const QString& name) const;
+
+		bool WriteTorrentFile (const QString& name, const QByteArray& contents) const;
+		bool WriteResumeData (const QString& name, const QByteArray& contents) const;
+	private:
+		QByteArray Read (const QString& name) const;
+		bool Write (const QString& name, const QByteArray& contents) const;
+	};
+}
+}
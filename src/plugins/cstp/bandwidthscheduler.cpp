@@ -0,0 +1,240 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "bandwidthscheduler.h"
+#include <limits>
+#include <algorithm>
+#include <QTimer>
+#include "xmlsettingsmanager.h"
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	namespace
+	{
+		const int TickInterval = 100;
+
+		/** How much data may be consumed in one burst after a bucket has
+		 * been idle, in milliseconds worth of its rate.
+		 */
+		const int BurstMsecs = 500;
+	}
+
+	qint64 BandwidthScheduler::Bucket::GetAvailable () const
+	{
+		return Limit_ ?
+				static_cast<qint64> (Tokens_) :
+				std::numeric_limits<qint64>::max ();
+	}
+
+	void BandwidthScheduler::Bucket::Consume (qint64 bytes)
+	{
+		Consumed_ += bytes;
+		if (Limit_)
+			Tokens_ -= bytes;
+	}
+
+	void BandwidthScheduler::Bucket::Tick (qint64 msecs)
+	{
+		msecs = std::max<qint64> (msecs, 1);
+
+		Rate_ = (Rate_ + Consumed_ * 1000. / msecs) / 2;
+		Consumed_ = 0;
+
+		if (Limit_)
+			Tokens_ = std::min<double> (Tokens_ + Limit_ * msecs / 1000.,
+					Limit_ * BurstMsecs / 1000.);
+	}
+
+	BandwidthScheduler::BandwidthScheduler (QObject *parent)
+	: QObject { parent }
+	, Timer_ { new QTimer { this } }
+	{
+		connect (Timer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (tick ()));
+
+		XmlSettingsManager::Instance ().RegisterObject (QList<QByteArray> {
+					"GlobalDownloadLimit",
+					"TaskDownloadLimit",
+					"BackgroundDownloadLimit"
+				},
+				this, "handleLimitsChanged");
+		handleLimitsChanged ();
+	}
+
+	void BandwidthScheduler::Register (QObject *consumer,
+			Priority priority, const std::function<void ()>& resume)
+	{
+		if (!Consumers_.contains (consumer))
+			connect (consumer,
+					SIGNAL (destroyed (QObject*)),
+					this,
+					SLOT (removeConsumer (QObject*)));
+
+		Consumer c { priority, resume, {}, false };
+		c.Bucket_.Limit_ = XmlSettingsManager::Instance ()
+				.property ("TaskDownloadLimit").toLongLong () * 1024;
+		c.Bucket_.Tokens_ = c.Bucket_.Limit_ * BurstMsecs / 1000.;
+		Consumers_ [consumer] = c;
+
+		if (!Timer_->isActive ())
+		{
+			SinceTick_.start ();
+			Timer_->start (TickInterval);
+		}
+	}
+
+	bool BandwidthScheduler::IsRegistered (QObject *consumer) const
+	{
+		return Consumers_.contains (consumer);
+	}
+
+	void BandwidthScheduler::Unregister (QObject *consumer)
+	{
+		if (!Consumers_.contains (consumer))
+			return;
+
+		disconnect (consumer,
+				SIGNAL (destroyed (QObject*)),
+				this,
+				SLOT (removeConsumer (QObject*)));
+		removeConsumer (consumer);
+	}
+
+	qint64 BandwidthScheduler::Acquire (QObject *consumer, qint64 wanted)
+	{
+		const auto pos = Consumers_.find (consumer);
+		if (pos == Consumers_.end ())
+			return wanted;
+
+		auto& classBucket = GetClassBucket (pos->Priority_);
+		const auto allowed = std::max<qint64> (0,
+				std::min ({
+					wanted,
+					Global_.GetAvailable (),
+					classBucket.GetAvailable (),
+					pos->Bucket_.GetAvailable ()
+				}));
+
+		Global_.Consume (allowed);
+		classBucket.Consume (allowed);
+		pos->Bucket_.Consume (allowed);
+
+		if (allowed < wanted)
+			pos->Waiting_ = true;
+
+		return allowed;
+	}
+
+	qint64 BandwidthScheduler::GetRate () const
+	{
+		return Global_.Rate_;
+	}
+
+	qint64 BandwidthScheduler::GetRate (Priority priority) const
+	{
+		return GetClassBucket (priority).Rate_;
+	}
+
+	qint64 BandwidthScheduler::GetRate (QObject *consumer) const
+	{
+		const auto pos = Consumers_.find (consumer);
+		return pos == Consumers_.end () ? 0 : pos->Bucket_.Rate_;
+	}
+
+	auto BandwidthScheduler::GetClassBucket (Priority priority) -> Bucket&
+	{
+		return priority == Priority::Interactive ? Interactive_ : Background_;
+	}
+
+	auto BandwidthScheduler::GetClassBucket (Priority priority) const -> const Bucket&
+	{
+		return priority == Priority::Interactive ? Interactive_ : Background_;
+	}
+
+	void BandwidthScheduler::handleLimitsChanged ()
+	{
+		auto getLimit = [] (const char *name)
+		{
+			return XmlSettingsManager::Instance ().property (name).toLongLong () * 1024;
+		};
+
+		Global_.Limit_ = getLimit ("GlobalDownloadLimit");
+		Background_.Limit_ = getLimit ("BackgroundDownloadLimit");
+
+		const auto taskLimit = getLimit ("TaskDownloadLimit");
+		for (auto& consumer : Consumers_)
+			consumer.Bucket_.Limit_ = taskLimit;
+	}
+
+	void BandwidthScheduler::tick ()
+	{
+		const auto msecs = SinceTick_.restart ();
+
+		Global_.Tick (msecs);
+		Interactive_.Tick (msecs);
+		Background_.Tick (msecs);
+
+		QList<QObject*> interactive;
+		QList<QObject*> background;
+		for (auto i = Consumers_.begin (), end = Consumers_.end (); i != end; ++i)
+		{
+			i->Bucket_.Tick (msecs);
+			if (!i->Waiting_)
+				continue;
+
+			i->Waiting_ = false;
+			(i->Priority_ == Priority::Interactive ? interactive : background) << i.key ();
+		}
+
+		/* The resume callbacks may register, unregister or mark as
+		 * waiting any consumers, so don't hold any iterators here.
+		 */
+		for (const auto consumer : interactive + background)
+		{
+			const auto pos = Consumers_.find (consumer);
+			if (pos != Consumers_.end ())
+			{
+				const auto resume = pos->Resume_;
+				resume ();
+			}
+		}
+	}
+
+	void BandwidthScheduler::removeConsumer (QObject *consumer)
+	{
+		Consumers_.remove (consumer);
+		if (Consumers_.isEmpty ())
+			Timer_->stop ();
+	}
+}
+}
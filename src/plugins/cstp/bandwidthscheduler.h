@@ -0,0 +1,152 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QObject>
+#include <QHash>
+#include <QElapsedTimer>
+
+class QTimer;
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	/** Limits the rate at which the tasks consume the downloaded data.
+	 *
+	 * Each task, the whole CSTP and each of the priority classes have
+	 * their own token bucket refilled according to the configured
+	 * limits. A task asks for the permission to consume some bytes via
+	 * Acquire() and is allowed to consume at most as much as all the
+	 * relevant buckets have. If it got less than it has asked for, its
+	 * resume callback is invoked once the buckets are refilled, with
+	 * interactive tasks being woken up before background ones.
+	 *
+	 * Since the tasks leave the data they weren't allowed to consume
+	 * in their replies, and the replies have a limited read buffer, this
+	 * eventually throttles the network transfer itself.
+	 */
+	class BandwidthScheduler : public QObject
+	{
+		Q_OBJECT
+	public:
+		enum class Priority
+		{
+			Interactive,
+			Background
+		};
+	private:
+		struct Bucket
+		{
+			/** The rate in bytes per second, or 0 if unlimited.
+			 */
+			qint64 Limit_ = 0;
+			double Tokens_ = 0;
+
+			qint64 Consumed_ = 0;
+			double Rate_ = 0;
+
+			qint64 GetAvailable () const;
+			void Consume (qint64);
+			void Tick (qint64 msecs);
+		};
+
+		struct Consumer
+		{
+			Priority Priority_;
+			std::function<void ()> Resume_;
+			Bucket Bucket_;
+			bool Waiting_;
+		};
+
+		QTimer * const Timer_;
+		QElapsedTimer SinceTick_;
+
+		Bucket Global_;
+		Bucket Interactive_;
+		Bucket Background_;
+		QHash<QObject*, Consumer> Consumers_;
+	public:
+		BandwidthScheduler (QObject* = nullptr);
+
+		/** Registers the consumer with the given priority.
+		 *
+		 * The consumer is unregistered automatically once it's
+		 * destroyed, but it should call Unregister() as soon as it
+		 * stops consuming data.
+		 *
+		 * @param[in] consumer The consumer object.
+		 * @param[in] priority The priority class of the consumer.
+		 * @param[in] resume The function to be called once more data
+		 * may be consumed after Acquire() has returned less than was
+		 * asked for.
+		 */
+		void Register (QObject *consumer, Priority priority, const std::function<void ()>& resume);
+		bool IsRegistered (QObject*) const;
+
+		/** Unregisters the consumer, if it was registered.
+		 *
+		 * The scheduler stops ticking once there are no registered
+		 * consumers left.
+		 */
+		void Unregister (QObject*);
+
+		/** Returns how many of the wanted bytes the consumer may
+		 * consume right now, marking them as consumed.
+		 *
+		 * Unregistered consumers aren't limited at all.
+		 */
+		qint64 Acquire (QObject *consumer, qint64 wanted);
+
+		/** Returns the current overall rate in bytes per second.
+		 */
+		qint64 GetRate () const;
+
+		/** Returns the current rate of the given priority class in
+		 * bytes per second.
+		 */
+		qint64 GetRate (Priority) const;
+
+		/** Returns the current rate of the given consumer in bytes per
+		 * second.
+		 */
+		qint64 GetRate (QObject*) const;
+	private:
+		Bucket& GetClassBucket (Priority);
+		const Bucket& GetClassBucket (Priority) const;
+	public slots:
+		void handleLimitsChanged ();
+	private slots:
+		void tick ();
+		void removeConsumer (QObject*);
+	};
+}
+}
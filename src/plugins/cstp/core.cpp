@@ -41,6 +41,7 @@
 #include <QRegExp>
 #include <QDesktopServices>
 #include <QToolBar>
+#include <QThread>
 #include <interfaces/entitytesthandleresult.h>
 #include <interfaces/core/icoreproxy.h>
 #include <interfaces/ijobholder.h>
@@ -53,6 +54,7 @@
 #include "task.h"
 #include "xmlsettingsmanager.h"
 #include "addtask.h"
+#include "bandwidthscheduler.h"
 
 Q_DECLARE_METATYPE (QNetworkReply*)
 Q_DECLARE_METATYPE (QToolBar*)
@@ -76,6 +78,8 @@ namespace CSTP
 	: Headers_ { "URL", tr ("State"), tr ("Progress") }
 	, SaveScheduled_ (false)
 	, Toolbar_ (0)
+	, WriterThread_ (0)
+	, Scheduler_ (new BandwidthScheduler (this))
 	{
 		setObjectName ("CSTP Core");
 		qRegisterMetaType<std::shared_ptr<QFile>> ("std::shared_ptr<QFile>");
@@ -93,6 +97,12 @@ namespace CSTP
 	void Core::Release ()
 	{
 		writeSettings ();
+
+		if (WriterThread_)
+		{
+			WriterThread_->quit ();
+			WriterThread_->wait ();
+		}
 	}
 
 	void Core::SetCoreProxy (ICoreProxy_ptr proxy)
@@ -316,6 +326,8 @@ namespace CSTP
 
 		if (td.Parameters_ & Internal)
 			td.Task_->ForbidNameChanges ();
+		if (td.Parameters_ & Internal || td.Parameters_ & DoNotNotifyUser)
+			td.Task_->SetPriority (BandwidthScheduler::Priority::Background);
 
 		connect (td.Task_.get (),
 				SIGNAL (done (bool)),
@@ -352,9 +364,7 @@ namespace CSTP
 
 	qint64 Core::GetTotalDownloadSpeed () const
 	{
-		return std::accumulate (ActiveTasks_.begin (), ActiveTasks_.end (), 0,
-				[] (qint64 acc, const Core::TaskDescr& td)
-					{ return acc + td.Task_->GetSpeed (); });
+		return Scheduler_->GetRate ();
 	}
 
 	namespace
@@ -425,6 +435,22 @@ namespace CSTP
 		FinishedReplies_.remove (rep);
 	}
 
+	QThread* Core::GetWriterThread ()
+	{
+		if (!WriterThread_)
+		{
+			WriterThread_ = new QThread (this);
+			WriterThread_->start ();
+		}
+
+		return WriterThread_;
+	}
+
+	BandwidthScheduler* Core::GetBandwidthScheduler () const
+	{
+		return Scheduler_;
+	}
+
 	int Core::columnCount (const QModelIndex&) const
 	{
 		return Headers_.size ();
@@ -624,6 +650,8 @@ namespace CSTP
 
 	void Core::done (bool err)
 	{
+		Scheduler_->Unregister (sender ());
+
 		tasks_t::iterator taskdscr = FindTask (sender ());
 		if (taskdscr == ActiveTasks_.end ())
 			return;
@@ -43,6 +43,7 @@
 
 class QFile;
 class QToolBar;
+class QThread;
 
 struct EntityTestHandleResult;
 
@@ -59,6 +60,7 @@ namespace LeechCraft
 namespace CSTP
 {
 	class Task;
+	class BandwidthScheduler;
 
 	class Core : public QAbstractItemModel
 	{
@@ -81,6 +83,8 @@ namespace CSTP
 		bool SaveScheduled_;
 		QNetworkAccessManager *NetworkAccessManager_;
 		QToolBar *Toolbar_;
+		QThread *WriterThread_;
+		BandwidthScheduler *Scheduler_;
 		QSet<QNetworkReply*> FinishedReplies_;
 		QModelIndex Selected_;
 		ICoreProxy_ptr CoreProxy_;
@@ -117,6 +121,13 @@ namespace CSTP
 		bool HasFinishedReply (QNetworkReply*) const;
 		void RemoveFinishedReply (QNetworkReply*);
 
+		/** Returns the thread the segmented downloads write their data
+		 * from, starting it if needed.
+		 */
+		QThread* GetWriterThread ();
+
+		BandwidthScheduler* GetBandwidthScheduler () const;
+
 		virtual int columnCount (const QModelIndex& = QModelIndex ()) const;
 		virtual QVariant data (const QModelIndex&, int = Qt::DisplayRole) const;
 		virtual Qt::ItemFlags flags (const QModelIndex&) const;
@@ -27,75 +27,62 @@
  * DEALINGS IN THE SOFTWARE.
  **********************************************************************/
 
-#include "avatarsstorage.h"
-#include <memory>
-#include <QTimer>
-#include <QImage>
-#include <QtConcurrentRun>
+#include "segmentwriter.h"
+#include <QFile>
 #include <QtDebug>
-#include <util/sys/paths.h>
 
 namespace LeechCraft
 {
-namespace Azoth
+namespace CSTP
 {
-namespace Xoox
-{
-	AvatarsStorage::AvatarsStorage (QObject *parent)
-	: QObject { parent }
-	, AvatarsDir_ { Util::GetUserDir (Util::UserDir::Cache, "azoth/xoox/hashed_avatars") }
+	SegmentWriter::SegmentWriter (const QString& path)
+	: File_ { new QFile { path, this } }
 	{
-		QTimer::singleShot (30000,
-				this,
-				SLOT (collectOldAvatars ()));
-
-		// Remove later
-		QtConcurrent::run ([] () -> void
-				{
-					auto dir = Util::CreateIfNotExists ("azoth/xoox/hashed_avatars");
-					for (const auto& file : dir.entryList (QDir::Files))
-						dir.remove (file);
-
-					dir.cdUp ();
-					dir.rmdir ("hashed_avatars");
-				});
 	}
 
-	/** The clients are free to not call this function if they know the avatar is
-	 * already stored. That means that we should be beware of this when implementing
-	 * caching, if we'd ever do.
-	 *
-	 * See EntryBase::SetVCard() for example.
-	 */
-	void AvatarsStorage::StoreAvatar (const QImage& image, const QByteArray& hash)
+	void SegmentWriter::write (qint64 offset, const QByteArray& data)
 	{
-		auto file = std::make_shared<QFile> (AvatarsDir_.absoluteFilePath (hash));
-		if (file->exists () && file->size ())
+		if (Failed_)
 			return;
 
-		if (!file->open (QIODevice::WriteOnly | QIODevice::Truncate))
+		if (!File_->isOpen () && !File_->open (QIODevice::ReadWrite | QIODevice::Unbuffered))
+		{
+			Fail ();
+			return;
+		}
+
+		if (!File_->seek (offset) ||
+				File_->write (data) != data.size ())
 		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open file"
-					<< file->fileName ()
-					<< "for writing";
+			Fail ();
 			return;
 		}
 
-		QtConcurrent::run ([file, image] { image.save (file.get (), "PNG", 0); });
+		emit written (offset, data.size ());
 	}
 
-	QImage AvatarsStorage::GetAvatar (const QByteArray& hash) const
+	void SegmentWriter::sync ()
 	{
-		return QImage (AvatarsDir_.absoluteFilePath (hash));
 	}
 
-	void AvatarsStorage::collectOldAvatars ()
+	void SegmentWriter::finish ()
 	{
-		auto list = AvatarsDir_.entryList (QDir::Files, QDir::Time | QDir::Reversed);
-		while (list.size () > 4000)
-			AvatarsDir_.remove (list.takeLast ());
+		if (Failed_)
+			return;
+
+		File_->close ();
+		emit finished ();
+	}
+
+	void SegmentWriter::Fail ()
+	{
+		qWarning () << Q_FUNC_INFO
+				<< "error writing to"
+				<< File_->fileName ()
+				<< File_->errorString ();
+
+		Failed_ = true;
+		emit error (File_->errorString ());
 	}
-}
 }
 }
@@ -0,0 +1,82 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QObject>
+
+class QFile;
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	/** Writes the data of a segmented download into the target file
+	 * at the given offsets.
+	 *
+	 * The writer is meant to live in the writer thread returned by
+	 * Core::GetWriterThread(), so that the disk I/O doesn't block the
+	 * GUI thread. Thus all its slots should be invoked via queued
+	 * connections.
+	 */
+	class SegmentWriter : public QObject
+	{
+		Q_OBJECT
+
+		QFile * const File_;
+		bool Failed_ = false;
+	public:
+		SegmentWriter (const QString& path);
+	public slots:
+		/** Writes the data at the given offset and emits written() once
+		 * the data is handed over to the OS.
+		 */
+		void write (qint64 offset, const QByteArray& data);
+
+		/** A barrier for the writer thread: it does nothing on its
+		 * own, but once its invocation via a blocking queued connection
+		 * returns, all the previously queued writes are done.
+		 *
+		 * The file is unbuffered, so the written data is already handed
+		 * over to the OS by then. It is not fsync()'ed though.
+		 */
+		void sync ();
+
+		/** Closes the file and emits finished().
+		 */
+		void finish ();
+	private:
+		void Fail ();
+	signals:
+		void written (qint64 offset, qint64 size);
+		void finished ();
+		void error (const QString&);
+	};
+}
+}
@@ -29,6 +29,7 @@
 
 #include "task.h"
 #include <algorithm>
+#include <limits>
 #include <typeinfo>
 #include <stdexcept>
 #include <QUrl>
@@ -36,11 +37,13 @@
 #include <QDataStream>
 #include <QDir>
 #include <QTimer>
+#include <QCoreApplication>
 #include <QtDebug>
 #include <util/xpc/util.h>
 #include <interfaces/core/icoreproxy.h>
 #include "core.h"
 #include "xmlsettingsmanager.h"
+#include "segmentwriter.h"
 
 namespace LeechCraft
 {
@@ -53,6 +56,19 @@ namespace CSTP
 			if (rep)
 				rep->deleteLater ();
 		}
+
+		/** Segments aren't split further if this would make them
+		 * smaller than this.
+		 */
+		const qint64 MinSegmentSize = 1024 * 1024;
+
+		const int MaxSegmentRetries = 3;
+
+		/** Limits how much data a reply buffers on its own, so that the
+		 * data held back by the BandwidthScheduler throttles the
+		 * network transfer itself.
+		 */
+		const qint64 ReadBufferSize = 512 * 1024;
 	}
 
 	Task::Task (const QUrl& url, const QVariantMap& params)
@@ -67,6 +83,12 @@ namespace CSTP
 	, CanChangeName_ (true)
 	, Referer_ (params ["Referer"].toUrl ())
 	, Params_ (params)
+	, Priority_ (BandwidthScheduler::Priority::Interactive)
+	, FinishPending_ (false)
+	, CanSegment_ (true)
+	, Writer_ (nullptr)
+	, DoneAtSegmentsStart_ (0)
+	, MaxConnections_ (std::numeric_limits<int>::max ())
 	{
 		StartTime_.start ();
 
@@ -85,6 +107,12 @@ namespace CSTP
 	, UpdateCounter_ (0)
 	, Timer_ (new QTimer (this))
 	, CanChangeName_ (true)
+	, Priority_ (BandwidthScheduler::Priority::Interactive)
+	, FinishPending_ (false)
+	, CanSegment_ (false)
+	, Writer_ (nullptr)
+	, DoneAtSegmentsStart_ (0)
+	, MaxConnections_ (std::numeric_limits<int>::max ())
 	{
 		StartTime_.start ();
 
@@ -94,11 +122,38 @@ namespace CSTP
 				SIGNAL (updateInterface ()));
 	}
 
+	Task::~Task ()
+	{
+		if (Writer_)
+			Writer_->deleteLater ();
+	}
+
 	void Task::Start (const std::shared_ptr<QFile>& tof)
 	{
 		FileSizeAtStart_ = tof->size ();
 		To_ = tof;
 
+		Core::Instance ().GetBandwidthScheduler ()->Register (this,
+				Priority_,
+				[this] { handleBandwidthAvailable (); });
+
+		if (!Segments_.isEmpty ())
+		{
+			if (!URL_.isEmpty () && tof->size () == Total_)
+			{
+				StartSegments ();
+				return;
+			}
+
+			qWarning () << Q_FUNC_INFO
+					<< "cannot resume the segmented download of"
+					<< URL_
+					<< "starting from scratch";
+			Segments_.clear ();
+			tof->resize (0);
+			FileSizeAtStart_ = 0;
+		}
+
 		if (!Reply_.get ())
 		{
 			if (URL_.scheme () == "file")
@@ -109,28 +164,9 @@ namespace CSTP
 				return;
 			}
 
-			QString ua = XmlSettingsManager::Instance ()
-				.property ("UserUserAgent").toString ();
-			if (ua.isEmpty ())
-				ua = XmlSettingsManager::Instance ()
-					.property ("PredefinedUserAgent").toString ();
-
-			if (ua == "%leechcraft%")
-				ua = "LeechCraft.CSTP/" + Core::Instance ().GetCoreProxy ()->GetVersion ();
-
-			QNetworkRequest req (URL_);
+			auto req = MakeRequest ();
 			if (tof->size ())
 				req.setRawHeader ("Range", QString ("bytes=%1-").arg (tof->size ()).toLatin1 ());
-			req.setRawHeader ("User-Agent", ua.toLatin1 ());
-
-			if (Referer_.isEmpty ())
-				req.setRawHeader ("Referer", QString (QString ("http://") + URL_.host ()).toLatin1 ());
-			else
-				req.setRawHeader ("Referer", Referer_.toEncoded ());
-
-			req.setRawHeader ("Host", URL_.host ().toLatin1 ());
-			req.setRawHeader ("Origin", URL_.scheme ().toLatin1 () + "://" + URL_.host ().toLatin1 ());
-			req.setRawHeader ("Accept", "*/*");
 
 			StartTime_.restart ();
 
@@ -155,6 +191,7 @@ namespace CSTP
 		}
 		else
 		{
+			Reply_->setReadBufferSize (ReadBufferSize);
 			handleMetaDataChanged ();
 
 			qint64 contentLength = Reply_->
@@ -181,6 +218,7 @@ namespace CSTP
 		if (!Timer_->isActive ())
 			Timer_->start (3000);
 
+		Reply_->setReadBufferSize (ReadBufferSize);
 		Reply_->setParent (0);
 		connect (Reply_.get (),
 				SIGNAL (downloadProgress (qint64, qint64)),
@@ -206,8 +244,19 @@ namespace CSTP
 
 	void Task::Stop ()
 	{
+		Core::Instance ().GetBandwidthScheduler ()->Unregister (this);
+
 		if (Reply_.get ())
 			Reply_->abort ();
+		else if (HasSegmentReplies ())
+		{
+			// Stopping a segmented download isn't an error, it just becomes
+			// resumable from the confirmed offsets.
+			StopSegments ();
+			Timer_->stop ();
+			Speed_ = 0;
+			emit updateInterface ();
+		}
 	}
 
 	void Task::ForbidNameChanges ()
@@ -215,18 +264,28 @@ namespace CSTP
 		CanChangeName_ = false;
 	}
 
+	void Task::SetPriority (BandwidthScheduler::Priority priority)
+	{
+		Priority_ = priority;
+	}
+
 	QByteArray Task::Serialize () const
 	{
 		QByteArray result;
 		{
 			QDataStream out (&result, QIODevice::WriteOnly);
-			out << 2
+			QList<QPair<qint64, qint64>> segments;
+			for (const auto& seg : Segments_)
+				segments << qMakePair (seg.Written_, seg.End_);
+
+			out << 3
 				<< URL_
 				<< StartTime_
 				<< Done_
 				<< Total_
 				<< Speed_
-				<< CanChangeName_;
+				<< CanChangeName_
+				<< segments;
 		}
 		return result;
 	}
@@ -246,8 +305,15 @@ namespace CSTP
 		}
 		if (version >= 2)
 			in >> CanChangeName_;
+		if (version >= 3)
+		{
+			QList<QPair<qint64, qint64>> segments;
+			in >> segments;
+			for (const auto& pair : segments)
+				Segments_.append ({ pair.first, pair.first, pair.first, pair.second, {}, {}, 0, 0 });
+		}
 
-		if (version < 1 || version > 2)
+		if (version < 1 || version > 3)
 			throw std::runtime_error ("Unknown version");
 	}
 
@@ -268,7 +334,7 @@ namespace CSTP
 
 	QString Task::GetState () const
 	{
-		if (!Reply_.get ())
+		if (!Reply_.get () && !HasSegmentReplies ())
 			return tr ("Stopped");
 		else if (Done_ == Total_)
 			return tr ("Finished");
@@ -288,12 +354,17 @@ namespace CSTP
 
 	bool Task::IsRunning () const
 	{
-		return Reply_.get () && !URL_.isEmpty ();
+		return (Reply_.get () || HasSegmentReplies ()) && !URL_.isEmpty ();
 	}
 
 	QString Task::GetErrorString () const
 	{
-		return Reply_.get () ? Reply_->errorString () : tr ("Task isn't initialized properly");
+		if (Reply_.get ())
+			return Reply_->errorString ();
+		else if (!SegmentsError_.isEmpty ())
+			return SegmentsError_;
+		else
+			return tr ("Task isn't initialized properly");
 	}
 
 	void Task::Reset ()
@@ -466,6 +537,429 @@ namespace CSTP
 		Reply_.reset ();
 	}
 
+	QNetworkRequest Task::MakeRequest () const
+	{
+		QString ua = XmlSettingsManager::Instance ()
+			.property ("UserUserAgent").toString ();
+		if (ua.isEmpty ())
+			ua = XmlSettingsManager::Instance ()
+				.property ("PredefinedUserAgent").toString ();
+
+		if (ua == "%leechcraft%")
+			ua = "LeechCraft.CSTP/" + Core::Instance ().GetCoreProxy ()->GetVersion ();
+
+		QNetworkRequest req (URL_);
+		req.setRawHeader ("User-Agent", ua.toLatin1 ());
+
+		if (Referer_.isEmpty ())
+			req.setRawHeader ("Referer", QString (QString ("http://") + URL_.host ()).toLatin1 ());
+		else
+			req.setRawHeader ("Referer", Referer_.toEncoded ());
+
+		req.setRawHeader ("Host", URL_.host ().toLatin1 ());
+		req.setRawHeader ("Origin", URL_.scheme ().toLatin1 () + "://" + URL_.host ().toLatin1 ());
+		req.setRawHeader ("Accept", "*/*");
+		return req;
+	}
+
+	namespace
+	{
+		bool ParseContentRange (const QByteArray& header, qint64& start, qint64& total)
+		{
+			// bytes <start>-<end>/<total>
+			const auto& spec = header.trimmed ();
+			if (!spec.startsWith ("bytes "))
+				return false;
+
+			const auto dashPos = spec.indexOf ('-');
+			const auto slashPos = spec.indexOf ('/');
+			if (dashPos == -1 || slashPos < dashPos)
+				return false;
+
+			bool startOk = false;
+			bool totalOk = false;
+			start = spec.mid (6, dashPos - 6).toLongLong (&startOk);
+			total = spec.mid (slashPos + 1).toLongLong (&totalOk);
+			return startOk && totalOk;
+		}
+	}
+
+	bool Task::TrySegmenting ()
+	{
+		if (!CanSegment_ ||
+				!Reply_.get () ||
+				URL_.isEmpty () ||
+				!Segments_.isEmpty ())
+			return false;
+
+		if (Params_.value ("Operation", QNetworkAccessManager::GetOperation).toInt () !=
+				QNetworkAccessManager::GetOperation)
+			return false;
+
+		if (!Reply_->rawHeader ("Location").isEmpty ())
+			return false;
+
+		const auto maxSegments = XmlSettingsManager::Instance ()
+				.property ("SegmentsCount").toInt ();
+		if (maxSegments < 2)
+			return false;
+
+		qint64 start = 0;
+		qint64 total = -1;
+		switch (Reply_->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ())
+		{
+		case 200:
+			if (FileSizeAtStart_ ||
+					Reply_->rawHeader ("Accept-Ranges").trimmed () != "bytes")
+				return false;
+			total = Reply_->header (QNetworkRequest::ContentLengthHeader).toLongLong ();
+			break;
+		case 206:
+			if (!ParseContentRange (Reply_->rawHeader ("Content-Range"), start, total))
+				return false;
+			break;
+		default:
+			return false;
+		}
+
+		if (start != FileSizeAtStart_ ||
+				To_->size () != FileSizeAtStart_ ||
+				total - start < 2 * MinSegmentSize)
+			return false;
+
+		if (!To_->resize (total))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to preallocate"
+					<< total
+					<< "bytes for"
+					<< To_->fileName ()
+					<< To_->errorString ();
+			return false;
+		}
+
+		const auto length = total - start;
+		const auto count = std::min<qint64> (maxSegments, length / MinSegmentSize);
+		const auto segmentSize = length / count;
+		for (int i = 0; i < count; ++i)
+		{
+			const auto segStart = start + i * segmentSize;
+			const auto segEnd = i == count - 1 ? total : segStart + segmentSize;
+			Segments_.append ({ segStart, segStart, segStart, segEnd, {}, {}, 0, 0 });
+		}
+
+		qDebug () << Q_FUNC_INFO
+				<< "downloading"
+				<< URL_
+				<< "in"
+				<< count
+				<< "segments";
+
+		// The current reply is already fetching the first segment.
+		disconnect (Reply_.get (),
+				0,
+				this,
+				0);
+		auto& first = Segments_ [0];
+		first.Reply_.reset (Reply_.release (), &LateDelete);
+		first.Started_.start ();
+		ConnectSegment (first.Reply_.get ());
+
+		Total_ = total;
+		StartSegments ();
+		return true;
+	}
+
+	void Task::StartSegments ()
+	{
+		Writer_ = new SegmentWriter (To_->fileName ());
+		Writer_->moveToThread (Core::Instance ().GetWriterThread ());
+		connect (Writer_,
+				SIGNAL (written (qint64, qint64)),
+				this,
+				SLOT (handleSegmentWritten (qint64, qint64)));
+		connect (Writer_,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleWriterFinished ()));
+		connect (Writer_,
+				SIGNAL (error (QString)),
+				this,
+				SLOT (handleWriterError (QString)));
+
+		Done_ = Total_;
+		for (const auto& seg : Segments_)
+			Done_ -= seg.End_ - seg.Pos_;
+		DoneAtSegmentsStart_ = Done_;
+		StartTime_.restart ();
+
+		while (StartParkedSegment ())
+			;
+
+		if (!Timer_->isActive ())
+			Timer_->start (3000);
+
+		CheckSegmentsDone ();
+	}
+
+	int Task::GetMaxConnections () const
+	{
+		const auto maxSegments = XmlSettingsManager::Instance ()
+				.property ("SegmentsCount").toInt ();
+		return std::max (std::min (maxSegments, MaxConnections_), 1);
+	}
+
+	int Task::CountSegmentReplies () const
+	{
+		return std::count_if (Segments_.begin (), Segments_.end (),
+				[] (const Segment& seg) { return static_cast<bool> (seg.Reply_); });
+	}
+
+	void Task::StartSegment (Segment& seg)
+	{
+		auto req = MakeRequest ();
+		req.setRawHeader ("Range",
+				QString ("bytes=%1-%2").arg (seg.Pos_).arg (seg.End_ - 1).toLatin1 ());
+
+		seg.Reply_.reset (Core::Instance ().GetNetworkAccessManager ()->get (req), &LateDelete);
+		seg.Started_.start ();
+		seg.Received_ = 0;
+
+		// Only the replies we've sent a Range for should be checked for 206.
+		connect (seg.Reply_.get (),
+				SIGNAL (metaDataChanged ()),
+				this,
+				SLOT (handleSegmentMetaDataChanged ()));
+		ConnectSegment (seg.Reply_.get ());
+	}
+
+	/** Starts a connection for a segment that has no reply but still has
+	 * data to fetch, if the connections limit allows it.
+	 */
+	bool Task::StartParkedSegment ()
+	{
+		if (CountSegmentReplies () >= GetMaxConnections ())
+			return false;
+
+		for (auto& seg : Segments_)
+			if (!seg.Reply_ && seg.Pos_ < seg.End_)
+			{
+				StartSegment (seg);
+				return true;
+			}
+
+		return false;
+	}
+
+	void Task::ConnectSegment (QNetworkReply *reply)
+	{
+		reply->setReadBufferSize (ReadBufferSize);
+		reply->setParent (0);
+		connect (reply,
+				SIGNAL (readyRead ()),
+				this,
+				SLOT (handleSegmentReadyRead ()));
+		connect (reply,
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleSegmentFinished ()));
+	}
+
+	void Task::ReleaseSegmentReply (Segment& seg)
+	{
+		if (!seg.Reply_)
+			return;
+
+		const auto reply = seg.Reply_.get ();
+		disconnect (reply,
+				0,
+				this,
+				0);
+		reply->abort ();
+		Core::Instance ().RemoveFinishedReply (reply);
+		seg.Reply_.reset ();
+	}
+
+	int Task::FindSegment (QObject *reply) const
+	{
+		for (int i = 0; i < Segments_.size (); ++i)
+			if (Segments_.at (i).Reply_.get () == reply)
+				return i;
+
+		return -1;
+	}
+
+	void Task::ReadSegment (int idx)
+	{
+		auto& seg = Segments_ [idx];
+
+		const auto wanted = std::min (seg.Reply_->bytesAvailable (), seg.End_ - seg.Pos_);
+		const auto& data = seg.Reply_->read (Core::Instance ()
+					.GetBandwidthScheduler ()->Acquire (this, wanted));
+		const bool reachedEnd = seg.Pos_ + data.size () >= seg.End_;
+
+		if (!data.isEmpty ())
+		{
+			QMetaObject::invokeMethod (Writer_,
+					"write",
+					Qt::QueuedConnection,
+					Q_ARG (qint64, seg.Pos_),
+					Q_ARG (QByteArray, data));
+
+			seg.Pos_ += data.size ();
+			seg.Received_ += data.size ();
+			Done_ += data.size ();
+			Speed_ = static_cast<double> ((Done_ - DoneAtSegmentsStart_) * 1000) /
+					std::max (StartTime_.elapsed (), 1);
+		}
+
+		if (!reachedEnd)
+			return;
+
+		ReleaseSegmentReply (seg);
+		if (!StartParkedSegment ())
+			Rebalance ();
+		CheckSegmentsDone ();
+	}
+
+	void Task::Rebalance ()
+	{
+		const auto maxSegments = GetMaxConnections ();
+
+		int active = 0;
+		int slowest = -1;
+		double slowestEta = 0;
+		for (int i = 0; i < Segments_.size (); ++i)
+		{
+			const auto& seg = Segments_.at (i);
+			if (!seg.Reply_)
+				continue;
+
+			++active;
+
+			const auto left = seg.End_ - seg.Pos_;
+			if (left < 2 * MinSegmentSize)
+				continue;
+
+			const auto eta = static_cast<double> (left) *
+					std::max (seg.Started_.elapsed (), 1) /
+					std::max<qint64> (seg.Received_, 1);
+			if (eta > slowestEta)
+			{
+				slowest = i;
+				slowestEta = eta;
+			}
+		}
+
+		if (slowest == -1 || active >= maxSegments)
+			return;
+
+		/* Steal the second half of the remaining part of the slowest
+		 * segment. Its reply will be stopped once it reaches the new
+		 * end, even though it has asked for more.
+		 */
+		auto& victim = Segments_ [slowest];
+		const auto mid = victim.Pos_ + (victim.End_ - victim.Pos_) / 2;
+		const auto end = victim.End_;
+		victim.End_ = mid;
+		Segments_.append ({ mid, mid, mid, end, {}, {}, 0, 0 });
+
+		StartSegment (Segments_.last ());
+	}
+
+	void Task::CheckSegmentsDone ()
+	{
+		if (!Writer_)
+			return;
+
+		for (const auto& seg : Segments_)
+			if (seg.Pos_ < seg.End_)
+				return;
+
+		QMetaObject::invokeMethod (Writer_, "finish", Qt::QueuedConnection);
+	}
+
+	void Task::StopSegments ()
+	{
+		for (auto& seg : Segments_)
+			ReleaseSegmentReply (seg);
+
+		if (!Writer_)
+			return;
+
+		QMetaObject::invokeMethod (Writer_, "sync", Qt::BlockingQueuedConnection);
+		Writer_->deleteLater ();
+		Writer_ = nullptr;
+
+		/* The writer has processed everything by now, so deliver its
+		 * pending notifications and roll back whatever wasn't written.
+		 */
+		QCoreApplication::sendPostedEvents (this, QEvent::MetaCall);
+
+		Done_ = Total_;
+		for (auto& seg : Segments_)
+		{
+			seg.Pos_ = seg.Written_;
+			Done_ -= seg.End_ - seg.Pos_;
+		}
+	}
+
+	void Task::RestartWithoutSegments ()
+	{
+		qWarning () << Q_FUNC_INFO
+				<< URL_
+				<< "doesn't support ranged requests, falling back to a single connection";
+
+		StopSegments ();
+		Segments_.clear ();
+		CanSegment_ = false;
+
+		To_->resize (0);
+		Reset ();
+		Start (To_);
+	}
+
+	/** Drops the connection of the segment whose request has been
+	 * rejected by the server (like with 503 or 429 from a server
+	 * limiting connections per client). Its range is picked up by the
+	 * next connection that finishes its own segment, and no more
+	 * connections than the currently working ones are opened later.
+	 */
+	void Task::ParkSegment (int idx)
+	{
+		auto& seg = Segments_ [idx];
+		ReleaseSegmentReply (seg);
+
+		const auto active = CountSegmentReplies ();
+		if (active)
+		{
+			MaxConnections_ = std::min (MaxConnections_, active);
+			return;
+		}
+
+		// Nobody else is left to pick the range up.
+		if (++seg.Retries_ > MaxSegmentRetries)
+		{
+			FailSegments (tr ("Server refused the ranged request."));
+			return;
+		}
+
+		StartSegment (seg);
+	}
+
+	void Task::FailSegments (const QString& errorString)
+	{
+		SegmentsError_ = errorString;
+		StopSegments ();
+		emit done (true);
+	}
+
+	bool Task::HasSegmentReplies () const
+	{
+		return std::any_of (Segments_.begin (), Segments_.end (),
+				[] (const Segment& seg) { return static_cast<bool> (seg.Reply_); });
+	}
+
 	void Task::handleDataTransferProgress (qint64 done, qint64 total)
 	{
 		Done_ = done;
@@ -497,6 +991,7 @@ namespace CSTP
 	{
 		HandleMetadataRedirection ();
 		HandleMetadataFilename ();
+		TrySegmenting ();
 	}
 
 	void Task::handleLocalTransfer ()
@@ -563,10 +1058,11 @@ namespace CSTP
 	{
 		if (Reply_.get ())
 		{
-			quint64 avail = Reply_->bytesAvailable ();
-			quint64 res = To_->write (Reply_->readAll ());
+			const auto avail = Core::Instance ().GetBandwidthScheduler ()->
+					Acquire (this, Reply_->bytesAvailable ());
+			quint64 res = To_->write (Reply_->read (avail));
 			if ((static_cast<quint64> (-1) == res) ||
-					(res != avail))
+					(res != static_cast<quint64> (avail)))
 			{
 				qWarning () << Q_FUNC_INFO
 						<< "Error writing to file:"
@@ -594,6 +1090,14 @@ namespace CSTP
 
 	void Task::handleFinished ()
 	{
+		// Some data is still held back by the bandwidth scheduler.
+		if (Reply_.get () && Reply_->bytesAvailable ())
+		{
+			FinishPending_ = true;
+			return;
+		}
+
+		FinishPending_ = false;
 		Cleanup ();
 		emit done (false);
 	}
@@ -603,5 +1107,126 @@ namespace CSTP
 		Cleanup ();
 		emit done (true);
 	}
+
+	void Task::handleSegmentMetaDataChanged ()
+	{
+		const auto idx = FindSegment (sender ());
+		if (idx == -1)
+			return;
+
+		const auto& reply = Segments_.at (idx).Reply_;
+		const auto status = reply->attribute (QNetworkRequest::HttpStatusCodeAttribute);
+		if (!status.isValid () || status.toInt () == 206)
+			return;
+
+		// The server has ignored the Range header and sends the whole file.
+		if (status.toInt () == 200)
+		{
+			RestartWithoutSegments ();
+			return;
+		}
+
+		qWarning () << Q_FUNC_INFO
+				<< "segment"
+				<< Segments_.at (idx).Pos_
+				<< Segments_.at (idx).End_
+				<< "got status"
+				<< status.toInt ()
+				<< reply->attribute (QNetworkRequest::HttpReasonPhraseAttribute).toString ();
+		ParkSegment (idx);
+	}
+
+	void Task::handleSegmentReadyRead ()
+	{
+		const auto idx = FindSegment (sender ());
+		if (idx != -1)
+			ReadSegment (idx);
+	}
+
+	void Task::handleSegmentFinished ()
+	{
+		const auto idx = FindSegment (sender ());
+		if (idx != -1)
+			FinishSegment (idx);
+	}
+
+	void Task::FinishSegment (int idx)
+	{
+		ReadSegment (idx);
+
+		auto& seg = Segments_ [idx];
+		if (!seg.Reply_ || seg.Reply_->bytesAvailable ())
+			return;
+
+		const auto& errorString = seg.Reply_->errorString ();
+		qWarning () << Q_FUNC_INFO
+				<< "segment"
+				<< seg.Pos_
+				<< seg.End_
+				<< "finished prematurely:"
+				<< errorString;
+
+		if (++seg.Retries_ > MaxSegmentRetries)
+		{
+			FailSegments (errorString);
+			return;
+		}
+
+		ReleaseSegmentReply (seg);
+		StartSegment (seg);
+	}
+
+	void Task::handleSegmentWritten (qint64 offset, qint64 size)
+	{
+		for (auto& seg : Segments_)
+			if (offset >= seg.Start_ && offset < seg.End_)
+			{
+				seg.Written_ = std::max (seg.Written_, offset + size);
+				break;
+			}
+	}
+
+	void Task::handleWriterFinished ()
+	{
+		Writer_->deleteLater ();
+		Writer_ = nullptr;
+		Segments_.clear ();
+
+		emit done (false);
+	}
+
+	void Task::handleWriterError (const QString& errorString)
+	{
+		const auto& errString = tr ("Error writing to file %1: %2")
+				.arg (To_->fileName ())
+				.arg (errorString);
+		emit gotEntity (Util::MakeNotification ("LeechCraft CSTP",
+					errString,
+					PCritical_));
+		FailSegments (errString);
+	}
+
+	void Task::handleBandwidthAvailable ()
+	{
+		if (Reply_.get ())
+		{
+			handleReadyRead ();
+			if (FinishPending_ && Reply_.get () && !Reply_->bytesAvailable ())
+				handleFinished ();
+			return;
+		}
+
+		for (int i = 0; i < Segments_.size (); ++i)
+		{
+			const auto& reply = Segments_.at (i).Reply_;
+			if (!reply)
+				continue;
+
+			if (reply->isFinished ())
+				FinishSegment (i);
+			else
+				ReadSegment (i);
+		}
+	}
 }
 }
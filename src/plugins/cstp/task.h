@@ -36,6 +36,7 @@
 #include <QNetworkReply>
 #include <QStringList>
 #include <interfaces/structures.h>
+#include "bandwidthscheduler.h"
 
 class QAuthenticator;
 class QNetworkProxy;
@@ -47,6 +48,8 @@ namespace LeechCraft
 {
 namespace CSTP
 {
+	class SegmentWriter;
+
 	class Task : public QObject
 	{
 		Q_OBJECT
@@ -64,13 +67,43 @@ namespace CSTP
 
 		QUrl Referer_;
 		const QVariantMap Params_;
+
+		BandwidthScheduler::Priority Priority_;
+		bool FinishPending_;
+
+		/** A byte range [Start_, End_) of a segmented download.
+		 *
+		 * Pos_ is the offset up to which the data has been received and
+		 * queued for writing, while Written_ is the offset up to which
+		 * the writer has confirmed the data being on disk.
+		 */
+		struct Segment
+		{
+			qint64 Start_;
+			qint64 Pos_;
+			qint64 Written_;
+			qint64 End_;
+
+			std::shared_ptr<QNetworkReply> Reply_;
+			QTime Started_;
+			qint64 Received_;
+			int Retries_;
+		};
+		QList<Segment> Segments_;
+		bool CanSegment_;
+		SegmentWriter *Writer_;
+		qint64 DoneAtSegmentsStart_;
+		int MaxConnections_;
+		QString SegmentsError_;
 	public:
 		explicit Task (const QUrl& url = QUrl (), const QVariantMap& params = QVariantMap ());
 		explicit Task (QNetworkReply*);
+		~Task ();
 
 		void Start (const std::shared_ptr<QFile>&);
 		void Stop ();
 		void ForbidNameChanges ();
+		void SetPriority (BandwidthScheduler::Priority);
 
 		QByteArray Serialize () const;
 		void Deserialize (QByteArray&);
@@ -90,6 +123,27 @@ namespace CSTP
 		void HandleMetadataFilename ();
 
 		void Cleanup ();
+
+		QNetworkRequest MakeRequest () const;
+
+		bool TrySegmenting ();
+		void StartSegments ();
+		int GetMaxConnections () const;
+		int CountSegmentReplies () const;
+		void StartSegment (Segment&);
+		bool StartParkedSegment ();
+		void ConnectSegment (QNetworkReply*);
+		void ReleaseSegmentReply (Segment&);
+		int FindSegment (QObject*) const;
+		void ReadSegment (int);
+		void FinishSegment (int);
+		void Rebalance ();
+		void CheckSegmentsDone ();
+		void StopSegments ();
+		void RestartWithoutSegments ();
+		void ParkSegment (int);
+		void FailSegments (const QString&);
+		bool HasSegmentReplies () const;
 	private slots:
 		void handleDataTransferProgress (qint64, qint64);
 		void redirectedConstruction (const QByteArray&);
@@ -100,6 +154,15 @@ namespace CSTP
 		bool handleReadyRead ();
 		void handleFinished ();
 		void handleError ();
+
+		void handleSegmentMetaDataChanged ();
+		void handleSegmentReadyRead ();
+		void handleSegmentFinished ();
+		void handleSegmentWritten (qint64, qint64);
+		void handleWriterFinished ();
+		void handleWriterError (const QString&);
+
+		void handleBandwidthAvailable ();
 	signals:
 		void gotEntity (const LeechCraft::Entity&);
 		void updateInterface ();
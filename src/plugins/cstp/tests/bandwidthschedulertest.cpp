@@ -0,0 +1,195 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "bandwidthschedulertest.h"
+#include <QtTest>
+#include <QTimer>
+#include "bandwidthscheduler.h"
+#include "xmlsettingsmanager.h"
+
+QTEST_MAIN (LeechCraft::CSTP::BandwidthSchedulerTest)
+
+namespace LeechCraft
+{
+namespace CSTP
+{
+	namespace
+	{
+		// Buckets may accumulate at most 500 ms worth of their rate.
+		const qint64 Burst = 10 * 1024 / 2;
+
+		// Enough for a bucket to get completely refilled.
+		const int RefillWait = 700;
+
+		void SetLimits (qint64 global, qint64 task, qint64 background)
+		{
+			auto& xsm = XmlSettingsManager::Instance ();
+			xsm.setProperty ("GlobalDownloadLimit", global);
+			xsm.setProperty ("TaskDownloadLimit", task);
+			xsm.setProperty ("BackgroundDownloadLimit", background);
+		}
+
+		void Noop ()
+		{
+		}
+	}
+
+	void BandwidthSchedulerTest::initTestCase ()
+	{
+		QCoreApplication::setOrganizationName ("LeechCraft");
+		QCoreApplication::setApplicationName ("lc_cstp_bandwidthscheduler_test");
+	}
+
+	void BandwidthSchedulerTest::cleanup ()
+	{
+		SetLimits (0, 0, 0);
+	}
+
+	void BandwidthSchedulerTest::unregisteredIsUnlimited ()
+	{
+		SetLimits (10, 10, 10);
+
+		BandwidthScheduler scheduler;
+
+		QObject consumer;
+		QCOMPARE (scheduler.Acquire (&consumer, 1 << 20), qint64 (1 << 20));
+	}
+
+	void BandwidthSchedulerTest::taskBurst ()
+	{
+		SetLimits (0, 10, 0);
+
+		BandwidthScheduler scheduler;
+
+		QObject consumer;
+		scheduler.Register (&consumer, BandwidthScheduler::Priority::Interactive, Noop);
+
+		QCOMPARE (scheduler.Acquire (&consumer, 1 << 20), Burst);
+		QCOMPARE (scheduler.Acquire (&consumer, 1 << 20), qint64 (0));
+	}
+
+	void BandwidthSchedulerTest::taskRefill ()
+	{
+		SetLimits (0, 10, 0);
+
+		BandwidthScheduler scheduler;
+
+		int resumed = 0;
+		QObject consumer;
+		scheduler.Register (&consumer, BandwidthScheduler::Priority::Interactive,
+				[&resumed] { ++resumed; });
+
+		scheduler.Acquire (&consumer, 1 << 20);
+		QTest::qWait (RefillWait);
+
+		QCOMPARE (resumed, 1);
+		QCOMPARE (scheduler.Acquire (&consumer, 1 << 20), Burst);
+	}
+
+	void BandwidthSchedulerTest::globalLimitShared ()
+	{
+		SetLimits (10, 0, 0);
+
+		BandwidthScheduler scheduler;
+
+		QObject first;
+		QObject second;
+		scheduler.Register (&first, BandwidthScheduler::Priority::Interactive, Noop);
+		scheduler.Register (&second, BandwidthScheduler::Priority::Interactive, Noop);
+
+		QTest::qWait (RefillWait);
+
+		QCOMPARE (scheduler.Acquire (&first, Burst / 2), Burst / 2);
+		QCOMPARE (scheduler.Acquire (&second, 1 << 20), Burst / 2);
+		QCOMPARE (scheduler.Acquire (&first, 1 << 20), qint64 (0));
+	}
+
+	void BandwidthSchedulerTest::backgroundLimit ()
+	{
+		SetLimits (0, 0, 10);
+
+		BandwidthScheduler scheduler;
+
+		QObject interactive;
+		QObject background;
+		scheduler.Register (&interactive, BandwidthScheduler::Priority::Interactive, Noop);
+		scheduler.Register (&background, BandwidthScheduler::Priority::Background, Noop);
+
+		QTest::qWait (RefillWait);
+
+		QCOMPARE (scheduler.Acquire (&background, 1 << 20), Burst);
+		QCOMPARE (scheduler.Acquire (&interactive, 1 << 20), qint64 (1 << 20));
+	}
+
+	void BandwidthSchedulerTest::interactiveResumedFirst ()
+	{
+		SetLimits (10, 0, 0);
+
+		BandwidthScheduler scheduler;
+
+		QStringList order;
+		QObject background;
+		QObject interactive;
+		scheduler.Register (&background, BandwidthScheduler::Priority::Background,
+				[&order] { order << "background"; });
+		scheduler.Register (&interactive, BandwidthScheduler::Priority::Interactive,
+				[&order] { order << "interactive"; });
+
+		QTest::qWait (RefillWait);
+
+		QCOMPARE (scheduler.Acquire (&background, 1 << 20), Burst);
+		QCOMPARE (scheduler.Acquire (&interactive, 1 << 20), qint64 (0));
+
+		QTest::qWait (RefillWait);
+
+		QCOMPARE (order, (QStringList { "interactive", "background" }));
+	}
+
+	void BandwidthSchedulerTest::stopsTickingWhenUnregistered ()
+	{
+		BandwidthScheduler scheduler;
+		const auto timer = scheduler.findChild<QTimer*> ();
+		QVERIFY (timer);
+		QVERIFY (!timer->isActive ());
+
+		QObject first;
+		QObject second;
+		scheduler.Register (&first, BandwidthScheduler::Priority::Interactive, Noop);
+		scheduler.Register (&second, BandwidthScheduler::Priority::Background, Noop);
+		QVERIFY (timer->isActive ());
+
+		scheduler.Unregister (&first);
+		QVERIFY (!scheduler.IsRegistered (&first));
+		QVERIFY (timer->isActive ());
+
+		scheduler.Unregister (&second);
+		QVERIFY (!timer->isActive ());
+	}
+}
+}
@@ -36,13 +36,16 @@ namespace LeechCraft
 namespace HttHare
 {
 	Connection::Connection (boost::asio::io_service& service,
-			const StorageManager& stMgr, IconResolver *resolver, TrManager *trMgr)
+			const StorageManager& stMgr, IconResolver *resolver, TrManager *trMgr,
+			const boost::posix_time::time_duration& idleTimeout)
 	: Strand_ { service }
 	, Socket_ { service }
+	, IdleTimer_ { service }
+	, IdleTimeout_ { idleTimeout }
 	, StorageMgr_ (stMgr)
 	, IconResolver_ { resolver }
 	, TrManager_ { trMgr }
-	, Buf_ { 2 * 1024 }
+	, Buf_ { 8 * 1024 }
 	{
 	}
 
@@ -71,9 +74,38 @@ namespace HttHare
 		return StorageMgr_;
 	}
 
+	bool Connection::CanKeepAlive () const
+	{
+		return IdleTimeout_.total_seconds () > 0;
+	}
+
 	void Connection::Start ()
+	{
+		boost::system::error_code ec;
+		Socket_.set_option (boost::asio::ip::tcp::no_delay { true }, ec);
+
+		ReadRequest ();
+	}
+
+	void Connection::FinishRequest (const boost::system::error_code& ec, bool keepAlive)
+	{
+		if (ec || !keepAlive)
+			Close ();
+		else
+			ReadRequest ();
+	}
+
+	void Connection::ReadRequest ()
 	{
 		auto conn = shared_from_this ();
+
+		if (CanKeepAlive ())
+		{
+			IdleTimer_.expires_from_now (IdleTimeout_);
+			IdleTimer_.async_wait (Strand_.wrap ([conn] (const boost::system::error_code& ec)
+						{ conn->HandleIdleTimeout (ec); }));
+		}
+
 		boost::asio::async_read_until (Socket_,
 				Buf_,
 				std::string { "\r\n\r\n" },
@@ -81,8 +113,20 @@ namespace HttHare
 					{ conn->HandleHeader (ec, transferred); }));
 	}
 
-	void Connection::HandleHeader (const boost::system::error_code&, unsigned long transferred)
+	void Connection::HandleHeader (const boost::system::error_code& ec, unsigned long transferred)
 	{
+		IdleTimer_.expires_at (boost::posix_time::ptime { boost::posix_time::pos_infin });
+
+		if (ec)
+		{
+			if (ec != boost::asio::error::eof &&
+					ec != boost::asio::error::operation_aborted)
+				qWarning () << Q_FUNC_INFO
+						<< ec.message ().c_str ();
+			Close ();
+			return;
+		}
+
 		QByteArray data;
 		data.resize (transferred);
 
@@ -91,5 +135,26 @@ namespace HttHare
 
 		RequestHandler { shared_from_this () } (data);
 	}
+
+	void Connection::HandleIdleTimeout (const boost::system::error_code& ec)
+	{
+		if (ec == boost::asio::error::operation_aborted)
+			return;
+
+		// The timer might have been rearmed for the next request after this
+		// handler got queued, so make sure the deadline has really passed.
+		if (IdleTimer_.expires_at () > boost::asio::deadline_timer::traits_type::now ())
+			return;
+
+		Close ();
+	}
+
+	void Connection::Close ()
+	{
+		boost::system::error_code ec;
+		IdleTimer_.cancel (ec);
+		Socket_.shutdown (boost::asio::socket_base::shutdown_both, ec);
+		Socket_.close (ec);
+	}
 }
 }
@@ -44,6 +44,8 @@ namespace HttHare
 	{
 		boost::asio::io_service::strand Strand_;
 		boost::asio::ip::tcp::socket Socket_;
+		boost::asio::deadline_timer IdleTimer_;
+		const boost::posix_time::time_duration IdleTimeout_;
 
 		const StorageManager& StorageMgr_;
 		IconResolver * const IconResolver_;
@@ -51,7 +53,8 @@ namespace HttHare
 
 		boost::asio::streambuf Buf_;
 	public:
-		Connection (boost::asio::io_service&, const StorageManager&, IconResolver*, TrManager*);
+		Connection (boost::asio::io_service&, const StorageManager&, IconResolver*, TrManager*,
+				const boost::posix_time::time_duration& idleTimeout);
 
 		Connection (const Connection&) = delete;
 		Connection& operator= (const Connection&) = delete;
@@ -63,9 +66,25 @@ namespace HttHare
 
 		const StorageManager& GetStorageManager () const;
 
+		bool CanKeepAlive () const;
+
 		void Start ();
+
+		/** @brief Called by the request handler once the response is
+		 * fully written.
+		 *
+		 * If keepAlive is true and there was no error, the next
+		 * (possibly already buffered, pipelined) request is read from
+		 * the connection. Otherwise the connection is closed.
+		 *
+		 * Must be called from within the connection's strand.
+		 */
+		void FinishRequest (const boost::system::error_code&, bool keepAlive);
 	private:
+		void ReadRequest ();
 		void HandleHeader (const boost::system::error_code&, unsigned long);
+		void HandleIdleTimeout (const boost::system::error_code&);
+		void Close ();
 	};
 
 	typedef std::shared_ptr<Connection> Connection_ptr;
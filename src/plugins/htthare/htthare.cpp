@@ -60,6 +60,8 @@ namespace HttHare
 
 		XmlSettingsManager::Instance ().RegisterObject ("EnableServer",
 				this, "handleEnableServerChanged");
+		XmlSettingsManager::Instance ().RegisterObject ({ "WorkerThreads", "KeepAliveTimeout" },
+				this, "reapplyAddresses");
 		handleEnableServerChanged ();
 	}
 
@@ -97,6 +99,14 @@ namespace HttHare
 		return XSD_;
 	}
 
+	std::shared_ptr<Server> Plugin::CreateServer () const
+	{
+		const auto& xsm = XmlSettingsManager::Instance ();
+		return std::make_shared<Server> (AddrMgr_->GetAddresses (),
+				xsm.property ("WorkerThreads").toInt (),
+				xsm.property ("KeepAliveTimeout").toInt ());
+	}
+
 	void Plugin::handleEnableServerChanged ()
 	{
 		const bool enable = XmlSettingsManager::Instance ().property ("EnableServer").toBool ();
@@ -108,7 +118,7 @@ namespace HttHare
 			S_.reset ();
 		else
 		{
-			S_.reset (new Server { AddrMgr_->GetAddresses () });
+			S_ = CreateServer ();
 			S_->Start ();
 		}
 	}
@@ -125,7 +135,7 @@ namespace HttHare
 		QTimer::singleShot (100, &loop, SLOT (quit ()));
 		loop.exec ();
 
-		S_.reset (new Server { AddrMgr_->GetAddresses () });
+		S_ = CreateServer ();
 		S_->Start ();
 	}
 }
@@ -68,6 +68,8 @@ namespace HttHare
 		QIcon GetIcon () const;
 
 		Util::XmlSettingsDialog_ptr GetSettingsDialog () const;
+	private:
+		std::shared_ptr<Server> CreateServer () const;
 	private slots:
 		void handleEnableServerChanged ();
 		void reapplyAddresses ();
@@ -30,6 +30,7 @@
 #include "iconresolver.h"
 #include <QImage>
 #include <QIcon>
+#include <QStringList>
 #include <QtDebug>
 #include <util/util.h>
 
@@ -39,10 +40,68 @@ namespace HttHare
 {
 	IconResolver::IconResolver (QObject *parent)
 	: QObject (parent)
+	, IconSize_ (16)
+	, Fallback_ (Render ("application/octet-stream"))
 	{
+		const QStringList commonTypes
+		{
+			"inode/directory",
+			"text/plain",
+			"text/html",
+			"text/x-c",
+			"application/pdf",
+			"application/zip",
+			"application/x-bzip2",
+			"application/x-gzip",
+			"application/x-xz",
+			"application/x-bittorrent",
+			"application/x-executable",
+			"image/jpeg",
+			"image/png",
+			"image/gif",
+			"audio/mpeg",
+			"audio/ogg",
+			"audio/x-flac",
+			"video/mp4",
+			"video/x-matroska",
+			"video/x-msvideo"
+		};
+		for (const auto& type : commonTypes)
+			Cache_ [type] = Render (type);
+		Cache_ ["application/octet-stream"] = Fallback_;
+	}
+
+	int IconResolver::GetIconSize () const
+	{
+		return IconSize_;
+	}
+
+	QByteArray IconResolver::GetMimeIcon (const QString& mimetype)
+	{
+		{
+			QReadLocker locker { &CacheLock_ };
+			const auto pos = Cache_.find (mimetype);
+			if (pos != Cache_.end ())
+				return *pos;
+		}
+
+		QWriteLocker locker { &CacheLock_ };
+		if (Cache_.contains (mimetype))
+			return Cache_ [mimetype];
+
+		if (!Scheduled_.contains (mimetype))
+		{
+			Scheduled_ << mimetype;
+			QMetaObject::invokeMethod (this,
+					"cacheMime",
+					Qt::QueuedConnection,
+					Q_ARG (QString, mimetype));
+		}
+
+		return Fallback_;
 	}
 
-	void IconResolver::resolveMime (QString mimetype, QByteArray& image, int dim)
+	QByteArray IconResolver::Render (QString mimetype) const
 	{
 		mimetype.replace ('/', '-');
 		auto icon = QIcon::fromTheme (mimetype);
@@ -55,7 +114,16 @@ namespace HttHare
 		if (icon.isNull ())
 			icon = QIcon::fromTheme ("application-octet-stream");
 
-		image = Util::GetAsBase64Src (icon.pixmap (dim, dim).toImage ()).toLatin1 ();
+		return Util::GetAsBase64Src (icon.pixmap (IconSize_, IconSize_).toImage ()).toLatin1 ();
+	}
+
+	void IconResolver::cacheMime (const QString& mimetype)
+	{
+		const auto& image = Render (mimetype);
+
+		QWriteLocker locker { &CacheLock_ };
+		Cache_ [mimetype] = image;
+		Scheduled_.remove (mimetype);
 	}
 }
 }
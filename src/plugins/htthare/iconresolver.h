@@ -30,6 +30,9 @@
 #pragma once
 
 #include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QReadWriteLock>
 
 class QImage;
 
@@ -37,13 +40,41 @@ namespace LeechCraft
 {
 namespace HttHare
 {
+	/** @brief Provides pre-rendered MIME type icons to the worker threads.
+	 *
+	 * Icons are rendered in the GUI thread (the one this object lives
+	 * in) and cached as base64 data URIs. GetMimeIcon() never blocks on
+	 * the GUI thread: for a MIME type not seen before it returns a
+	 * generic icon and schedules rendering the proper one, so that it is
+	 * used by subsequent requests.
+	 */
 	class IconResolver : public QObject
 	{
 		Q_OBJECT
+
+		const int IconSize_;
+		QByteArray Fallback_;
+
+		mutable QReadWriteLock CacheLock_;
+		QHash<QString, QByteArray> Cache_;
+		QSet<QString> Scheduled_;
 	public:
 		IconResolver (QObject* = 0);
-	public slots:
-		void resolveMime (QString, QByteArray&, int);
+
+		int GetIconSize () const;
+
+		/** @brief Returns the icon for the given MIME type.
+		 *
+		 * This function is thread-safe.
+		 *
+		 * @param[in] mimetype The MIME type, like text/plain.
+		 * @return The icon as a data URI.
+		 */
+		QByteArray GetMimeIcon (const QString& mimetype);
+	private:
+		QByteArray Render (QString) const;
+	private slots:
+		void cacheMime (const QString&);
 	};
 }
 }
@@ -0,0 +1,377 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+/** A simple load generator for HTThare.
+ *
+ * Opens a number of persistent connections to the server, each served by
+ * its own thread, and issues GET requests over them (optionally
+ * pipelined), measuring the latency of each request. Three scenarios are
+ * supported: small files, large files (served via sendfile() by the
+ * server) and random range requests.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+namespace asio = boost::asio;
+namespace po = boost::program_options;
+using asio::ip::tcp;
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock_t;
+
+	struct Config
+	{
+		std::string Host_;
+		std::string Port_;
+		int Connections_;
+		int Requests_;
+		int Pipeline_;
+		int RangeSize_;
+	};
+
+	struct Response
+	{
+		int Code_ = 0;
+		long long ContentLength_ = 0;
+		bool Close_ = false;
+	};
+
+	struct Result
+	{
+		std::vector<double> Latencies_;
+		long long Bytes_ = 0;
+		int Errors_ = 0;
+	};
+
+	std::string ToLower (std::string str)
+	{
+		std::transform (str.begin (), str.end (), str.begin (), ::tolower);
+		return str;
+	}
+
+	Response ParseHead (std::istream& istr)
+	{
+		Response resp;
+
+		std::string line;
+		std::getline (istr, line);
+		const auto spacePos = line.find (' ');
+		if (spacePos != std::string::npos)
+			resp.Code_ = std::atoi (line.c_str () + spacePos + 1);
+
+		while (std::getline (istr, line) && line != "\r")
+		{
+			const auto colonPos = line.find (':');
+			if (colonPos == std::string::npos)
+				continue;
+
+			const auto& name = ToLower (line.substr (0, colonPos));
+			auto value = line.substr (colonPos + 1);
+			value.erase (0, value.find_first_not_of (' '));
+			value.erase (value.find_last_not_of ("\r ") + 1);
+
+			if (name == "content-length")
+				resp.ContentLength_ = std::atoll (value.c_str ());
+			else if (name == "connection")
+				resp.Close_ = ToLower (value) == "close";
+		}
+
+		return resp;
+	}
+
+	class Client
+	{
+		const Config& Config_;
+		asio::io_service IoService_;
+		tcp::socket Socket_;
+		asio::streambuf Buf_;
+		std::vector<char> Sink_;
+		bool Connected_ = false;
+	public:
+		Client (const Config& config)
+		: Config_ (config)
+		, Socket_ { IoService_ }
+		, Sink_ (256 * 1024)
+		{
+		}
+
+		Response Head (const std::string& path)
+		{
+			EnsureConnected ();
+			WriteRequest ("HEAD", path, {});
+			const auto& resp = ReadHead ();
+			if (resp.Close_)
+				Disconnect ();
+			return resp;
+		}
+
+		void Run (const std::string& path, long long fileSize, int requests, Result& result)
+		{
+			std::mt19937 gen { std::random_device {} () };
+
+			for (auto done = 0; done < requests; )
+			{
+				const auto batch = std::min (Config_.Pipeline_, requests - done);
+
+				try
+				{
+					EnsureConnected ();
+
+					const auto start = Clock_t::now ();
+
+					std::string reqs;
+					for (auto i = 0; i < batch; ++i)
+						reqs += MakeRequest ("GET", path, MakeRange (gen, fileSize));
+					asio::write (Socket_, asio::buffer (reqs));
+
+					for (auto i = 0; i < batch; ++i)
+					{
+						const auto& resp = ReadHead ();
+						result.Bytes_ += SkipBody (resp.ContentLength_);
+
+						const std::chrono::duration<double, std::milli> latency = Clock_t::now () - start;
+						result.Latencies_.push_back (latency.count ());
+
+						if (resp.Code_ != 200 && resp.Code_ != 206)
+							++result.Errors_;
+
+						if (resp.Close_)
+						{
+							Disconnect ();
+							break;
+						}
+					}
+				}
+				catch (const std::exception& e)
+				{
+					std::cerr << "request failed: " << e.what () << std::endl;
+					++result.Errors_;
+					Disconnect ();
+				}
+
+				done += batch;
+			}
+		}
+	private:
+		std::string MakeRange (std::mt19937& gen, long long fileSize) const
+		{
+			if (Config_.RangeSize_ <= 0 || fileSize <= Config_.RangeSize_)
+				return {};
+
+			std::uniform_int_distribution<long long> dist { 0, fileSize - Config_.RangeSize_ };
+			const auto start = dist (gen);
+			return "bytes=" + std::to_string (start) + "-" + std::to_string (start + Config_.RangeSize_ - 1);
+		}
+
+		std::string MakeRequest (const std::string& verb, const std::string& path, const std::string& range) const
+		{
+			std::string req = verb + " " + path + " HTTP/1.1\r\n";
+			req += "Host: " + Config_.Host_ + "\r\n";
+			if (!range.empty ())
+				req += "Range: " + range + "\r\n";
+			req += "\r\n";
+			return req;
+		}
+
+		void WriteRequest (const std::string& verb, const std::string& path, const std::string& range)
+		{
+			asio::write (Socket_, asio::buffer (MakeRequest (verb, path, range)));
+		}
+
+		Response ReadHead ()
+		{
+			asio::read_until (Socket_, Buf_, "\r\n\r\n");
+			std::istream istr { &Buf_ };
+			return ParseHead (istr);
+		}
+
+		long long SkipBody (long long length)
+		{
+			const auto buffered = std::min<long long> (length, Buf_.size ());
+			Buf_.consume (buffered);
+
+			for (auto left = length - buffered; left > 0; )
+			{
+				const auto chunk = std::min<long long> (left, Sink_.size ());
+				left -= asio::read (Socket_, asio::buffer (Sink_.data (), chunk));
+			}
+
+			return length;
+		}
+
+		void EnsureConnected ()
+		{
+			if (Connected_)
+				return;
+
+			tcp::resolver resolver { IoService_ };
+			asio::connect (Socket_, resolver.resolve ({ Config_.Host_, Config_.Port_ }));
+			Socket_.set_option (tcp::no_delay { true });
+			Buf_.consume (Buf_.size ());
+			Connected_ = true;
+		}
+
+		void Disconnect ()
+		{
+			boost::system::error_code ec;
+			Socket_.close (ec);
+			Connected_ = false;
+		}
+	};
+
+	double Percentile (const std::vector<double>& sorted, double p)
+	{
+		if (sorted.empty ())
+			return 0;
+
+		const auto idx = static_cast<size_t> (p * (sorted.size () - 1));
+		return sorted [idx];
+	}
+
+	void RunScenario (const std::string& name, const std::string& path, Config config)
+	{
+		long long fileSize = 0;
+		try
+		{
+			const auto& head = Client { config }.Head (path);
+			if (head.Code_ != 200)
+			{
+				std::cerr << name << ": HEAD " << path << " returned " << head.Code_ << std::endl;
+				return;
+			}
+			fileSize = head.ContentLength_;
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << name << ": cannot connect: " << e.what () << std::endl;
+			return;
+		}
+
+		if (name != "range")
+			config.RangeSize_ = 0;
+
+		std::vector<Result> results (config.Connections_);
+		std::vector<std::thread> threads;
+
+		const auto start = Clock_t::now ();
+		for (auto i = 0; i < config.Connections_; ++i)
+			threads.emplace_back ([&config, &results, &path, fileSize, i]
+					{
+						const auto perConn = config.Requests_ / config.Connections_ +
+								(i < config.Requests_ % config.Connections_ ? 1 : 0);
+						Client { config }.Run (path, fileSize, perConn, results [i]);
+					});
+		for (auto& thread : threads)
+			thread.join ();
+		const std::chrono::duration<double> elapsed = Clock_t::now () - start;
+
+		Result total;
+		for (const auto& result : results)
+		{
+			total.Latencies_.insert (total.Latencies_.end (),
+					result.Latencies_.begin (), result.Latencies_.end ());
+			total.Bytes_ += result.Bytes_;
+			total.Errors_ += result.Errors_;
+		}
+		std::sort (total.Latencies_.begin (), total.Latencies_.end ());
+
+		const auto secs = elapsed.count ();
+		std::cout << std::fixed << std::setprecision (2)
+				<< name << " (" << path << ", " << fileSize << " bytes"
+				<< (config.RangeSize_ ? ", " + std::to_string (config.RangeSize_) + " byte ranges" : std::string {})
+				<< "):\n"
+				<< "\trequests: " << total.Latencies_.size () << ", errors: " << total.Errors_ << "\n"
+				<< "\tthroughput: " << total.Latencies_.size () / secs << " req/s, "
+				<< total.Bytes_ / secs / (1024 * 1024) << " MiB/s\n"
+				<< "\tlatency, ms: p50 " << Percentile (total.Latencies_, 0.5)
+				<< ", p90 " << Percentile (total.Latencies_, 0.9)
+				<< ", p99 " << Percentile (total.Latencies_, 0.99)
+				<< ", max " << (total.Latencies_.empty () ? 0 : total.Latencies_.back ())
+				<< std::endl;
+	}
+}
+
+int main (int argc, char **argv)
+{
+	Config config;
+	std::string small, large, range;
+
+	po::options_description desc { "Allowed options" };
+	desc.add_options ()
+			("help", "show this help message")
+			("host", po::value (&config.Host_)->default_value ("127.0.0.1"), "server host")
+			("port", po::value (&config.Port_)->default_value ("14801"), "server port")
+			("connections,c", po::value (&config.Connections_)->default_value (8), "number of concurrent connections")
+			("requests,n", po::value (&config.Requests_)->default_value (10000), "total number of requests per scenario")
+			("pipeline,p", po::value (&config.Pipeline_)->default_value (1), "number of requests pipelined on a connection")
+			("range-size", po::value (&config.RangeSize_)->default_value (64 * 1024), "size of a range for the range scenario")
+			("small", po::value (&small), "path of a small file on the server")
+			("large", po::value (&large), "path of a large file on the server")
+			("range", po::value (&range), "path of a file to request random ranges of");
+
+	po::variables_map vm;
+	try
+	{
+		po::store (po::parse_command_line (argc, argv, desc), vm);
+		po::notify (vm);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << e.what () << std::endl << desc << std::endl;
+		return 1;
+	}
+
+	if (vm.count ("help") || (small.empty () && large.empty () && range.empty ()))
+	{
+		std::cout << desc << std::endl;
+		return vm.count ("help") ? 0 : 1;
+	}
+
+	config.Connections_ = std::max (config.Connections_, 1);
+	config.Pipeline_ = std::max (config.Pipeline_, 1);
+
+	if (!small.empty ())
+		RunScenario ("small", small, config);
+	if (!large.empty ())
+		RunScenario ("large", large, config);
+	if (!range.empty ())
+		RunScenario ("range", range, config);
+}
@@ -61,10 +61,37 @@ namespace HttHare
 {
 	RequestHandler::RequestHandler (const Connection_ptr& conn)
 	: Conn_ (conn)
+	, KeepAlive_ (false)
 	{
 		ResponseHeaders_.append ({ "Accept-Ranges", "bytes" });
 	}
 
+	namespace
+	{
+		QString GetHeader (const QMap<QString, QString>& headers, const QString& name)
+		{
+			for (auto i = headers.begin (); i != headers.end (); ++i)
+				if (!i.key ().compare (name, Qt::CaseInsensitive))
+					return i.value ();
+
+			return {};
+		}
+
+		bool IsKeepAlive (const QByteArray& version, const QMap<QString, QString>& headers)
+		{
+			// We don't read request bodies, so we won't be able to find the
+			// beginning of the next request if there is one.
+			const auto contentLength = GetHeader (headers, "Content-Length").toLongLong ();
+			if (contentLength > 0 || !GetHeader (headers, "Transfer-Encoding").isEmpty ())
+				return false;
+
+			const auto& connection = GetHeader (headers, "Connection").toLower ();
+			if (version == "HTTP/1.1")
+				return !connection.contains ("close");
+			return connection.contains ("keep-alive");
+		}
+	}
+
 	void RequestHandler::operator() (QByteArray data)
 	{
 		data.replace ("\r", "");
@@ -92,6 +119,8 @@ namespace HttHare
 			Headers_ [line.left (colonPos)] = line.mid (colonPos + 1).trimmed ();
 		}
 
+		KeepAlive_ = Conn_->CanKeepAlive () && IsKeepAlive (req.value (2).toUpper (), Headers_);
+
 #ifdef QT_DEBUG
 		qDebug () << Q_FUNC_INFO << "got request";
 		qDebug () << req << Url_;
@@ -155,8 +184,6 @@ namespace HttHare
 					.replace ('.', '_')
 					.replace ('+', '_');
 		}
-
-		const auto IconSize = 16;
 	}
 
 	QByteArray RequestHandler::MakeDirResponse (const QFileInfo& fi, const QString& path, const QUrl& url)
@@ -169,6 +196,8 @@ namespace HttHare
 		{
 			QString MimeType_;
 		};
+		const auto resolver = Conn_->GetIconResolver ();
+		const auto iconSize = resolver->GetIconSize ();
 		QHash<QString, QByteArray> mimeCache;
 		QList<MimeInfo> mimes;
 		Util::MimeDetector detector;
@@ -177,16 +206,7 @@ namespace HttHare
 			const auto& type = detector (entry.filePath ());
 
 			if (!mimeCache.contains (type))
-			{
-				QByteArray image;
-				QMetaObject::invokeMethod (Conn_->GetIconResolver (),
-						"resolveMime",
-						Qt::BlockingQueuedConnection,
-						Q_ARG (QString, type),
-						Q_ARG (QByteArray&, image),
-						Q_ARG (int, IconSize));
-				mimeCache [type] = image;
-			}
+				mimeCache [type] = resolver->GetMimeIcon (type);
 
 			mimes.append ({ type });
 		}
@@ -198,7 +218,7 @@ namespace HttHare
 			result += "." + NormalizeClass (pos.key ()) + " {";
 			result += "background-image: url('" + pos.value () + "');";
 			result += "background-repeat: no-repeat;";
-			result += "padding-left: " + QString::number (IconSize + 4) + ";";
+			result += "padding-left: " + QString::number (iconSize + 4) + ";";
 			result += "}";
 		}
 		result += "</style></head><body><h1>" + Tr ("Listing of %1").arg (url.toString ()) + "</h1>";
@@ -489,31 +509,41 @@ namespace HttHare
 		}
 
 		auto c = Conn_;
+		const auto keepAlive = KeepAlive_;
+		const auto& response = CookResponse (verb);
 		boost::asio::async_write (c->GetSocket (),
-				ToBuffers (verb),
-				c->GetStrand ().wrap ([c, path, verb, ranges] (boost::system::error_code ec, ulong) mutable -> void
+				boost::asio::buffer (response->constData (), static_cast<size_t> (response->size ())),
+				c->GetStrand ().wrap ([c, response, path, verb, ranges, keepAlive] (boost::system::error_code ec, ulong) mutable -> void
 					{
 						if (ec)
+						{
 							qWarning () << Q_FUNC_INFO
 									<< ec.message ().c_str ();
-
-						auto& s = c->GetSocket ();
-
-						std::shared_ptr<void> shutdownGuard = std::shared_ptr<void> (nullptr,
-								[&s, &ec] (void*)
-								{
-									s.shutdown (boost::asio::socket_base::shutdown_both, ec);
-								});
+							c->FinishRequest (ec, false);
+							return;
+						}
 
 						if (verb != Verb::Get)
+						{
+							c->FinishRequest (ec, keepAlive);
 							return;
+						}
 
 						std::shared_ptr<QFile> file { new QFile { path } };
-						file->open (QIODevice::ReadOnly);
+						if (!file->open (QIODevice::ReadOnly))
+						{
+							qWarning () << Q_FUNC_INFO
+									<< "unable to open"
+									<< path
+									<< file->errorString ();
+							c->FinishRequest (ec, false);
+							return;
+						}
 
 						if (ranges.isEmpty ())
 							ranges.append ({ 0, file->size () - 1 });
 
+						auto& s = c->GetSocket ();
 						if (!s.native_non_blocking ())
 							s.native_non_blocking (true, ec);
 
@@ -525,7 +555,10 @@ namespace HttHare
 							0,
 							headRange,
 							ranges,
-							[c, shutdownGuard] (boost::system::error_code, ulong) {}
+							[c, keepAlive] (boost::system::error_code sendEc, ulong)
+							{
+								c->GetStrand ().dispatch ([c, sendEc, keepAlive] { c->FinishRequest (sendEc, keepAlive); });
+							}
 						} (ec, 0);
 					}));
 	}
@@ -533,26 +566,22 @@ namespace HttHare
 	void RequestHandler::DefaultWrite (Verb verb)
 	{
 		auto c = Conn_;
+		const auto keepAlive = KeepAlive_;
+		const auto& response = CookResponse (verb);
 		boost::asio::async_write (c->GetSocket (),
-				ToBuffers (verb),
-				c->GetStrand ().wrap ([c] (const boost::system::error_code& ec, ulong)
+				boost::asio::buffer (response->constData (), static_cast<size_t> (response->size ())),
+				c->GetStrand ().wrap ([c, response, keepAlive] (const boost::system::error_code& ec, ulong)
 					{
 						if (ec)
 							qWarning () << Q_FUNC_INFO
 									<< ec.message ().c_str ();
 
-						boost::system::error_code iec;
-						c->GetSocket ().shutdown (boost::asio::socket_base::shutdown_both, iec);
+						c->FinishRequest (ec, keepAlive);
 					}));
 	}
 
 	namespace
 	{
-		boost::asio::const_buffer BA2Buffer (const QByteArray& ba)
-		{
-			return { ba.constData (), static_cast<size_t> (ba.size ()) };
-		}
-
 		bool SupportsDeflate (const QStringList& ae)
 		{
 			for (const auto& val : ae)
@@ -563,10 +592,8 @@ namespace HttHare
 		}
 	}
 
-	std::vector<boost::asio::const_buffer> RequestHandler::ToBuffers (Verb verb)
+	std::shared_ptr<QByteArray> RequestHandler::CookResponse (Verb verb)
 	{
-		std::vector<boost::asio::const_buffer> result;
-
 		const bool hasContentLength = std::find_if (ResponseHeaders_.begin (), ResponseHeaders_.end (),
 				[] (decltype (ResponseHeaders_.at (0)) pair)
 					{ return pair.first.toLower () == "content-length"; }) != ResponseHeaders_.end ();
@@ -584,6 +611,8 @@ namespace HttHare
 		if (!hasContentLength)
 			ResponseHeaders_.append ({ "Content-Length", QByteArray::number (ResponseBody_.size ()) });
 
+		ResponseHeaders_.append ({ "Connection", KeepAlive_ ? "keep-alive" : "close" });
+
 		CookedRH_.clear ();
 		for (const auto& pair : ResponseHeaders_)
 			CookedRH_ += pair.first + ": " + pair.second + "\r\n";
@@ -596,12 +625,15 @@ namespace HttHare
 			qDebug () << '\t' << (pair.first + ": " + pair.second);
 #endif
 
-		result.push_back (BA2Buffer (ResponseLine_));
-		result.push_back (BA2Buffer (CookedRH_));
-
+		// The response must outlive this handler, which is destroyed as soon
+		// as the asynchronous write is started.
+		const auto result = std::make_shared<QByteArray> ();
+		result->reserve (ResponseLine_.size () + CookedRH_.size () +
+				(verb == Verb::Get ? ResponseBody_.size () : 0));
+		*result += ResponseLine_;
+		*result += CookedRH_;
 		if (verb == Verb::Get)
-			result.push_back (BA2Buffer (ResponseBody_));
-
+			*result += ResponseBody_;
 		return result;
 	}
 }
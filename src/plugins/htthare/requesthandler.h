@@ -30,7 +30,6 @@
 #pragma once
 
 #include <memory>
-#include <boost/asio/buffer.hpp>
 #include <QByteArray>
 #include <QUrl>
 #include <QMap>
@@ -59,6 +58,8 @@ namespace HttHare
 		QByteArray CookedRH_;
 		QByteArray ResponseBody_;
 
+		bool KeepAlive_;
+
 		enum class Verb
 		{
 			Get,
@@ -78,7 +79,7 @@ namespace HttHare
 		void WriteDir (const QString&, const QFileInfo&, Verb);
 		void WriteFile (const QString&, const QFileInfo&, Verb);
 		void DefaultWrite (Verb);
-		std::vector<boost::asio::const_buffer> ToBuffers (Verb);
+		std::shared_ptr<QByteArray> CookResponse (Verb);
 	};
 }
 }
@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "server.h"
+#include <algorithm>
 #include <QString>
 #include <QtDebug>
 #include "connection.h"
@@ -40,11 +41,22 @@ namespace HttHare
 {
 	namespace ip = boost::asio::ip;
 
-	Server::Server (const QList<QPair<QString, QString>>& addresses)
+	Server::Server (const QList<QPair<QString, QString>>& addresses, int workers, int idleTimeout)
 	: IconResolver_ { new IconResolver  }
 	, TrManager_ { new TrManager }
+	, IdleTimeout_ { boost::posix_time::seconds { idleTimeout } }
 	{
-		ip::tcp::resolver resolver { IoService_ };
+		if (workers <= 0)
+			workers = std::max<int> (std::thread::hardware_concurrency (), 1);
+
+		for (auto i = 0; i < workers; ++i)
+		{
+			IoServices_.emplace_back (new boost::asio::io_service { 1 });
+			Works_.emplace_back (new boost::asio::io_service::work { *IoServices_.back () });
+		}
+
+		auto& acceptService = *IoServices_.front ();
+		ip::tcp::resolver resolver { acceptService };
 
 		for (const auto& pair : addresses)
 		{
@@ -52,7 +64,7 @@ namespace HttHare
 			{
 				const ip::tcp::endpoint endpoint = *resolver.resolve ({ pair.first.toStdString (), pair.second.toStdString () });
 
-				std::unique_ptr<ip::tcp::acceptor> accPtr { new ip::tcp::acceptor { IoService_ } };
+				std::unique_ptr<ip::tcp::acceptor> accPtr { new ip::tcp::acceptor { acceptService } };
 				accPtr->open (endpoint.protocol ());
 				accPtr->set_option (ip::tcp::acceptor::reuse_address (true));
 				accPtr->bind (endpoint);
@@ -69,13 +81,13 @@ namespace HttHare
 			}
 		}
 
-		StartAccept ();
+		for (const auto& acceptor : Acceptors_)
+			StartAccept (*acceptor);
 	}
 
 	Server::~Server ()
 	{
-		if (!IoService_.stopped ())
-			Stop ();
+		Stop ();
 	}
 
 	void Server::Start ()
@@ -83,35 +95,47 @@ namespace HttHare
 		if (Acceptors_.empty ())
 			return;
 
-		for (auto i = 0; i < 2; ++i)
-			Threads_.emplace_back ([this] { IoService_.run (); });
+		for (const auto& service : IoServices_)
+		{
+			const auto servicePtr = service.get ();
+			Threads_.emplace_back ([servicePtr] { servicePtr->run (); });
+		}
 	}
 
 	void Server::Stop ()
 	{
-		IoService_.stop ();
+		Works_.clear ();
+		for (const auto& service : IoServices_)
+			service->stop ();
+
 		for (auto& thread : Threads_)
 			thread.join ();
 		Threads_.clear ();
 	}
 
-	void Server::StartAccept ()
+	void Server::StartAccept (ip::tcp::acceptor& acceptor)
 	{
-		Connection_ptr connection { new Connection { IoService_, StorageMgr_, IconResolver_, TrManager_ } };
-
-		for (auto& acceptor : Acceptors_)
-			acceptor->async_accept (connection->GetSocket (),
-					[this, connection] (const boost::system::error_code& ec)
-					{
-						if (!ec)
-							connection->Start ();
-						else
-							qWarning () << Q_FUNC_INFO
-									<< "cannot accept:"
-									<< ec.message ().c_str ();
-
-						StartAccept ();
-					});
+		// Only ever called from the first io_service's thread (or from the
+		// constructor before any threads are started), so NextService_
+		// needs no synchronization.
+		auto& service = *IoServices_ [NextService_++ % IoServices_.size ()];
+		Connection_ptr connection { new Connection { service, StorageMgr_, IconResolver_, TrManager_, IdleTimeout_ } };
+
+		acceptor.async_accept (connection->GetSocket (),
+				[this, connection, &acceptor] (const boost::system::error_code& ec)
+				{
+					if (ec == boost::asio::error::operation_aborted)
+						return;
+
+					if (!ec)
+						connection->GetStrand ().post ([connection] { connection->Start (); });
+					else
+						qWarning () << Q_FUNC_INFO
+								<< "cannot accept:"
+								<< ec.message ().c_str ();
+
+					StartAccept (acceptor);
+				});
 	}
 }
 }
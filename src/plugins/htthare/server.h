@@ -47,7 +47,10 @@ namespace HttHare
 
 	class Server
 	{
-		boost::asio::io_service IoService_;
+		std::vector<std::unique_ptr<boost::asio::io_service>> IoServices_;
+		std::vector<std::unique_ptr<boost::asio::io_service::work>> Works_;
+		size_t NextService_ = 0;
+
 		std::vector<std::unique_ptr<boost::asio::ip::tcp::acceptor>> Acceptors_;
 
 		StorageManager StorageMgr_;
@@ -56,8 +59,23 @@ namespace HttHare
 
 		IconResolver * const IconResolver_;
 		TrManager * const TrManager_;
+
+		const boost::posix_time::time_duration IdleTimeout_;
 	public:
-		Server (const QList<QPair<QString, QString>>& addresses);
+		/** @brief Creates the server listening on the given addresses.
+		 *
+		 * Each worker thread runs its own io_service, and accepted
+		 * connections are distributed among them in a round-robin
+		 * fashion.
+		 *
+		 * @param[in] addresses The (host, port) pairs to listen on.
+		 * @param[in] workers The number of worker threads, or 0 to use
+		 * one thread per CPU core.
+		 * @param[in] idleTimeout The number of seconds an idle
+		 * keep-alive connection is kept open, or 0 to close the
+		 * connection after each response.
+		 */
+		Server (const QList<QPair<QString, QString>>& addresses, int workers, int idleTimeout);
 		~Server ();
 
 		Server (const Server&) = delete;
@@ -66,7 +84,7 @@ namespace HttHare
 		void Start ();
 		void Stop ();
 	private:
-		void StartAccept ();
+		void StartAccept (boost::asio::ip::tcp::acceptor&);
 	};
 }
 }
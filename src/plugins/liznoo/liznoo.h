@@ -34,6 +34,7 @@
 #include <interfaces/iinfo.h>
 #include <interfaces/ihavesettings.h>
 #include <interfaces/ientityhandler.h>
+#include <interfaces/ientityroutinghints.h>
 #include <interfaces/iactionsexporter.h>
 #include "batteryhistory.h"
 #include "batteryinfo.h"
@@ -60,10 +61,11 @@ namespace Liznoo
 				 , public IInfo
 				 , public IHaveSettings
 				 , public IEntityHandler
+				 , public IEntityRoutingHints
 				 , public IActionsExporter
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IHaveSettings IEntityHandler IActionsExporter)
+		Q_INTERFACES (IInfo IHaveSettings IEntityHandler IEntityRoutingHints IActionsExporter)
 
 		LC_PLUGIN_METADATA ("org.LeechCraft.Liznoo")
 
@@ -96,6 +98,8 @@ namespace Liznoo
 		EntityTestHandleResult CouldHandle (const Entity& entity) const;
 		void Handle (Entity entity);
 
+		EntityRoutingKeys GetEntityRoutingKeys () const;
+
 		QList<QAction*> GetActions (ActionsEmbedPlace) const;
 		QMap<QString, QList<QAction*>> GetMenuActions () const;
 	private:
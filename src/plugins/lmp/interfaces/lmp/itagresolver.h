@@ -31,7 +31,7 @@
 
 #include <QtPlugin>
 
-class QMutex;
+class QReadWriteLock;
 
 namespace TagLib
 {
@@ -51,9 +51,15 @@ namespace LMP
 
 		virtual TagLib::FileRef GetFileRef (const QString&) const = 0;
 		virtual MediaInfo ResolveInfo (const QString&) = 0;
-		virtual QMutex& GetMutex () = 0;
+		/** @brief Returns the lock guarding TagLib file access.
+		 *
+		 * Code reading tags via GetFileRef() should hold this lock for
+		 * reading, and code modifying and saving tags should hold it for
+		 * writing, so that a file is never read while it is rewritten.
+		 */
+		virtual QReadWriteLock& GetTagLock () = 0;
 	};
 }
 }
 
-Q_DECLARE_INTERFACE (LeechCraft::LMP::ITagResolver, "org.LeechCraft.LMP.ITagResolver/1.0");
+Q_DECLARE_INTERFACE (LeechCraft::LMP::ITagResolver, "org.LeechCraft.LMP.ITagResolver/2.0");
@@ -31,13 +31,19 @@
 #include <functional>
 #include <algorithm>
 #include <numeric>
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
 #include <QStandardItemModel>
 #include <QSortFilterProxyModel>
 #include <QtConcurrentMap>
 #include <QtConcurrentRun>
 #include <QTimer>
+#include <QFileInfo>
+#include <QCryptographicHash>
 #include <QtDebug>
 #include <util/xpc/util.h>
+#include <util/db/dblock.h>
 #include "localcollectionstorage.h"
 #include "core.h"
 #include "util.h"
@@ -59,11 +65,15 @@ namespace LMP
 	, CollectionModel_ (new LocalCollectionModel (this))
 	, FilesWatcher_ (new LocalCollectionWatcher (this))
 	, AlbumArtMgr_ (new AlbumArtManager (this))
-	, Watcher_ (new QFutureWatcher<MediaInfo> (this))
+	, Watcher_ (new QFutureWatcher<ScanResult> (this))
 	, UpdateNewArtists_ (0)
 	, UpdateNewAlbums_ (0)
 	, UpdateNewTracks_ (0)
 	{
+		connect (Watcher_,
+				SIGNAL (resultsReadyAt (int, int)),
+				this,
+				SLOT (handleScanResults (int, int)));
 		connect (Watcher_,
 				SIGNAL (finished ()),
 				this,
@@ -144,7 +154,67 @@ namespace LMP
 		{
 			QSet<QString> UnchangedFiles_;
 			QSet<QString> ChangedFiles_;
+
+			/** Indexed tag hashes of the changed files, if known.
+			 */
+			QHash<QString, QByteArray> TagHashes_;
 		};
+
+		quint64 GetInode (const QString& path)
+		{
+#ifdef Q_OS_UNIX
+			struct stat st;
+			if (!stat (QFile::encodeName (path).constData (), &st))
+				return st.st_ino;
+#else
+			Q_UNUSED (path)
+#endif
+			return 0;
+		}
+
+		bool IsUnchanged (const LocalCollectionStorage::FileIndexEntry& entry,
+				const QFileInfo& info, quint64 inode)
+		{
+			if (!entry.MTime_.isValid () ||
+					std::abs (entry.MTime_.msecsTo (info.lastModified ())) >= 1500)
+				return false;
+
+			if (entry.Size_ >= 0 && entry.Size_ != info.size ())
+				return false;
+
+			if (entry.Inode_ && inode && entry.Inode_ != inode)
+				return false;
+
+			return true;
+		}
+
+		bool IsUnderPath (const QString& subPath, const QString& path)
+		{
+			if (path.endsWith ('/'))
+				return subPath.startsWith (path);
+
+			return subPath == path || subPath.startsWith (path + '/');
+		}
+
+		QByteArray HashTags (const MediaInfo& info)
+		{
+			QCryptographicHash hash { QCryptographicHash::Md5 };
+			for (const QString& str :
+					{
+						info.Artist_,
+						info.Album_,
+						info.Title_,
+						info.Genres_.join ("/"),
+						QString::number (info.Year_),
+						QString::number (info.TrackNumber_),
+						QString::number (info.Length_)
+					})
+			{
+				hash.addData (str.toUtf8 ());
+				hash.addData ("\0", 1);
+			}
+			return hash.result ();
+		}
 	}
 
 	void LocalCollection::Scan (const QString& path, bool root)
@@ -167,46 +237,52 @@ namespace LMP
 
 			LocalCollectionStorage storage;
 
-			const auto& paths = storage.GetTracksPaths ();
+			QHash<QString, LocalCollectionStorage::FileIndexEntry> index;
+			try
+			{
+				index = storage.GetFileIndex ();
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error getting file index"
+						<< e.what ();
+			}
 
 			const auto& allInfos = RecIterateInfo (path, symLinks);
 			for (const auto& info : allInfos)
 			{
 				const auto& trackPath = info.absoluteFilePath ();
-				const auto& mtime = info.lastModified ();
-				try
-				{
-					const auto& storedDt = storage.GetMTime (trackPath);
-					if (storedDt.isValid () &&
-							std::abs (storedDt.msecsTo (mtime)) < 1500)
-					{
-						result.UnchangedFiles_ << trackPath;
-						continue;
-					}
-				}
-				catch (const std::exception& e)
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "error getting mtime"
-							<< trackPath
-							<< e.what ();
-				}
 
-				if (paths.contains (trackPath))
+				const auto pos = index.find (trackPath);
+				if (pos != index.end () && IsUnchanged (*pos, info, GetInode (trackPath)))
+					result.UnchangedFiles_ << trackPath;
+				else
 				{
-					try
-					{
-						storage.SetMTime (trackPath, mtime);
-					}
-					catch (const std::exception& e)
-					{
-						qWarning () << Q_FUNC_INFO
-								<< "error setting mtime"
-								<< trackPath
-								<< e.what ();
-					}
+					result.ChangedFiles_ << trackPath;
+					if (pos != index.end () && !pos->TagHash_.isEmpty ())
+						result.TagHashes_ [trackPath] = pos->TagHash_;
 				}
-				result.ChangedFiles_ << trackPath;
+
+				if (pos != index.end ())
+					index.erase (pos);
+			}
+
+			// Whatever is left under this path doesn't exist anymore.
+			QStringList stale;
+			for (const auto& indexedPath : index.keys ())
+				if (IsUnderPath (indexedPath, path))
+					stale << indexedPath;
+
+			try
+			{
+				storage.RemoveFileIndexEntries (stale);
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error removing stale file index entries"
+						<< e.what ();
 			}
 
 			return result;
@@ -220,7 +296,7 @@ namespace LMP
 			return;
 
 		QStringList toRemove;
-		auto pred = [&path] (const QString& subPath) { return subPath.startsWith (path); };
+		auto pred = [&path] (const QString& subPath) { return IsUnderPath (subPath, path); };
 		std::copy_if (PresentPaths_.begin (), PresentPaths_.end (),
 				std::back_inserter (toRemove), pred);
 		PresentPaths_.subtract (QSet<QString>::fromList (toRemove));
@@ -492,7 +568,9 @@ namespace LMP
 				Artists_.insert (pos, artist);
 			}
 			else
-				pos->Albums_ << artist.Albums_;
+				for (const auto& album : artist.Albums_)
+					if (!AlbumID2Album_.contains (album->ID_))
+						pos->Albums_ << album;
 
 			for (const auto& album : artist.Albums_)
 				for (const auto& track : album->Tracks_)
@@ -508,13 +586,13 @@ namespace LMP
 			{
 				trackCount += album->Tracks_.size ();
 
-				if (autoFetchAA)
-					AlbumArtMgr_->CheckAlbumArt (artist, album);
-
 				if (AlbumID2Album_.contains (album->ID_))
 					AlbumID2Album_ [album->ID_]->Tracks_ << album->Tracks_;
 				else
 				{
+					if (autoFetchAA)
+						AlbumArtMgr_->CheckAlbumArt (artist, album);
+
 					AlbumID2Album_ [album->ID_] = album;
 					AlbumID2ArtistID_ [album->ID_] = artist.ID_;
 				}
@@ -684,11 +762,19 @@ namespace LMP
 		auto resolver = Core::Instance ().GetLocalFileResolver ();
 
 		emit scanStarted (newPaths.size ());
-		auto worker = [resolver] (const QString& path) -> MediaInfo
+		auto worker = [resolver] (const QString& path) -> ScanResult
 		{
+			const QFileInfo fileInfo { path };
+			ScanResult result
+			{
+				MediaInfo (),
+				{ path, fileInfo.size (), fileInfo.lastModified (), GetInode (path), {} }
+			};
+
 			try
 			{
-				return resolver->ResolveInfo (path);
+				result.Info_ = resolver->ResolveInfo (path);
+				result.Entry_.TagHash_ = HashTags (result.Info_);
 			}
 			catch (const ResolveError& error)
 			{
@@ -696,14 +782,56 @@ namespace LMP
 						<< "error resolving media info for"
 						<< error.GetPath ()
 						<< error.what ();
-				return MediaInfo ();
 			}
+			return result;
 		};
 		const auto& future = QtConcurrent::mapped (newPaths,
-				std::function<MediaInfo (const QString&)> (worker));
+				std::function<ScanResult (const QString&)> (worker));
 		Watcher_->setFuture (future);
 	}
 
+	void LocalCollection::FlushScanResults ()
+	{
+		// The whole batch is stored in a single transaction.
+		std::shared_ptr<Util::DBLock> lock;
+		try
+		{
+			lock = Storage_->BeginTransaction ();
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to start transaction, continuing without it:"
+					<< e.what ();
+		}
+
+		if (!ScannedNewInfos_.isEmpty ())
+		{
+			const auto& newArts = Storage_->AddToCollection (ScannedNewInfos_);
+			HandleNewArtists (newArts);
+		}
+
+		HandleExistingInfos (ScannedExistingInfos_);
+
+		try
+		{
+			Storage_->SetFileIndexEntries (ScannedEntries_);
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "error updating file index"
+					<< e.what ();
+		}
+
+		if (lock)
+			lock->Good ();
+
+		ScannedNewInfos_.clear ();
+		ScannedExistingInfos_.clear ();
+		ScannedEntries_.clear ();
+	}
+
 	void LocalCollection::recordPlayedTrack (const QString& path)
 	{
 		if (!Path2Track_.contains (path))
@@ -756,35 +884,54 @@ namespace LMP
 
 		CheckRemovedFiles (result.ChangedFiles_ + result.UnchangedFiles_, path);
 
+		for (auto i = result.TagHashes_.begin (); i != result.TagHashes_.end (); ++i)
+			IndexedTagHashes_ [i.key ()] = i.value ();
+
 		if (Watcher_->isRunning ())
 			NewPathsQueue_ << result.ChangedFiles_;
 		else
 			InitiateScan (result.ChangedFiles_);
 	}
 
-	void LocalCollection::handleScanFinished ()
+	void LocalCollection::handleScanResults (int begin, int end)
 	{
-		auto future = Watcher_->future ();
-		QList<MediaInfo> newInfos, existingInfos;
-		for (const auto& info : future)
+		for (int i = begin; i < end; ++i)
 		{
+			const auto& result = Watcher_->resultAt (i);
+			ScannedEntries_ << result.Entry_;
+			const auto& indexedTagHash = IndexedTagHashes_.take (result.Entry_.Path_);
+
+			const auto& info = result.Info_;
 			const auto& path = info.LocalPath_;
 			if (path.isEmpty ())
 				continue;
 
+			// A file that has changed on disk but still has the very
+			// same tags doesn't need its track to be updated.
 			if (PresentPaths_.contains (path))
-				existingInfos << info;
+			{
+				if (indexedTagHash.isEmpty () || indexedTagHash != result.Entry_.TagHash_)
+					ScannedExistingInfos_ << info;
+			}
 			else
 			{
-				newInfos << info;
+				ScannedNewInfos_ << info;
 				PresentPaths_ += path;
 			}
 		}
 
-		emit scanFinished ();
+		// Results are stored in batches as they come, so that a huge
+		// scan neither waits for the last file nor does a transaction
+		// per file.
+		if (ScannedEntries_.size () >= 500)
+			FlushScanResults ();
+	}
 
-		auto newArts = Storage_->AddToCollection (newInfos);
-		HandleNewArtists (newArts);
+	void LocalCollection::handleScanFinished ()
+	{
+		FlushScanResults ();
+
+		emit scanFinished ();
 
 		if (!NewPathsQueue_.isEmpty ())
 			InitiateScan (NewPathsQueue_.takeFirst ());
@@ -801,8 +948,6 @@ namespace LMP
 
 			UpdateNewArtists_ = UpdateNewAlbums_ = UpdateNewTracks_ = 0;
 		}
-
-		HandleExistingInfos (existingInfos);
 	}
 
 	void LocalCollection::saveRootPaths ()
@@ -38,6 +38,7 @@
 #include "interfaces/lmp/ilocalcollection.h"
 #include "mediainfo.h"
 #include "localcollectionmodel.h"
+#include "localcollectionstorage.h"
 
 class QStandardItemModel;
 class QStandardItem;
@@ -50,7 +51,6 @@ namespace LeechCraft
 namespace LMP
 {
 	class AlbumArtManager;
-	class LocalCollectionStorage;
 	class LocalCollectionWatcher;
 	class LocalCollectionModel;
 	class Player;
@@ -81,9 +81,24 @@ namespace LMP
 		QHash<int, Collection::Album_ptr> AlbumID2Album_;
 		QHash<int, int> AlbumID2ArtistID_;
 
-		QFutureWatcher<MediaInfo> *Watcher_;
+		struct ScanResult
+		{
+			MediaInfo Info_;
+			LocalCollectionStorage::FileIndexEntry Entry_;
+		};
+
+		QFutureWatcher<ScanResult> *Watcher_;
 		QList<QSet<QString>> NewPathsQueue_;
 
+		QList<MediaInfo> ScannedNewInfos_;
+		QList<MediaInfo> ScannedExistingInfos_;
+		QList<LocalCollectionStorage::FileIndexEntry> ScannedEntries_;
+
+		/** The tag hashes from the file index of the files being
+		 * rescanned, used to skip those whose tags haven't changed.
+		 */
+		QHash<QString, QByteArray> IndexedTagHashes_;
+
 		int UpdateNewArtists_;
 		int UpdateNewAlbums_;
 		int UpdateNewTracks_;
@@ -162,12 +177,14 @@ namespace LMP
 		void CheckRemovedFiles (const QSet<QString>& scanned, const QString& root);
 
 		void InitiateScan (const QSet<QString>&);
+		void FlushScanResults ();
 	public slots:
 		void recordPlayedTrack (const QString&);
 	private slots:
 		void rescanOnLoad ();
 		void handleLoadFinished ();
 		void handleIterateFinished ();
+		void handleScanResults (int, int);
 		void handleScanFinished ();
 		void saveRootPaths ();
 	signals:
@@ -29,6 +29,7 @@
 
 #include "localcollectionstorage.h"
 #include <stdexcept>
+#include <algorithm>
 #include <QSqlError>
 #include <QSqlQuery>
 #include <QFileInfo>
@@ -109,7 +110,8 @@ namespace LMP
 		lock.Init ();
 		QSqlQuery query (DB_);
 		if (!query.exec ("DELETE FROM artists;") ||
-			!query.exec ("DELETE FROM albums;"))
+			!query.exec ("DELETE FROM albums;") ||
+			!query.exec ("DELETE FROM fileIndex;"))
 		{
 			Util::DBLock::DumpError (query);
 			throw std::runtime_error ("unable to clear database");
@@ -120,6 +122,13 @@ namespace LMP
 		PresentArtists_.clear ();
 	}
 
+	std::shared_ptr<Util::DBLock> LocalCollectionStorage::BeginTransaction ()
+	{
+		const auto& lock = std::make_shared<Util::DBLock> (DB_);
+		lock->Init ();
+		return lock;
+	}
+
 	Collection::Artists_t LocalCollectionStorage::AddToCollection (const QList<MediaInfo>& infos)
 	{
 		QMap<int, Collection::Artist> artists;
@@ -154,6 +163,15 @@ namespace LMP
 				AddAlbum (artist, album);
 				artists [artist.ID_].Albums_ << Collection::Album_ptr (new Collection::Album (album));
 			}
+			else
+			{
+				// The album might have been added by an earlier call,
+				// return it too so that the callers get the new track.
+				auto& albums = artists [artist.ID_].Albums_;
+				if (std::none_of (albums.begin (), albums.end (),
+						[&album] (const Collection::Album_ptr& other) { return other->ID_ == album.ID_; }))
+					albums << Collection::Album_ptr (new Collection::Album (album));
+			}
 
 			Collection::Track track =
 			{
@@ -251,6 +269,15 @@ namespace LMP
 
 	void LocalCollectionStorage::RemoveTrack (int id)
 	{
+		// Otherwise the file would be considered unchanged and never
+		// added back on the next rescan.
+		RemoveTrackFileIndex_.bindValue (":track_id", id);
+		if (!RemoveTrackFileIndex_.exec ())
+		{
+			Util::DBLock::DumpError (RemoveTrackFileIndex_);
+			throw std::runtime_error ("cannot remove track file index entry");
+		}
+
 		RemoveTrack_.bindValue (":track_id", id);
 		if (!RemoveTrack_.exec ())
 		{
@@ -384,6 +411,85 @@ namespace LMP
 		}
 	}
 
+	QHash<QString, LocalCollectionStorage::FileIndexEntry> LocalCollectionStorage::GetFileIndex ()
+	{
+		if (!GetFileIndex_.exec ())
+		{
+			Util::DBLock::DumpError (GetFileIndex_);
+			throw std::runtime_error ("cannot get file index");
+		}
+
+		QHash<QString, FileIndexEntry> result;
+		while (GetFileIndex_.next ())
+		{
+			const auto& path = GetFileIndex_.value (0).toString ();
+			result [path] = FileIndexEntry
+			{
+				path,
+				GetFileIndex_.value (1).toLongLong (),
+				GetFileIndex_.value (2).toDateTime (),
+				GetFileIndex_.value (3).toULongLong (),
+				GetFileIndex_.value (4).toByteArray ()
+			};
+		}
+		GetFileIndex_.finish ();
+		return result;
+	}
+
+	void LocalCollectionStorage::SetFileIndexEntries (const QList<FileIndexEntry>& entries)
+	{
+		if (entries.isEmpty ())
+			return;
+
+		Util::DBLock lock (DB_);
+		lock.Init ();
+
+		for (const auto& entry : entries)
+		{
+			SetFileIndexEntry_.bindValue (":path", entry.Path_);
+			SetFileIndexEntry_.bindValue (":size", entry.Size_);
+			SetFileIndexEntry_.bindValue (":mtime", entry.MTime_);
+			SetFileIndexEntry_.bindValue (":inode", entry.Inode_);
+			SetFileIndexEntry_.bindValue (":tag_hash", entry.TagHash_);
+			if (!SetFileIndexEntry_.exec ())
+			{
+				Util::DBLock::DumpError (SetFileIndexEntry_);
+				throw std::runtime_error ("cannot set file index entry");
+			}
+
+			SetTrackMTime_.bindValue (":filepath", entry.Path_);
+			SetTrackMTime_.bindValue (":mtime", entry.MTime_);
+			if (!SetTrackMTime_.exec ())
+			{
+				Util::DBLock::DumpError (SetTrackMTime_);
+				throw std::runtime_error ("cannot set file mtime");
+			}
+		}
+
+		lock.Good ();
+	}
+
+	void LocalCollectionStorage::RemoveFileIndexEntries (const QStringList& paths)
+	{
+		if (paths.isEmpty ())
+			return;
+
+		Util::DBLock lock (DB_);
+		lock.Init ();
+
+		for (const auto& path : paths)
+		{
+			RemoveFileIndexEntry_.bindValue (":path", path);
+			if (!RemoveFileIndexEntry_.exec ())
+			{
+				Util::DBLock::DumpError (RemoveFileIndexEntry_);
+				throw std::runtime_error ("cannot remove file index entry");
+			}
+		}
+
+		lock.Good ();
+	}
+
 	const int LovedStateID = 1;
 	const int BannedStateID = 2;
 
@@ -724,6 +830,9 @@ namespace LMP
 		RemoveTrack_ = QSqlQuery (DB_);
 		RemoveTrack_.prepare ("DELETE FROM tracks WHERE Id = :track_id;");
 
+		RemoveTrackFileIndex_ = QSqlQuery (DB_);
+		RemoveTrackFileIndex_.prepare ("DELETE FROM fileIndex WHERE Path = (SELECT Path FROM tracks WHERE Id = :track_id);");
+
 		RemoveAlbum_ = QSqlQuery (DB_);
 		RemoveAlbum_.prepare ("DELETE FROM albums WHERE Id = :album_id;");
 
@@ -758,6 +867,19 @@ namespace LMP
 		SetFileMTime_ = QSqlQuery (DB_);
 		SetFileMTime_.prepare ("INSERT OR REPLACE INTO fileTimes (TrackID, MTime) VALUES ((SELECT Id FROM tracks WHERE Path = :filepath), :mtime);");
 
+		SetTrackMTime_ = QSqlQuery (DB_);
+		SetTrackMTime_.prepare ("INSERT OR REPLACE INTO fileTimes (TrackID, MTime) SELECT Id, :mtime FROM tracks WHERE Path = :filepath;");
+
+		GetFileIndex_ = QSqlQuery (DB_);
+		GetFileIndex_.prepare ("SELECT Path, Size, MTime, Inode, TagHash FROM fileIndex;");
+
+		SetFileIndexEntry_ = QSqlQuery (DB_);
+		SetFileIndexEntry_.prepare ("INSERT OR REPLACE INTO fileIndex (Path, Size, MTime, Inode, TagHash) "
+				"VALUES (:path, :size, :mtime, :inode, :tag_hash);");
+
+		RemoveFileIndexEntry_ = QSqlQuery (DB_);
+		RemoveFileIndexEntry_.prepare ("DELETE FROM fileIndex WHERE Path = :path;");
+
 		GetLovedBanned_ = QSqlQuery (DB_);
 		GetLovedBanned_.prepare ("SELECT TrackId FROM lovedBanned WHERE State = :state;");
 
@@ -863,6 +985,14 @@ namespace LMP
 				"TrackId INTEGER NOT NULL REFERENCES tracks (Id) ON DELETE CASCADE, "
 				"Date TIMESTAMP"
 				");");
+		table2query << QueryPair_t ("fileIndex",
+				"CREATE TABLE fileIndex ("
+				"Path TEXT PRIMARY KEY, "
+				"Size INTEGER NOT NULL, "
+				"MTime TIMESTAMP NOT NULL, "
+				"Inode INTEGER NOT NULL, "
+				"TagHash BLOB"
+				");");
 
 		Util::DBLock lock (DB_);
 		lock.Init ();
@@ -881,6 +1011,21 @@ namespace LMP
 				}
 			}
 
+		// Seed the file index from the modification times we already
+		// know, so that the first rescan after upgrading doesn't have to
+		// read the tags of the whole collection again.
+		if (!tables.contains ("fileIndex"))
+		{
+			QSqlQuery q (DB_);
+			if (!q.exec ("INSERT INTO fileIndex (Path, Size, MTime, Inode) "
+						"SELECT tracks.Path, -1, fileTimes.MTime, 0 FROM tracks, fileTimes "
+						"WHERE tracks.Id = fileTimes.TrackID;"))
+			{
+				Util::DBLock::DumpError (q);
+				throw std::runtime_error ("cannot seed file index");
+			}
+		}
+
 		const auto tracksTableVersion = XmlSettingsManager::Instance ()
 				.Property ("TracksTableVersion", 1).toInt ();
 		if (tracksTableVersion < 2)
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <memory>
 #include <QObject>
 #include <QHash>
 #include <QSqlDatabase>
@@ -38,6 +39,11 @@
 
 namespace LeechCraft
 {
+namespace Util
+{
+	class DBLock;
+}
+
 namespace LMP
 {
 	struct RGData;
@@ -62,6 +68,7 @@ namespace LMP
 		QSqlQuery AddGenre_;
 
 		QSqlQuery RemoveTrack_;
+		QSqlQuery RemoveTrackFileIndex_;
 		QSqlQuery RemoveAlbum_;
 		QSqlQuery RemoveArtist_;
 
@@ -74,6 +81,11 @@ namespace LMP
 		QSqlQuery GetFileIdMTime_;
 		QSqlQuery GetFileMTime_;
 		QSqlQuery SetFileMTime_;
+		QSqlQuery SetTrackMTime_;
+
+		QSqlQuery GetFileIndex_;
+		QSqlQuery SetFileIndexEntry_;
+		QSqlQuery RemoveFileIndexEntry_;
 
 		// 1 is loved, 2 is banned
 		QSqlQuery GetLovedBanned_;
@@ -94,10 +106,42 @@ namespace LMP
 			QHash<QString, int> PresentAlbums_;
 		};
 
+		/** @brief The state of a file as of the last time it's been
+		 * scanned.
+		 *
+		 * Files are only resolved again during the rescan if any of
+		 * these change. The size of -1 and the inode of 0 mean the
+		 * corresponding value is unknown and shouldn't be compared.
+		 */
+		struct FileIndexEntry
+		{
+			QString Path_;
+			qint64 Size_;
+			QDateTime MTime_;
+			quint64 Inode_;
+
+			/** @brief The hash of the tags read from the file, if any.
+			 */
+			QByteArray TagHash_;
+		};
+
 		LocalCollectionStorage (QObject* = 0);
 		~LocalCollectionStorage ();
 
 		void Clear ();
+
+		/** @brief Starts a transaction spanning several calls.
+		 *
+		 * The methods called while the returned lock is alive join
+		 * its transaction instead of committing on their own. The
+		 * transaction is committed only if Util::DBLock::Good() has
+		 * been called on the lock, otherwise it is rolled back.
+		 *
+		 * @throw std::runtime_error If the transaction could not be
+		 * started.
+		 */
+		std::shared_ptr<Util::DBLock> BeginTransaction ();
+
 		Collection::Artists_t AddToCollection (const QList<MediaInfo>&);
 		LoadResult Load ();
 		void Load (const LoadResult&);
@@ -117,6 +161,17 @@ namespace LMP
 		QDateTime GetMTime (const QString&);
 		void SetMTime (const QString&, const QDateTime&);
 
+		QHash<QString, FileIndexEntry> GetFileIndex ();
+
+		/** @brief Stores the given file index entries in a single
+		 * transaction.
+		 *
+		 * The modification time of the tracks corresponding to the
+		 * entries, if any, is updated as well.
+		 */
+		void SetFileIndexEntries (const QList<FileIndexEntry>&);
+		void RemoveFileIndexEntries (const QStringList&);
+
 		void SetTrackLoved (int);
 		void SetTrackBanned (int);
 		void ClearTrackLovedBanned (int);
@@ -79,8 +79,9 @@ namespace LMP
 			}
 		}
 
-		QMutexLocker tlLocker (&TaglibMutex_);
-
+		// Reading different files via different FileRefs is safe, so
+		// readers only exclude tag writers, not each other.
+		QReadLocker taglibLocker (&TaglibLock_);
 		auto r = GetFileRef (file);
 		auto tag = r.tag ();
 		if (!tag)
@@ -113,9 +114,9 @@ namespace LMP
 		return info;
 	}
 
-	QMutex& LocalFileResolver::GetMutex ()
+	QReadWriteLock& LocalFileResolver::GetTagLock ()
 	{
-		return TaglibMutex_;
+		return TaglibLock_;
 	}
 }
 }
@@ -33,7 +33,6 @@
 #include <QObject>
 #include <QHash>
 #include <QReadWriteLock>
-#include <QMutex>
 #include <QDateTime>
 #include <taglib/fileref.h>
 #include "interfaces/lmp/itagresolver.h"
@@ -59,7 +58,7 @@ namespace LMP
 		Q_OBJECT
 		Q_INTERFACES (LeechCraft::LMP::ITagResolver)
 
-		QMutex TaglibMutex_;
+		QReadWriteLock TaglibLock_;
 		QReadWriteLock CacheLock_;
 		QHash<QString, QPair<QDateTime, MediaInfo>> Cache_;
 	public:
@@ -67,7 +66,7 @@ namespace LMP
 
 		TagLib::FileRef GetFileRef (const QString&) const;
 		MediaInfo ResolveInfo (const QString&);
-		QMutex& GetMutex ();
+		QReadWriteLock& GetTagLock ();
 	};
 }
 }
@@ -30,6 +30,7 @@
 #include "pagegraphicsitem.h"
 #include <limits>
 #include <cmath>
+#include <algorithm>
 #include <QtDebug>
 #include <QtConcurrentRun>
 #include <QFutureWatcher>
@@ -40,6 +41,9 @@
 #include <QGraphicsView>
 #include <QMenu>
 #include <QWidgetAction>
+#include <QStyleOptionGraphicsItem>
+#include <QPainter>
+#include "interfaces/monocle/isupporttiledrendering.h"
 #include "core.h"
 #include "pixmapcachemanager.h"
 #include "arbitraryrotationwidget.h"
@@ -49,6 +53,47 @@ namespace LeechCraft
 {
 namespace Monocle
 {
+	namespace
+	{
+		/* The side of a tile in pixels.
+		 */
+		const int TileSize = 512;
+
+		/* The number of tile scale levels per each twofold zoom.
+		 */
+		const int LevelsPerOctave = 4;
+
+		/* The longest side of the low-resolution page rendering shown
+		 * while the tiles are being rendered.
+		 */
+		const int PlaceholderSize = 512;
+
+		bool IsThreaded (const IDocument_ptr& doc)
+		{
+			return qobject_cast<IBackendPlugin*> (doc->GetBackendPlugin ())->IsThreaded ();
+		}
+
+		bool SupportsTiles (const IDocument_ptr& doc)
+		{
+			return IsThreaded (doc) &&
+					qobject_cast<ISupportTiledRendering*> (doc->GetQObject ());
+		}
+
+		double GetLevel (double scale)
+		{
+			if (scale <= 0)
+				return 1;
+
+			const auto steps = std::ceil (std::log2 (scale) * LevelsPerOctave - 1e-6);
+			return std::pow (2, steps / LevelsPerOctave);
+		}
+
+		qint64 GetPixmapSize (const QPixmap& px)
+		{
+			return static_cast<qint64> (px.width ()) * px.height () * px.defaultDepth () / 8 * 1.5;
+		}
+	}
+
 	PageGraphicsItem::PageGraphicsItem (IDocument_ptr doc, int page, QGraphicsItem *parent)
 	: QGraphicsPixmapItem (parent)
 	, Doc_ (doc)
@@ -56,10 +101,19 @@ namespace Monocle
 	, XScale_ (1)
 	, YScale_ (1)
 	, Invalid_ (true)
+	, IsTiled_ (SupportsTiles (doc))
+	, XLevel_ (0)
+	, YLevel_ (0)
 	, LayoutManager_ (0)
 	{
 		setTransformationMode (Qt::SmoothTransformation);
-		setPixmap (QPixmap (Doc_->GetPageSize (page)));
+		if (IsTiled_)
+		{
+			setFlag (ItemUsesExtendedStyleOption);
+			UpdateLevels ();
+		}
+		else
+			setPixmap (QPixmap (Doc_->GetPageSize (page)));
 		setAcceptHoverEvents (true);
 	}
 
@@ -69,6 +123,12 @@ namespace Monocle
 
 		if (RenderFuture_)
 			RenderFuture_->waitForFinished ();
+		if (PlaceholderFuture_)
+			PlaceholderFuture_->waitForFinished ();
+
+		CancelTiles ();
+		for (const auto& tile : CancelledTiles_)
+			tile.Watcher_->waitForFinished ();
 	}
 
 	void PageGraphicsItem::SetLayoutManager (PagesLayoutManager *manager)
@@ -87,13 +147,16 @@ namespace Monocle
 			std::abs (ys - YScale_) < std::numeric_limits<double>::epsilon ())
 			return;
 
+		if (IsTiled_)
+			prepareGeometryChange ();
+
 		XScale_ = xs;
 		YScale_ = ys;
 
-		auto size = Doc_->GetPageSize (PageNum_);
-		size.rwidth () *= xs;
-		size.rheight () *= ys;
-		setPixmap (QPixmap (size));
+		if (IsTiled_)
+			UpdateLevels ();
+		else
+			setPixmap (QPixmap (GetScaledSize ()));
 
 		Invalid_ = true;
 
@@ -148,47 +211,133 @@ namespace Monocle
 
 	void PageGraphicsItem::ClearPixmap ()
 	{
-		auto size = Doc_->GetPageSize (PageNum_);
-		size.rwidth () *= XScale_;
-		size.rheight () *= YScale_;
-		setPixmap (QPixmap (size));
+		if (IsTiled_)
+		{
+			CancelTiles ();
+			Tiles_.clear ();
+			Placeholder_ = QPixmap ();
+			++Generation_;
+		}
+		else
+			setPixmap (QPixmap (GetScaledSize ()));
 
 		Invalid_ = true;
 	}
 
 	void PageGraphicsItem::UpdatePixmap ()
 	{
+		if (IsTiled_)
+		{
+			CancelTiles ();
+			Tiles_.clear ();
+			PlaceholderStale_ = true;
+			++Generation_;
+		}
+
 		Invalid_ = true;
 		if (IsDisplayed ())
 			update ();
 	}
 
+	void PageGraphicsItem::SetVisibleRect (const QRectF& rect)
+	{
+		if (!IsTiled_)
+			return;
+
+		if (rect.isEmpty ())
+		{
+			CancelTiles ();
+			return;
+		}
+
+		CancelTiles (rect.adjusted (-TileSize, -TileSize, TileSize, TileSize));
+
+		// Keep a viewport worth of tiles around the visible part for scrolling back and forth.
+		const auto& keep = rect.adjusted (-rect.width (), -rect.height (), rect.width (), rect.height ());
+		bool dropped = false;
+		for (auto i = Tiles_.begin (); i != Tiles_.end (); )
+			if (GetTileRect (i.key ().first, i.key ().second).intersects (keep))
+				++i;
+			else
+			{
+				i = Tiles_.erase (i);
+				dropped = true;
+			}
+
+		if (dropped)
+			Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+	}
+
+	void PageGraphicsItem::Prefetch (const QSizeF& viewSize, bool forward)
+	{
+		if (!IsTiled_)
+		{
+			if (Invalid_ && IsThreaded (Doc_))
+				StartThreadedRender ();
+			return;
+		}
+
+		const auto& bounding = boundingRect ();
+		const auto height = std::min (viewSize.height (), bounding.height ());
+		RequestTiles ({
+				0,
+				forward ? 0 : bounding.height () - height,
+				bounding.width (),
+				height
+			});
+	}
+
+	qint64 PageGraphicsItem::GetMemoryUsage () const
+	{
+		if (!IsTiled_)
+			return GetPixmapSize (pixmap ());
+
+		auto result = GetPixmapSize (Placeholder_);
+		for (const auto& tile : Tiles_)
+			result += GetPixmapSize (tile);
+		return result;
+	}
+
+	QRectF PageGraphicsItem::boundingRect () const
+	{
+		if (!IsTiled_)
+			return QGraphicsPixmapItem::boundingRect ();
+
+		return { QPointF {}, GetScaledSize () };
+	}
+
+	QPainterPath PageGraphicsItem::shape () const
+	{
+		if (!IsTiled_)
+			return QGraphicsPixmapItem::shape ();
+
+		QPainterPath path;
+		path.addRect (boundingRect ());
+		return path;
+	}
+
 	void PageGraphicsItem::paint (QPainter *painter,
 			const QStyleOptionGraphicsItem *option, QWidget *w)
 	{
+		if (IsTiled_)
+		{
+			PaintTiles (painter, option->exposedRect);
+			Core::Instance ().GetPixmapCacheManager ()->PixmapPainted (this);
+			return;
+		}
+
 		if (Invalid_ && IsDisplayed ())
 		{
-			auto backendObj = Doc_->GetBackendPlugin ();
-			if (qobject_cast<IBackendPlugin*> (backendObj)->IsThreaded ())
-			{
-				if (!RenderFuture_)
-					RequestThreadedRender ();
-
-				auto size = Doc_->GetPageSize (PageNum_);
-				size.rwidth () *= XScale_;
-				size.rheight () *= YScale_;
-				QPixmap px (size);
-				px.fill ();
-				setPixmap (px);
-			}
+			if (IsThreaded (Doc_))
+				StartThreadedRender ();
 			else
 			{
 				const auto& img = Doc_->RenderPage (PageNum_, XScale_, YScale_);
 				setPixmap (QPixmap::fromImage (img));
-			}
-			Invalid_ = false;
+				Invalid_ = false;
 
-			Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+				Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+			}
 		}
 
 		QGraphicsPixmapItem::paint (painter, option, w);
@@ -244,6 +393,28 @@ namespace Monocle
 		rotateMenu.exec (event->screenPos ());
 	}
 
+	QSize PageGraphicsItem::GetScaledSize () const
+	{
+		auto size = Doc_->GetPageSize (PageNum_);
+		size.rwidth () *= XScale_;
+		size.rheight () *= YScale_;
+		return size;
+	}
+
+	void PageGraphicsItem::StartThreadedRender ()
+	{
+		if (!RenderFuture_)
+			RequestThreadedRender ();
+
+		QPixmap px (GetScaledSize ());
+		px.fill ();
+		setPixmap (px);
+
+		Invalid_ = false;
+
+		Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+	}
+
 	void PageGraphicsItem::RequestThreadedRender ()
 	{
 		RenderFuture_.reset (new QFutureWatcher<RenderInfo>,
@@ -264,7 +435,7 @@ namespace Monocle
 				{
 					return RenderInfo
 					{
-						Doc_->RenderPage (PageNum_, yscale, yscale),
+						Doc_->RenderPage (PageNum_, xscale, yscale),
 						xscale,
 						yscale
 					};
@@ -287,6 +458,210 @@ namespace Monocle
 		return false;
 	}
 
+	void PageGraphicsItem::UpdateLevels ()
+	{
+		const auto xLevel = GetLevel (XScale_);
+		const auto yLevel = GetLevel (YScale_);
+		if (xLevel == XLevel_ && yLevel == YLevel_)
+			return;
+
+		XLevel_ = xLevel;
+		YLevel_ = yLevel;
+
+		CancelTiles ();
+		Tiles_.clear ();
+		++Generation_;
+	}
+
+	QSize PageGraphicsItem::GetLevelSize () const
+	{
+		const auto& size = Doc_->GetPageSize (PageNum_);
+		return
+		{
+			static_cast<int> (std::ceil (size.width () * XLevel_)),
+			static_cast<int> (std::ceil (size.height () * YLevel_))
+		};
+	}
+
+	QRect PageGraphicsItem::GetLevelTileRect (int row, int col) const
+	{
+		const QRect rect { col * TileSize, row * TileSize, TileSize, TileSize };
+		return rect.intersected ({ QPoint {}, GetLevelSize () });
+	}
+
+	QRectF PageGraphicsItem::GetTileRect (int row, int col) const
+	{
+		const auto& rect = GetLevelTileRect (row, col);
+		const auto xRatio = XScale_ / XLevel_;
+		const auto yRatio = YScale_ / YLevel_;
+		return
+		{
+			rect.x () * xRatio,
+			rect.y () * yRatio,
+			rect.width () * xRatio,
+			rect.height () * yRatio
+		};
+	}
+
+	QRect PageGraphicsItem::GetTilesIn (const QRectF& itemRect) const
+	{
+		const auto& levelSize = GetLevelSize ();
+		const auto lastCol = (levelSize.width () - 1) / TileSize;
+		const auto lastRow = (levelSize.height () - 1) / TileSize;
+
+		const auto xRatio = XLevel_ / XScale_ / TileSize;
+		const auto yRatio = YLevel_ / YScale_ / TileSize;
+
+		auto clamp = [] (double val, int max)
+			{ return std::max (0, std::min (static_cast<int> (val), max)); };
+
+		return QRect
+		{
+			QPoint { clamp (itemRect.left () * xRatio, lastCol), clamp (itemRect.top () * yRatio, lastRow) },
+			QPoint { clamp (itemRect.right () * xRatio, lastCol), clamp (itemRect.bottom () * yRatio, lastRow) }
+		};
+	}
+
+	void PageGraphicsItem::PaintTiles (QPainter *painter, const QRectF& exposed)
+	{
+		const auto& bounding = boundingRect ();
+		const auto& rect = exposed.isEmpty () ?
+				bounding :
+				exposed.intersected (bounding);
+		if (rect.isEmpty ())
+			return;
+
+		painter->save ();
+		painter->setRenderHint (QPainter::SmoothPixmapTransform);
+
+		const auto& tiles = GetTilesIn (rect);
+		for (int row = tiles.top (); row <= tiles.bottom (); ++row)
+			for (int col = tiles.left (); col <= tiles.right (); ++col)
+			{
+				const auto& tileRect = GetTileRect (row, col);
+
+				const auto pos = Tiles_.find ({ row, col });
+				if (pos != Tiles_.end ())
+					painter->drawPixmap (tileRect, *pos, pos->rect ());
+				else if (!Placeholder_.isNull ())
+				{
+					const auto xRatio = Placeholder_.width () / bounding.width ();
+					const auto yRatio = Placeholder_.height () / bounding.height ();
+					const QRectF source
+					{
+						tileRect.x () * xRatio,
+						tileRect.y () * yRatio,
+						tileRect.width () * xRatio,
+						tileRect.height () * yRatio
+					};
+					painter->drawPixmap (tileRect, Placeholder_, source);
+				}
+				else
+					painter->fillRect (tileRect, Qt::white);
+			}
+
+		painter->restore ();
+
+		RequestTiles (rect);
+	}
+
+	void PageGraphicsItem::RequestTiles (const QRectF& rect)
+	{
+		const auto& levelSize = GetLevelSize ();
+		const bool isSingleTile = levelSize.width () <= TileSize && levelSize.height () <= TileSize;
+		if (!isSingleTile &&
+				(Placeholder_.isNull () || PlaceholderStale_) &&
+				!PlaceholderFuture_)
+			RequestPlaceholder ();
+
+		const auto& tiles = GetTilesIn (rect);
+		for (int row = tiles.top (); row <= tiles.bottom (); ++row)
+			for (int col = tiles.left (); col <= tiles.right (); ++col)
+			{
+				const TileKey_t key { row, col };
+				if (!Tiles_.contains (key) && !PendingTiles_.contains (key))
+					RequestTile (row, col);
+			}
+	}
+
+	void PageGraphicsItem::RequestTile (int row, int col)
+	{
+		const auto& cancelled = std::make_shared<std::atomic<bool>> (false);
+		const std::shared_ptr<QFutureWatcher<TileInfo>> watcher
+		{
+			new QFutureWatcher<TileInfo>,
+			[this] (QFutureWatcher<TileInfo> *watcher)
+			{
+				disconnect (watcher, 0, this, 0);
+				watcher->deleteLater ();
+			}
+		};
+		connect (watcher.get (),
+				SIGNAL (finished ()),
+				this,
+				SLOT (handleTileRendered ()));
+		PendingTiles_ [{ row, col }] = { cancelled, watcher };
+
+		const auto renderer = qobject_cast<ISupportTiledRendering*> (Doc_->GetQObject ());
+		const auto page = PageNum_;
+		const auto xLevel = XLevel_;
+		const auto yLevel = YLevel_;
+		const auto& rect = GetLevelTileRect (row, col);
+		const auto generation = Generation_;
+		watcher->setFuture (QtConcurrent::run ([=]
+				() -> TileInfo
+				{
+					TileInfo info { {}, row, col, generation };
+					if (!*cancelled)
+						info.Image_ = renderer->RenderTile (page, xLevel, yLevel, rect);
+					return info;
+				}));
+	}
+
+	void PageGraphicsItem::RequestPlaceholder ()
+	{
+		PlaceholderFuture_.reset (new QFutureWatcher<RenderInfo>,
+				[this] (QFutureWatcher<RenderInfo> *watcher)
+				{
+					disconnect (watcher, 0, this, 0);
+					watcher->deleteLater ();
+				});
+		connect (PlaceholderFuture_.get (),
+				SIGNAL (finished ()),
+				this,
+				SLOT (handlePlaceholderRendered ()));
+
+		PlaceholderStale_ = false;
+
+		const auto& size = Doc_->GetPageSize (PageNum_);
+		const auto scale = std::min (1.,
+				static_cast<double> (PlaceholderSize) / std::max (size.width (), size.height ()));
+
+		const auto doc = Doc_;
+		const auto page = PageNum_;
+		PlaceholderFuture_->setFuture (QtConcurrent::run ([doc, page, scale]
+				{
+					return RenderInfo { doc->RenderPage (page, scale, scale), scale, scale };
+				}));
+	}
+
+	void PageGraphicsItem::CancelTiles (const QRectF& keep)
+	{
+		for (auto i = PendingTiles_.begin (); i != PendingTiles_.end (); )
+		{
+			if (!keep.isEmpty () &&
+					GetTileRect (i.key ().first, i.key ().second).intersects (keep))
+			{
+				++i;
+				continue;
+			}
+
+			*i->Cancelled_ = true;
+			CancelledTiles_ << *i;
+			i = PendingTiles_.erase (i);
+		}
+	}
+
 	void PageGraphicsItem::rotateCCW ()
 	{
 		LayoutManager_->AddRotation (-90, PageNum_);
@@ -332,5 +707,47 @@ namespace Monocle
 
 		Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
 	}
+
+	void PageGraphicsItem::handleTileRendered ()
+	{
+		const auto watcher = static_cast<QFutureWatcher<TileInfo>*> (sender ());
+
+		const auto cancelledPos = std::find_if (CancelledTiles_.begin (), CancelledTiles_.end (),
+				[watcher] (const PendingTile& tile) { return tile.Watcher_.get () == watcher; });
+		if (cancelledPos != CancelledTiles_.end ())
+		{
+			CancelledTiles_.erase (cancelledPos);
+			return;
+		}
+
+		const auto info = watcher->result ();
+		const TileKey_t key { info.Row_, info.Col_ };
+		const auto pos = PendingTiles_.find (key);
+		if (pos == PendingTiles_.end () || pos->Watcher_.get () != watcher)
+			return;
+		PendingTiles_.erase (pos);
+
+		if (info.Image_.isNull () || info.Generation_ != Generation_)
+			return;
+
+		Tiles_ [key] = QPixmap::fromImage (info.Image_);
+		update (GetTileRect (info.Row_, info.Col_));
+
+		Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+	}
+
+	void PageGraphicsItem::handlePlaceholderRendered ()
+	{
+		if (sender () != PlaceholderFuture_.get ())
+			return;
+
+		const auto& result = PlaceholderFuture_->result ();
+		PlaceholderFuture_.reset ();
+
+		Placeholder_ = QPixmap::fromImage (result.Result_);
+		update ();
+
+		Core::Instance ().GetPixmapCacheManager ()->PixmapChanged (this);
+	}
 }
 }
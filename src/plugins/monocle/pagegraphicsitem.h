@@ -31,8 +31,11 @@
 
 #include <functional>
 #include <memory>
+#include <atomic>
 #include <QGraphicsPixmapItem>
 #include <QPointer>
+#include <QHash>
+#include <QPair>
 #include "interfaces/monocle/idocument.h"
 
 template<typename T>
@@ -58,6 +61,22 @@ namespace Monocle
 
 		bool Invalid_;
 
+		/* Whether the page is rendered as a set of tiles instead of a
+		 * single pixmap, see ISupportTiledRendering.
+		 */
+		const bool IsTiled_;
+
+		/* The discrete scales the tiles are rendered at, the nearest
+		 * ones not less than XScale_ and YScale_.
+		 */
+		double XLevel_;
+		double YLevel_;
+
+		/* Incremented each time the rendered tiles become stale, so
+		 * that results of the jobs started before that are ignored.
+		 */
+		int Generation_ = 0;
+
 		std::function<void (int, QPointF)> ReleaseHandler_;
 
 		PagesLayoutManager *LayoutManager_;
@@ -71,6 +90,28 @@ namespace Monocle
 			double YScale_;
 		};
 		std::shared_ptr<QFutureWatcher<RenderInfo>> RenderFuture_;
+
+		struct TileInfo
+		{
+			QImage Image_;
+			int Row_;
+			int Col_;
+			int Generation_;
+		};
+		struct PendingTile
+		{
+			std::shared_ptr<std::atomic<bool>> Cancelled_;
+			std::shared_ptr<QFutureWatcher<TileInfo>> Watcher_;
+		};
+
+		typedef QPair<int, int> TileKey_t;
+		QHash<TileKey_t, QPixmap> Tiles_;
+		QHash<TileKey_t, PendingTile> PendingTiles_;
+		QList<PendingTile> CancelledTiles_;
+
+		QPixmap Placeholder_;
+		bool PlaceholderStale_ = false;
+		std::shared_ptr<QFutureWatcher<RenderInfo>> PlaceholderFuture_;
 	public:
 		typedef std::function<void (QRectF)> RectSetter_f;
 	private:
@@ -99,14 +140,54 @@ namespace Monocle
 
 		void ClearPixmap ();
 		void UpdatePixmap ();
+
+		/** @brief Notifies the page about its currently visible part.
+		 *
+		 * Pending tile renders for the parts of the page far from the
+		 * \em rect are cancelled, and the tiles far from it are
+		 * dropped. Passing an empty \em rect cancels all pending renders.
+		 *
+		 * @param[in] rect The visible rect in item coordinates.
+		 */
+		void SetVisibleRect (const QRectF& rect);
+
+		/** @brief Starts rendering the page before it's shown.
+		 *
+		 * @param[in] viewSize The size of the viewport.
+		 * @param[in] forward Whether the page is going to be shown from
+		 * its top (scrolling forward) or its bottom (scrolling back).
+		 */
+		void Prefetch (const QSizeF& viewSize, bool forward);
+
+		/** @brief Returns the approximate memory used by the renders.
+		 */
+		qint64 GetMemoryUsage () const;
+
+		QRectF boundingRect () const;
+		QPainterPath shape () const;
 	protected:
 		void paint (QPainter*, const QStyleOptionGraphicsItem*, QWidget*);
 		void mousePressEvent (QGraphicsSceneMouseEvent*);
 		void mouseReleaseEvent (QGraphicsSceneMouseEvent*);
 		void contextMenuEvent (QGraphicsSceneContextMenuEvent*);
 	private:
+		QSize GetScaledSize () const;
+
+		void StartThreadedRender ();
 		void RequestThreadedRender ();
 		bool IsDisplayed () const;
+
+		void UpdateLevels ();
+		QSize GetLevelSize () const;
+		QRect GetLevelTileRect (int row, int col) const;
+		QRectF GetTileRect (int row, int col) const;
+		QRect GetTilesIn (const QRectF&) const;
+
+		void PaintTiles (QPainter*, const QRectF&);
+		void RequestTiles (const QRectF&);
+		void RequestTile (int row, int col);
+		void RequestPlaceholder ();
+		void CancelTiles (const QRectF& keep = {});
 	private slots:
 		void rotateCCW ();
 		void rotateCW ();
@@ -115,6 +196,8 @@ namespace Monocle
 		void updateRotation (double, int);
 
 		void handlePixmapRendered ();
+		void handleTileRendered ();
+		void handlePlaceholderRendered ();
 	signals:
 		void rotateRequested (double);
 	};
@@ -43,6 +43,11 @@ namespace Monocle
 {
 	const int Margin = 10;
 
+	/* The number of pages rendered ahead of the visible ones in the
+	 * scrolling direction.
+	 */
+	const int PrefetchPages = 2;
+
 	PagesLayoutManager::PagesLayoutManager (PagesView *view, QObject *parent)
 	: QObject (parent)
 	, View_ (view)
@@ -55,6 +60,12 @@ namespace Monocle
 				this,
 				SLOT (scheduleRelayout ()),
 				Qt::QueuedConnection);
+
+		for (auto scrollBar : { View_->verticalScrollBar (), View_->horizontalScrollBar () })
+			connect (scrollBar,
+					SIGNAL (valueChanged (int)),
+					this,
+					SLOT (updateVisiblePages ()));
 	}
 
 	void PagesLayoutManager::HandleDoc (IDocument_ptr doc, const QList<PageGraphicsItem*>& pages)
@@ -361,5 +372,49 @@ namespace Monocle
 	{
 		scheduleRelayout ();
 	}
+
+	void PagesLayoutManager::updateVisiblePages ()
+	{
+		const auto& viewRect = View_->mapToScene (View_->viewport ()->rect ()).boundingRect ();
+
+		QList<QRectF> visibleRects;
+		int firstVisible = -1;
+		int lastVisible = -1;
+		for (int i = 0; i < Pages_.size (); ++i)
+		{
+			const auto page = Pages_.at (i);
+			const auto& xsect = viewRect.intersected (page->mapToScene (page->boundingRect ()).boundingRect ());
+			if (xsect.isEmpty ())
+			{
+				visibleRects << QRectF {};
+				continue;
+			}
+
+			visibleRects << page->mapFromScene (xsect).boundingRect ();
+			if (firstVisible < 0)
+				firstVisible = i;
+			lastVisible = i;
+		}
+
+		if (firstVisible < 0)
+			return;
+
+		const auto scrollValue = View_->verticalScrollBar ()->value ();
+		const bool forward = scrollValue >= LastScrollValue_;
+		LastScrollValue_ = scrollValue;
+
+		const auto prefetchCount = PrefetchPages * GetLayoutModeCount ();
+		const auto prefetchBegin = forward ? lastVisible + 1 : firstVisible - prefetchCount;
+		const auto prefetchEnd = forward ? lastVisible + prefetchCount : firstVisible - 1;
+
+		for (int i = 0; i < Pages_.size (); ++i)
+		{
+			const auto page = Pages_.at (i);
+			if (i >= prefetchBegin && i <= prefetchEnd)
+				page->Prefetch (viewRect.size (), forward);
+			else
+				page->SetVisibleRect (visibleRects.at (i));
+		}
+	}
 }
 }
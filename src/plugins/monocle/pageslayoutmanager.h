@@ -68,6 +68,8 @@ namespace Monocle
 		double VertMargin_ = 0;
 
 		double Rotation_ = 0;
+
+		int LastScrollValue_ = 0;
 	public:
 		PagesLayoutManager (PagesView*, QObject* = 0);
 
@@ -108,6 +110,7 @@ namespace Monocle
 		void handleRelayout ();
 	private slots:
 		void handlePageSizeChanged (int);
+		void updateVisiblePages ();
 	signals:
 		void scheduledRelayoutFinished ();
 		void rotationUpdated (double);
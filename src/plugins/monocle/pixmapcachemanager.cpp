@@ -47,14 +47,6 @@ namespace Monocle
 		handleCacheSizeChanged ();
 	}
 
-	namespace
-	{
-		quint64 GetPixmapSize (const QPixmap& px)
-		{
-			return px.width () * px.height () * px.defaultDepth () / 8 * 1.5;
-		}
-	}
-
 	void PixmapCacheManager::PixmapPainted (PageGraphicsItem *item)
 	{
 		RecentlyUsed_.removeAll (item);
@@ -64,18 +56,18 @@ namespace Monocle
 	void PixmapCacheManager::PixmapChanged (PageGraphicsItem *item)
 	{
 		if (RecentlyUsed_.removeAll (item))
-			CurrentSize_ = std::accumulate (RecentlyUsed_.begin (), RecentlyUsed_.end (), 0,
+			CurrentSize_ = std::accumulate (RecentlyUsed_.begin (), RecentlyUsed_.end (), static_cast<qint64> (0),
 					[] (qint64 size, decltype (RecentlyUsed_.front ()) item)
-						{ return size + GetPixmapSize (item->pixmap ()); });
+						{ return size + item->GetMemoryUsage (); });
 
 		RecentlyUsed_ << item;
-		CurrentSize_ += GetPixmapSize (item->pixmap ());
+		CurrentSize_ += item->GetMemoryUsage ();
 		CheckCache ();
 	}
 
 	void PixmapCacheManager::PixmapDeleted (PageGraphicsItem *item)
 	{
-		CurrentSize_ -= GetPixmapSize (item->pixmap ());
+		CurrentSize_ -= item->GetMemoryUsage ();
 		RecentlyUsed_.removeAll (item);
 	}
 
@@ -84,7 +76,7 @@ namespace Monocle
 		while (MaxSize_ < CurrentSize_ && RecentlyUsed_.size () > 2)
 		{
 			auto page = RecentlyUsed_.takeFirst ();
-			const quint64 pxSize = GetPixmapSize (page->pixmap ());
+			const quint64 pxSize = page->GetMemoryUsage ();
 			CurrentSize_ -= pxSize;
 			page->ClearPixmap ();
 		}
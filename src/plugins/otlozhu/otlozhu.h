@@ -38,6 +38,7 @@
 #endif
 
 #include <interfaces/ientityhandler.h>
+#include <interfaces/ientityroutinghints.h>
 #include <interfaces/ihavesettings.h>
 
 namespace LeechCraft
@@ -51,12 +52,13 @@ namespace Otlozhu
 					, public IHaveTabs
 					, public IHaveSettings
 					, public IEntityHandler
+					, public IEntityRoutingHints
 #ifndef DISABLE_SYNC
 					, public ISyncable
 #endif
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IHaveTabs IEntityHandler IHaveSettings)
+		Q_INTERFACES (IInfo IHaveTabs IEntityHandler IEntityRoutingHints IHaveSettings)
 #ifndef DISABLE_SYNC
 		Q_INTERFACES (ISyncable)
 #endif
@@ -85,6 +87,8 @@ namespace Otlozhu
 		EntityTestHandleResult CouldHandle (const Entity&) const;
 		void Handle (Entity);
 
+		EntityRoutingKeys GetEntityRoutingKeys () const;
+
 		Util::XmlSettingsDialog_ptr GetSettingsDialog () const;
 
 #ifndef DISABLE_SYNC
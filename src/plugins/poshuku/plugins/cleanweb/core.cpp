@@ -33,6 +33,7 @@
 #include <QNetworkRequest>
 #include <QRegExp>
 #include <QFile>
+#include <QCryptographicHash>
 #include <QSettings>
 #include <QFileInfo>
 #include <QTimer>
@@ -44,8 +45,8 @@
 #include <qwebelement.h>
 #include <QCoreApplication>
 #include <QtConcurrentRun>
-#include <QtConcurrentMap>
 #include <QFutureWatcher>
+#include <QElapsedTimer>
 #include <QMenu>
 #include <QMainWindow>
 #include <QDir>
@@ -68,7 +69,6 @@
 Q_DECLARE_METATYPE (QNetworkReply*);
 Q_DECLARE_METATYPE (QWebFrame*);
 Q_DECLARE_METATYPE (QPointer<QWebFrame>);
-Q_DECLARE_METATYPE (LeechCraft::Poshuku::CleanWeb::HidingWorkerResult);
 
 namespace LeechCraft
 {
@@ -141,7 +141,22 @@ namespace CleanWeb
 				}
 			};
 
-		QList<Filter> ParseToFilters (const QStringList& paths)
+		Filter ParseText (const QByteArray& data)
+		{
+			QStringList rawLines = QString::fromUtf8 (data).split ('\n', QString::SkipEmptyParts);
+			if (rawLines.size ())
+				rawLines.removeAt (0);
+			QStringList lines;
+			std::transform (rawLines.begin (), rawLines.end (),
+					std::back_inserter (lines),
+					[] (const QString& t) { return t.trimmed (); });
+
+			Filter f;
+			std::for_each (lines.begin (), lines.end (), LineParser (&f));
+			return f;
+		}
+
+		QList<Filter> ParseToFilters (const QStringList& paths, const FilterCache& cache)
 		{
 			QList<Filter> result;
 			for (const auto& filePath : paths)
@@ -157,19 +172,20 @@ namespace CleanWeb
 					continue;
 				}
 
-				const auto& data = QString::fromUtf8 (file.readAll ());
-				QStringList rawLines = data.split ('\n', QString::SkipEmptyParts);
-				if (rawLines.size ())
-					rawLines.removeAt (0);
-				QStringList lines;
-				std::transform (rawLines.begin (), rawLines.end (),
-						std::back_inserter (lines),
-						[] (const QString& t) { return t.trimmed (); });
+				const auto& data = file.readAll ();
+				const auto& hash = QCryptographicHash::hash (data, QCryptographicHash::Sha1);
+				const auto& fileName = QFileInfo (filePath).fileName ();
 
 				Filter f;
-				std::for_each (lines.begin (), lines.end (), LineParser (&f));
+				if (const auto& cached = cache.Load (fileName, hash))
+					f = *cached;
+				else
+				{
+					f = ParseText (data);
+					cache.Save (fileName, hash, f);
+				}
 
-				f.SD_.Filename_ = QFileInfo (filePath).fileName ();
+				f.SD_.Filename_ = fileName;
 
 				result << f;
 			}
@@ -215,7 +231,7 @@ namespace CleanWeb
 					SIGNAL (finished ()),
 					this,
 					SLOT (handleParsed ()));
-			const auto& future = QtConcurrent::run (ParseToFilters, paths);
+			const auto& future = QtConcurrent::run (ParseToFilters, paths, FilterCache_);
 			watcher->setFuture (future);
 		}
 
@@ -224,8 +240,6 @@ namespace CleanWeb
 				this,
 				SIGNAL (gotEntity (LeechCraft::Entity)));
 
-		qRegisterMetaType<HidingWorkerResult> ("HidingWorkerResult");
-
 		connect (UserFilters_,
 				SIGNAL (filtersChanged ()),
 				this,
@@ -359,14 +373,6 @@ namespace CleanWeb
 		Remove (Filters_ [index.row ()].SD_.Filename_);
 	}
 
-	namespace
-	{
-		void RemoveElem (QWebElement elem)
-		{
-			elem.setStyleProperty ("visibility", "hidden !important");
-		}
-	}
-
 	void Core::HandleInitialLayout (QWebPage*, QWebFrame *frame)
 	{
 		QMetaObject::invokeMethod (this,
@@ -590,15 +596,6 @@ namespace CleanWeb
 		}
 	}
 
-	namespace
-	{
-		void DumbReductor (bool& res, bool value)
-		{
-			if (value)
-				res = true;
-		}
-	}
-
 	/** We test each filter until we know that we should reject it or until
 	 * it gets whitelisted.
 	 *
@@ -619,6 +616,9 @@ namespace CleanWeb
 	 *   that the '*' is prepended by the filter parsing code, not this one.
 	 *
 	 * The same is applied to the filter strings.
+	 *
+	 * Only the entries that may match the URL according to the
+	 * RuleIndex are checked.
 	 */
 	bool Core::ShouldReject (const QNetworkRequest& req) const
 	{
@@ -659,37 +659,30 @@ namespace CleanWeb
 		const auto& domainUtf8 = domain.toUtf8 ();
 		const bool isForeign = !req.rawHeader ("Referer").contains (domainUtf8);
 
-		auto matches = [=] (const QList<QList<FilterItem_ptr>>& chunks) -> bool
+		const auto& urlTokens = RuleIndex::TokenizeUrl (cinUrlUtf8);
+
+		auto matches = [&] (const RuleIndex& index) -> bool
 			{
-				return QtConcurrent::blockingMappedReduced (chunks.begin (), chunks.end (),
-						std::function<bool (const QList<FilterItem_ptr>&)>
+				return index.AnyOf (urlTokens,
+						[&] (const FilterItem_ptr& item) -> bool
 						{
-							[=] (const QList<FilterItem_ptr>& items) -> bool
-							{
-								for (const auto& item : items)
-								{
-									const auto& opt = item->Option_;
-									if (opt.AbortForeign_ && isForeign)
-										continue;
-
-									if (opt.MatchObjects_ != FilterOption::MatchObject::All &&
-											objs != FilterOption::MatchObject::All &&
-											!(objs & opt.MatchObjects_))
-										continue;
-
-									const auto& url = item->Option_.Case_ == Qt::CaseSensitive ? urlStr : cinUrlStr;
-									const auto& utf8 = item->Option_.Case_ == Qt::CaseSensitive ? urlUtf8 : cinUrlUtf8;
-									if (Matches (item, url, utf8, domain))
-										return true;
-								}
+							const auto& opt = item->Option_;
+							if (opt.AbortForeign_ && isForeign)
+								return false;
 
+							if (opt.MatchObjects_ != FilterOption::MatchObject::All &&
+									objs != FilterOption::MatchObject::All &&
+									!(objs & opt.MatchObjects_))
 								return false;
-							}
-						}, DumbReductor);
+
+							const auto& url = opt.Case_ == Qt::CaseSensitive ? urlStr : cinUrlStr;
+							const auto& utf8 = opt.Case_ == Qt::CaseSensitive ? urlUtf8 : cinUrlUtf8;
+							return Matches (item, url, utf8, domain);
+						});
 			};
-		if (matches (ExceptionsCache_))
+		if (matches (ExceptionsIndex_))
 			return false;
-		if (matches (FilterItemsCache_))
+		if (matches (FiltersIndex_))
 			return true;
 
 		return false;
@@ -731,11 +724,6 @@ namespace CleanWeb
 		regenFilterCaches ();
 	}
 
-	void Core::Parse (const QString& filePath)
-	{
-		AddFilter (ParseToFilters ({ filePath }).first ());
-	}
-
 	bool Core::Add (const QUrl& subscrUrl)
 	{
 		qDebug () << Q_FUNC_INFO << subscrUrl;
@@ -825,6 +813,7 @@ namespace CleanWeb
 		home.cd (".leechcraft");
 		home.cd ("cleanweb");
 		home.remove (fileName);
+		FilterCache_.Remove (fileName);
 
 		QList<Filter>::iterator pos = std::find_if (Filters_.begin (), Filters_.end (),
 				FilterFinder<FTFilename_> (fileName));
@@ -948,13 +937,30 @@ namespace CleanWeb
 			pj.FileName_,
 			QDateTime::currentDateTime ()
 		};
-		Parse (pj.FullName_);
 		PendingJobs_.remove (id);
-		if (!AssignSD (sd))
-			qWarning () << Q_FUNC_INFO
-				<< "could not find filter for name"
-				<< sd.Filename_;
-		WriteSettings ();
+
+		auto watcher = new QFutureWatcher<QList<Filter>> (this);
+		new Util::SlotClosure<Util::DeleteLaterPolicy>
+		{
+			[this, watcher, sd] () -> void
+			{
+				watcher->deleteLater ();
+
+				const auto& filters = watcher->result ();
+				if (!filters.isEmpty ())
+					AddFilter (filters.first ());
+
+				if (!AssignSD (sd))
+					qWarning () << Q_FUNC_INFO
+						<< "could not find filter for name"
+						<< sd.Filename_;
+				WriteSettings ();
+			},
+			watcher,
+			SIGNAL (finished ()),
+			watcher
+		};
+		watcher->setFuture (QtConcurrent::run (ParseToFilters, QStringList { pj.FullName_ }, FilterCache_));
 	}
 
 	void Core::handleJobError (int id, IDownload::Error)
@@ -973,7 +979,6 @@ namespace CleanWeb
 		const QUrl& frameUrl = frame->url ().isEmpty () ?
 				frame->baseUrl () :
 				frame->url ();
-		qDebug () << Q_FUNC_INFO << frame << frameUrl;
 		const QString& urlStr = frameUrl.toString ();
 		const auto& urlUtf8 = urlStr.toUtf8 ();
 		const QString& cinUrlStr = urlStr.toLower ();
@@ -981,33 +986,37 @@ namespace CleanWeb
 
 		const QString& domain = frameUrl.host ();
 
-		QList<Filter> allFilters = Filters_;
-		allFilters << UserFilters_->GetFilter ();
+		QElapsedTimer timer;
+		timer.start ();
 
-		auto watcher = new QFutureWatcher<HidingWorkerResult> (this);
-		connect (watcher,
-				SIGNAL (finished ()),
-				this,
-				SLOT (hidingElementsFound ()));
-		watcher->setFuture (QtConcurrent::run ([=] () -> HidingWorkerResult
-					{
-						QStringList sels;
-						for (const Filter& filter : allFilters)
-							for (const auto& item : filter.Filters_)
-							{
-								if (item->Option_.HideSelector_.isEmpty ())
-									continue;
-
-								const auto& opt = item->Option_;
-								const auto& url = opt.Case_ == Qt::CaseSensitive ? urlStr : cinUrlStr;
-								const auto& utf8 = opt.Case_ == Qt::CaseSensitive ? urlUtf8 : cinUrlUtf8;
-								if (!Matches (item, url, utf8, domain))
-									continue;
-
-								sels << item->Option_.HideSelector_;
-							}
-						return { frame, 0, sels };
-					}));
+		const auto& styleSheet = HidingIndex_.GetStyleSheet (frameUrl,
+				[&] (const FilterItem_ptr& item) -> bool
+				{
+					const auto& opt = item->Option_;
+					const auto& url = opt.Case_ == Qt::CaseSensitive ? urlStr : cinUrlStr;
+					const auto& utf8 = opt.Case_ == Qt::CaseSensitive ? urlUtf8 : cinUrlUtf8;
+					return Matches (item, url, utf8, domain);
+				});
+		const auto lookupTime = timer.nsecsElapsed ();
+
+		if (!styleSheet.isEmpty ())
+		{
+			auto root = frame->documentElement ();
+			auto head = root.findFirst ("head");
+			auto parent = head.isNull () ? root : head;
+			parent.appendInside ("<style type=\"text/css\"></style>");
+			parent.lastChild ().setPlainText (styleSheet);
+		}
+
+		qDebug () << Q_FUNC_INFO
+				<< frameUrl
+				<< "lookup took"
+				<< lookupTime / 1000
+				<< "us, injection took"
+				<< (timer.nsecsElapsed () - lookupTime) / 1000
+				<< "us for"
+				<< styleSheet.size ()
+				<< "bytes of CSS";
 
 		new Util::SlotClosure<Util::DeleteLaterPolicy>
 		{
@@ -1022,46 +1031,6 @@ namespace CleanWeb
 		};
 	}
 
-	void Core::hidingElementsFound ()
-	{
-		auto watcher = dynamic_cast<QFutureWatcher<HidingWorkerResult>*> (sender ());
-		watcher->deleteLater ();
-
-		hideElementsChunk (watcher->result ());
-
-	}
-
-	void Core::hideElementsChunk (HidingWorkerResult result)
-	{
-		if (!result.Frame_)
-			return;
-
-		const int chunkSize = 100;
-
-		auto& i = result.CurrentPos_;
-		for (auto end = std::min (i + chunkSize, result.Selectors_.size ()); i < end; ++i)
-		{
-			const auto& selector = result.Selectors_.value (i);
-
-			const auto& matchingElems = result.Frame_->findAllElements (selector);
-			if (matchingElems.count ())
-				qDebug () << "removing"
-						<< matchingElems.count ()
-						<< "elems for"
-						<< selector
-						<< result.Frame_->url ();
-
-			for (int i = matchingElems.count () - 1; i >= 0; --i)
-				RemoveElem (matchingElems.at (i));
-		}
-
-		if (result.CurrentPos_ < result.Selectors_.size ())
-			QMetaObject::invokeMethod (this,
-					"hideElementsChunk",
-					Qt::QueuedConnection,
-					Q_ARG (HidingWorkerResult, result));
-	}
-
 	namespace
 	{
 		bool RemoveElements (QWebFrame *frame, const QList<QUrl>& urls)
@@ -1124,61 +1093,39 @@ namespace CleanWeb
 
 	void Core::regenFilterCaches ()
 	{
-		ExceptionsCache_.clear ();
-		FilterItemsCache_.clear ();
-
 		QList<Filter> allFilters = Filters_;
 		allFilters << UserFilters_->GetFilter ();
 
-		int exceptionsCount = 0;
-		int filtersCount = 0;
-		for (const Filter& filter : allFilters)
-		{
-			exceptionsCount += filter.Exceptions_.size ();
-			filtersCount += filter.Filters_.size ();
-		}
-
-		auto idealThreads = std::max (QThread::idealThreadCount (), 2);
-
-		const int exChunkSize = std::max (exceptionsCount / idealThreads / 4, 200);
-		const int fChunkSize = std::max (filtersCount / idealThreads / 4, 200);
-		qDebug () << Q_FUNC_INFO << exceptionsCount << filtersCount << exChunkSize << fChunkSize;
-
-		QList<FilterItem_ptr> lastItemsChunk, lastExceptionsChunk;
-		lastItemsChunk.reserve (fChunkSize);
-		lastExceptionsChunk.reserve (exChunkSize);
-
+		QList<FilterItem_ptr> exceptions;
+		QList<FilterItem_ptr> filters;
+		QList<FilterItem_ptr> hiding;
 		for (const Filter& filter : allFilters)
 		{
 			for (const auto& item : filter.Exceptions_)
 				if (item->Option_.HideSelector_.isEmpty ())
-				{
-					lastExceptionsChunk << item;
-					if (lastExceptionsChunk.size () >= exChunkSize)
-					{
-						ExceptionsCache_ << lastExceptionsChunk;
-						lastExceptionsChunk.clear ();
-					}
-				}
+					exceptions << item;
 
 			for (const auto& item : filter.Filters_)
-			{
-				if (!item->Option_.HideSelector_.isEmpty ())
-					continue;
-
-				lastItemsChunk << item;
-				if (lastItemsChunk.size () >= fChunkSize)
-				{
-					FilterItemsCache_ << lastItemsChunk;
-					lastItemsChunk.clear ();
-				}
-			}
+				if (item->Option_.HideSelector_.isEmpty ())
+					filters << item;
+				else
+					hiding << item;
 		}
 
-		if (!lastItemsChunk.isEmpty ())
-			ExceptionsCache_ << lastItemsChunk;
-		if (!lastExceptionsChunk.isEmpty ())
-			FilterItemsCache_ << lastExceptionsChunk;
+		ExceptionsIndex_ = RuleIndex { exceptions };
+		FiltersIndex_ = RuleIndex { filters };
+		HidingIndex_ = HidingIndex { hiding };
+
+		qDebug () << Q_FUNC_INFO
+				<< "exceptions:"
+				<< ExceptionsIndex_.GetTokenizedCount ()
+				<< "indexed,"
+				<< ExceptionsIndex_.GetUntokenizedCount ()
+				<< "unindexed; filters:"
+				<< FiltersIndex_.GetTokenizedCount ()
+				<< "indexed,"
+				<< FiltersIndex_.GetUntokenizedCount ()
+				<< "unindexed";
 	}
 }
 }
@@ -40,6 +40,9 @@
 #include <interfaces/poshuku/poshukutypes.h>
 #include <interfaces/core/ihookproxy.h>
 #include "filter.h"
+#include "ruleindex.h"
+#include "filtercache.h"
+#include "hidingindex.h"
 
 class QNetworkRequest;
 class QWebPage;
@@ -56,14 +59,6 @@ namespace CleanWeb
 	class FlashOnClickWhitelist;
 	class UserFiltersModel;
 
-
-	struct HidingWorkerResult
-	{
-		QPointer<QWebFrame> Frame_;
-		int CurrentPos_;
-		QStringList Selectors_;
-	};
-
 	class Core : public QAbstractItemModel
 	{
 		Q_OBJECT
@@ -73,9 +68,11 @@ namespace CleanWeb
 		UserFiltersModel *UserFilters_;
 
 		QList<Filter> Filters_;
+		const FilterCache FilterCache_;
 
-		QList<QList<FilterItem_ptr>> ExceptionsCache_;
-		QList<QList<FilterItem_ptr>> FilterItemsCache_;
+		RuleIndex ExceptionsIndex_;
+		RuleIndex FiltersIndex_;
+		HidingIndex HidingIndex_;
 
 		QObjectList Downloaders_;
 		QStringList HeaderLabels_;
@@ -170,7 +167,6 @@ namespace CleanWeb
 		void HandleProvider (QObject*);
 
 		void AddFilter (const Filter&);
-		void Parse (const QString&);
 
 		/** Removes the subscription at
 		 * ~/.leechcraft/cleanweb/filename.
@@ -185,8 +181,6 @@ namespace CleanWeb
 		void handleJobFinished (int);
 		void handleJobError (int, IDownload::Error);
 		void handleFrameLayout (QPointer<QWebFrame>);
-		void hidingElementsFound ();
-		void hideElementsChunk (HidingWorkerResult);
 		void delayedRemoveElements (QPointer<QWebFrame>, const QUrl&);
 		void moreDelayedRemoveElements ();
 		void handleFrameDestroyed ();
@@ -39,13 +39,15 @@ namespace CleanWeb
 {
 	QDataStream& operator<< (QDataStream& out, const FilterOption& opt)
 	{
-		qint8 version = 2;
+		qint8 version = 3;
 		out << version
 			<< static_cast<qint8> (opt.Case_)
 			<< static_cast<qint8> (opt.MatchType_)
 			<< opt.Domains_
 			<< opt.NotDomains_
-			<< opt.AbortForeign_;
+			<< opt.AbortForeign_
+			<< static_cast<qint32> (opt.MatchObjects_)
+			<< opt.HideSelector_;
 		return out;
 	}
 
@@ -54,7 +56,7 @@ namespace CleanWeb
 		qint8 version = 0;
 		in >> version;
 
-		if (version < 1 || version > 2)
+		if (version < 1 || version > 3)
 		{
 			qWarning () << Q_FUNC_INFO
 				<< "unknown version"
@@ -77,6 +79,13 @@ namespace CleanWeb
 		}
 		if (version >= 2)
 			in >> opt.AbortForeign_;
+		if (version >= 3)
+		{
+			qint32 objs = 0;
+			in >> objs
+				>> opt.HideSelector_;
+			opt.MatchObjects_ = FilterOption::MatchObjects (objs);
+		}
 
 		return in;
 	}
@@ -138,7 +147,8 @@ namespace CleanWeb
 			QString str;
 			quint8 cs;
 			in >> str >> cs;
-			item.RegExp_ = Util::RegExp (str, static_cast<Qt::CaseSensitivity> (cs));
+			if (!str.isEmpty ())
+				item.RegExp_ = Util::RegExp (str, static_cast<Qt::CaseSensitivity> (cs));
 		}
 		in >> item.Option_;
 		return in;
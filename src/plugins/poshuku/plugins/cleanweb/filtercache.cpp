@@ -0,0 +1,190 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "filtercache.h"
+#include <memory>
+#include <QFile>
+#include <QDataStream>
+#include <QtDebug>
+#include <util/sys/paths.h>
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace CleanWeb
+{
+	namespace
+	{
+		const QByteArray Magic { "LCCWFC" };
+
+		/* Bump this whenever the LineParser output or the FilterItem
+		 * serialization changes.
+		 */
+		const quint8 CacheVersion = 1;
+
+		QList<FilterItem_ptr> ReadItems (QDataStream& in)
+		{
+			qint32 count = 0;
+			in >> count;
+
+			QList<FilterItem_ptr> result;
+			result.reserve (count);
+			for (qint32 i = 0; i < count && in.status () == QDataStream::Ok; ++i)
+			{
+				const auto& item = std::make_shared<FilterItem> ();
+				in >> *item;
+				result << item;
+			}
+			return result;
+		}
+
+		void WriteItems (QDataStream& out, const QList<FilterItem_ptr>& items)
+		{
+			out << static_cast<qint32> (items.size ());
+			for (const auto& item : items)
+				out << *item;
+		}
+	}
+
+	FilterCache::FilterCache ()
+	{
+		try
+		{
+			Dir_ = Util::GetUserDir (Util::UserDir::Cache, "poshuku/cleanweb");
+			IsValid_ = true;
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to get the cache directory, cache disabled:"
+					<< e.what ();
+		}
+	}
+
+	boost::optional<Filter> FilterCache::Load (const QString& name, const QByteArray& hash) const
+	{
+		if (!IsValid_)
+			return {};
+
+		QFile file { Dir_.filePath (name) };
+		if (!file.exists ())
+			return {};
+
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return {};
+		}
+
+		const auto size = file.size ();
+		const auto mapped = file.map (0, size);
+		const auto& data = mapped ?
+				QByteArray::fromRawData (reinterpret_cast<const char*> (mapped), size) :
+				file.readAll ();
+
+		QDataStream in { data };
+		in.setVersion (QDataStream::Qt_4_8);
+
+		QByteArray magic;
+		quint8 version = 0;
+		QByteArray cachedHash;
+		in >> magic >> version >> cachedHash;
+		if (magic != Magic || version != CacheVersion || cachedHash != hash)
+			return {};
+
+		Filter filter;
+		filter.Filters_ = ReadItems (in);
+		filter.Exceptions_ = ReadItems (in);
+
+		if (in.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "corrupted cache"
+					<< file.fileName ();
+			return {};
+		}
+
+		return filter;
+	}
+
+	void FilterCache::Save (const QString& name, const QByteArray& hash, const Filter& filter) const
+	{
+		if (!IsValid_)
+			return;
+
+		const auto& path = Dir_.filePath (name);
+		QFile file { path + ".new" };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream out { &file };
+		out.setVersion (QDataStream::Qt_4_8);
+		out << Magic << CacheVersion << hash;
+		WriteItems (out, filter.Filters_);
+		WriteItems (out, filter.Exceptions_);
+		file.close ();
+
+		if (out.status () != QDataStream::Ok || file.error () != QFile::NoError)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write"
+					<< file.fileName ()
+					<< file.errorString ();
+			file.remove ();
+			return;
+		}
+
+		QFile::remove (path);
+		if (!file.rename (path))
+			qWarning () << Q_FUNC_INFO
+					<< "unable to rename"
+					<< file.fileName ()
+					<< "to"
+					<< path
+					<< file.errorString ();
+	}
+
+	void FilterCache::Remove (const QString& name) const
+	{
+		if (IsValid_)
+			QFile::remove (Dir_.filePath (name));
+	}
+}
+}
+}
@@ -0,0 +1,71 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <QDir>
+#include "filter.h"
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace CleanWeb
+{
+	/** Stores the already parsed subscriptions in a binary form, so
+	 * that they don't need to be parsed by the LineParser on each
+	 * startup.
+	 *
+	 * Each subscription is cached in its own file along with the hash
+	 * of the subscription text it was parsed from. A cached
+	 * subscription is used only if this hash matches the current text
+	 * and the cache format version matches the current one.
+	 *
+	 * All the methods are reentrant, so this class may be freely used
+	 * from the worker threads.
+	 */
+	class FilterCache
+	{
+		QDir Dir_;
+		bool IsValid_ = false;
+	public:
+		FilterCache ();
+
+		/** Returns the filter parsed from the subscription with the
+		 * given file name and text hash, if the cache has it.
+		 */
+		boost::optional<Filter> Load (const QString& name, const QByteArray& hash) const;
+
+		void Save (const QString& name, const QByteArray& hash, const Filter&) const;
+		void Remove (const QString& name) const;
+	};
+}
+}
+}
@@ -0,0 +1,153 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "hidingindex.h"
+#include <algorithm>
+#include <QUrl>
+#include <QSet>
+#include <QRegExp>
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace CleanWeb
+{
+	namespace
+	{
+		QString MakeRule (const QString& selector)
+		{
+			return selector + " { visibility: hidden !important; }\n";
+		}
+
+		/* Selectors come from third-party lists and are pasted into a
+		 * stylesheet as is, so a selector that could close the rule or
+		 * the style element is never trusted.
+		 */
+		bool IsSafeSelector (const QString& selector)
+		{
+			return !selector.contains ('<') &&
+					!selector.contains ('{') &&
+					!selector.contains ('}');
+		}
+
+		bool MatchesDomain (const QString& host, const QString& domain)
+		{
+			return host.endsWith (domain) &&
+					(host.size () == domain.size () ||
+						host.at (host.size () - domain.size () - 1) == '.');
+		}
+
+		bool IsExcluded (const QString& host, const QStringList& notDomains)
+		{
+			return std::any_of (notDomains.begin (), notDomains.end (),
+					[&host] (const QString& domain) { return MatchesDomain (host, domain); });
+		}
+
+		bool IsDomainList (const QByteArray& pattern)
+		{
+			static const QRegExp rx { "^[a-z0-9.,~_-]+$" };
+			return rx.exactMatch (QString::fromUtf8 (pattern));
+		}
+	}
+
+	HidingIndex::HidingIndex (const QList<FilterItem_ptr>& items)
+	{
+		for (const auto& item : items)
+		{
+			const auto& opt = item->Option_;
+			if (!IsSafeSelector (opt.HideSelector_))
+				continue;
+
+			const auto& pattern = item->PlainMatcher_.toLower ();
+
+			const bool simple = opt.MatchType_ == FilterOption::MTPlain &&
+					opt.Domains_.isEmpty () &&
+					opt.NotDomains_.isEmpty ();
+			if (!simple || !(pattern.isEmpty () || IsDomainList (pattern)))
+			{
+				Other_ << item;
+				continue;
+			}
+
+			QStringList domains;
+			Entry entry { opt.HideSelector_, {} };
+			for (const auto& domain : QString::fromUtf8 (pattern).split (',', QString::SkipEmptyParts))
+				if (domain.startsWith ('~'))
+					entry.NotDomains_ << domain.mid (1);
+				else
+					domains << domain;
+
+			if (!domains.isEmpty ())
+				for (const auto& domain : domains)
+					Domain2Entries_ [domain] << entry;
+			else if (!entry.NotDomains_.isEmpty ())
+				GenericExcept_ << entry;
+			else
+				GenericStyleSheet_ += MakeRule (entry.Selector_);
+		}
+	}
+
+	QString HidingIndex::GetStyleSheet (const QUrl& url, const Matcher_f& matcher) const
+	{
+		const auto& host = url.host ().toLower ();
+
+		QStringList selectors;
+
+		for (const auto& entry : GenericExcept_)
+			if (!IsExcluded (host, entry.NotDomains_))
+				selectors << entry.Selector_;
+
+		for (int pos = 0; pos >= 0; )
+		{
+			const auto& suffix = host.mid (pos);
+			if (!suffix.isEmpty ())
+				for (const auto& entry : Domain2Entries_.value (suffix))
+					if (!IsExcluded (host, entry.NotDomains_))
+						selectors << entry.Selector_;
+
+			pos = host.indexOf ('.', pos);
+			if (pos >= 0)
+				++pos;
+		}
+
+		for (const auto& item : Other_)
+			if (matcher (item))
+				selectors << item->Option_.HideSelector_;
+
+		selectors.removeDuplicates ();
+
+		auto result = GenericStyleSheet_;
+		for (const auto& selector : selectors)
+			result += MakeRule (selector);
+		return result;
+	}
+}
+}
+}
@@ -0,0 +1,86 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <functional>
+#include <QHash>
+#include <QStringList>
+#include "filter.h"
+
+class QUrl;
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace CleanWeb
+{
+	/** Maps the hosts to the element hiding selectors that should be
+	 * applied to the pages from them.
+	 *
+	 * The generic selectors (the ones without any domains) are
+	 * combined into a single stylesheet once, when the index is built.
+	 * The domain-specific selectors are looked up by each suffix of
+	 * the page host, so the lookup costs a hash lookup per host label.
+	 * The rare items whose pattern isn't a list of domains are checked
+	 * against the page URL one by one.
+	 *
+	 * Selectors containing <code>&lt;</code>, <code>{</code> or
+	 * <code>}</code> are dropped, as they could break out of their rule.
+	 */
+	class HidingIndex
+	{
+		struct Entry
+		{
+			QString Selector_;
+			QStringList NotDomains_;
+		};
+
+		QString GenericStyleSheet_;
+		QHash<QString, QList<Entry>> Domain2Entries_;
+		QList<Entry> GenericExcept_;
+		QList<FilterItem_ptr> Other_;
+	public:
+		typedef std::function<bool (FilterItem_ptr)> Matcher_f;
+
+		HidingIndex () = default;
+		HidingIndex (const QList<FilterItem_ptr>&);
+
+		/** Returns the stylesheet hiding the elements that should be
+		 * hidden on the page with the given URL.
+		 *
+		 * The matcher is used to check the items that are not indexed
+		 * by domain against the URL.
+		 */
+		QString GetStyleSheet (const QUrl&, const Matcher_f& matcher) const;
+	};
+}
+}
+}
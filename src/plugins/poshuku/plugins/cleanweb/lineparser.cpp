@@ -175,6 +175,7 @@ namespace CleanWeb
 				if (!Util::RegExp::IsFast ())
 					return;
 
+				actualLine.replace ('.', "\\.");
 				actualLine.replace ('*', ".*");
 				if (f.MatchType_ != FilterOption::MTWildcard)
 					actualLine.replace ('?', "\\?");
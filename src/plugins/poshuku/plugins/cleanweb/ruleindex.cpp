@@ -0,0 +1,314 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "ruleindex.h"
+#include <algorithm>
+#include <cctype>
+#include <QSet>
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace CleanWeb
+{
+	namespace
+	{
+		bool IsTokenChar (char c)
+		{
+			return (c >= 'a' && c <= 'z') ||
+					(c >= '0' && c <= '9') ||
+					c == '%';
+		}
+
+		char ToLowerAscii (char c)
+		{
+			return c >= 'A' && c <= 'Z' ?
+					c - 'A' + 'a' :
+					c;
+		}
+
+		/* A pattern is first split into atoms: the characters it
+		 * matches literally and the parts that may match varying
+		 * characters (wildcards, character classes, quantified atoms).
+		 * A literal non-token character bounds a token, while the
+		 * varying parts make the adjacent runs useless, since a longer
+		 * URL token may match there.
+		 */
+		struct Atom
+		{
+			enum class Kind
+			{
+				Char,
+				Separator,
+				Any
+			} Kind_;
+
+			char Char_;
+		};
+
+		Atom MakeLiteral (char c)
+		{
+			c = ToLowerAscii (c);
+			return IsTokenChar (c) ?
+					Atom { Atom::Kind::Char, c } :
+					Atom { Atom::Kind::Separator, 0 };
+		}
+
+		const Atom AnyAtom { Atom::Kind::Any, 0 };
+		const Atom SeparatorAtom { Atom::Kind::Separator, 0 };
+
+		QList<Atom> ParseLiteral (const QByteArray& pattern, FilterOption::MatchType type)
+		{
+			QList<Atom> atoms;
+
+			const bool isWildcard = type == FilterOption::MTWildcard;
+			if (type == FilterOption::MTBegin || (isWildcard && !pattern.startsWith ('*')))
+				atoms << SeparatorAtom;
+
+			for (int i = 0; i < pattern.size (); ++i)
+			{
+				const char c = pattern.at (i);
+				if (!isWildcard)
+					atoms << MakeLiteral (c);
+				else if (c == '*' || c == '?')
+					atoms << AnyAtom;
+				else if (c == '\\' && i + 1 < pattern.size ())
+					atoms << MakeLiteral (pattern.at (++i));
+				else if (c == '[')
+				{
+					const int end = pattern.indexOf (']', i + 1);
+					if (end < 0)
+						return {};
+					atoms << AnyAtom;
+					i = end;
+				}
+				else
+					atoms << MakeLiteral (c);
+			}
+
+			if (type == FilterOption::MTEnd || (isWildcard && !pattern.endsWith ('*')))
+				atoms << SeparatorAtom;
+
+			return atoms;
+		}
+
+		/* Only the subset of regexps produced by the LineParser from
+		 * the ^-containing rules is handled precisely. Alternations
+		 * and groups make the whole regexp untokenizable.
+		 */
+		QList<Atom> ParseRegexp (const QByteArray& pattern)
+		{
+			static const QByteArray SeparatorClass { "[^a-zA-Z0-9_\\.%-]" };
+
+			QList<Atom> atoms;
+			for (int i = 0; i < pattern.size (); ++i)
+			{
+				const char c = pattern.at (i);
+				switch (c)
+				{
+				case '|':
+				case '(':
+				case ')':
+					return {};
+				case '\\':
+					if (++i >= pattern.size ())
+						return {};
+					if (std::isalnum (static_cast<unsigned char> (pattern.at (i))))
+						atoms << AnyAtom;
+					else
+						atoms << MakeLiteral (pattern.at (i));
+					break;
+				case '.':
+					atoms << AnyAtom;
+					break;
+				case '^':
+					atoms << (i ? AnyAtom : SeparatorAtom);
+					break;
+				case '$':
+					atoms << (i == pattern.size () - 1 ? SeparatorAtom : AnyAtom);
+					break;
+				case '[':
+				{
+					if (pattern.mid (i, SeparatorClass.size ()) == SeparatorClass)
+					{
+						atoms << SeparatorAtom;
+						i += SeparatorClass.size () - 1;
+						break;
+					}
+
+					const int end = pattern.indexOf (']', i + 2);
+					if (end < 0)
+						return {};
+					atoms << AnyAtom;
+					i = end;
+					break;
+				}
+				case '*':
+				case '+':
+				case '?':
+				case '{':
+					if (!atoms.isEmpty ())
+						atoms.last () = AnyAtom;
+					if (c == '{')
+					{
+						i = pattern.indexOf ('}', i);
+						if (i < 0)
+							return {};
+					}
+					break;
+				default:
+					atoms << MakeLiteral (c);
+					break;
+				}
+			}
+			return atoms;
+		}
+
+		QList<QByteArray> ExtractTokens (const QList<Atom>& atoms)
+		{
+			QList<QByteArray> result;
+
+			QByteArray run;
+			bool leftBounded = false;
+			for (const auto& atom : atoms)
+				switch (atom.Kind_)
+				{
+				case Atom::Kind::Char:
+					run += atom.Char_;
+					break;
+				case Atom::Kind::Separator:
+					if (leftBounded && run.size () >= 2 && !result.contains (run))
+						result << run;
+					run.clear ();
+					leftBounded = true;
+					break;
+				case Atom::Kind::Any:
+					run.clear ();
+					leftBounded = false;
+					break;
+				}
+
+			return result;
+		}
+
+		QList<QByteArray> GetTokens (const FilterItem& item)
+		{
+			const auto& atoms = item.Option_.MatchType_ == FilterOption::MTRegexp ?
+					ParseRegexp (item.RegExp_.GetPattern ().toUtf8 ()) :
+					ParseLiteral (item.PlainMatcher_, item.Option_.MatchType_);
+			return ExtractTokens (atoms);
+		}
+
+		bool IsCommonToken (const QByteArray& token)
+		{
+			static const QSet<QByteArray> common { "http", "https", "www", "com" };
+			return common.contains (token);
+		}
+	}
+
+	RuleIndex::RuleIndex (const QList<FilterItem_ptr>& items)
+	{
+		QList<QList<QByteArray>> itemsTokens;
+		itemsTokens.reserve (items.size ());
+
+		QHash<QByteArray, int> frequencies;
+		for (const auto& item : items)
+		{
+			itemsTokens << GetTokens (*item);
+			for (const auto& token : itemsTokens.last ())
+				++frequencies [token];
+		}
+
+		auto isBetter = [&frequencies] (const QByteArray& t1, const QByteArray& t2)
+		{
+			if (IsCommonToken (t1) != IsCommonToken (t2))
+				return IsCommonToken (t2);
+
+			const auto f1 = frequencies.value (t1);
+			const auto f2 = frequencies.value (t2);
+			if (f1 != f2)
+				return f1 < f2;
+
+			return t1.size () > t2.size ();
+		};
+
+		for (int i = 0; i < items.size (); ++i)
+		{
+			const auto& tokens = itemsTokens.at (i);
+			if (tokens.isEmpty ())
+			{
+				Untokenized_ << items.at (i);
+				continue;
+			}
+
+			const auto& best = *std::min_element (tokens.begin (), tokens.end (), isBetter);
+			Token2Items_ [best] << items.at (i);
+		}
+	}
+
+	QList<QByteArray> RuleIndex::TokenizeUrl (const QByteArray& lowerUrl)
+	{
+		QList<QByteArray> result;
+
+		const auto data = lowerUrl.constData ();
+		const int size = lowerUrl.size ();
+		int start = -1;
+		for (int i = 0; i <= size; ++i)
+		{
+			const bool isToken = i < size && IsTokenChar (data [i]);
+			if (isToken && start < 0)
+				start = i;
+			else if (!isToken && start >= 0)
+			{
+				const auto& token = QByteArray::fromRawData (data + start, i - start);
+				if (!result.contains (token))
+					result << token;
+				start = -1;
+			}
+		}
+
+		return result;
+	}
+
+	int RuleIndex::GetTokenizedCount () const
+	{
+		int result = 0;
+		for (const auto& list : Token2Items_)
+			result += list.size ();
+		return result;
+	}
+
+	int RuleIndex::GetUntokenizedCount () const
+	{
+		return Untokenized_.size ();
+	}
+}
+}
+}
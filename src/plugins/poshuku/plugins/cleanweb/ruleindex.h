@@ -0,0 +1,98 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QByteArray>
+#include "filter.h"
+
+namespace LeechCraft
+{
+namespace Poshuku
+{
+namespace CleanWeb
+{
+	/** Indexes the filter items by a literal token each of them
+	 * requires the URL to contain, so that only a handful of items
+	 * should be actually checked against a given URL.
+	 *
+	 * A token is a maximal run of ASCII letters, digits and percent
+	 * signs. Both the filter patterns and the URLs are tokenized
+	 * case-insensitively. An item is indexed by the token of its
+	 * pattern that's the rarest among all the items in the index. The
+	 * items without any suitable token (like the regexps with
+	 * alternations) are checked against every URL.
+	 */
+	class RuleIndex
+	{
+		QHash<QByteArray, QList<FilterItem_ptr>> Token2Items_;
+		QList<FilterItem_ptr> Untokenized_;
+	public:
+		RuleIndex () = default;
+		RuleIndex (const QList<FilterItem_ptr>&);
+
+		/** Returns the distinct tokens of the given lowercased URL.
+		 *
+		 * The returned byte arrays share the data with the passed URL,
+		 * so the URL should outlive them.
+		 */
+		static QList<QByteArray> TokenizeUrl (const QByteArray& lowerUrl);
+
+		/** Returns whether the given predicate holds for any of the
+		 * items that may match an URL with the given tokens.
+		 */
+		template<typename F>
+		bool AnyOf (const QList<QByteArray>& urlTokens, const F& pred) const
+		{
+			for (const auto& item : Untokenized_)
+				if (pred (item))
+					return true;
+
+			for (const auto& token : urlTokens)
+			{
+				const auto pos = Token2Items_.find (token);
+				if (pos == Token2Items_.end ())
+					continue;
+
+				for (const auto& item : *pos)
+					if (pred (item))
+						return true;
+			}
+
+			return false;
+		}
+
+		int GetTokenizedCount () const;
+		int GetUntokenizedCount () const;
+	};
+}
+}
+}
@@ -32,6 +32,7 @@
 #include <QSqlDatabase>
 #include <QSqlError>
 #include <QSqlQuery>
+#include <QSqlRecord>
 #include <QtDebug>
 #include <util/db/dblock.h>
 #include <util/sll/qtutil.h>
@@ -132,6 +133,54 @@ namespace Snails
 		return result;
 	}
 
+	QHash<QByteArray, bool> AccountDatabase::GetReadStatuses (const QStringList& folder)
+	{
+		QueryGetReadStatuses_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryGetReadStatuses_);
+
+		QHash<QByteArray, bool> result;
+		while (QueryGetReadStatuses_.next ())
+			result [QueryGetReadStatuses_.value (0).toByteArray ()] = QueryGetReadStatuses_.value (1).toBool ();
+		QueryGetReadStatuses_.finish ();
+		return result;
+	}
+
+	boost::optional<FolderSyncState> AccountDatabase::GetFolderSyncState (const QStringList& folder)
+	{
+		if (!KnownFolders_.contains (folder))
+			return {};
+
+		QueryGetSyncState_.bindValue (":folderId", GetFolder (folder));
+		Util::DBLock::Execute (QueryGetSyncState_);
+
+		const std::shared_ptr<void> finishGuard
+		{
+			nullptr,
+			[this] (void*) { QueryGetSyncState_.finish (); }
+		};
+
+		if (!QueryGetSyncState_.next ())
+			return {};
+
+		return FolderSyncState
+		{
+			QueryGetSyncState_.value (0).value<quint32> (),
+			QueryGetSyncState_.value (1).value<quint64> (),
+			QueryGetSyncState_.value (2).value<quint32> (),
+			QueryGetSyncState_.value (3).value<quint32> ()
+		};
+	}
+
+	void AccountDatabase::SetFolderSyncState (const QStringList& folder, const FolderSyncState& state)
+	{
+		QuerySetSyncState_.bindValue (":folderId", AddFolder (folder));
+		QuerySetSyncState_.bindValue (":uidValidity", static_cast<qint64> (state.UIDValidity_));
+		QuerySetSyncState_.bindValue (":highestModSeq", static_cast<qint64> (state.HighestModSeq_));
+		QuerySetSyncState_.bindValue (":uidNext", static_cast<qint64> (state.UIDNext_));
+		QuerySetSyncState_.bindValue (":messagesCount", static_cast<qint64> (state.MessagesCount_));
+		Util::DBLock::Execute (QuerySetSyncState_);
+	}
+
 	boost::optional<int> AccountDatabase::GetMsgTableId (const QByteArray& uniqueId)
 	{
 		if (uniqueId.isEmpty ())
@@ -265,8 +314,25 @@ namespace Snails
 					FolderMessageId TEXT NOT NULL
 					)
 				)d";
+		table2queries ["folder_sync_state"] <<
+				R"d(
+					CREATE TABLE folder_sync_state (
+					FolderId INTEGER PRIMARY KEY REFERENCES folders (Id) ON DELETE CASCADE,
+					UidValidity INTEGER NOT NULL,
+					HighestModSeq INTEGER NOT NULL,
+					UidNext INTEGER NOT NULL,
+					MessagesCount INTEGER NOT NULL
+					)
+				)d";
 
 		QSqlQuery query { *DB_ };
+
+		// The sync state is just a cache, so it's fine to drop the one
+		// without the messages count and do a full sync.
+		if (DB_->tables ().contains ("folder_sync_state") &&
+				!DB_->record ("folder_sync_state").contains ("MessagesCount"))
+			query.exec ("DROP TABLE folder_sync_state;");
+
 		for (const auto& pair : Util::Stlize (table2queries))
 			if (!DB_->tables ().contains (pair.first))
 				for (const auto& queryStr : pair.second)
@@ -322,6 +388,28 @@ namespace Snails
 		QueryAddFolder_ = QSqlQuery { *DB_ };
 		QueryAddFolder_.prepare ("INSERT INTO folders (FolderPath) VALUES (:path);");
 
+		QueryGetReadStatuses_ = QSqlQuery { *DB_ };
+		QueryGetReadStatuses_.prepare (R"d(
+					SELECT msg2folder.FolderMessageId, messages.IsRead FROM msg2folder, folders, messages
+					WHERE folders.FolderPath = :path
+					AND folders.Id = msg2folder.FolderId
+					AND messages.Id = msg2folder.MsgId
+				)d");
+
+		QueryGetSyncState_ = QSqlQuery { *DB_ };
+		QueryGetSyncState_.prepare (R"d(
+					SELECT UidValidity, HighestModSeq, UidNext, MessagesCount FROM folder_sync_state
+					WHERE FolderId = :folderId
+				)d");
+
+		QuerySetSyncState_ = QSqlQuery { *DB_ };
+		QuerySetSyncState_.prepare (R"d(
+					INSERT OR REPLACE INTO folder_sync_state
+					(FolderId, UidValidity, HighestModSeq, UidNext, MessagesCount)
+					VALUES
+					(:folderId, :uidValidity, :highestModSeq, :uidNext, :messagesCount)
+				)d");
+
 		QueryGetMsgTableIdByFolder_ = QSqlQuery { *DB_ };
 		QueryGetMsgTableIdByFolder_.prepare (R"d(
 					SELECT msg2folder.MsgId FROM msg2folder, folders
@@ -35,6 +35,8 @@
 #include <QSqlQuery>
 #include <QStringList>
 #include <QMap>
+#include <QHash>
+#include "foldersyncstate.h"
 
 class QSqlDatabase;
 typedef std::shared_ptr<QSqlDatabase> QSqlDatabase_ptr;
@@ -60,6 +62,9 @@ namespace Snails
 		QSqlQuery QueryGetTotalCount_;
 		QSqlQuery QueryRemoveMessage_;
 		QSqlQuery QueryAddFolder_;
+		QSqlQuery QueryGetReadStatuses_;
+		QSqlQuery QueryGetSyncState_;
+		QSqlQuery QuerySetSyncState_;
 
 		/* Returns the primary key of a message by its
 		 * folder-local ID and folder path.
@@ -85,6 +90,11 @@ namespace Snails
 		int GetUnreadMessageCount (const QStringList& folder);
 		int GetMessageCount ();
 
+		QHash<QByteArray, bool> GetReadStatuses (const QStringList& folder);
+
+		boost::optional<FolderSyncState> GetFolderSyncState (const QStringList& folder);
+		void SetFolderSyncState (const QStringList& folder, const FolderSyncState& state);
+
 		void AddMessage (const Message_ptr&);
 		void RemoveMessage (const QByteArray& msgId, const QStringList& folder,
 				const std::function<void ()>& continuation = {});
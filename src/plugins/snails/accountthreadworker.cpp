@@ -35,6 +35,7 @@
 #include <QSslSocket>
 #include <QtDebug>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <vmime/security/defaultAuthenticator.hpp>
 #include <vmime/security/cert/defaultCertificateVerifier.hpp>
 #include <vmime/security/cert/X509Certificate.hpp>
@@ -49,6 +50,7 @@
 #include <vmime/stringContentHandler.hpp>
 #include <vmime/fileAttachment.hpp>
 #include <vmime/messageIdSequence.hpp>
+#include <vmime/net/imap/IMAPFolderStatus.hpp>
 #include <util/util.h>
 #include <util/xpc/util.h>
 #include "message.h"
@@ -56,6 +58,7 @@
 #include "core.h"
 #include "progresslistener.h"
 #include "storage.h"
+#include "accountdatabase.h"
 #include "vmimeconversions.h"
 #include "outputiodevadapter.h"
 #include "common.h"
@@ -582,6 +585,34 @@ namespace Snails
 		}
 	}
 
+	namespace
+	{
+		boost::optional<FolderSyncState> GetServerSyncState (const VmimeFolder_ptr& folder)
+		{
+			try
+			{
+				const auto& status = vmime::dynamicCast<vmime::net::imap::IMAPFolderStatus> (folder->getStatus ());
+				if (!status)
+					return {};
+
+				return FolderSyncState
+				{
+					status->getUIDValidity (),
+					status->getHighestModSeq (),
+					status->getUIDNext (),
+					static_cast<quint32> (status->getMessageCount ())
+				};
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to get folder status:"
+						<< e.what ();
+				return {};
+			}
+		}
+	}
+
 	QList<Message_ptr> AccountThreadWorker::FetchVmimeMessages (MessageVector_t messages,
 			const VmimeFolder_ptr& folder, const QStringList& folderName)
 	{
@@ -642,25 +673,70 @@ namespace Snails
 
 		qDebug () << Q_FUNC_INFO << folderName << folder.get () << lastId;
 
+		QElapsedTimer timer;
+		timer.start ();
+
+		const auto storage = Core::Instance ().GetStorage ();
+
+		const auto& serverState = lastId.isEmpty () ?
+				GetServerSyncState (folder) :
+				boost::optional<FolderSyncState> {};
+		if (serverState)
+		{
+			const auto& storedState = storage->GetFolderSyncState (A_, folderName);
+			if (CanSyncIncrementally (storedState, *serverState))
+			{
+				if (SyncFolderChanges (folderName, folder, *storedState, *serverState))
+				{
+					storage->SetFolderSyncState (A_, folderName, *serverState);
+					qDebug () << Q_FUNC_INFO
+							<< "incrementally synced"
+							<< folderName
+							<< "in"
+							<< timer.elapsed ()
+							<< "ms";
+					return;
+				}
+
+				qWarning () << Q_FUNC_INFO
+						<< "incremental sync failed for"
+						<< folderName
+						<< ", falling back to the full one";
+			}
+		}
+
 		auto messages = GetMessagesInFolder (folder, lastId);
-		auto newMessages = FetchVmimeMessages (messages, folder, folderName);
-		auto existing = Core::Instance ().GetStorage ()->LoadIDs (A_, folderName);
+		const auto& fetchedMessages = FetchVmimeMessages (messages, folder, folderName);
+
+		auto existing = storage->LoadIDs (A_, folderName).toSet ();
+
+		QList<Message_ptr> newMessages;
+		QList<Message_ptr> knownMessages;
+		QList<QByteArray> knownIds;
+		for (const auto& msg : fetchedMessages)
+		{
+			const auto& id = msg->GetFolderID ();
+			if (existing.remove (id))
+			{
+				knownMessages << msg;
+				knownIds << id;
+			}
+			else
+				newMessages << msg;
+		}
+
+		const auto& storedMessages = storage->LoadMessages (A_, folderName, knownIds);
 
 		QList<QByteArray> ids;
 
 		QList<Message_ptr> updatedMessages;
-		Q_FOREACH (const auto& msg, newMessages)
+		for (int i = 0; i < knownMessages.size (); ++i)
 		{
-			if (!existing.contains (msg->GetFolderID ()))
-				continue;
-
-			existing.removeAll (msg->GetFolderID ());
-			newMessages.removeAll (msg);
+			const auto& msg = knownMessages.at (i);
+			const auto& updated = storedMessages.at (i);
 
 			bool isUpdated = false;
 
-			auto updated = Core::Instance ().GetStorage ()->LoadMessage (A_, folderName, msg->GetFolderID ());
-
 			if (updated->IsRead () != msg->IsRead ())
 			{
 				updated->SetRead (msg->IsRead ());
@@ -683,6 +759,19 @@ namespace Snails
 				ids << msg->GetFolderID ();
 		}
 
+		qDebug () << Q_FUNC_INFO
+				<< "synced"
+				<< folderName
+				<< ":"
+				<< newMessages.size ()
+				<< "new,"
+				<< updatedMessages.size ()
+				<< "updated,"
+				<< ids.size ()
+				<< "unchanged in"
+				<< timer.elapsed ()
+				<< "ms";
+
 		if (ids.size ())
 			emit gotOtherMessages (ids, folderName);
 
@@ -690,7 +779,86 @@ namespace Snails
 		emit gotUpdatedMessages (updatedMessages, folderName);
 
 		if (lastId.isEmpty ())
-			emit gotMessagesRemoved (existing, folderName);
+			emit gotMessagesRemoved (existing.toList (), folderName);
+
+		if (serverState &&
+				static_cast<std::size_t> (fetchedMessages.size ()) == folder->getMessageCount ())
+			storage->SetFolderSyncState (A_, folderName, *serverState);
+	}
+
+	bool AccountThreadWorker::SyncFolderChanges (const QStringList& folderName,
+			const VmimeFolder_ptr& folder, const FolderSyncState& stored, const FolderSyncState& current)
+	{
+		const auto storage = Core::Instance ().GetStorage ();
+		const auto& readStatuses = storage->LoadReadStatuses (A_, folderName);
+
+		QList<Message_ptr> newMessages;
+		if (current.UIDNext_ != stored.UIDNext_)
+		{
+			const auto& firstUid = QByteArray::number (stored.UIDNext_);
+			const auto& messages = GetMessagesInFolder (folder, firstUid);
+			const auto& fetched = FetchVmimeMessages (messages, folder, folderName);
+			if (!messages.empty () && fetched.isEmpty ())
+				return false;
+
+			// UID ranges like n:* always include the last message, even if it's older than n.
+			for (const auto& msg : fetched)
+				if (!readStatuses.contains (msg->GetFolderID ()))
+					newMessages << msg;
+		}
+
+		FolderFlagsDiff diff;
+		if (NeedsFlagsResync (stored, current, newMessages.size ()))
+		{
+			auto messages = GetMessagesInFolder (folder, {});
+			if (messages.size () != folder->getMessageCount ())
+				return false;
+
+			try
+			{
+				const auto& context = tr ("Fetching flags for %1")
+						.arg (A_->GetName ());
+				folder->fetchMessages (messages,
+						vmime::net::fetchAttributes::FLAGS | vmime::net::fetchAttributes::UID,
+						MkPgListener (context));
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to fetch flags:"
+						<< e.what ();
+				return false;
+			}
+
+			QList<QPair<QByteArray, bool>> serverFlags;
+			for (const auto& message : messages)
+				serverFlags.append ({
+						static_cast<vmime::string> (message->getUID ()).c_str (),
+						static_cast<bool> (message->getFlags () & vmime::net::message::FLAG_SEEN)
+					});
+
+			diff = DiffFolderFlags (readStatuses, serverFlags);
+		}
+
+		const auto& updatedMessages = storage->LoadMessages (A_, folderName, diff.ChangedIds_);
+		for (int i = 0; i < updatedMessages.size (); ++i)
+			updatedMessages.at (i)->SetRead (diff.ChangedReadStatuses_.at (i));
+
+		qDebug () << Q_FUNC_INFO
+				<< folderName
+				<< ":"
+				<< newMessages.size ()
+				<< "new,"
+				<< updatedMessages.size ()
+				<< "updated,"
+				<< diff.RemovedIds_.size ()
+				<< "removed";
+
+		emit gotMsgHeaders (newMessages, folderName);
+		emit gotUpdatedMessages (updatedMessages, folderName);
+		emit gotMessagesRemoved (diff.RemovedIds_, folderName);
+
+		return true;
 	}
 
 	namespace
@@ -49,6 +49,7 @@ namespace Snails
 	class MessageChangeListener;
 
 	struct Folder;
+	struct FolderSyncState;
 
 	typedef std::vector<vmime::shared_ptr<vmime::net::message>> MessageVector_t;
 	typedef vmime::shared_ptr<vmime::net::folder> VmimeFolder_ptr;
@@ -90,6 +91,8 @@ namespace Snails
 		void FetchMessagesIMAP (const QList<QStringList>&, const QByteArray&);
 		QList<Message_ptr> FetchVmimeMessages (MessageVector_t, const VmimeFolder_ptr&, const QStringList&);
 		void FetchMessagesInFolder (const QStringList&, const VmimeFolder_ptr&, const QByteArray&);
+		bool SyncFolderChanges (const QStringList&, const VmimeFolder_ptr&,
+				const FolderSyncState& stored, const FolderSyncState& current);
 
 		void SyncIMAPFolders (vmime::shared_ptr<vmime::net::store>);
 		QList<Message_ptr> FetchFullMessages (const std::vector<vmime::shared_ptr<vmime::net::message>>&);
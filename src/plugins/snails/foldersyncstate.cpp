@@ -0,0 +1,78 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "foldersyncstate.h"
+#include <QSet>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	bool CanSyncIncrementally (const boost::optional<FolderSyncState>& stored,
+			const FolderSyncState& current)
+	{
+		return stored &&
+				current.HighestModSeq_ &&
+				stored->HighestModSeq_ &&
+				stored->UIDValidity_ == current.UIDValidity_;
+	}
+
+	bool NeedsFlagsResync (const FolderSyncState& stored,
+			const FolderSyncState& current, int newMessages)
+	{
+		return current.HighestModSeq_ != stored.HighestModSeq_ ||
+				current.MessagesCount_ != stored.MessagesCount_ + newMessages;
+	}
+
+	FolderFlagsDiff DiffFolderFlags (const QHash<QByteArray, bool>& local,
+			const QList<QPair<QByteArray, bool>>& server)
+	{
+		FolderFlagsDiff result;
+
+		QSet<QByteArray> serverIds;
+		for (const auto& pair : server)
+		{
+			serverIds << pair.first;
+
+			const auto pos = local.find (pair.first);
+			if (pos == local.end () || *pos == pair.second)
+				continue;
+
+			result.ChangedIds_ << pair.first;
+			result.ChangedReadStatuses_ << pair.second;
+		}
+
+		for (auto i = local.begin (), end = local.end (); i != end; ++i)
+			if (!serverIds.contains (i.key ()))
+				result.RemovedIds_ << i.key ();
+
+		return result;
+	}
+}
+}
@@ -0,0 +1,124 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <QList>
+#include <QHash>
+#include <QPair>
+#include <QByteArray>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	/** @brief The state of a folder as of its last synchronization.
+	 *
+	 * Comparing it against the current server-side state allows
+	 * skipping the full resync of the folder.
+	 */
+	struct FolderSyncState
+	{
+		/** The UIDVALIDITY of the folder. The locally known UIDs are
+		 * meaningless if it changes.
+		 */
+		quint32 UIDValidity_;
+
+		/** The HIGHESTMODSEQ of the folder, or 0 if the server doesn't
+		 * support CONDSTORE.
+		 */
+		quint64 HighestModSeq_;
+
+		/** The UIDNEXT of the folder, that is, the UID that the next
+		 * message appended to the folder will get.
+		 */
+		quint32 UIDNext_;
+
+		/** The number of messages in the folder (the MESSAGES item of
+		 * the STATUS response).
+		 */
+		quint32 MessagesCount_;
+	};
+
+	/** @brief Checks whether the folder can be synced incrementally.
+	 *
+	 * This requires the server to support CONDSTORE and the UIDs known
+	 * locally to still be valid.
+	 */
+	bool CanSyncIncrementally (const boost::optional<FolderSyncState>& stored,
+			const FolderSyncState& current);
+
+	/** @brief Checks whether the flags of the known messages should be
+	 * refetched.
+	 *
+	 * A changed HIGHESTMODSEQ means some flags have changed. Without
+	 * QRESYNC, which vmime doesn't enable, an EXPUNGE doesn't have to
+	 * bump the HIGHESTMODSEQ, so the messages count is checked as well:
+	 * it should be equal to the stored one plus the number of the new
+	 * messages unless something has been expunged.
+	 *
+	 * @param[in] stored The state as of the last sync.
+	 * @param[in] current The current state on the server.
+	 * @param[in] newMessages The number of new messages fetched during
+	 * this sync.
+	 */
+	bool NeedsFlagsResync (const FolderSyncState& stored,
+			const FolderSyncState& current, int newMessages);
+
+	/** @brief The changes of the locally known messages of a folder.
+	 */
+	struct FolderFlagsDiff
+	{
+		/** The IDs of messages whose read status has changed.
+		 */
+		QList<QByteArray> ChangedIds_;
+
+		/** The new read statuses of the messages in ChangedIds_.
+		 */
+		QList<bool> ChangedReadStatuses_;
+
+		/** The IDs of messages removed from the folder on the server.
+		 */
+		QList<QByteArray> RemovedIds_;
+	};
+
+	/** @brief Diffs the locally known read statuses against the server.
+	 *
+	 * Messages present on the server but not known locally are ignored.
+	 *
+	 * @param[in] local The read statuses of the locally known messages,
+	 * keyed by their folder IDs.
+	 * @param[in] server The (folder ID, read status) pairs of all the
+	 * messages in the folder on the server.
+	 */
+	FolderFlagsDiff DiffFolderFlags (const QHash<QByteArray, bool>& local,
+			const QList<QPair<QByteArray, bool>>& server);
+}
+}
@@ -0,0 +1,655 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "messagestore.h"
+#include <stdexcept>
+#include <algorithm>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		const QString PackName { "messages.pack" };
+		const QString IndexName { "messages.idx" };
+
+		const QByteArray IndexMagic { "LCSNIX" };
+		const quint8 IndexVersion = 1;
+
+		/* Garbage below this size is never worth compacting.
+		 */
+		const qint64 MinCompactGarbage = 4 * 1024 * 1024;
+
+		/* The index is rewritten once this many bytes have been appended
+		 * to the pack since the last write, so that a crash doesn't lead
+		 * to rescanning too much of the pack.
+		 */
+		const qint64 IndexRewriteThreshold = 16 * 1024 * 1024;
+
+		QByteArray SerializeRecord (const QByteArray& id, const QByteArray& data)
+		{
+			QByteArray result;
+			QDataStream out { &result, QIODevice::WriteOnly };
+			out.setVersion (QDataStream::Qt_4_8);
+			out << id << data;
+			return result;
+		}
+	}
+
+	MessageStore::MessageStore (const QDir& dir)
+	: Dir_ { dir }
+	, Pack_ { dir.filePath (PackName) }
+	{
+		QElapsedTimer timer;
+		timer.start ();
+
+		// Recover from a compaction interrupted between the renames.
+		const auto& oldPath = Pack_.fileName () + ".old";
+		if (!Pack_.exists () && QFile::exists (oldPath))
+			QFile::rename (oldPath, Pack_.fileName ());
+
+		if (!Pack_.open (QIODevice::ReadWrite))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Pack_.fileName ()
+					<< Pack_.errorString ();
+			throw std::runtime_error ("Unable to open the message pack");
+		}
+
+		if (!LoadIndex ())
+		{
+			Index_.clear ();
+			GarbageSize_ = 0;
+			IndexedSize_ = 0;
+		}
+
+		if (IndexedSize_ != Pack_.size ())
+		{
+			ScanPack (IndexedSize_);
+			IndexDirty_ = true;
+		}
+
+		MigrateFiles ();
+
+		if (IndexDirty_)
+			WriteIndex ();
+
+		qDebug () << Q_FUNC_INFO
+				<< "opened"
+				<< Dir_.path ()
+				<< "with"
+				<< Index_.size ()
+				<< "messages in"
+				<< timer.elapsed ()
+				<< "ms";
+	}
+
+	MessageStore::~MessageStore ()
+	{
+		Sync ();
+	}
+
+	void MessageStore::Save (const QList<Message_ptr>& messages)
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		for (const auto& msg : messages)
+		{
+			const auto& id = msg->GetFolderID ();
+			if (id.isEmpty ())
+				continue;
+
+			Append (id, qCompress (msg->Serialize (), 9));
+		}
+
+		Pack_.flush ();
+
+		CompactIfNeeded ();
+
+		if (Pack_.size () - IndexedSize_ > IndexRewriteThreshold)
+			WriteIndex ();
+	}
+
+	Message_ptr MessageStore::Load (const QByteArray& id) const
+	{
+		QByteArray data;
+
+		{
+			QMutexLocker locker { &Mutex_ };
+
+			const auto pos = Index_.find (id);
+			if (pos == Index_.end ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "no message"
+						<< id.toHex ()
+						<< "in"
+						<< Dir_.path ();
+				throw std::runtime_error ("No such message in the store");
+			}
+
+			data = ReadRecord (id, *pos);
+		}
+
+		const auto& msg = std::make_shared<Message> ();
+		try
+		{
+			msg->Deserialize (qUncompress (data));
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "error deserializing the message"
+					<< id.toHex ()
+					<< "from"
+					<< Dir_.path ()
+					<< e.what ();
+			throw;
+		}
+		return msg;
+	}
+
+	QList<Message_ptr> MessageStore::LoadAll () const
+	{
+		QList<QByteArray> datas;
+
+		{
+			QMutexLocker locker { &Mutex_ };
+
+			QList<QPair<QByteArray, Record>> records;
+			records.reserve (Index_.size ());
+			for (auto i = Index_.begin (), end = Index_.end (); i != end; ++i)
+				records.append ({ i.key (), *i });
+			std::sort (records.begin (), records.end (),
+					[] (const QPair<QByteArray, Record>& left, const QPair<QByteArray, Record>& right)
+						{ return left.second.Offset_ < right.second.Offset_; });
+
+			for (const auto& pair : records)
+				try
+				{
+					datas << ReadRecord (pair.first, pair.second);
+				}
+				catch (const std::exception&)
+				{
+				}
+		}
+
+		QList<Message_ptr> result;
+		for (const auto& data : datas)
+		{
+			const auto& msg = std::make_shared<Message> ();
+			try
+			{
+				msg->Deserialize (qUncompress (data));
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error deserializing a message from"
+						<< Dir_.path ()
+						<< e.what ();
+				continue;
+			}
+			result << msg;
+		}
+		return result;
+	}
+
+	void MessageStore::Remove (const QByteArray& id)
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		if (!Index_.contains (id))
+			return;
+
+		Append (id, {});
+		Pack_.flush ();
+
+		CompactIfNeeded ();
+	}
+
+	bool MessageStore::Contains (const QByteArray& id) const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Index_.contains (id);
+	}
+
+	int MessageStore::GetCount () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Index_.size ();
+	}
+
+	void MessageStore::Sync ()
+	{
+		QMutexLocker locker { &Mutex_ };
+		if (IndexDirty_)
+			WriteIndex ();
+	}
+
+	bool MessageStore::LoadIndex ()
+	{
+		QFile file { Dir_.filePath (IndexName) };
+		if (!file.exists ())
+			return false;
+
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return false;
+		}
+
+		QDataStream in { &file };
+		in.setVersion (QDataStream::Qt_4_8);
+
+		QByteArray magic;
+		quint8 version = 0;
+		qint64 packSize = 0;
+		qint64 garbage = 0;
+		qint32 count = 0;
+		in >> magic >> version >> packSize >> garbage >> count;
+		if (magic != IndexMagic || version != IndexVersion || count < 0)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown index format in"
+					<< file.fileName ();
+			return false;
+		}
+
+		if (packSize > Pack_.size ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "index"
+					<< file.fileName ()
+					<< "refers past the end of the pack, rebuilding";
+			return false;
+		}
+
+		Index_.reserve (count);
+		for (qint32 i = 0; i < count; ++i)
+		{
+			QByteArray id;
+			Record record;
+			in >> id >> record.Offset_ >> record.Size_;
+			Index_ [id] = record;
+		}
+
+		if (in.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "truncated index"
+					<< file.fileName ();
+			return false;
+		}
+
+		GarbageSize_ = garbage;
+		IndexedSize_ = packSize;
+		return true;
+	}
+
+	void MessageStore::WriteIndex ()
+	{
+		const auto& path = Dir_.filePath (IndexName);
+
+		QFile file { path + ".new" };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< file.fileName ()
+					<< file.errorString ();
+			return;
+		}
+
+		const auto packSize = Pack_.size ();
+
+		{
+			QDataStream out { &file };
+			out.setVersion (QDataStream::Qt_4_8);
+			out << IndexMagic
+					<< IndexVersion
+					<< packSize
+					<< GarbageSize_
+					<< static_cast<qint32> (Index_.size ());
+			for (auto i = Index_.begin (), end = Index_.end (); i != end; ++i)
+				out << i.key () << i->Offset_ << i->Size_;
+		}
+
+		if (!file.flush ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write"
+					<< file.fileName ()
+					<< file.errorString ();
+			file.close ();
+			file.remove ();
+			return;
+		}
+		file.close ();
+
+		QFile::remove (path);
+		if (!file.rename (path))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to rename"
+					<< file.fileName ()
+					<< "to"
+					<< path
+					<< file.errorString ();
+			return;
+		}
+
+		IndexedSize_ = packSize;
+		IndexDirty_ = false;
+	}
+
+	void MessageStore::ScanPack (qint64 from)
+	{
+		if (!Pack_.seek (from))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to seek to"
+					<< from
+					<< "in"
+					<< Pack_.fileName ();
+			return;
+		}
+
+		QDataStream in { &Pack_ };
+		in.setVersion (QDataStream::Qt_4_8);
+
+		const auto packSize = Pack_.size ();
+		auto offset = from;
+		while (offset < packSize)
+		{
+			QByteArray id;
+			QByteArray data;
+			in >> id >> data;
+			if (in.status () != QDataStream::Ok || id.isEmpty ())
+				break;
+
+			const auto end = Pack_.pos ();
+			const Record record { offset, end - offset };
+			offset = end;
+
+			const auto pos = Index_.find (id);
+			if (pos != Index_.end ())
+			{
+				GarbageSize_ += pos->Size_;
+				Index_.erase (pos);
+			}
+
+			if (data.isEmpty ())
+				GarbageSize_ += record.Size_;
+			else
+				Index_ [id] = record;
+		}
+
+		if (offset < packSize)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "truncating a partially written record at"
+					<< offset
+					<< "in"
+					<< Pack_.fileName ();
+			Pack_.resize (offset);
+		}
+	}
+
+	void MessageStore::MigrateFiles ()
+	{
+		// Old versions stored each message in <folder>/<last 3 hex digits of ID>/<hex ID>.
+		for (const auto& subdirName : Dir_.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
+		{
+			if (subdirName.size () != 3)
+				continue;
+
+			QDir subdir = Dir_;
+			if (!subdir.cd (subdirName))
+				continue;
+
+			for (const auto& name : subdir.entryList (QDir::Files))
+			{
+				QFile file { subdir.filePath (name) };
+				if (!file.open (QIODevice::ReadOnly))
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to open"
+							<< file.fileName ()
+							<< file.errorString ();
+					continue;
+				}
+
+				const auto& id = QByteArray::fromHex (name.toLatin1 ());
+				if (!Index_.contains (id))
+					Append (id, file.readAll ());
+
+				file.close ();
+				file.remove ();
+			}
+
+			Dir_.rmdir (subdirName);
+			IndexDirty_ = true;
+		}
+
+		Pack_.flush ();
+	}
+
+	void MessageStore::Append (const QByteArray& id, const QByteArray& data)
+	{
+		const auto& serialized = SerializeRecord (id, data);
+
+		const auto offset = Pack_.size ();
+		if (!Pack_.seek (offset) || Pack_.write (serialized) != serialized.size ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to append to"
+					<< Pack_.fileName ()
+					<< Pack_.errorString ();
+			throw std::runtime_error ("Unable to append to the message pack");
+		}
+
+		const Record record { offset, serialized.size () };
+
+		const auto pos = Index_.find (id);
+		if (pos != Index_.end ())
+		{
+			GarbageSize_ += pos->Size_;
+			Index_.erase (pos);
+		}
+
+		if (data.isEmpty ())
+			GarbageSize_ += record.Size_;
+		else
+			Index_ [id] = record;
+
+		IndexDirty_ = true;
+	}
+
+	QByteArray MessageStore::ReadRecord (const QByteArray& expectedId, const Record& record) const
+	{
+		if (!Pack_.seek (record.Offset_))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to seek to"
+					<< record.Offset_
+					<< "in"
+					<< Pack_.fileName ();
+			throw std::runtime_error ("Unable to seek in the message pack");
+		}
+
+		QDataStream in { Pack_.read (record.Size_) };
+		in.setVersion (QDataStream::Qt_4_8);
+
+		QByteArray id;
+		QByteArray data;
+		in >> id >> data;
+		if (in.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to read the record at"
+					<< record.Offset_
+					<< "from"
+					<< Pack_.fileName ();
+			throw std::runtime_error ("Unable to read the message record");
+		}
+
+		if (id != expectedId)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "the record at"
+					<< record.Offset_
+					<< "in"
+					<< Pack_.fileName ()
+					<< "belongs to"
+					<< id.toHex ()
+					<< "instead of"
+					<< expectedId.toHex ();
+			throw std::runtime_error ("The message record doesn't match the index");
+		}
+		return data;
+	}
+
+	void MessageStore::CompactIfNeeded ()
+	{
+		if (GarbageSize_ < MinCompactGarbage ||
+				GarbageSize_ * 2 < Pack_.size ())
+			return;
+
+		QElapsedTimer timer;
+		timer.start ();
+
+		const auto& packPath = Pack_.fileName ();
+		QFile newPack { packPath + ".new" };
+		if (!newPack.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< newPack.fileName ()
+					<< newPack.errorString ();
+			return;
+		}
+
+		QList<QPair<QByteArray, Record>> records;
+		records.reserve (Index_.size ());
+		for (auto i = Index_.begin (), end = Index_.end (); i != end; ++i)
+			records.append ({ i.key (), *i });
+		std::sort (records.begin (), records.end (),
+				[] (const QPair<QByteArray, Record>& left, const QPair<QByteArray, Record>& right)
+					{ return left.second.Offset_ < right.second.Offset_; });
+
+		QHash<QByteArray, Record> newIndex;
+		newIndex.reserve (records.size ());
+		for (const auto& pair : records)
+		{
+			if (!Pack_.seek (pair.second.Offset_))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to seek in"
+						<< packPath;
+				newPack.remove ();
+				return;
+			}
+
+			const auto& serialized = Pack_.read (pair.second.Size_);
+			const Record record { newPack.pos (), serialized.size () };
+			if (newPack.write (serialized) != serialized.size ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to write to"
+						<< newPack.fileName ()
+						<< newPack.errorString ();
+				newPack.remove ();
+				return;
+			}
+
+			newIndex [pair.first] = record;
+		}
+		newPack.close ();
+
+		const auto oldSize = Pack_.size ();
+
+		Pack_.close ();
+
+		/* The offsets in the current index are meaningless for the
+		 * compacted pack, so make sure a crash before the new index is
+		 * written leads to a rescan rather than to a stale index.
+		 */
+		QFile::remove (Dir_.filePath (IndexName));
+
+		const auto& oldPath = packPath + ".old";
+		QFile::remove (oldPath);
+		QFile::rename (packPath, oldPath);
+		if (!newPack.rename (packPath))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to rename"
+					<< newPack.fileName ()
+					<< newPack.errorString ();
+			QFile::rename (oldPath, packPath);
+		}
+		else
+		{
+			QFile::remove (oldPath);
+			Index_ = newIndex;
+			GarbageSize_ = 0;
+		}
+
+		if (!Pack_.open (QIODevice::ReadWrite))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to reopen"
+					<< packPath
+					<< Pack_.errorString ();
+			throw std::runtime_error ("Unable to reopen the message pack");
+		}
+
+		WriteIndex ();
+
+		qDebug () << Q_FUNC_INFO
+				<< "compacted"
+				<< packPath
+				<< "from"
+				<< oldSize
+				<< "to"
+				<< Pack_.size ()
+				<< "bytes in"
+				<< timer.elapsed ()
+				<< "ms";
+	}
+}
+}
@@ -0,0 +1,141 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include "message.h"
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	/** @brief Packed storage of the messages of a single folder.
+	 *
+	 * Messages are appended to a single pack file as
+	 * <code>(id, compressed message)</code> records, and an in-memory
+	 * hash maps message IDs to their records' offsets. The hash is
+	 * persisted as an index file next to the pack, so opening a folder
+	 * doesn't require scanning the whole pack: only the records appended
+	 * after the index has been written last time are scanned.
+	 *
+	 * Removing or overwriting a message appends a new record and leaves
+	 * the old one as garbage. The pack is compacted once the garbage
+	 * takes more than a half of it.
+	 *
+	 * Messages stored by the previous versions as separate files are
+	 * migrated into the pack when the store is opened.
+	 *
+	 * This class is thread-safe.
+	 */
+	class MessageStore
+	{
+		struct Record
+		{
+			qint64 Offset_;
+			qint64 Size_;
+		};
+
+		const QDir Dir_;
+
+		mutable QMutex Mutex_;
+		mutable QFile Pack_;
+
+		QHash<QByteArray, Record> Index_;
+		qint64 GarbageSize_ = 0;
+		qint64 IndexedSize_ = 0;
+		bool IndexDirty_ = false;
+	public:
+		/** @brief Opens the store in the given folder directory.
+		 *
+		 * @param[in] dir The directory of the folder.
+		 *
+		 * @exception std::runtime_error If the pack file cannot be
+		 * opened.
+		 */
+		MessageStore (const QDir& dir);
+
+		/** @brief Writes the index if it has changed.
+		 */
+		~MessageStore ();
+
+		MessageStore (const MessageStore&) = delete;
+		MessageStore& operator= (const MessageStore&) = delete;
+
+		/** @brief Appends the given messages to the pack.
+		 *
+		 * Messages with empty folder IDs are ignored. If a message with
+		 * the same ID is already stored, it is replaced.
+		 */
+		void Save (const QList<Message_ptr>& messages);
+
+		/** @brief Loads the message with the given ID.
+		 *
+		 * @exception std::runtime_error If there is no such message or
+		 * it cannot be read.
+		 */
+		Message_ptr Load (const QByteArray& id) const;
+
+		/** @brief Loads all the messages in this store.
+		 *
+		 * Messages that fail to be read or deserialized are skipped.
+		 */
+		QList<Message_ptr> LoadAll () const;
+
+		/** @brief Removes the message with the given ID.
+		 *
+		 * Does nothing if there is no such message.
+		 */
+		void Remove (const QByteArray& id);
+
+		bool Contains (const QByteArray& id) const;
+		int GetCount () const;
+
+		/** @brief Writes the index to the disk if it has changed.
+		 */
+		void Sync ();
+	private:
+		bool LoadIndex ();
+		void WriteIndex ();
+		void ScanPack (qint64 from);
+		void MigrateFiles ();
+
+		void Append (const QByteArray& id, const QByteArray& data);
+		QByteArray ReadRecord (const QByteArray& id, const Record&) const;
+
+		void CompactIfNeeded ();
+	};
+
+	typedef std::shared_ptr<MessageStore> MessageStore_ptr;
+}
+}
@@ -37,11 +37,13 @@
 #include <QSqlError>
 #include <QtConcurrentRun>
 #include <QFutureWatcher>
+#include <QDirIterator>
 #include <util/db/dblock.h>
 #include <util/sys/paths.h>
 #include "xmlsettingsmanager.h"
 #include "account.h"
 #include "accountdatabase.h"
+#include "messagestore.h"
 
 namespace LeechCraft
 {
@@ -69,29 +71,17 @@ namespace Snails
 
 	namespace
 	{
-		QList<Message_ptr> MessageSaverProc (QList<Message_ptr> msgs, const QDir dir)
+		QList<Message_ptr> MessageSaverProc (QList<Message_ptr> msgs, const MessageStore_ptr store)
 		{
-			for (const auto& msg : msgs)
+			try
 			{
-				if (msg->GetFolderID ().isEmpty ())
-					continue;
-
-				const QString dirName = msg->GetFolderID ().toHex ().right (3);
-
-				QDir msgDir = dir;
-				if (!dir.exists (dirName))
-					msgDir.mkdir (dirName);
-				if (!msgDir.cd (dirName))
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "unable to cd into"
-							<< msgDir.filePath (dirName);
-					continue;
-				}
-
-				QFile file (msgDir.filePath (msg->GetFolderID ().toHex ()));
-				file.open (QIODevice::WriteOnly);
-				file.write (qCompress (msg->Serialize (), 9));
+				store->Save (msgs);
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to save messages:"
+						<< e.what ();
 			}
 
 			return msgs;
@@ -100,21 +90,7 @@ namespace Snails
 
 	void Storage::SaveMessages (Account *acc, const QStringList& folder, const QList<Message_ptr>& msgs)
 	{
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.exists (subdir))
-				dir.mkdir (subdir);
-
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
+		const auto& store = StoreForFolder (acc, folder);
 
 		for (const auto& msg : msgs)
 			PendingSaveMessages_ [acc] [msg->GetFolderID ()] = msg;
@@ -126,7 +102,7 @@ namespace Snails
 				SIGNAL (finished ()),
 				this,
 				SLOT (handleMessagesSaved ()));
-		auto future = QtConcurrent::run (MessageSaverProc, msgs, dir);
+		auto future = QtConcurrent::run (MessageSaverProc, msgs, store);
 		watcher->setFuture (future);
 
 		for (const auto& msg : msgs)
@@ -144,42 +120,15 @@ namespace Snails
 		MessageSet result;
 
 		const QDir& dir = DirForAccount (acc);
-		for (const auto& str : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
+		QDirIterator it (dir.path (),
+				QStringList ("messages.pack"),
+				QDir::Files,
+				QDirIterator::Subdirectories);
+		while (it.hasNext ())
 		{
-			QDir subdir = dir;
-			if (!subdir.cd (str))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< str;
-				continue;
-			}
-
-			for (const auto& str : subdir.entryList (QDir::NoDotAndDotDot | QDir::Files))
+			const auto& store = StoreForDir (QFileInfo (it.next ()).dir ());
+			for (const auto& msg : store->LoadAll ())
 			{
-				QFile file (subdir.filePath (str));
-				if (!file.open (QIODevice::ReadOnly))
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "unable to open"
-							<< str
-							<< file.errorString ();
-					continue;
-				}
-
-				const auto& msg = std::make_shared<Message> ();
-				try
-				{
-					msg->Deserialize (qUncompress (file.readAll ()));
-				}
-				catch (const std::exception& e)
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "error deserializing the message from"
-							<< file.fileName ()
-							<< e.what ();
-					continue;
-				}
 				result << msg;
 				UpdateCaches (msg);
 			}
@@ -199,85 +148,25 @@ namespace Snails
 		if (PendingSaveMessages_ [acc].contains (id))
 			return PendingSaveMessages_ [acc] [id];
 
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
-
-		const auto& msg = LoadMessage (acc, dir, id);
+		const auto& msg = StoreForFolder (acc, folder)->Load (id);
 		UpdateCaches (msg);
 		return msg;
 	}
 
-	Message_ptr Storage::LoadMessage (Account *acc, QDir dir, const QByteArray& id) const
-	{
-		if (PendingSaveMessages_ [acc].contains (id))
-			return PendingSaveMessages_ [acc] [id];
-
-		if (!dir.cd (id.toHex ().right (3)))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to cd to"
-					<< dir.filePath (id.toHex ().right (3));
-			throw std::runtime_error ("Unable to cd to the directory");
-		}
-
-		QFile file (dir.filePath (id.toHex ()));
-		if (!file.open (QIODevice::ReadOnly))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open"
-					<< file.fileName ()
-					<< file.errorString ();
-			throw std::runtime_error ("Unable to open the message file");
-		}
-
-		const auto& msg = std::make_shared<Message> ();
-		try
-		{
-			msg->Deserialize (qUncompress (file.readAll ()));
-		}
-		catch (const std::exception& e)
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "error deserializing the message from"
-					<< file.fileName ()
-					<< e.what ();
-			throw;
-		}
-
-		return msg;
-	}
-
 	QList<Message_ptr> Storage::LoadMessages (Account *acc, const QStringList& folder, const QList<QByteArray>& ids)
 	{
-		auto rootDir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!rootDir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< rootDir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
+		const auto& store = StoreForFolder (acc, folder);
+		const auto pending = PendingSaveMessages_ [acc];
 
 		QList<Message_ptr> result;
 		auto future = QtConcurrent::mapped (ids,
 				std::function<Message_ptr (QByteArray)>
 				{
-					[this, acc, rootDir] (const QByteArray& id)
-						{ return LoadMessage (acc, rootDir, id); }
+					[store, pending] (const QByteArray& id)
+					{
+						const auto pos = pending.find (id);
+						return pos == pending.end () ? store->Load (id) : *pos;
+					}
 				});
 
 		for (const auto& item : future.results ())
@@ -294,6 +183,11 @@ namespace Snails
 		return BaseForAccount (acc)->GetIDs (folder);
 	}
 
+	QHash<QByteArray, bool> Storage::LoadReadStatuses (Account *acc, const QStringList& folder)
+	{
+		return BaseForAccount (acc)->GetReadStatuses (folder);
+	}
+
 	void Storage::RemoveMessage (Account *acc, const QStringList& folder, const QByteArray& id)
 	{
 		PendingSaveMessages_ [acc].remove (id);
@@ -302,26 +196,9 @@ namespace Snails
 				[this, acc, folder, id] { RemoveMessageFile (acc, folder, id); });
 	}
 
-	int Storage::GetNumMessages (Account *acc) const
+	int Storage::GetNumMessages (Account *acc)
 	{
-		int result = 0;
-
-		const QDir& dir = DirForAccount (acc);
-		for (const auto& str : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
-		{
-			QDir subdir = dir;
-			if (!subdir.cd (str))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< str;
-				continue;
-			}
-
-			result += subdir.entryList (QDir::NoDotAndDotDot | QDir::Files).size ();
-		}
-
-		return result;
+		return BaseForAccount (acc)->GetMessageCount ();
 	}
 
 	int Storage::GetNumMessages (Account *acc, const QStringList& folder)
@@ -334,7 +211,7 @@ namespace Snails
 		return BaseForAccount (acc)->GetUnreadMessageCount (folder);
 	}
 
-	bool Storage::HasMessagesIn (Account *acc) const
+	bool Storage::HasMessagesIn (Account *acc)
 	{
 		return GetNumMessages (acc);
 	}
@@ -347,41 +224,19 @@ namespace Snails
 		return LoadMessage (acc, folder, id)->IsRead ();
 	}
 
-	void Storage::RemoveMessageFile (Account *acc, const QStringList& folder, const QByteArray& id)
+	boost::optional<FolderSyncState> Storage::GetFolderSyncState (Account *acc, const QStringList& folder)
 	{
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
-
-		if (!dir.cd (id.toHex ().right (3)))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to cd to"
-					<< dir.filePath (id.toHex ().right (3));
-			throw std::runtime_error ("Unable to cd to the directory");
-		}
+		return BaseForAccount (acc)->GetFolderSyncState (folder);
+	}
 
-		QFile file (dir.filePath (id.toHex ()));
-		if (!file.exists ())
-			return;
+	void Storage::SetFolderSyncState (Account *acc, const QStringList& folder, const FolderSyncState& state)
+	{
+		BaseForAccount (acc)->SetFolderSyncState (folder, state);
+	}
 
-		qDebug () << "removing" << file.fileName () << file.size ();
-		if (!file.remove ())
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to remove the file:"
-					<< file.errorString ();
-			throw std::runtime_error ("Unable to remove the file");
-		}
+	void Storage::RemoveMessageFile (Account *acc, const QStringList& folder, const QByteArray& id)
+	{
+		StoreForFolder (acc, folder)->Remove (id);
 	}
 
 	QDir Storage::DirForAccount (Account *acc) const
@@ -402,6 +257,42 @@ namespace Snails
 		return dir;
 	}
 
+	QDir Storage::DirForFolder (Account *acc, const QStringList& folder) const
+	{
+		auto dir = DirForAccount (acc);
+		for (const auto& elem : folder)
+		{
+			const auto& subdir = elem.toUtf8 ().toHex ();
+			if (!dir.exists (subdir))
+				dir.mkdir (subdir);
+
+			if (!dir.cd (subdir))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to cd to"
+						<< dir.filePath (subdir);
+				throw std::runtime_error ("Unable to cd to the directory");
+			}
+		}
+		return dir;
+	}
+
+	MessageStore_ptr Storage::StoreForDir (const QDir& dir)
+	{
+		QMutexLocker locker (&StoresMutex_);
+
+		const auto& path = dir.absolutePath ();
+		auto& store = Stores_ [path];
+		if (!store)
+			store = std::make_shared<MessageStore> (dir);
+		return store;
+	}
+
+	MessageStore_ptr Storage::StoreForFolder (Account *acc, const QStringList& folder)
+	{
+		return StoreForDir (DirForFolder (acc, folder));
+	}
+
 	AccountDatabase_ptr Storage::BaseForAccount (Account *acc)
 	{
 		if (AccountBases_.contains (acc))
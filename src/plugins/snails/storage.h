@@ -34,6 +34,8 @@
 #include <QSettings>
 #include <QHash>
 #include <QSet>
+#include <QMutex>
+#include <boost/optional.hpp>
 #include "message.h"
 
 namespace LeechCraft
@@ -43,8 +45,12 @@ namespace Snails
 	class Account;
 
 	class AccountDatabase;
+	struct FolderSyncState;
 	typedef std::shared_ptr<AccountDatabase> AccountDatabase_ptr;
 
+	class MessageStore;
+	typedef std::shared_ptr<MessageStore> MessageStore_ptr;
+
 	class Storage : public QObject
 	{
 		Q_OBJECT
@@ -56,6 +62,9 @@ namespace Snails
 		QHash<Account*, AccountDatabase_ptr> AccountBases_;
 		QHash<Account*, QHash<QByteArray, Message_ptr>> PendingSaveMessages_;
 
+		QMutex StoresMutex_;
+		QHash<QString, MessageStore_ptr> Stores_;
+
 		QHash<QObject*, Account*> FutureWatcher2Account_;
 	public:
 		Storage (QObject* = 0);
@@ -67,19 +76,25 @@ namespace Snails
 		QList<Message_ptr> LoadMessages (Account*, const QStringList& folder, const QList<QByteArray>& ids);
 
 		QList<QByteArray> LoadIDs (Account*, const QStringList& folder);
+		QHash<QByteArray, bool> LoadReadStatuses (Account*, const QStringList& folder);
 		void RemoveMessage (Account*, const QStringList&, const QByteArray&);
 
-		int GetNumMessages (Account*) const;
+		int GetNumMessages (Account*);
 		int GetNumMessages (Account*, const QStringList& folder);
 		int GetNumUnread (Account*, const QStringList& folder);
-		bool HasMessagesIn (Account*) const;
+		bool HasMessagesIn (Account*);
 
 		bool IsMessageRead (Account*, const QStringList& folder, const QByteArray&);
+
+		boost::optional<FolderSyncState> GetFolderSyncState (Account*, const QStringList& folder);
+		void SetFolderSyncState (Account*, const QStringList& folder, const FolderSyncState&);
 	private:
-		Message_ptr LoadMessage (Account*, QDir, const QByteArray&) const;
 		void RemoveMessageFile (Account*, const QStringList&, const QByteArray&);
 	private:
 		QDir DirForAccount (Account*) const;
+		QDir DirForFolder (Account*, const QStringList&) const;
+		MessageStore_ptr StoreForDir (const QDir&);
+		MessageStore_ptr StoreForFolder (Account*, const QStringList&);
 		AccountDatabase_ptr BaseForAccount (Account*);
 
 		void AddMessage (Message_ptr, Account*);
@@ -0,0 +1,154 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "foldersyncstatetest.h"
+#include <QtTest>
+#include "foldersyncstate.h"
+
+QTEST_MAIN (LeechCraft::Snails::FolderSyncStateTest)
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		FolderSyncState MakeState (quint32 validity, quint64 modSeq, quint32 uidNext, quint32 count)
+		{
+			return { validity, modSeq, uidNext, count };
+		}
+
+		QSet<QByteArray> ToSet (const QList<QByteArray>& ids)
+		{
+			return QSet<QByteArray>::fromList (ids);
+		}
+	}
+
+	void FolderSyncStateTest::incrementalNeedsStoredState ()
+	{
+		const auto& current = MakeState (1, 100, 10, 9);
+
+		QCOMPARE (CanSyncIncrementally ({}, current), false);
+		QCOMPARE (CanSyncIncrementally (MakeState (1, 90, 8, 7), current), true);
+	}
+
+	void FolderSyncStateTest::incrementalNeedsCondstore ()
+	{
+		QCOMPARE (CanSyncIncrementally (MakeState (1, 90, 8, 7), MakeState (1, 0, 10, 9)), false);
+		QCOMPARE (CanSyncIncrementally (MakeState (1, 0, 8, 7), MakeState (1, 100, 10, 9)), false);
+	}
+
+	void FolderSyncStateTest::incrementalNeedsSameUidValidity ()
+	{
+		QCOMPARE (CanSyncIncrementally (MakeState (1, 90, 8, 7), MakeState (2, 100, 10, 9)), false);
+	}
+
+	void FolderSyncStateTest::noResyncWhenUnchanged ()
+	{
+		const auto& stored = MakeState (1, 100, 10, 9);
+
+		QCOMPARE (NeedsFlagsResync (stored, stored, 0), false);
+		QCOMPARE (NeedsFlagsResync (stored, MakeState (1, 100, 12, 11), 2), false);
+	}
+
+	void FolderSyncStateTest::resyncOnModSeqChange ()
+	{
+		QCOMPARE (NeedsFlagsResync (MakeState (1, 100, 10, 9), MakeState (1, 101, 10, 9), 0), true);
+	}
+
+	void FolderSyncStateTest::resyncOnExpunge ()
+	{
+		const auto& stored = MakeState (1, 100, 10, 9);
+
+		// An expunge without a HIGHESTMODSEQ bump.
+		QCOMPARE (NeedsFlagsResync (stored, MakeState (1, 100, 10, 8), 0), true);
+
+		// A message has arrived and another one has been expunged.
+		QCOMPARE (NeedsFlagsResync (stored, MakeState (1, 100, 11, 9), 1), true);
+	}
+
+	void FolderSyncStateTest::diffChangedFlags ()
+	{
+		const QHash<QByteArray, bool> local
+		{
+			{ "1", false },
+			{ "2", true },
+			{ "3", false }
+		};
+		const QList<QPair<QByteArray, bool>> server
+		{
+			{ "1", true },
+			{ "2", true },
+			{ "3", false }
+		};
+
+		const auto& diff = DiffFolderFlags (local, server);
+		QCOMPARE (diff.ChangedIds_, QList<QByteArray> { "1" });
+		QCOMPARE (diff.ChangedReadStatuses_, QList<bool> { true });
+		QVERIFY (diff.RemovedIds_.isEmpty ());
+	}
+
+	void FolderSyncStateTest::diffRemovedMessages ()
+	{
+		const QHash<QByteArray, bool> local
+		{
+			{ "1", false },
+			{ "2", true },
+			{ "3", false }
+		};
+		const QList<QPair<QByteArray, bool>> server
+		{
+			{ "2", false }
+		};
+
+		const auto& diff = DiffFolderFlags (local, server);
+		QCOMPARE (diff.ChangedIds_, QList<QByteArray> { "2" });
+		QCOMPARE (diff.ChangedReadStatuses_, QList<bool> { false });
+		QCOMPARE (ToSet (diff.RemovedIds_), (QSet<QByteArray> { "1", "3" }));
+	}
+
+	void FolderSyncStateTest::diffIgnoresUnknownMessages ()
+	{
+		const QHash<QByteArray, bool> local
+		{
+			{ "1", true }
+		};
+		const QList<QPair<QByteArray, bool>> server
+		{
+			{ "1", true },
+			{ "4", false }
+		};
+
+		const auto& diff = DiffFolderFlags (local, server);
+		QVERIFY (diff.ChangedIds_.isEmpty ());
+		QVERIFY (diff.ChangedReadStatuses_.isEmpty ());
+		QVERIFY (diff.RemovedIds_.isEmpty ());
+	}
+}
+}
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <atomic>
 #include "utilconfig.h"
 #include <QByteArray>
 #include <QSet>
@@ -44,11 +45,14 @@ namespace Util
 	 * This class holds a pool of identificators of the given type \em T.
 	 * It is very simple and produces consecutive IDs, this \em T should
 	 * support <code>operator++()</code>.
+	 *
+	 * GetID() is safe to call concurrently from several threads as long
+	 * as \em T is suitable for <code>std::atomic</code>.
 	 */
 	template<typename T>
 	class IDPool
 	{
-		T CurrentID_;
+		std::atomic<T> CurrentID_;
 	public:
 		/** @brief Creates a pool with the given initial value.
 		 *
@@ -59,6 +63,26 @@ namespace Util
 		{
 		}
 
+		/** @brief Copies the current state of the \em other pool.
+		 *
+		 * @param[in] other The pool to copy.
+		 */
+		IDPool (const IDPool& other)
+		: CurrentID_ (other.CurrentID_.load ())
+		{
+		}
+
+		/** @brief Copies the current state of the \em other pool.
+		 *
+		 * @param[in] other The pool to copy.
+		 * @return This pool.
+		 */
+		IDPool& operator= (const IDPool& other)
+		{
+			CurrentID_ = other.CurrentID_.load ();
+			return *this;
+		}
+
 		/** @brief Destroys the pool.
 		 */
 		virtual ~IDPool ()
@@ -103,7 +127,7 @@ namespace Util
 				QDataStream ostr (&result, QIODevice::WriteOnly);
 				quint8 ver = 1;
 				ostr << ver;
-				ostr << CurrentID_;
+				ostr << CurrentID_.load ();
 			}
 			return result;
 		}
@@ -122,7 +146,11 @@ namespace Util
 			quint8 ver;
 			istr >> ver;
 			if (ver == 1)
-				istr >> CurrentID_;
+			{
+				T id;
+				istr >> id;
+				CurrentID_ = id;
+			}
 			else
 				qWarning () << Q_FUNC_INFO
 						<< "unknown version"
@@ -29,61 +29,244 @@
 
 #pragma once
 
-#include <algorithm>
+#include <iterator>
+#include <list>
 #include <QHash>
 
 namespace LeechCraft
 {
 namespace Util
 {
+	/** @brief Eviction strategies for AssocCache.
+	 *
+	 * A strategy is a class having a nested <code>State<K></code>
+	 * template, which keeps track of the keys of the cache in the
+	 * order they are to be evicted. The state should provide:
+	 * - a <code>ValueAddon</code> type, stored along with each value,
+	 * - <code>ValueAddon Insert (const K&)</code>, called when a new key
+	 *   is added,
+	 * - <code>void Touch (ValueAddon&)</code>, called when an existing
+	 *   key is accessed,
+	 * - <code>void Remove (ValueAddon&)</code>, called when a key is
+	 *   removed from the cache,
+	 * - <code>const K& Victim (const K& keep)</code> returning the key
+	 *   to evict next other than \em keep, without counting \em keep as
+	 *   accessed (there is always at least one other key),
+	 * - <code>void Clear ()</code>.
+	 *
+	 * All the operations of the strategies below are O(1), amortized
+	 * for CLOCK.
+	 */
 	namespace CacheStrat
 	{
-		class LRU
+		/** @brief Evicts the least recently used key.
+		 */
+		struct LRU
 		{
-			size_t Current_ = 0;
-		public:
-			struct ValueAddon
+			template<typename K>
+			class State
 			{
-				size_t LastAccess_ = 0;
+				std::list<K> Order_;
+			public:
+				struct ValueAddon
+				{
+					typename std::list<K>::iterator Pos_;
+				};
 
-				ValueAddon () = default;
+				ValueAddon Insert (const K& key)
+				{
+					return { Order_.insert (Order_.end (), key) };
+				}
 
-				ValueAddon (size_t la)
-				: LastAccess_ { la }
+				void Touch (ValueAddon& add)
 				{
+					Order_.splice (Order_.end (), Order_, add.Pos_);
+				}
+
+				void Remove (ValueAddon& add)
+				{
+					Order_.erase (add.Pos_);
+				}
+
+				const K& Victim (const K& keep)
+				{
+					const auto& front = Order_.front ();
+					return front == keep ? *std::next (Order_.begin ()) : front;
+				}
+
+				void Clear ()
+				{
+					Order_.clear ();
 				}
 			};
+		};
 
-			ValueAddon CreateInfo ()
+		/** @brief Approximates LRU using the CLOCK (second chance)
+		 * algorithm.
+		 *
+		 * Accessing a key only sets a flag, which is cheaper than
+		 * reordering the keys on each access like LRU does.
+		 */
+		struct CLOCK
+		{
+			template<typename K>
+			class State
 			{
-				return { ++Current_ };
-			}
+				struct Slot
+				{
+					K Key_;
+					bool Referenced_;
+				};
+				std::list<Slot> Ring_;
+				typename std::list<Slot>::iterator Hand_ = Ring_.end ();
+			public:
+				struct ValueAddon
+				{
+					typename std::list<Slot>::iterator Pos_;
+				};
 
-			void Clear ()
-			{
-				Current_ = 0;
-			}
+				State () = default;
+				State (const State&) = delete;
+				State& operator= (const State&) = delete;
 
-			void Touch (ValueAddon& add)
-			{
-				add.LastAccess_ = ++Current_;
-			}
+				ValueAddon Insert (const K& key)
+				{
+					return { Ring_.insert (Hand_, { key, false }) };
+				}
+
+				void Touch (ValueAddon& add)
+				{
+					add.Pos_->Referenced_ = true;
+				}
+
+				void Remove (ValueAddon& add)
+				{
+					if (Hand_ == add.Pos_)
+						++Hand_;
+					Ring_.erase (add.Pos_);
+				}
+
+				const K& Victim (const K& keep)
+				{
+					while (true)
+					{
+						if (Hand_ == Ring_.end ())
+							Hand_ = Ring_.begin ();
+
+						if (Hand_->Key_ == keep)
+						{
+							++Hand_;
+							continue;
+						}
+
+						if (!Hand_->Referenced_)
+							return Hand_->Key_;
+
+						Hand_->Referenced_ = false;
+						++Hand_;
+					}
+				}
+
+				void Clear ()
+				{
+					Ring_.clear ();
+					Hand_ = Ring_.end ();
+				}
+			};
 		};
 
-		inline bool operator< (const LRU::ValueAddon& v1, const LRU::ValueAddon& v2)
+		/** @brief Evicts the least frequently used key.
+		 *
+		 * Among the keys with the same access count the least recently
+		 * used one is evicted.
+		 */
+		struct LFU
 		{
-			return v1.LastAccess_ < v2.LastAccess_;
-		}
+			template<typename K>
+			class State
+			{
+				struct Bucket
+				{
+					size_t Frequency_;
+					std::list<K> Keys_;
+				};
+				std::list<Bucket> Buckets_;
+			public:
+				struct ValueAddon
+				{
+					typename std::list<Bucket>::iterator Bucket_;
+					typename std::list<K>::iterator Pos_;
+				};
+
+				ValueAddon Insert (const K& key)
+				{
+					if (Buckets_.empty () || Buckets_.front ().Frequency_ != 1)
+						Buckets_.push_front ({ 1, {} });
+
+					auto& keys = Buckets_.front ().Keys_;
+					return { Buckets_.begin (), keys.insert (keys.end (), key) };
+				}
+
+				void Touch (ValueAddon& add)
+				{
+					const auto frequency = add.Bucket_->Frequency_ + 1;
+
+					auto next = std::next (add.Bucket_);
+					if (next == Buckets_.end () || next->Frequency_ != frequency)
+						next = Buckets_.insert (next, { frequency, {} });
+
+					next->Keys_.splice (next->Keys_.end (), add.Bucket_->Keys_, add.Pos_);
+					if (add.Bucket_->Keys_.empty ())
+						Buckets_.erase (add.Bucket_);
+					add.Bucket_ = next;
+				}
+
+				void Remove (ValueAddon& add)
+				{
+					add.Bucket_->Keys_.erase (add.Pos_);
+					if (add.Bucket_->Keys_.empty ())
+						Buckets_.erase (add.Bucket_);
+				}
+
+				const K& Victim (const K& keep)
+				{
+					const auto& keys = Buckets_.front ().Keys_;
+					if (keys.front () != keep)
+						return keys.front ();
+
+					return keys.size () > 1 ?
+							*std::next (keys.begin ()) :
+							std::next (Buckets_.begin ())->Keys_.front ();
+				}
+
+				void Clear ()
+				{
+					Buckets_.clear ();
+				}
+			};
+		};
 	}
 
+	/** @brief An associative container evicting values once their
+	 * total cost exceeds the given maximum.
+	 *
+	 * The order the values are evicted in is defined by the CS
+	 * strategy, see CacheStrat namespace for the available ones.
+	 *
+	 * @tparam K The type of the keys, should be usable as a QHash key.
+	 * @tparam V The type of the values, should be default-constructible.
+	 * @tparam CS The eviction strategy.
+	 */
 	template<typename K, typename V, typename CS = CacheStrat::LRU>
 	class AssocCache
 	{
+		using StratState_t = typename CS::template State<K>;
+
 		struct ValueHolder
 		{
 			V V_;
 			size_t Cost_;
-			typename CS::ValueAddon CacheInfo_;
+			typename StratState_t::ValueAddon CacheInfo_;
 		};
 
 		QHash<K, ValueHolder> Hash_;
@@ -91,20 +274,81 @@ namespace Util
 		size_t CurrentCost_ = 0;
 		const size_t MaxCost_;
 
-		CS CacheStratState_;
+		StratState_t CacheStratState_;
+	public:
+		/** @brief Access statistics of the cache.
+		 */
+		struct Stats
+		{
+			/** @brief The number of accesses to the existing keys.
+			 */
+			size_t Hits_ = 0;
+			/** @brief The number of accesses to the missing keys.
+			 */
+			size_t Misses_ = 0;
+			/** @brief The number of values evicted due to the cost limit.
+			 */
+			size_t Evictions_ = 0;
+		};
+	private:
+		Stats Stats_;
 	public:
+		/** @brief Constructs the cache with the given maximum total cost.
+		 *
+		 * @param[in] maxCost The maximum total cost of the values.
+		 */
 		AssocCache (size_t maxCost)
 		: MaxCost_ { maxCost }
 		{
 		}
 
+		AssocCache (const AssocCache&) = delete;
+		AssocCache& operator= (const AssocCache&) = delete;
+
 		size_t size () const;
 		void clear ();
 		bool contains (const K&) const;
 
+		/** @brief Returns the value for the given key.
+		 *
+		 * If there is no such key, a default-constructed value with the
+		 * cost of 1 is inserted.
+		 */
 		V& operator[] (const K&);
+
+		/** @brief Inserts the value with the given cost.
+		 *
+		 * If the key is already present, its value and cost are
+		 * replaced.
+		 *
+		 * @param[in] key The key.
+		 * @param[in] value The value.
+		 * @param[in] cost The cost of the value.
+		 */
+		void insert (const K& key, const V& value, size_t cost = 1);
+
+		/** @brief Removes the given key from the cache.
+		 *
+		 * @return Whether the key was present in the cache.
+		 */
+		bool remove (const K&);
+
+		/** @brief Returns the total cost of the values in the cache.
+		 */
+		size_t totalCost () const;
+
+		/** @brief Returns the maximum total cost of the values.
+		 */
+		size_t maxCost () const;
+
+		/** @brief Returns the access statistics since the construction
+		 * or the last call to resetStats().
+		 */
+		const Stats& stats () const;
+
+		void resetStats ();
 	private:
-		void CheckShrink ();
+		void CheckShrink (const K& keep);
 	};
 
 	template<typename K, typename V, typename CS>
@@ -118,6 +362,7 @@ namespace Util
 	{
 		Hash_.clear ();
 		CacheStratState_.Clear ();
+		CurrentCost_ = 0;
 	}
 
 	template<typename K, typename V, typename CS>
@@ -129,29 +374,88 @@ namespace Util
 	template<typename K, typename V, typename CS>
 	V& AssocCache<K, V, CS>::operator[] (const K& key)
 	{
-		if (!Hash_.contains (key))
+		auto pos = Hash_.find (key);
+		if (pos == Hash_.end ())
 		{
-			Hash_.insert (key, { {}, 1, CacheStratState_.CreateInfo () });
+			++Stats_.Misses_;
+
+			Hash_.insert (key, { {}, 1, CacheStratState_.Insert (key) });
 			++CurrentCost_;
 
-			CheckShrink ();
+			CheckShrink (key);
+			return Hash_ [key].V_;
 		}
-		else
-			CacheStratState_.Touch (Hash_ [key].CacheInfo_);
 
-		return Hash_ [key].V_;
+		++Stats_.Hits_;
+		CacheStratState_.Touch (pos->CacheInfo_);
+		return pos->V_;
 	}
 
 	template<typename K, typename V, typename CS>
-	void AssocCache<K, V, CS>::CheckShrink ()
+	void AssocCache<K, V, CS>::insert (const K& key, const V& value, size_t cost)
 	{
-		while (CurrentCost_ > MaxCost_)
+		auto pos = Hash_.find (key);
+		if (pos == Hash_.end ())
+			Hash_.insert (key, { value, cost, CacheStratState_.Insert (key) });
+		else
 		{
-			const auto pos = std::min_element (Hash_.begin (), Hash_.end (),
-					[] (const ValueHolder& left, const ValueHolder& right)
-						{ return left.CacheInfo_ < right.CacheInfo_; });
 			CurrentCost_ -= pos->Cost_;
-			Hash_.erase (pos);
+			pos->V_ = value;
+			pos->Cost_ = cost;
+			CacheStratState_.Touch (pos->CacheInfo_);
+		}
+		CurrentCost_ += cost;
+
+		CheckShrink (key);
+	}
+
+	template<typename K, typename V, typename CS>
+	bool AssocCache<K, V, CS>::remove (const K& key)
+	{
+		const auto pos = Hash_.find (key);
+		if (pos == Hash_.end ())
+			return false;
+
+		CurrentCost_ -= pos->Cost_;
+		CacheStratState_.Remove (pos->CacheInfo_);
+		Hash_.erase (pos);
+		return true;
+	}
+
+	template<typename K, typename V, typename CS>
+	size_t AssocCache<K, V, CS>::totalCost () const
+	{
+		return CurrentCost_;
+	}
+
+	template<typename K, typename V, typename CS>
+	size_t AssocCache<K, V, CS>::maxCost () const
+	{
+		return MaxCost_;
+	}
+
+	template<typename K, typename V, typename CS>
+	auto AssocCache<K, V, CS>::stats () const -> const Stats&
+	{
+		return Stats_;
+	}
+
+	template<typename K, typename V, typename CS>
+	void AssocCache<K, V, CS>::resetStats ()
+	{
+		Stats_ = {};
+	}
+
+	template<typename K, typename V, typename CS>
+	void AssocCache<K, V, CS>::CheckShrink (const K& keep)
+	{
+		// The value that has just been inserted or updated is never
+		// evicted, even if it alone exceeds the maximum cost.
+		while (CurrentCost_ > MaxCost_ && Hash_.size () > 1)
+		{
+			const auto victim = CacheStratState_.Victim (keep);
+			++Stats_.Evictions_;
+			remove (victim);
 		}
 	}
 }
@@ -0,0 +1,190 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "assoccache.h"
+#include <QtTest>
+#include <assoccache.h>
+
+QTEST_MAIN (LeechCraft::Util::AssocCacheTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	void AssocCacheTest::testLRU ()
+	{
+		AssocCache<int, QString> cache { 2 };
+		cache [1] = "a";
+		cache [2] = "b";
+		cache [1];
+		cache [3] = "c";
+
+		QCOMPARE (cache.size (), size_t { 2 });
+		QCOMPARE (cache.contains (1), true);
+		QCOMPARE (cache.contains (2), false);
+		QCOMPARE (cache [1], QString { "a" });
+	}
+
+	void AssocCacheTest::testCLOCK ()
+	{
+		AssocCache<int, int, CacheStrat::CLOCK> cache { 3 };
+		cache [1];
+		cache [2];
+		cache [3];
+		cache [1];
+		cache [3];
+		cache [4];
+
+		QCOMPARE (cache.contains (1), true);
+		QCOMPARE (cache.contains (2), false);
+		QCOMPARE (cache.contains (3), true);
+		QCOMPARE (cache.contains (4), true);
+	}
+
+	void AssocCacheTest::testLFU ()
+	{
+		AssocCache<int, int, CacheStrat::LFU> cache { 2 };
+		cache [1];
+		cache [1];
+		cache [2];
+		cache [2];
+		cache [2];
+		cache [3];
+
+		QCOMPARE (cache.contains (1), false);
+		QCOMPARE (cache.contains (2), true);
+		QCOMPARE (cache.contains (3), true);
+	}
+
+	void AssocCacheTest::testLFUKeepNotCounted ()
+	{
+		AssocCache<int, int, CacheStrat::LFU> cache { 2 };
+		cache [1];
+		cache [1];
+		cache [1];
+
+		// 1 is evicted, and 2 is kept without being counted as accessed.
+		cache.insert (2, 2, 2);
+		cache.insert (2, 2, 1);
+
+		cache [3];
+		cache [3];
+		cache [3];
+		cache [4];
+
+		QCOMPARE (cache.contains (2), false);
+		QCOMPARE (cache.contains (3), true);
+		QCOMPARE (cache.contains (4), true);
+	}
+
+	void AssocCacheTest::testCosts ()
+	{
+		AssocCache<int, int> cache { 10 };
+		for (int i = 0; i < 5; ++i)
+			cache.insert (i, i, 2);
+		QCOMPARE (cache.totalCost (), size_t { 10 });
+
+		cache.insert (5, 5, 5);
+		QCOMPARE (cache.totalCost (), size_t { 9 });
+		QCOMPARE (cache.size (), size_t { 3 });
+		QCOMPARE (cache.contains (2), false);
+		QCOMPARE (cache.contains (3), true);
+
+		cache.insert (6, 6, 20);
+		QCOMPARE (cache.size (), size_t { 1 });
+		QCOMPARE (cache.contains (6), true);
+	}
+
+	void AssocCacheTest::testRemove ()
+	{
+		AssocCache<int, int> cache { 3 };
+		cache [1];
+		cache [2];
+
+		QCOMPARE (cache.remove (1), true);
+		QCOMPARE (cache.remove (1), false);
+		QCOMPARE (cache.totalCost (), size_t { 1 });
+
+		cache [3];
+		cache [4];
+		QCOMPARE (cache.contains (2), true);
+	}
+
+	void AssocCacheTest::testStats ()
+	{
+		AssocCache<int, int> cache { 2 };
+		cache [1];
+		cache [1];
+		cache [2];
+		cache [3];
+
+		QCOMPARE (cache.stats ().Hits_, size_t { 1 });
+		QCOMPARE (cache.stats ().Misses_, size_t { 3 });
+		QCOMPARE (cache.stats ().Evictions_, size_t { 1 });
+
+		cache.resetStats ();
+		QCOMPARE (cache.stats ().Hits_, size_t { 0 });
+	}
+
+	namespace
+	{
+		template<typename CS>
+		void RunBenchmark ()
+		{
+			const int cacheSize = 10000;
+
+			qsrand (0);
+			QVector<int> keys;
+			for (int i = 0; i < cacheSize * 10; ++i)
+				keys << qrand () % (cacheSize * 2);
+
+			AssocCache<int, int, CS> cache { cacheSize };
+			QBENCHMARK {
+				for (auto key : keys)
+					++cache [key];
+			}
+		}
+	}
+
+	void AssocCacheTest::benchmarkLRU ()
+	{
+		RunBenchmark<CacheStrat::LRU> ();
+	}
+
+	void AssocCacheTest::benchmarkCLOCK ()
+	{
+		RunBenchmark<CacheStrat::CLOCK> ();
+	}
+
+	void AssocCacheTest::benchmarkLFU ()
+	{
+		RunBenchmark<CacheStrat::LFU> ();
+	}
+}
+}